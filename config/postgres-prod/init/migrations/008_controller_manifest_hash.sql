@@ -0,0 +1,16 @@
+-- 008_controller_manifest_hash.sql
+-- Purpose:
+--  - Remember the manifest fingerprint of each controller's last stored registration,
+--    so device-monitor keeps answering "manifest_known" across its own restarts.
+--
+-- Notes:
+--  - Written by device-monitor (ManifestFingerprintResponder) once a requested
+--    registration has been stored; NULL means the next connect registers in full.
+
+BEGIN;
+
+ALTER TABLE controllers ADD COLUMN IF NOT EXISTS manifest_hash VARCHAR(64);
+
+COMMENT ON COLUMN controllers.manifest_hash IS 'Manifest fingerprint of the last stored registration (set by device-monitor)';
+
+COMMIT;
@@ -200,6 +200,7 @@ unsigned long last_ir_timestamp = 0;
 // ──────────────────────────────────────────────────────────────────────────────
 void build_capability_manifest();
 SentientMQTTConfig build_mqtt_config();
+void handle_mqtt_command(const char *command, const JsonDocument &payload, void *ctx);
 bool build_heartbeat_payload(JsonDocument &doc, void *ctx);
 
 // ──────────────────────────────────────────────────────────────────────────────
@@ -292,8 +293,13 @@ void setup()
   Serial.println(F("[BoilerRmA] MQTT connected successfully!"));
 
   // Set callbacks
-  // We override command routing to parse device + command from topic
+  // Commands arrive on commands/<controller>/<device>/<command>; the handler routes on the device
   mqtt.setHeartbeatBuilder(build_heartbeat_payload);
+  mqtt.setCommandCallback(handle_mqtt_command);
+
+  // Registration goes out from mqtt.loop(), one record per pass, on every (re)connect
+  manifest.set_registration_room(room_id);
+  mqtt.setRegistration(&manifest);
 
   // Wait for broker connection (max 5 seconds)
   Serial.println(F("[BoilerRmA] Waiting for broker connection..."));
@@ -308,17 +314,6 @@ void setup()
   {
     Serial.println(F("[BoilerRmA] Broker connected!"));
 
-    // Register with Sentient system
-    Serial.println(F("[BoilerRmA] Registering with Sentient system..."));
-    if (manifest.publish_registration(mqtt.get_client(), room_id, controller_id))
-    {
-      Serial.println(F("[BoilerRmA] Registration successful!"));
-    }
-    else
-    {
-      Serial.println(F("[BoilerRmA] WARNING: Registration publish failed"));
-    }
-
     // Publish initial status
     publish_hardware_status();
   }
@@ -327,169 +322,6 @@ void setup()
     Serial.println(F("[BoilerRmA] Broker connection timeout - will retry in main loop"));
   }
 
-  // Subscribe to device-scoped commands and set our own message handler
-  {
-    String topic = String(mqtt_namespace) + "/" + room_id + "/" + naming::CAT_COMMANDS + "/" + controller_id + "/+/+";
-    mqtt.get_client().subscribe(topic.c_str());
-    Serial.print(F("[BoilerRmA] Subscribed (device+command): "));
-    Serial.println(topic);
-    mqtt.get_client().setCallback([](char *topic, uint8_t *payload, unsigned int length)
-                                  {
-  // Parse topic → device + command
-      String device, command;
-      // Extract segments (expect: client/room/commands/controller/device/command)
-  int seg = 0; const char *p = topic;
-      const char *segStart[8] = {nullptr}; size_t segLen[8] = {0};
-      segStart[0] = p;
-      while (*p && seg < 8) { if (*p == '/') { segLen[seg] = p - segStart[seg]; seg++; if (seg < 8) segStart[seg] = p + 1; } p++; }
-      if (seg < 8 && segStart[seg]) { segLen[seg] = p - segStart[seg]; seg++; }
-      auto equalsSeg = [&](int idx, const char *lit) -> bool {
-        size_t litLen = strlen(lit); return segLen[idx] == litLen && strncmp(segStart[idx], lit, litLen) == 0; };
-      if (seg >= 6 && equalsSeg(0, mqtt_namespace) && equalsSeg(1, room_id) && equalsSeg(2, naming::CAT_COMMANDS) && equalsSeg(3, controller_id)) {
-        device = String(segStart[4]).substring(0, segLen[4]);
-        command = String(segStart[5]).substring(0, segLen[5]);
-        // Serial observability for command receipt
-        Serial.print(F("[BoilerRmA] CMD recv: device="));
-        Serial.print(device);
-        Serial.print(F(" command="));
-        Serial.print(command);
-        Serial.print(F(" payload_len="));
-        Serial.println(length);
-      } else {
-        return; // Not for us
-      }
-
-      // Parse payload (JSON or raw)
-      DynamicJsonDocument doc(256);
-      bool hasJson = false;
-      if (length > 0) {
-        DeserializationError err = deserializeJson(doc, payload, length);
-        hasJson = !err;
-        if (err) {
-          // Note: payload not valid JSON, treat as raw string
-          Serial.println(F("[BoilerRmA] Payload parse: non-JSON, treating as raw"));
-          doc.clear(); doc["value"] = String((const char *)payload).substring(0, length);
-        }
-      }
-
-      long ack_duration_ms = -1; // will be included in ACK if >= 0
-
-      // Dispatch
-      // Intro TV
-      if (device == naming::DEV_INTRO_TV) {
-        if (command == naming::CMD_TV_POWER_ON)  { tv_power_on = true;  digitalWrite(tv_power_pin, HIGH); publish_hardware_status(); }
-        else if (command == naming::CMD_TV_POWER_OFF) { tv_power_on = false; digitalWrite(tv_power_pin, LOW); publish_hardware_status(); }
-        else if (command == naming::CMD_TV_LIFT_UP)   { tv_lift_state = 1;  digitalWrite(tv_lift_up_pin, HIGH); digitalWrite(tv_lift_down_pin, LOW); publish_hardware_status(); }
-        else if (command == naming::CMD_TV_LIFT_DOWN) { tv_lift_state = -1; digitalWrite(tv_lift_down_pin, HIGH); digitalWrite(tv_lift_up_pin, LOW); publish_hardware_status(); }
-        else { /* unknown */ }
-      }
-      // Controller-level (power-off sequence)
-      else if (device == naming::DEV_CONTROLLER) {
-        if (command == naming::CMD_CONTROLLER_POWER_OFF_SEQUENCE) {
-          // Perform power-off sequence: set outputs to safe/off state
-          // TV
-          tv_power_on = false; digitalWrite(tv_power_pin, LOW);
-          tv_lift_state = 0; digitalWrite(tv_lift_up_pin, LOW); digitalWrite(tv_lift_down_pin, LOW);
-          // Fog system
-          fog_trigger_on = false; digitalWrite(fog_trigger_pin, LOW);
-          ultrasonic_water_on = false; digitalWrite(ultrasonic_water_pin, LOW);
-          fog_power_on = false; digitalWrite(fog_power_pin, LOW);
-          // Doors/locks to safe default (locked)
-          barrel_maglock_locked = true; digitalWrite(barrel_maglock_pin, HIGH);
-          study_door_top_locked = true; study_door_bottom_a_locked = true; study_door_bottom_b_locked = true;
-          digitalWrite(study_door_maglock_top_pin, HIGH);
-          digitalWrite(study_door_maglock_bottom_a_pin, HIGH);
-          digitalWrite(study_door_maglock_bottom_b_pin, HIGH);
-          // Lights off
-          gauge_progress_level = 0; fill_solid(leds, num_leds, CRGB::Black); FastLED.show();
-          // IR off
-          ir_sensor_active = false;
-          // Publish status and readiness
-          publish_hardware_status();
-          // Publish shutdown readiness: [client]/[room]/events/[controller]/controller/shutdown_ready
-          StaticJsonDocument<160> ready;
-          ready["controller_id"] = controller_id;
-          ready["ready"] = true;
-          ready["version"] = firmware::VERSION;
-          ready["timestamp_ms"] = millis();
-          char rbuf[196]; serializeJson(ready, rbuf, sizeof(rbuf));
-          String rTopic = String(mqtt_namespace) + "/" + room_id + "/" + naming::CAT_EVENTS + "/" + controller_id + "/" + naming::DEV_CONTROLLER + "/shutdown_ready";
-          mqtt.get_client().publish(rTopic.c_str(), rbuf, false);
-        }
-      }
-      // Fog Machine
-      else if (device == naming::DEV_BOILER_FOG_MACHINE) {
-        if (command == naming::CMD_FOG_POWER_ON)  { fog_power_on = true;  digitalWrite(fog_power_pin, HIGH); publish_hardware_status(); }
-        else if (command == naming::CMD_FOG_POWER_OFF) { fog_power_on = false; digitalWrite(fog_power_pin, LOW); publish_hardware_status(); }
-        else if (command == naming::CMD_FOG_TRIGGER)   {
-          // Option A: allow optional duration_ms (default 500ms), clamped to [100, 3000]
-          long durationMs = 500;
-          if (hasJson) {
-            if (!doc["duration_ms"].isNull()) {
-              durationMs = doc["duration_ms"].as<long>();
-            } else if (!doc["duration"].isNull()) {
-              durationMs = doc["duration"].as<long>();
-            } else if (!doc["value"].isNull()) {
-              // Accept numeric or numeric string in "value"
-              if (doc["value"].is<long>()) durationMs = doc["value"].as<long>();
-              else {
-                String vs = doc["value"].as<String>();
-                durationMs = vs.toInt();
-              }
-            }
-          }
-          if (durationMs < 100) durationMs = 100;
-          if (durationMs > 3000) durationMs = 3000;
-          ack_duration_ms = durationMs;
-          Serial.print(F("[BoilerRmA] Fog trigger pulse: ")); Serial.print(durationMs); Serial.println(F(" ms"));
-          fog_trigger_on = true; digitalWrite(fog_trigger_pin, HIGH);
-          delay((unsigned long)durationMs);
-          fog_trigger_on = false; digitalWrite(fog_trigger_pin, LOW);
-          publish_hardware_status();
-        }
-        else if (command == naming::CMD_ULTRASONIC_ON)  { ultrasonic_water_on = true;  digitalWrite(ultrasonic_water_pin, HIGH); publish_hardware_status(); }
-        else if (command == naming::CMD_ULTRASONIC_OFF) { ultrasonic_water_on = false; digitalWrite(ultrasonic_water_pin, LOW); publish_hardware_status(); }
-        else { /* unknown */ }
-      }
-      // Study Door (group)
-      else if (device == naming::DEV_STUDY_DOOR) {
-        if (command == naming::CMD_DOOR_LOCK)   { study_door_top_locked = true; study_door_bottom_a_locked = true; study_door_bottom_b_locked = true; digitalWrite(study_door_maglock_top_pin, HIGH); digitalWrite(study_door_maglock_bottom_a_pin, HIGH); digitalWrite(study_door_maglock_bottom_b_pin, HIGH); publish_hardware_status(); }
-        else if (command == naming::CMD_DOOR_UNLOCK) { study_door_top_locked = false; study_door_bottom_a_locked = false; study_door_bottom_b_locked = false; digitalWrite(study_door_maglock_top_pin, LOW); digitalWrite(study_door_maglock_bottom_a_pin, LOW); digitalWrite(study_door_maglock_bottom_b_pin, LOW); publish_hardware_status(); }
-        else { /* unknown */ }
-      }
-      // Gauge Progress Chest
-      else if (device == naming::DEV_GAUGE_PROGRESS_CHEST) {
-        if (command == naming::CMD_GAUGE_CLEAR) { gauge_progress_level = 0; fill_solid(leds, num_leds, CRGB::Black); }
-        else if (command == naming::CMD_GAUGE_SOLVED_1) { gauge_progress_level = 1; fill_solid(leds, 15, CRGB::Green); fill_solid(leds + 15, num_leds - 15, CRGB::Black); }
-        else if (command == naming::CMD_GAUGE_SOLVED_2) { gauge_progress_level = 2; fill_solid(leds, 30, CRGB::Green); fill_solid(leds + 30, num_leds - 30, CRGB::Black); }
-        else if (command == naming::CMD_GAUGE_SOLVED_3) { gauge_progress_level = 3; fill_solid(leds, 45, CRGB::Green); fill_solid(leds + 45, num_leds - 45, CRGB::Black); }
-        FastLED.show(); publish_hardware_status();
-      }
-      // Barrel (maglock + IR control)
-      else if (device == naming::DEV_BOILER_ROOM_BARREL) {
-        if (command == naming::CMD_BARREL_UNLOCK) { barrel_maglock_locked = false; digitalWrite(barrel_maglock_pin, LOW); publish_hardware_status(); }
-        else if (command == naming::CMD_BARREL_LOCK) { barrel_maglock_locked = true; digitalWrite(barrel_maglock_pin, HIGH); publish_hardware_status(); }
-        else if (command == naming::CMD_ACTIVATE_IR) { ir_sensor_active = true; publish_hardware_status(); }
-        else if (command == naming::CMD_DEACTIVATE_IR) { ir_sensor_active = false; publish_hardware_status(); }
-        else { /* unknown */ }
-      }
-
-      // Publish command acknowledgement
-      StaticJsonDocument<160> ack;
-      ack["controller_id"] = controller_id;
-      ack["device_id"] = device;
-      ack["command"] = command;
-      ack["success"] = true;
-      ack["timestamp_ms"] = millis();
-      if (ack_duration_ms >= 0) { ack["duration_ms"] = (long)ack_duration_ms; }
-      char buf[196]; serializeJson(ack, buf, sizeof(buf));
-    // Publish ACK as an event to avoid contaminating persisted status/state
-    String ackTopic = String(mqtt_namespace) + "/" + room_id + "/" + naming::CAT_EVENTS + "/" + controller_id + "/" + device + "/command_ack";
-      mqtt.get_client().publish(ackTopic.c_str(), buf, false);
-      Serial.print(F("[BoilerRmA] ACK -> "));
-      Serial.println(ackTopic); });
-  }
-
   Serial.println(F("[BoilerRmA] Ready - awaiting Sentient commands"));
 }
 
@@ -512,10 +344,140 @@ void loop()
 }
 
 // ══════════════════════════════════════════════════════════════════════════════
-// SECTION 4: (Legacy handler removed) — All commands are routed via topic-based
-//            device+command parsing inside the MQTT callback set in setup().
+// SECTION 4: COMMAND HANDLER
 // ══════════════════════════════════════════════════════════════════════════════
 
+void handle_mqtt_command(const char *command, const JsonDocument &payload, void *ctx)
+{
+  // Every command here is device-scoped: commands/<controller>/<device>/<command>
+  const String device = mqtt.commandDevice();
+  if (device.length() == 0)
+  {
+    return; // Not for us
+  }
+  const String cmd = command;
+  // Serial observability for command receipt
+  Serial.print(F("[BoilerRmA] CMD recv: device="));
+  Serial.print(device);
+  Serial.print(F(" command="));
+  Serial.println(command);
+
+  long ack_duration_ms = -1; // will be included in ACK if >= 0
+
+  // Dispatch
+  // Intro TV
+  if (device == naming::DEV_INTRO_TV) {
+    if (cmd == naming::CMD_TV_POWER_ON)  { tv_power_on = true;  digitalWrite(tv_power_pin, HIGH); publish_hardware_status(); }
+    else if (cmd == naming::CMD_TV_POWER_OFF) { tv_power_on = false; digitalWrite(tv_power_pin, LOW); publish_hardware_status(); }
+    else if (cmd == naming::CMD_TV_LIFT_UP)   { tv_lift_state = 1;  digitalWrite(tv_lift_up_pin, HIGH); digitalWrite(tv_lift_down_pin, LOW); publish_hardware_status(); }
+    else if (cmd == naming::CMD_TV_LIFT_DOWN) { tv_lift_state = -1; digitalWrite(tv_lift_down_pin, HIGH); digitalWrite(tv_lift_up_pin, LOW); publish_hardware_status(); }
+    else { /* unknown */ }
+  }
+  // Controller-level (power-off sequence)
+  else if (device == naming::DEV_CONTROLLER) {
+    if (cmd == naming::CMD_CONTROLLER_POWER_OFF_SEQUENCE) {
+      // Perform power-off sequence: set outputs to safe/off state
+      // TV
+      tv_power_on = false; digitalWrite(tv_power_pin, LOW);
+      tv_lift_state = 0; digitalWrite(tv_lift_up_pin, LOW); digitalWrite(tv_lift_down_pin, LOW);
+      // Fog system
+      fog_trigger_on = false; digitalWrite(fog_trigger_pin, LOW);
+      ultrasonic_water_on = false; digitalWrite(ultrasonic_water_pin, LOW);
+      fog_power_on = false; digitalWrite(fog_power_pin, LOW);
+      // Doors/locks to safe default (locked)
+      barrel_maglock_locked = true; digitalWrite(barrel_maglock_pin, HIGH);
+      study_door_top_locked = true; study_door_bottom_a_locked = true; study_door_bottom_b_locked = true;
+      digitalWrite(study_door_maglock_top_pin, HIGH);
+      digitalWrite(study_door_maglock_bottom_a_pin, HIGH);
+      digitalWrite(study_door_maglock_bottom_b_pin, HIGH);
+      // Lights off
+      gauge_progress_level = 0; fill_solid(leds, num_leds, CRGB::Black); FastLED.show();
+      // IR off
+      ir_sensor_active = false;
+      // Publish status and readiness
+      publish_hardware_status();
+      // Publish shutdown readiness: [client]/[room]/events/[controller]/controller/shutdown_ready
+      StaticJsonDocument<160> ready;
+      ready["controller_id"] = controller_id;
+      ready["ready"] = true;
+      ready["version"] = firmware::VERSION;
+      ready["timestamp_ms"] = millis();
+      char rbuf[196]; serializeJson(ready, rbuf, sizeof(rbuf));
+      String rTopic = String(mqtt_namespace) + "/" + room_id + "/" + naming::CAT_EVENTS + "/" + controller_id + "/" + naming::DEV_CONTROLLER + "/shutdown_ready";
+      mqtt.get_client().publish(rTopic.c_str(), rbuf, false);
+    }
+  }
+  // Fog Machine
+  else if (device == naming::DEV_BOILER_FOG_MACHINE) {
+    if (cmd == naming::CMD_FOG_POWER_ON)  { fog_power_on = true;  digitalWrite(fog_power_pin, HIGH); publish_hardware_status(); }
+    else if (cmd == naming::CMD_FOG_POWER_OFF) { fog_power_on = false; digitalWrite(fog_power_pin, LOW); publish_hardware_status(); }
+    else if (cmd == naming::CMD_FOG_TRIGGER)   {
+      // Option A: allow optional duration_ms (default 500ms), clamped to [100, 3000]
+      long durationMs = 500;
+      if (!payload["duration_ms"].isNull()) {
+        durationMs = payload["duration_ms"].as<long>();
+      } else if (!payload["duration"].isNull()) {
+        durationMs = payload["duration"].as<long>();
+      } else if (!payload["value"].isNull()) {
+        // Accept numeric or numeric string in "value" (a plain-text payload arrives as {"value": text})
+        if (payload["value"].is<long>()) durationMs = payload["value"].as<long>();
+        else {
+          String vs = payload["value"].as<String>();
+          durationMs = vs.toInt();
+        }
+      }
+      if (durationMs < 100) durationMs = 100;
+      if (durationMs > 3000) durationMs = 3000;
+      ack_duration_ms = durationMs;
+      Serial.print(F("[BoilerRmA] Fog trigger pulse: ")); Serial.print(durationMs); Serial.println(F(" ms"));
+      fog_trigger_on = true; digitalWrite(fog_trigger_pin, HIGH);
+      delay((unsigned long)durationMs);
+      fog_trigger_on = false; digitalWrite(fog_trigger_pin, LOW);
+      publish_hardware_status();
+    }
+    else if (cmd == naming::CMD_ULTRASONIC_ON)  { ultrasonic_water_on = true;  digitalWrite(ultrasonic_water_pin, HIGH); publish_hardware_status(); }
+    else if (cmd == naming::CMD_ULTRASONIC_OFF) { ultrasonic_water_on = false; digitalWrite(ultrasonic_water_pin, LOW); publish_hardware_status(); }
+    else { /* unknown */ }
+  }
+  // Study Door (group)
+  else if (device == naming::DEV_STUDY_DOOR) {
+    if (cmd == naming::CMD_DOOR_LOCK)   { study_door_top_locked = true; study_door_bottom_a_locked = true; study_door_bottom_b_locked = true; digitalWrite(study_door_maglock_top_pin, HIGH); digitalWrite(study_door_maglock_bottom_a_pin, HIGH); digitalWrite(study_door_maglock_bottom_b_pin, HIGH); publish_hardware_status(); }
+    else if (cmd == naming::CMD_DOOR_UNLOCK) { study_door_top_locked = false; study_door_bottom_a_locked = false; study_door_bottom_b_locked = false; digitalWrite(study_door_maglock_top_pin, LOW); digitalWrite(study_door_maglock_bottom_a_pin, LOW); digitalWrite(study_door_maglock_bottom_b_pin, LOW); publish_hardware_status(); }
+    else { /* unknown */ }
+  }
+  // Gauge Progress Chest
+  else if (device == naming::DEV_GAUGE_PROGRESS_CHEST) {
+    if (cmd == naming::CMD_GAUGE_CLEAR) { gauge_progress_level = 0; fill_solid(leds, num_leds, CRGB::Black); }
+    else if (cmd == naming::CMD_GAUGE_SOLVED_1) { gauge_progress_level = 1; fill_solid(leds, 15, CRGB::Green); fill_solid(leds + 15, num_leds - 15, CRGB::Black); }
+    else if (cmd == naming::CMD_GAUGE_SOLVED_2) { gauge_progress_level = 2; fill_solid(leds, 30, CRGB::Green); fill_solid(leds + 30, num_leds - 30, CRGB::Black); }
+    else if (cmd == naming::CMD_GAUGE_SOLVED_3) { gauge_progress_level = 3; fill_solid(leds, 45, CRGB::Green); fill_solid(leds + 45, num_leds - 45, CRGB::Black); }
+    FastLED.show(); publish_hardware_status();
+  }
+  // Barrel (maglock + IR control)
+  else if (device == naming::DEV_BOILER_ROOM_BARREL) {
+    if (cmd == naming::CMD_BARREL_UNLOCK) { barrel_maglock_locked = false; digitalWrite(barrel_maglock_pin, LOW); publish_hardware_status(); }
+    else if (cmd == naming::CMD_BARREL_LOCK) { barrel_maglock_locked = true; digitalWrite(barrel_maglock_pin, HIGH); publish_hardware_status(); }
+    else if (cmd == naming::CMD_ACTIVATE_IR) { ir_sensor_active = true; publish_hardware_status(); }
+    else if (cmd == naming::CMD_DEACTIVATE_IR) { ir_sensor_active = false; publish_hardware_status(); }
+    else { /* unknown */ }
+  }
+
+  // Publish command acknowledgement
+  StaticJsonDocument<160> ack;
+  ack["controller_id"] = controller_id;
+  ack["device_id"] = device;
+  ack["command"] = command;
+  ack["success"] = true;
+  ack["timestamp_ms"] = millis();
+  if (ack_duration_ms >= 0) { ack["duration_ms"] = (long)ack_duration_ms; }
+  char buf[196]; serializeJson(ack, buf, sizeof(buf));
+  // Publish ACK as an event to avoid contaminating persisted status/state
+  String ackTopic = String(mqtt_namespace) + "/" + room_id + "/" + naming::CAT_EVENTS + "/" + controller_id + "/" + device + "/command_ack";
+  mqtt.get_client().publish(ackTopic.c_str(), buf, false);
+  Serial.print(F("[BoilerRmA] ACK -> "));
+  Serial.println(ackTopic);
+}
+
 // ──────────────────────────────────────────────────────────────────────────────
 // Hardware Execution Functions (called by command handler)
 // ──────────────────────────────────────────────────────────────────────────────
@@ -20,6 +20,7 @@
 #include <SentientMQTT.h>
 #include <SentientDeviceRegistry.h>
 #include <SentientCapabilityManifest.h>
+#include <SentientCommandRouter.h>
 #include <ArduinoJson.h>
 #include <FastLED.h>
 #include "controller_naming.h"
@@ -188,6 +189,54 @@ int lastEncoderTopBCount = 0;
 char lastTelemetry[200] = "";
 bool telemetryInitialized = false;
 
+// ═══════════════════════════════════════════════════════════════
+//                        COMMAND ROUTING
+// ═══════════════════════════════════════════════════════════════
+
+void activateHandler(const char *data);
+void stateHandler(const char *data);
+void pilasterHandler(const char *data);
+void fogMachineHandler(const char *data);
+void blacklightHandler(const char *data);
+void operatorMaglockHandler(const char *data);
+void woodDoorMaglockHandler(const char *data);
+void exitDoorFWDHandler(const char *data);
+void exitDoorRWDHandler(const char *data);
+void metalDoorFWDHandler(const char *data);
+void metalDoorRWDHandler(const char *data);
+void laserLightHandler(const char *data);
+
+// Every clock command carries a string value; the command callback checks that before dispatching
+void on_activate(const JsonDocument &payload, void *) { activateHandler(payload.as<const char *>()); }
+void on_state(const JsonDocument &payload, void *) { stateHandler(payload.as<const char *>()); }
+void on_pilaster(const JsonDocument &payload, void *) { pilasterHandler(payload.as<const char *>()); }
+void on_fog_machine(const JsonDocument &payload, void *) { fogMachineHandler(payload.as<const char *>()); }
+void on_blacklights(const JsonDocument &payload, void *) { blacklightHandler(payload.as<const char *>()); }
+void on_operator_maglock(const JsonDocument &payload, void *) { operatorMaglockHandler(payload.as<const char *>()); }
+void on_wood_door_maglock(const JsonDocument &payload, void *) { woodDoorMaglockHandler(payload.as<const char *>()); }
+void on_exit_door_fwd(const JsonDocument &payload, void *) { exitDoorFWDHandler(payload.as<const char *>()); }
+void on_exit_door_rwd(const JsonDocument &payload, void *) { exitDoorRWDHandler(payload.as<const char *>()); }
+void on_metal_door_fwd(const JsonDocument &payload, void *) { metalDoorFWDHandler(payload.as<const char *>()); }
+void on_metal_door_rwd(const JsonDocument &payload, void *) { metalDoorRWDHandler(payload.as<const char *>()); }
+void on_laser_lights(const JsonDocument &payload, void *) { laserLightHandler(payload.as<const char *>()); }
+
+// Perfect-hash dispatch table, built at compile time from the command names
+constexpr SentientCommandRoute command_routes[] = {
+    {"activate", on_activate},
+    {"state", on_state},
+    {"pilaster", on_pilaster},
+    {"fogMachine", on_fog_machine},
+    {"blacklights", on_blacklights},
+    {"OperatorMaglock", on_operator_maglock},
+    {"WoodDoorMaglock", on_wood_door_maglock},
+    {"ExitDoorFWD", on_exit_door_fwd},
+    {"ExitDoorRWD", on_exit_door_rwd},
+    {"MetalDoorFWD", on_metal_door_fwd},
+    {"MetalDoorRWD", on_metal_door_rwd},
+    {"laserLights", on_laser_lights}};
+
+constexpr auto command_router = makeSentientCommandRouter(command_routes);
+
 // ═══════════════════════════════════════════════════════════════
 //                          SETUP & LOOP
 // ═══════════════════════════════════════════════════════════════
@@ -246,32 +295,7 @@ void setup()
     sentient.setCommandCallback([](const char *command, const JsonDocument &payload, void *context)
                                 {
         if (payload.is<const char*>()) {
-            const char* value = payload.as<const char*>();
-            if (strcmp(command, "activate") == 0) {
-                activateHandler(value);
-            } else if (strcmp(command, "state") == 0) {
-                stateHandler(value);
-            } else if (strcmp(command, "pilaster") == 0) {
-                pilasterHandler(value);
-            } else if (strcmp(command, "fogMachine") == 0) {
-                fogMachineHandler(value);
-            } else if (strcmp(command, "blacklights") == 0) {
-                blacklightHandler(value);
-            } else if (strcmp(command, "OperatorMaglock") == 0) {
-                operatorMaglockHandler(value);
-            } else if (strcmp(command, "WoodDoorMaglock") == 0) {
-                woodDoorMaglockHandler(value);
-            } else if (strcmp(command, "ExitDoorFWD") == 0) {
-                exitDoorFWDHandler(value);
-            } else if (strcmp(command, "ExitDoorRWD") == 0) {
-                exitDoorRWDHandler(value);
-            } else if (strcmp(command, "MetalDoorFWD") == 0) {
-                metalDoorFWDHandler(value);
-            } else if (strcmp(command, "MetalDoorRWD") == 0) {
-                metalDoorRWDHandler(value);
-            } else if (strcmp(command, "laserLights") == 0) {
-                laserLightHandler(value);
-            }
+            command_router.dispatch(command, payload, context);
         } });
 
     Serial.println("Clock Puzzle Controller Ready");
@@ -334,6 +358,7 @@ void setStepperTarget(int motor, long target)
         gearStepsRemaining = abs(target - gearPosition);
         break;
     }
+    SentientTrace::record(SentientTrace::MotionStart, motor, static_cast<uint32_t>(target));
 
     // Reset acceleration when new target is set
     currentStepInterval = maxStepInterval; // Start slow
@@ -407,8 +432,8 @@ void stepMotor(int motor, bool direction)
     static int stepCount[3] = {0, 0, 0};
     if (stepCount[motor] < 10) // Only print first 10 steps per motor to avoid spam
     {
-        Serial.println("Motor " + String(motor) + " step " + String(stepCount[motor]) +
-                       " - DIR:" + String(direction) + " on pins " + String(stepPos) + "/" + String(stepNeg));
+        SENTIENT_LOG_DEBUG("Motor %d step %d - DIR:%d on pins %d/%d", motor, stepCount[motor], direction, stepPos,
+                           stepNeg);
     }
     stepCount[motor]++;
 
@@ -489,6 +514,10 @@ void runSteppers()
             stepMotor(0, direction);
             minuteStepsRemaining = abs(minuteTarget - minutePosition);
             handIsMoving = true;
+            if (minuteStepsRemaining == 0)
+            {
+                SentientTrace::record(SentientTrace::MotionStop, 0, static_cast<uint32_t>(minutePosition));
+            }
         }
 
         // Move hour motor toward target
@@ -498,6 +527,10 @@ void runSteppers()
             stepMotor(1, direction);
             hourStepsRemaining = abs(hourTarget - hourPosition);
             handIsMoving = true;
+            if (hourStepsRemaining == 0)
+            {
+                SentientTrace::record(SentientTrace::MotionStop, 1, static_cast<uint32_t>(hourPosition));
+            }
         }
 
         // Move gear motor toward target OR animate gears when hands are moving
@@ -506,6 +539,10 @@ void runSteppers()
             bool direction = gearTarget > gearPosition;
             stepMotor(2, direction);
             gearStepsRemaining = abs(gearTarget - gearPosition);
+            if (gearStepsRemaining == 0)
+            {
+                SentientTrace::record(SentientTrace::MotionStop, 2, static_cast<uint32_t>(gearPosition));
+            }
         }
         else if (handIsMoving)
         {
@@ -26,6 +26,7 @@
  */
 
 #include <SentientMQTT.h>
+#include <SentientCommandRouter.h>
 #include <SentientDeviceRegistry.h>
 #include <SentientCapabilityManifest.h>
 #include <AccelStepper.h>
@@ -295,6 +296,20 @@ void build_capability_manifest();
 SentientMQTTConfig build_mqtt_config();
 bool build_heartbeat_payload(JsonDocument &doc, void *ctx);
 void handle_mqtt_command(const char *command, const JsonDocument &payload, void *ctx);
+void on_activate_gauges(const JsonDocument &payload, void *ctx);
+void on_deactivate_gauges(const JsonDocument &payload, void *ctx);
+void on_adjust_gauge_zero(const JsonDocument &payload, void *ctx);
+void on_set_current_as_zero(const JsonDocument &payload, void *ctx);
+void on_ceiling_off(const JsonDocument &payload, void *ctx);
+void on_ceiling_pattern_1(const JsonDocument &payload, void *ctx);
+void on_ceiling_pattern_2(const JsonDocument &payload, void *ctx);
+void on_ceiling_pattern_3(const JsonDocument &payload, void *ctx);
+void on_flicker_off(const JsonDocument &payload, void *ctx);
+void on_flicker_mode_2(const JsonDocument &payload, void *ctx);
+void on_flicker_mode_5(const JsonDocument &payload, void *ctx);
+void on_flicker_mode_8(const JsonDocument &payload, void *ctx);
+void on_gauge_leds_on(const JsonDocument &payload, void *ctx);
+void on_gauge_leds_off(const JsonDocument &payload, void *ctx);
 void update_gauge_tracking();
 void monitor_sensors();
 void publish_sensor_changes(bool force_publish);
@@ -310,7 +325,29 @@ void set_flicker_mode_2();
 void set_flicker_mode_5();
 void set_flicker_mode_8();
 void update_gauge_flicker();
-String extract_command_value(const JsonDocument &payload);
+
+// ============================================================================
+// COMMAND ROUTING
+// ============================================================================
+
+// Perfect-hash dispatch table, built at compile time from the command slugs
+constexpr SentientCommandRoute command_routes[] = {
+    {CMD_ACTIVATE_GAUGES, on_activate_gauges},
+    {CMD_DEACTIVATE_GAUGES, on_deactivate_gauges},
+    {CMD_ADJUST_GAUGE_ZERO, on_adjust_gauge_zero},
+    {CMD_SET_CURRENT_AS_ZERO, on_set_current_as_zero},
+    {CMD_CEILING_OFF, on_ceiling_off},
+    {CMD_CEILING_PATTERN_1, on_ceiling_pattern_1},
+    {CMD_CEILING_PATTERN_2, on_ceiling_pattern_2},
+    {CMD_CEILING_PATTERN_3, on_ceiling_pattern_3},
+    {CMD_FLICKER_OFF, on_flicker_off},
+    {CMD_FLICKER_MODE_2, on_flicker_mode_2},
+    {CMD_FLICKER_MODE_5, on_flicker_mode_5},
+    {CMD_FLICKER_MODE_8, on_flicker_mode_8},
+    {CMD_GAUGE_LEDS_ON, on_gauge_leds_on},
+    {CMD_GAUGE_LEDS_OFF, on_gauge_leds_off}};
+
+constexpr auto command_router = makeSentientCommandRouter(command_routes);
 
 // ============================================================================
 // MQTT OBJECTS
@@ -520,148 +557,158 @@ bool build_heartbeat_payload(JsonDocument &doc, void * /*ctx*/)
 }
 
 // ============================================================================
-// COMMAND HANDLER
+// COMMAND HANDLERS
 // ============================================================================
 
-void handle_mqtt_command(const char *command, const JsonDocument &payload, void * /*ctx*/)
+void handle_mqtt_command(const char *command, const JsonDocument &payload, void *ctx)
 {
-    String value = extract_command_value(payload);
-    String cmd = String(command);
-
     Serial.print(F("[COMMAND] Received: "));
     Serial.print(command);
     Serial.print(F(" Value: "));
-    Serial.println(value);
-
-    // =========================================
-    // GAUGE 6 COMMANDS
-    // =========================================
+    serializeJson(payload["value"], Serial); // Straight from the document, no String copy
+    Serial.println();
 
-    if (cmd.equals(CMD_ACTIVATE_GAUGES))
+    if (!command_router.dispatch(command, payload, ctx))
     {
-        digitalWrite(gauge_6_enable_pin, LOW); // Enable stepper (active LOW)
-        gauges_active = true;
-        Serial.println(F("[GAUGE 6] Activated - tracking valve position"));
-        publish_hardware_status();
-    }
-    else if (cmd.equals(CMD_DEACTIVATE_GAUGES))
-    {
-        gauges_active = false;
-        stepper_6.moveTo(gauge_min_steps);
-        Serial.println(F("[GAUGE 6] Deactivated - moving to zero"));
-        publish_hardware_status();
+        Serial.print(F("[WARNING] Unknown command: "));
+        Serial.println(command);
     }
-    else if (cmd.equals(CMD_ADJUST_GAUGE_ZERO))
-    {
-        if (!payload["gauge"].is<int>() || !payload["steps"].is<int>())
-        {
-            Serial.println(F("[ERROR] adjust_gauge_zero requires 'gauge' and 'steps' parameters"));
-            return;
-        }
+}
 
-        int gauge_num = payload["gauge"];
-        int steps = payload["steps"];
+// =========================================
+// GAUGE 6 COMMANDS
+// =========================================
 
-        if (gauge_num == 6)
-        {
-            stepper_6.move(steps);
-            Serial.print(F("[CALIBRATION] Adjusting Gauge 6 by "));
-            Serial.print(steps);
-            Serial.println(F(" steps"));
-        }
-    }
-    else if (cmd.equals(CMD_SET_CURRENT_AS_ZERO))
-    {
-        if (!payload["gauge"].is<int>())
-        {
-            Serial.println(F("[ERROR] set_current_as_zero requires 'gauge' parameter"));
-            return;
-        }
+void on_activate_gauges(const JsonDocument & /*payload*/, void * /*ctx*/)
+{
+    digitalWrite(gauge_6_enable_pin, LOW); // Enable stepper (active LOW)
+    gauges_active = true;
+    Serial.println(F("[GAUGE 6] Activated - tracking valve position"));
+    publish_hardware_status();
+}
 
-        int gauge_num = payload["gauge"];
+void on_deactivate_gauges(const JsonDocument & /*payload*/, void * /*ctx*/)
+{
+    gauges_active = false;
+    stepper_6.moveTo(gauge_min_steps);
+    Serial.println(F("[GAUGE 6] Deactivated - moving to zero"));
+    publish_hardware_status();
+}
 
-        if (gauge_num == 6)
-        {
-            stepper_6.setCurrentPosition(gauge_min_steps);
-            save_gauge_position(6);
-            Serial.println(F("[CALIBRATION] Gauge 6 - current position set as zero"));
-        }
+void on_adjust_gauge_zero(const JsonDocument &payload, void * /*ctx*/)
+{
+    if (!payload["gauge"].is<int>() || !payload["steps"].is<int>())
+    {
+        Serial.println(F("[ERROR] adjust_gauge_zero requires 'gauge' and 'steps' parameters"));
+        return;
     }
 
-    // =========================================
-    // CEILING LED COMMANDS
-    // =========================================
+    int gauge_num = payload["gauge"];
+    int steps = payload["steps"];
 
-    else if (cmd.equals(CMD_CEILING_OFF))
-    {
-        set_ceiling_off();
-        Serial.println(F("[CEILING] All LEDs off"));
-    }
-    else if (cmd.equals(CMD_CEILING_PATTERN_1))
+    if (gauge_num == 6)
     {
-        set_ceiling_pattern_1();
-        Serial.println(F("[CEILING] Pattern 1"));
+        stepper_6.move(steps);
+        Serial.print(F("[CALIBRATION] Adjusting Gauge 6 by "));
+        Serial.print(steps);
+        Serial.println(F(" steps"));
     }
-    else if (cmd.equals(CMD_CEILING_PATTERN_2))
-    {
-        set_ceiling_pattern_2();
-        Serial.println(F("[CEILING] Pattern 2"));
-    }
-    else if (cmd.equals(CMD_CEILING_PATTERN_3))
+}
+
+void on_set_current_as_zero(const JsonDocument &payload, void * /*ctx*/)
+{
+    if (!payload["gauge"].is<int>())
     {
-        set_ceiling_pattern_3();
-        Serial.println(F("[CEILING] Pattern 3"));
+        Serial.println(F("[ERROR] set_current_as_zero requires 'gauge' parameter"));
+        return;
     }
 
-    // =========================================
-    // GAUGE INDICATOR LED COMMANDS
-    // =========================================
+    int gauge_num = payload["gauge"];
 
-    else if (cmd.equals(CMD_FLICKER_OFF))
+    if (gauge_num == 6)
     {
-        set_flicker_off();
-        Serial.println(F("[GAUGE LEDS] Flicker off"));
+        stepper_6.setCurrentPosition(gauge_min_steps);
+        save_gauge_position(6);
+        Serial.println(F("[CALIBRATION] Gauge 6 - current position set as zero"));
     }
-    else if (cmd.equals(CMD_FLICKER_MODE_2))
-    {
-        set_flicker_mode_2();
-        Serial.println(F("[GAUGE LEDS] Flicker mode 1"));
-    }
-    else if (cmd.equals(CMD_FLICKER_MODE_5))
-    {
-        set_flicker_mode_5();
-        Serial.println(F("[GAUGE LEDS] Flicker mode 2"));
-    }
-    else if (cmd.equals(CMD_FLICKER_MODE_8))
-    {
-        set_flicker_mode_8();
-        Serial.println(F("[GAUGE LEDS] Flicker mode 3"));
-    }
-    else if (cmd.equals(CMD_GAUGE_LEDS_ON))
-    {
-        for (int i = 0; i < 7; i++)
-        {
-            gauge_flicker[i].enabled = false;
-            gauge_leds[i][0] = CRGB(color_gauge_base);
-        }
-        FastLED.show();
-        Serial.println(F("[GAUGE LEDS] All ON (base color)"));
-    }
-    else if (cmd.equals(CMD_GAUGE_LEDS_OFF))
+}
+
+// =========================================
+// CEILING LED COMMANDS
+// =========================================
+
+void on_ceiling_off(const JsonDocument & /*payload*/, void * /*ctx*/)
+{
+    set_ceiling_off();
+    Serial.println(F("[CEILING] All LEDs off"));
+}
+
+void on_ceiling_pattern_1(const JsonDocument & /*payload*/, void * /*ctx*/)
+{
+    set_ceiling_pattern_1();
+    Serial.println(F("[CEILING] Pattern 1"));
+}
+
+void on_ceiling_pattern_2(const JsonDocument & /*payload*/, void * /*ctx*/)
+{
+    set_ceiling_pattern_2();
+    Serial.println(F("[CEILING] Pattern 2"));
+}
+
+void on_ceiling_pattern_3(const JsonDocument & /*payload*/, void * /*ctx*/)
+{
+    set_ceiling_pattern_3();
+    Serial.println(F("[CEILING] Pattern 3"));
+}
+
+// =========================================
+// GAUGE INDICATOR LED COMMANDS
+// =========================================
+
+void on_flicker_off(const JsonDocument & /*payload*/, void * /*ctx*/)
+{
+    set_flicker_off();
+    Serial.println(F("[GAUGE LEDS] Flicker off"));
+}
+
+void on_flicker_mode_2(const JsonDocument & /*payload*/, void * /*ctx*/)
+{
+    set_flicker_mode_2();
+    Serial.println(F("[GAUGE LEDS] Flicker mode 1"));
+}
+
+void on_flicker_mode_5(const JsonDocument & /*payload*/, void * /*ctx*/)
+{
+    set_flicker_mode_5();
+    Serial.println(F("[GAUGE LEDS] Flicker mode 2"));
+}
+
+void on_flicker_mode_8(const JsonDocument & /*payload*/, void * /*ctx*/)
+{
+    set_flicker_mode_8();
+    Serial.println(F("[GAUGE LEDS] Flicker mode 3"));
+}
+
+void on_gauge_leds_on(const JsonDocument & /*payload*/, void * /*ctx*/)
+{
+    for (int i = 0; i < 7; i++)
     {
-        for (int i = 0; i < 7; i++)
-        {
-            gauge_flicker[i].enabled = false;
-            gauge_leds[i][0] = CRGB::Black;
-        }
-        FastLED.show();
-        Serial.println(F("[GAUGE LEDS] All OFF"));
+        gauge_flicker[i].enabled = false;
+        gauge_leds[i][0] = CRGB(color_gauge_base);
     }
-    else
+    FastLED.show();
+    Serial.println(F("[GAUGE LEDS] All ON (base color)"));
+}
+
+void on_gauge_leds_off(const JsonDocument & /*payload*/, void * /*ctx*/)
+{
+    for (int i = 0; i < 7; i++)
     {
-        Serial.print(F("[WARNING] Unknown command: "));
-        Serial.println(cmd);
+        gauge_flicker[i].enabled = false;
+        gauge_leds[i][0] = CRGB::Black;
     }
+    FastLED.show();
+    Serial.println(F("[GAUGE LEDS] All OFF"));
 }
 
 // ============================================================================
@@ -1027,16 +1074,3 @@ void publish_hardware_status()
 
     mqtt.publishJson(CAT_SENSORS, (String(DEV_GAUGE_6) + "/" + SENSOR_VALVE_6_PSI).c_str(), doc);
 }
-
-// ============================================================================
-// UTILITY FUNCTIONS
-// ============================================================================
-
-String extract_command_value(const JsonDocument &payload)
-{
-    if (payload.containsKey("value"))
-    {
-        return payload["value"].as<String>();
-    }
-    return "";
-}
@@ -163,21 +163,10 @@ void loop()
         }
     }
 
-    Serial.print(counterA);
-    Serial.print(":");
-    Serial.print(digitalRead(FWD1));
-    Serial.print(":");
-    Serial.print(digitalRead(FWD2));
-    Serial.print(":");
-    Serial.print(digitalRead(FWD3));
-    Serial.print(":");
-    Serial.print(digitalRead(NEUTRAL));
-    Serial.print(":");
-    Serial.print(digitalRead(REV1));
-    Serial.print(":");
-    Serial.print(digitalRead(REV2));
-    Serial.print(":");
-    Serial.println(digitalRead(REV3));
+    // Per-loop input trace; compiled out unless SENTIENT_LOG_LEVEL is raised to DEBUG
+    SENTIENT_LOG_DEBUG("%ld:%d:%d:%d:%d:%d:%d:%d", counterA, digitalRead(FWD1), digitalRead(FWD2),
+                       digitalRead(FWD3), digitalRead(NEUTRAL), digitalRead(REV1), digitalRead(REV2),
+                       digitalRead(REV3));
 
     if (digitalRead(NEUTRAL) == LOW)
     {
@@ -208,6 +197,13 @@ void loop()
         throttle = -3;
     }
 
+    static int lastThrottle = 0;
+    if (throttle != lastThrottle)
+    {
+        SentientTrace::record(SentientTrace::SensorEdge, 0, static_cast<uint32_t>(throttle));
+        lastThrottle = throttle;
+    }
+
     // Send telemetry with current sensor readings
     char telemetryData[32];
     sprintf(telemetryData, "%ld:%d", counterA, throttle);
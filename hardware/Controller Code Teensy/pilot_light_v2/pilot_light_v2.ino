@@ -28,7 +28,8 @@
 
 #include <SentientCapabilityManifest.h>
 #include <SentientMQTT.h>
-#include <SentientDeviceRegistry.h>
+#include <SentientDeviceTable.h>
+#include <SentientManifestImage.h>
 #include <ArduinoJson.h>
 #include <FastLED.h>
 #include <Adafruit_TCS34725.h>
@@ -121,75 +122,92 @@ const unsigned long sensor_publish_interval_ms = 60000; // Publish every 60 seco
 // ============================================================================
 
 // Define command arrays
-const char *fire_leds_commands[] = {
+constexpr const char *fire_leds_commands[] = {
     naming::CMD_FIRE_LEDS_ON,
     naming::CMD_FIRE_LEDS_OFF};
 
-const char *monitor_commands[] = {
+constexpr const char *monitor_commands[] = {
     naming::CMD_MONITOR_ON,
     naming::CMD_MONITOR_OFF};
 
-const char *newell_commands[] = {
+constexpr const char *newell_commands[] = {
     naming::CMD_NEWELL_POWER_ON,
     naming::CMD_NEWELL_POWER_OFF};
 
-const char *flange_commands[] = {
+constexpr const char *flange_commands[] = {
     naming::CMD_FLANGE_ON,
     naming::CMD_FLANGE_OFF};
 
-const char *controller_commands[] = {
+constexpr const char *controller_commands[] = {
     naming::CMD_RESET,
     naming::CMD_REQUEST_STATUS};
 
 // Define sensor arrays
-const char *color_sensor_sensors[] = {
+constexpr const char *color_sensor_sensors[] = {
     naming::SENSOR_COLOR_TEMP,
     naming::SENSOR_LUX};
 
 // Create device definitions with canonical IDs and friendly names
-SentientDeviceDef dev_fire_leds(
+constexpr SentientDeviceDef dev_fire_leds(
     naming::DEV_FIRE_LEDS,
     naming::FRIENDLY_FIRE_LEDS,
     "led_strip",
     fire_leds_commands, 2);
 
-SentientDeviceDef dev_monitor_relay(
+constexpr SentientDeviceDef dev_monitor_relay(
     naming::DEV_MONITOR_POWER_RELAY,
     naming::FRIENDLY_MONITOR_RELAY,
     "relay",
     monitor_commands, 2);
 
-SentientDeviceDef dev_newell_relay(
+constexpr SentientDeviceDef dev_newell_relay(
     naming::DEV_NEWELL_POWER_RELAY,
     naming::FRIENDLY_NEWELL_RELAY,
     "relay",
     newell_commands, 2);
 
-SentientDeviceDef dev_flange_leds(
+constexpr SentientDeviceDef dev_flange_leds(
     naming::DEV_FLANGE_LEDS,
     naming::FRIENDLY_FLANGE_LEDS,
     "led_strip",
     flange_commands, 2);
 
-SentientDeviceDef dev_color_sensor(
+constexpr SentientDeviceDef dev_color_sensor(
     naming::DEV_PILOTLIGHT_COLOR_SENSOR,
     naming::FRIENDLY_COLOR_SENSOR,
     "sensor",
     color_sensor_sensors, 2, true); // true = input device
 
-SentientDeviceDef dev_controller(
+constexpr SentientDeviceDef dev_controller(
     naming::DEV_CONTROLLER,
     naming::FRIENDLY_CONTROLLER,
     "controller",
     controller_commands, 2);
 
-// Create the device registry
-SentientDeviceRegistry deviceRegistry;
+// Every device, in registration order; a duplicate device ID fails the build
+SENTIENT_DEVICE_TABLE(device_table,
+                      dev_fire_leds,
+                      dev_monitor_relay,
+                      dev_newell_relay,
+                      dev_flange_leds,
+                      dev_color_sensor,
+                      dev_controller);
+
+// Controller metadata for registration
+constexpr SentientManifestController manifest_controller = {
+    naming::CONTROLLER_ID,
+    naming::CONTROLLER_FRIENDLY_NAME,
+    firmware::VERSION,
+    naming::ROOM_ID,
+    naming::CONTROLLER_ID};
+
+// Registration messages, rendered by the compiler and stored in flash
+SENTIENT_MANIFEST_IMAGE(manifest_image, manifest_controller, device_table);
+SentientManifestImageSource manifest_registration(manifest_image);
 
 // ──────────────────────────────────────────────────────────────────────────────
 // Forward Declarations
 // ──────────────────────────────────────────────────────────────────────────────
-void build_capability_manifest();
 SentientMQTTConfig build_mqtt_config();
 bool build_heartbeat_payload(JsonDocument &doc, void *ctx);
 void handle_mqtt_command(const char *command, const JsonDocument &payload, void *ctx);
@@ -204,7 +222,6 @@ bool parse_truth(const String &value);
 String extract_command_value(const JsonDocument &payload);
 
 // MQTT objects
-SentientCapabilityManifest manifest;
 SentientMQTT mqtt(build_mqtt_config());
 
 // ──────────────────────────────────────────────────────────────────────────────
@@ -316,20 +333,8 @@ void setup()
     Serial.print(F("Color sensor: "));
     Serial.println(color_sensor_available ? F("found") : F("missing"));
 
-    // Register all devices (SINGLE SOURCE OF TRUTH!)
-    Serial.println(F("[PilotLight] Registering devices..."));
-    deviceRegistry.addDevice(&dev_fire_leds);
-    deviceRegistry.addDevice(&dev_monitor_relay);
-    deviceRegistry.addDevice(&dev_newell_relay);
-    deviceRegistry.addDevice(&dev_flange_leds);
-    deviceRegistry.addDevice(&dev_color_sensor);
-    deviceRegistry.addDevice(&dev_controller);
-    deviceRegistry.printSummary();
-
-    // Build capability manifest
-    Serial.println(F("[PilotLight] Building capability manifest..."));
-    build_capability_manifest();
-    Serial.println(F("[PilotLight] Manifest built successfully"));
+    // Devices are a compile-time table (SINGLE SOURCE OF TRUTH!)
+    device_table.printSummary();
 
     // Initialize MQTT
     Serial.println(F("[PilotLight] Initializing MQTT..."));
@@ -344,6 +349,9 @@ void setup()
         mqtt.setCommandCallback(handle_mqtt_command);
         mqtt.setHeartbeatBuilder(build_heartbeat_payload);
 
+        // Registration goes out from mqtt.loop(), one record per pass, on every (re)connect
+        mqtt.setRegistration(&manifest_registration);
+
         // Wait for broker connection (max 5 seconds)
         Serial.println(F("[PilotLight] Waiting for broker connection..."));
         unsigned long connection_start = millis();
@@ -357,16 +365,6 @@ void setup()
         {
             Serial.println(F("[PilotLight] Broker connected!"));
 
-            // Register with Sentient system
-            Serial.println(F("[PilotLight] Registering with Sentient system..."));
-            if (manifest.publish_registration(mqtt.get_client(), naming::ROOM_ID, naming::CONTROLLER_ID))
-            {
-                Serial.println(F("[PilotLight] Registration successful!"));
-            }
-            else
-            {
-                Serial.println(F("[PilotLight] Registration failed - will retry later"));
-            }
 
             // Publish initial status
             publish_device_profile();
@@ -605,26 +603,6 @@ void fill_fire_frame()
 // SECTION 5: ALL OTHER FUNCTIONS
 // ============================================================================
 
-// ──────────────────────────────────────────────────────────────────────────────
-// Capability Manifest Builder
-// ──────────────────────────────────────────────────────────────────────────────
-void build_capability_manifest()
-{
-    // Controller metadata using naming constants
-    manifest.set_controller_info(
-        naming::CONTROLLER_ID,
-        naming::CONTROLLER_FRIENDLY_NAME,
-        firmware::VERSION,
-        naming::ROOM_ID,
-        naming::CONTROLLER_ID);
-
-    // Auto-generate entire manifest from device registry - ONE LINE!
-    deviceRegistry.buildManifest(manifest);
-
-    // That's it! No manual device/topic registration needed!
-    // All devices and topics are defined once in the Device Registry section above.
-}
-
 // ──────────────────────────────────────────────────────────────────────────────
 // MQTT Configuration Builder
 // ──────────────────────────────────────────────────────────────────────────────
@@ -34,6 +34,7 @@
 #endif
 
 #include <SentientCapabilityManifest.h>
+#include <SentientCommandRouter.h>
 #include <SentientMQTT.h>
 #include <SentientDeviceRegistry.h>
 #include <ArduinoJson.h>
@@ -188,6 +189,7 @@ SentientMQTTConfig build_mqtt_config();
 bool build_heartbeat_payload(JsonDocument &doc, void *ctx);
 void handle_mqtt_command(const char *command, const JsonDocument &payload, void *ctx);
 void set_relay_state(int pin, bool state, bool &state_var, const char *device_name, const char *device_id);
+void relay_command(const char *command, int pin, bool &state_var, const char *device_name, const char *device_id);
 void publish_relay_state(const char *device_id, bool state);
 void publish_hardware_status();
 void publish_full_status();
@@ -198,6 +200,78 @@ void emergency_power_off();
 const char *build_device_identifier();
 const char *get_hardware_label();
 
+// ──────────────────────────────────────────────────────────────────────────────
+// Command Routing
+// ──────────────────────────────────────────────────────────────────────────────
+// Relay routes are keyed by device; the command (power_on/power_off) rides in the context
+void on_main_lighting_24v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), main_lighting_24v_pin, main_lighting_24v_state, "Main Lighting 24V", naming::DEV_MAIN_LIGHTING_24V); }
+void on_main_lighting_12v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), main_lighting_12v_pin, main_lighting_12v_state, "Main Lighting 12V", naming::DEV_MAIN_LIGHTING_12V); }
+void on_main_lighting_5v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), main_lighting_5v_pin, main_lighting_5v_state, "Main Lighting 5V", naming::DEV_MAIN_LIGHTING_5V); }
+void on_gauges_12v_a(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), gauges_12v_a_pin, gauges_12v_a_state, "Gauges 12V A", naming::DEV_GAUGES_12V_A); }
+void on_gauges_12v_b(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), gauges_12v_b_pin, gauges_12v_b_state, "Gauges 12V B", naming::DEV_GAUGES_12V_B); }
+void on_gauges_5v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), gauges_5v_pin, gauges_5v_state, "Gauges 5V", naming::DEV_GAUGES_5V); }
+void on_lever_boiler_5v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), lever_boiler_5v_pin, lever_boiler_5v_state, "Lever Boiler 5V", naming::DEV_LEVER_BOILER_5V); }
+void on_lever_boiler_12v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), lever_boiler_12v_pin, lever_boiler_12v_state, "Lever Boiler 12V", naming::DEV_LEVER_BOILER_12V); }
+void on_pilot_light_5v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), pilot_light_5v_pin, pilot_light_5v_state, "Pilot Light 5V", naming::DEV_PILOT_LIGHT_5V); }
+void on_kraken_controls_5v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), kraken_controls_5v_pin, kraken_controls_5v_state, "Kraken Controls 5V", naming::DEV_KRAKEN_CONTROLS_5V); }
+void on_fuse_12v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), fuse_12v_pin, fuse_12v_state, "Fuse 12V", naming::DEV_FUSE_12V); }
+void on_fuse_5v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), fuse_5v_pin, fuse_5v_state, "Fuse 5V", naming::DEV_FUSE_5V); }
+void on_syringe_24v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), syringe_24v_pin, syringe_24v_state, "Syringe 24V", naming::DEV_SYRINGE_24V); }
+void on_syringe_12v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), syringe_12v_pin, syringe_12v_state, "Syringe 12V", naming::DEV_SYRINGE_12V); }
+void on_syringe_5v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), syringe_5v_pin, syringe_5v_state, "Syringe 5V", naming::DEV_SYRINGE_5V); }
+void on_chemical_24v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), chemical_24v_pin, chemical_24v_state, "Chemical 24V", naming::DEV_CHEMICAL_24V); }
+void on_chemical_12v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), chemical_12v_pin, chemical_12v_state, "Chemical 12V", naming::DEV_CHEMICAL_12V); }
+void on_chemical_5v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), chemical_5v_pin, chemical_5v_state, "Chemical 5V", naming::DEV_CHEMICAL_5V); }
+void on_crawl_space_blacklight(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), crawl_space_blacklight_pin, crawl_space_blacklight_state, "Crawl Space Blacklight", naming::DEV_CRAWL_SPACE_BLACKLIGHT); }
+void on_floor_audio_amp(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), floor_audio_amp_pin, floor_audio_amp_state, "Floor Audio Amp", naming::DEV_FLOOR_AUDIO_AMP); }
+void on_kraken_radar_amp(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), kraken_radar_amp_pin, kraken_radar_amp_state, "Kraken Radar Amp", naming::DEV_KRAKEN_RADAR_AMP); }
+void on_vault_24v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), vault_24v_pin, vault_24v_state, "Vault 24V", naming::DEV_VAULT_24V); }
+void on_vault_12v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), vault_12v_pin, vault_12v_state, "Vault 12V", naming::DEV_VAULT_12V); }
+void on_vault_5v(const JsonDocument &, void *ctx) { relay_command(static_cast<const char *>(ctx), vault_5v_pin, vault_5v_state, "Vault 5V", naming::DEV_VAULT_5V); }
+
+void on_all_on(const JsonDocument &, void *) { all_relays_on(); }
+void on_all_off(const JsonDocument &, void *) { all_relays_off(); }
+void on_emergency_off(const JsonDocument &, void *) { emergency_power_off(); }
+void on_reset(const JsonDocument &, void *) { all_relays_off(); }
+void on_request_status(const JsonDocument &, void *) { publish_full_status(); }
+
+// Perfect-hash dispatch tables, built at compile time from the naming slugs
+constexpr SentientCommandRoute relay_routes[] = {
+    {naming::DEV_MAIN_LIGHTING_24V, on_main_lighting_24v},
+    {naming::DEV_MAIN_LIGHTING_12V, on_main_lighting_12v},
+    {naming::DEV_MAIN_LIGHTING_5V, on_main_lighting_5v},
+    {naming::DEV_GAUGES_12V_A, on_gauges_12v_a},
+    {naming::DEV_GAUGES_12V_B, on_gauges_12v_b},
+    {naming::DEV_GAUGES_5V, on_gauges_5v},
+    {naming::DEV_LEVER_BOILER_5V, on_lever_boiler_5v},
+    {naming::DEV_LEVER_BOILER_12V, on_lever_boiler_12v},
+    {naming::DEV_PILOT_LIGHT_5V, on_pilot_light_5v},
+    {naming::DEV_KRAKEN_CONTROLS_5V, on_kraken_controls_5v},
+    {naming::DEV_FUSE_12V, on_fuse_12v},
+    {naming::DEV_FUSE_5V, on_fuse_5v},
+    {naming::DEV_SYRINGE_24V, on_syringe_24v},
+    {naming::DEV_SYRINGE_12V, on_syringe_12v},
+    {naming::DEV_SYRINGE_5V, on_syringe_5v},
+    {naming::DEV_CHEMICAL_24V, on_chemical_24v},
+    {naming::DEV_CHEMICAL_12V, on_chemical_12v},
+    {naming::DEV_CHEMICAL_5V, on_chemical_5v},
+    {naming::DEV_CRAWL_SPACE_BLACKLIGHT, on_crawl_space_blacklight},
+    {naming::DEV_FLOOR_AUDIO_AMP, on_floor_audio_amp},
+    {naming::DEV_KRAKEN_RADAR_AMP, on_kraken_radar_amp},
+    {naming::DEV_VAULT_24V, on_vault_24v},
+    {naming::DEV_VAULT_12V, on_vault_12v},
+    {naming::DEV_VAULT_5V, on_vault_5v}};
+
+constexpr SentientCommandRoute controller_routes[] = {
+    {naming::CMD_ALL_ON, on_all_on},
+    {naming::CMD_ALL_OFF, on_all_off},
+    {naming::CMD_EMERGENCY_OFF, on_emergency_off},
+    {naming::CMD_RESET, on_reset},
+    {naming::CMD_REQUEST_STATUS, on_request_status}};
+
+constexpr auto relay_router = makeSentientCommandRouter(relay_routes);
+constexpr auto controller_router = makeSentientCommandRouter(controller_routes);
+
 // MQTT objects
 SentientCapabilityManifest manifest;
 SentientMQTT mqtt(build_mqtt_config());
@@ -330,6 +404,11 @@ void setup()
     {
         Serial.println(F("[PowerCtrl] MQTT initialization successful"));
         mqtt.setHeartbeatBuilder(build_heartbeat_payload);
+        mqtt.setCommandCallback(handle_mqtt_command);
+
+        // 25 devices: registration goes out from mqtt.loop(), one record per pass, on every (re)connect
+        manifest.set_registration_room(naming::ROOM_ID);
+        mqtt.setRegistration(&manifest);
 
         // Wait for broker connection (max 5 seconds)
         Serial.println(F("[PowerCtrl] Waiting for broker connection..."));
@@ -344,255 +423,6 @@ void setup()
         {
             Serial.println(F("[PowerCtrl] Broker connected!"));
 
-            // Register with Sentient system
-            Serial.println(F("[PowerCtrl] Registering with Sentient system..."));
-            if (manifest.publish_registration(mqtt.get_client(), naming::ROOM_ID, naming::CONTROLLER_ID))
-            {
-                Serial.println(F("[PowerCtrl] Registration successful!"));
-            }
-            else
-            {
-                Serial.println(F("[PowerCtrl] Registration failed - will retry later"));
-            }
-
-            // Subscribe to device-scoped commands
-            String topic = String(naming::CLIENT_ID) + "/" + naming::ROOM_ID + "/commands/" + naming::CONTROLLER_ID + "/+/+";
-            mqtt.get_client().subscribe(topic.c_str());
-            Serial.print(F("[PowerCtrl] Subscribed to: "));
-            Serial.println(topic); // Set custom message handler for device routing
-            mqtt.get_client().setCallback([](char *topic, uint8_t *payload, unsigned int length)
-                                          {
-                // Parse topic to extract device and command
-                String device, command;
-                
-                // Parse topic segments: client/room/commands/controller/device/command
-                int seg = 0;
-                const char *p = topic;
-                const char *segStart[8] = {nullptr};
-                size_t segLen[8] = {0};
-                segStart[0] = p;
-                
-                while (*p && seg < 8) {
-                    if (*p == '/') {
-                        segLen[seg] = p - segStart[seg];
-                        seg++;
-                        if (seg < 8) segStart[seg] = p + 1;
-                    }
-                    p++;
-                }
-                if (seg < 8 && segStart[seg]) {
-                    segLen[seg] = p - segStart[seg];
-                    seg++;
-                }
-                
-                auto equalsSeg = [&](int idx, const char *lit) -> bool {
-                    size_t litLen = strlen(lit);
-                    return segLen[idx] == litLen && strncmp(segStart[idx], lit, litLen) == 0;
-                };
-                
-                // Validate topic structure and extract device/command
-                if (seg >= 6 && equalsSeg(0, naming::CLIENT_ID) && equalsSeg(1, naming::ROOM_ID) && 
-                    equalsSeg(2, "commands") && equalsSeg(3, naming::CONTROLLER_ID)) {
-                    device = String(segStart[4]).substring(0, segLen[4]);
-                    command = String(segStart[5]).substring(0, segLen[5]);
-                    
-                    Serial.print(F("[PowerCtrl] Device: "));
-                    Serial.print(device);
-                    Serial.print(F(" Command: "));
-                    Serial.println(command);
-                    
-                    // Route to device-specific handlers
-                    if (device == naming::DEV_MAIN_LIGHTING_24V) {
-                        if (command == "power_on") {
-                            set_relay_state(main_lighting_24v_pin, true, main_lighting_24v_state, "Main Lighting 24V", naming::DEV_MAIN_LIGHTING_24V);
-                        } else if (command == "power_off") {
-                            set_relay_state(main_lighting_24v_pin, false, main_lighting_24v_state, "Main Lighting 24V", naming::DEV_MAIN_LIGHTING_24V);
-                        }
-                    }
-                    else if (device == naming::DEV_MAIN_LIGHTING_12V) {
-                        if (command == "power_on") {
-                            set_relay_state(main_lighting_12v_pin, true, main_lighting_12v_state, "Main Lighting 12V", naming::DEV_MAIN_LIGHTING_12V);
-                        } else if (command == "power_off") {
-                            set_relay_state(main_lighting_12v_pin, false, main_lighting_12v_state, "Main Lighting 12V", naming::DEV_MAIN_LIGHTING_12V);
-                        }
-                    }
-                    else if (device == naming::DEV_MAIN_LIGHTING_5V) {
-                        if (command == "power_on") {
-                            set_relay_state(main_lighting_5v_pin, true, main_lighting_5v_state, "Main Lighting 5V", naming::DEV_MAIN_LIGHTING_5V);
-                        } else if (command == "power_off") {
-                            set_relay_state(main_lighting_5v_pin, false, main_lighting_5v_state, "Main Lighting 5V", naming::DEV_MAIN_LIGHTING_5V);
-                        }
-                    }
-                    else if (device == naming::DEV_GAUGES_12V_A) {
-                        if (command == "power_on") {
-                            set_relay_state(gauges_12v_a_pin, true, gauges_12v_a_state, "Gauges 12V A", naming::DEV_GAUGES_12V_A);
-                        } else if (command == "power_off") {
-                            set_relay_state(gauges_12v_a_pin, false, gauges_12v_a_state, "Gauges 12V A", naming::DEV_GAUGES_12V_A);
-                        }
-                    }
-                    else if (device == naming::DEV_GAUGES_12V_B) {
-                        if (command == "power_on") {
-                            set_relay_state(gauges_12v_b_pin, true, gauges_12v_b_state, "Gauges 12V B", naming::DEV_GAUGES_12V_B);
-                        } else if (command == "power_off") {
-                            set_relay_state(gauges_12v_b_pin, false, gauges_12v_b_state, "Gauges 12V B", naming::DEV_GAUGES_12V_B);
-                        }
-                    }
-                    else if (device == naming::DEV_GAUGES_5V) {
-                        if (command == "power_on") {
-                            set_relay_state(gauges_5v_pin, true, gauges_5v_state, "Gauges 5V", naming::DEV_GAUGES_5V);
-                        } else if (command == "power_off") {
-                            set_relay_state(gauges_5v_pin, false, gauges_5v_state, "Gauges 5V", naming::DEV_GAUGES_5V);
-                        }
-                    }
-                    else if (device == naming::DEV_LEVER_BOILER_5V) {
-                        if (command == "power_on") {
-                            set_relay_state(lever_boiler_5v_pin, true, lever_boiler_5v_state, "Lever Boiler 5V", naming::DEV_LEVER_BOILER_5V);
-                        } else if (command == "power_off") {
-                            set_relay_state(lever_boiler_5v_pin, false, lever_boiler_5v_state, "Lever Boiler 5V", naming::DEV_LEVER_BOILER_5V);
-                        }
-                    }
-                    else if (device == naming::DEV_LEVER_BOILER_12V) {
-                        if (command == "power_on") {
-                            set_relay_state(lever_boiler_12v_pin, true, lever_boiler_12v_state, "Lever Boiler 12V", naming::DEV_LEVER_BOILER_12V);
-                        } else if (command == "power_off") {
-                            set_relay_state(lever_boiler_12v_pin, false, lever_boiler_12v_state, "Lever Boiler 12V", naming::DEV_LEVER_BOILER_12V);
-                        }
-                    }
-                    else if (device == naming::DEV_PILOT_LIGHT_5V) {
-                        if (command == "power_on") {
-                            set_relay_state(pilot_light_5v_pin, true, pilot_light_5v_state, "Pilot Light 5V", naming::DEV_PILOT_LIGHT_5V);
-                        } else if (command == "power_off") {
-                            set_relay_state(pilot_light_5v_pin, false, pilot_light_5v_state, "Pilot Light 5V", naming::DEV_PILOT_LIGHT_5V);
-                        }
-                    }
-                    else if (device == naming::DEV_KRAKEN_CONTROLS_5V) {
-                        if (command == "power_on") {
-                            set_relay_state(kraken_controls_5v_pin, true, kraken_controls_5v_state, "Kraken Controls 5V", naming::DEV_KRAKEN_CONTROLS_5V);
-                        } else if (command == "power_off") {
-                            set_relay_state(kraken_controls_5v_pin, false, kraken_controls_5v_state, "Kraken Controls 5V", naming::DEV_KRAKEN_CONTROLS_5V);
-                        }
-                    }
-                    else if (device == naming::DEV_FUSE_12V) {
-                        if (command == "power_on") {
-                            set_relay_state(fuse_12v_pin, true, fuse_12v_state, "Fuse 12V", naming::DEV_FUSE_12V);
-                        } else if (command == "power_off") {
-                            set_relay_state(fuse_12v_pin, false, fuse_12v_state, "Fuse 12V", naming::DEV_FUSE_12V);
-                        }
-                    }
-                    else if (device == naming::DEV_FUSE_5V) {
-                        if (command == "power_on") {
-                            set_relay_state(fuse_5v_pin, true, fuse_5v_state, "Fuse 5V", naming::DEV_FUSE_5V);
-                        } else if (command == "power_off") {
-                            set_relay_state(fuse_5v_pin, false, fuse_5v_state, "Fuse 5V", naming::DEV_FUSE_5V);
-                        }
-                    }
-                    else if (device == naming::DEV_SYRINGE_24V) {
-                        if (command == "power_on") {
-                            set_relay_state(syringe_24v_pin, true, syringe_24v_state, "Syringe 24V", naming::DEV_SYRINGE_24V);
-                        } else if (command == "power_off") {
-                            set_relay_state(syringe_24v_pin, false, syringe_24v_state, "Syringe 24V", naming::DEV_SYRINGE_24V);
-                        }
-                    }
-                    else if (device == naming::DEV_SYRINGE_12V) {
-                        if (command == "power_on") {
-                            set_relay_state(syringe_12v_pin, true, syringe_12v_state, "Syringe 12V", naming::DEV_SYRINGE_12V);
-                        } else if (command == "power_off") {
-                            set_relay_state(syringe_12v_pin, false, syringe_12v_state, "Syringe 12V", naming::DEV_SYRINGE_12V);
-                        }
-                    }
-                    else if (device == naming::DEV_SYRINGE_5V) {
-                        if (command == "power_on") {
-                            set_relay_state(syringe_5v_pin, true, syringe_5v_state, "Syringe 5V", naming::DEV_SYRINGE_5V);
-                        } else if (command == "power_off") {
-                            set_relay_state(syringe_5v_pin, false, syringe_5v_state, "Syringe 5V", naming::DEV_SYRINGE_5V);
-                        }
-                    }
-                    else if (device == naming::DEV_CHEMICAL_24V) {
-                        if (command == "power_on") {
-                            set_relay_state(chemical_24v_pin, true, chemical_24v_state, "Chemical 24V", naming::DEV_CHEMICAL_24V);
-                        } else if (command == "power_off") {
-                            set_relay_state(chemical_24v_pin, false, chemical_24v_state, "Chemical 24V", naming::DEV_CHEMICAL_24V);
-                        }
-                    }
-                    else if (device == naming::DEV_CHEMICAL_12V) {
-                        if (command == "power_on") {
-                            set_relay_state(chemical_12v_pin, true, chemical_12v_state, "Chemical 12V", naming::DEV_CHEMICAL_12V);
-                        } else if (command == "power_off") {
-                            set_relay_state(chemical_12v_pin, false, chemical_12v_state, "Chemical 12V", naming::DEV_CHEMICAL_12V);
-                        }
-                    }
-                    else if (device == naming::DEV_CHEMICAL_5V) {
-                        if (command == "power_on") {
-                            set_relay_state(chemical_5v_pin, true, chemical_5v_state, "Chemical 5V", naming::DEV_CHEMICAL_5V);
-                        } else if (command == "power_off") {
-                            set_relay_state(chemical_5v_pin, false, chemical_5v_state, "Chemical 5V", naming::DEV_CHEMICAL_5V);
-                        }
-                    }
-                    else if (device == naming::DEV_CRAWL_SPACE_BLACKLIGHT) {
-                        if (command == "power_on") {
-                            set_relay_state(crawl_space_blacklight_pin, true, crawl_space_blacklight_state, "Crawl Space Blacklight", naming::DEV_CRAWL_SPACE_BLACKLIGHT);
-                        } else if (command == "power_off") {
-                            set_relay_state(crawl_space_blacklight_pin, false, crawl_space_blacklight_state, "Crawl Space Blacklight", naming::DEV_CRAWL_SPACE_BLACKLIGHT);
-                        }
-                    }
-                    else if (device == naming::DEV_FLOOR_AUDIO_AMP) {
-                        if (command == "power_on") {
-                            set_relay_state(floor_audio_amp_pin, true, floor_audio_amp_state, "Floor Audio Amp", naming::DEV_FLOOR_AUDIO_AMP);
-                        } else if (command == "power_off") {
-                            set_relay_state(floor_audio_amp_pin, false, floor_audio_amp_state, "Floor Audio Amp", naming::DEV_FLOOR_AUDIO_AMP);
-                        }
-                    }
-                    else if (device == naming::DEV_KRAKEN_RADAR_AMP) {
-                        if (command == "power_on") {
-                            set_relay_state(kraken_radar_amp_pin, true, kraken_radar_amp_state, "Kraken Radar Amp", naming::DEV_KRAKEN_RADAR_AMP);
-                        } else if (command == "power_off") {
-                            set_relay_state(kraken_radar_amp_pin, false, kraken_radar_amp_state, "Kraken Radar Amp", naming::DEV_KRAKEN_RADAR_AMP);
-                        }
-                    }
-                    else if (device == naming::DEV_VAULT_24V) {
-                        if (command == "power_on") {
-                            set_relay_state(vault_24v_pin, true, vault_24v_state, "Vault 24V", naming::DEV_VAULT_24V);
-                        } else if (command == "power_off") {
-                            set_relay_state(vault_24v_pin, false, vault_24v_state, "Vault 24V", naming::DEV_VAULT_24V);
-                        }
-                    }
-                    else if (device == naming::DEV_VAULT_12V) {
-                        if (command == "power_on") {
-                            set_relay_state(vault_12v_pin, true, vault_12v_state, "Vault 12V", naming::DEV_VAULT_12V);
-                        } else if (command == "power_off") {
-                            set_relay_state(vault_12v_pin, false, vault_12v_state, "Vault 12V", naming::DEV_VAULT_12V);
-                        }
-                    }
-                    else if (device == naming::DEV_VAULT_5V) {
-                        if (command == "power_on") {
-                            set_relay_state(vault_5v_pin, true, vault_5v_state, "Vault 5V", naming::DEV_VAULT_5V);
-                        } else if (command == "power_off") {
-                            set_relay_state(vault_5v_pin, false, vault_5v_state, "Vault 5V", naming::DEV_VAULT_5V);
-                        }
-                    }
-                    else if (device == naming::DEV_CONTROLLER) {
-                        // Controller-level commands handled separately
-                        if (command == naming::CMD_ALL_ON) {
-                            all_relays_on();
-                        } else if (command == naming::CMD_ALL_OFF) {
-                            all_relays_off();
-                        } else if (command == naming::CMD_EMERGENCY_OFF) {
-                            emergency_power_off();
-                        } else if (command == naming::CMD_RESET) {
-                            all_relays_off();
-                        } else if (command == naming::CMD_REQUEST_STATUS) {
-                            publish_full_status();
-                        }
-                    }
-                    else {
-                        Serial.print(F("[PowerCtrl] Unknown device: "));
-                        Serial.println(device);
-                    }
-
-                    // Publish status update after command
-                    publish_hardware_status();
-                } });
-
             // Report actual physical relay states as single source of truth
             // This ensures database and cache reflect actual hardware state after power-up
             Serial.println(F("[PowerCtrl] Reporting actual relay states..."));
@@ -625,63 +455,32 @@ void loop()
 
 void handle_mqtt_command(const char *command, const JsonDocument &payload, void *ctx)
 {
-    String cmd = String(command);
+    // commands/<controller>/<device>/<command>; commands/<controller>/<command> addresses the controller
+    const char *device = mqtt.commandDevice();
+    if (device[0] == '\0')
+    {
+        device = naming::DEV_CONTROLLER;
+    }
 
-    Serial.print(F("[PowerCtrl] Command: "));
+    Serial.print(F("[PowerCtrl] Device: "));
+    Serial.print(device);
+    Serial.print(F(" Command: "));
     Serial.println(command);
 
-    // ──────────────────────────────────────────────────────────────────────────
-    // INDIVIDUAL DEVICE COMMANDS
-    // ──────────────────────────────────────────────────────────────────────────
-
-    // Main Lighting
-    if (cmd.equals(naming::CMD_POWER_ON))
+    // Route to device-specific handlers
+    if (strcmp(device, naming::DEV_CONTROLLER) == 0)
     {
-        // Command routing handled by device context from MQTT topic
-        // This simplified handler will be expanded with device-specific routing
+        // Controller-level commands handled separately
+        controller_router.dispatch(command, payload, ctx);
     }
-    else if (cmd.equals(naming::CMD_POWER_OFF))
+    else if (!relay_router.dispatch(device, payload, const_cast<char *>(command)))
     {
-        // Same as above
+        Serial.print(F("[PowerCtrl] Unknown device: "));
+        Serial.println(device);
     }
 
-    // ──────────────────────────────────────────────────────────────────────────
-    // CONTROLLER-LEVEL COMMANDS
-    // ──────────────────────────────────────────────────────────────────────────
-    else if (cmd.equals(naming::CMD_ALL_ON))
-    {
-        Serial.println(F("[PowerCtrl] ALL ON command"));
-        all_relays_on();
-        publish_hardware_status();
-    }
-    else if (cmd.equals(naming::CMD_ALL_OFF))
-    {
-        Serial.println(F("[PowerCtrl] ALL OFF command"));
-        all_relays_off();
-        publish_hardware_status();
-    }
-    else if (cmd.equals(naming::CMD_EMERGENCY_OFF))
-    {
-        Serial.println(F("[PowerCtrl] EMERGENCY OFF command"));
-        emergency_power_off();
-        publish_hardware_status();
-    }
-    else if (cmd.equals(naming::CMD_RESET))
-    {
-        Serial.println(F("[PowerCtrl] RESET command"));
-        all_relays_off();
-        publish_hardware_status();
-    }
-    else if (cmd.equals(naming::CMD_REQUEST_STATUS))
-    {
-        Serial.println(F("[PowerCtrl] Status requested"));
-        publish_full_status();
-    }
-    else
-    {
-        Serial.print(F("[PowerCtrl] Unknown command: "));
-        Serial.println(command);
-    }
+    // Publish status update after command
+    publish_hardware_status();
 }
 
 // ============================================================================
@@ -733,6 +532,19 @@ void set_relay_state(int pin, bool state, bool &state_var, const char *device_na
     }
 }
 
+// power_on / power_off for one relay; any other command leaves it as it is
+void relay_command(const char *command, int pin, bool &state_var, const char *device_name, const char *device_id)
+{
+    if (strcmp(command, naming::CMD_POWER_ON) == 0)
+    {
+        set_relay_state(pin, true, state_var, device_name, device_id);
+    }
+    else if (strcmp(command, naming::CMD_POWER_OFF) == 0)
+    {
+        set_relay_state(pin, false, state_var, device_name, device_id);
+    }
+}
+
 void all_relays_on()
 {
     set_relay_state(main_lighting_24v_pin, true, main_lighting_24v_state, "Main Lighting 24V", naming::DEV_MAIN_LIGHTING_24V);
@@ -13,13 +13,26 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <PubSubClient.h>
+#include <SentientRegistration.h>
+#include <SentientStreamWriter.h>
+
+#include <new>
+
+// Capacity of the per-device topic index a pass over the records builds; a manifest that
+// outgrows it falls back to scanning all topics for every device record
+#ifndef SENTIENT_MANIFEST_MAX_DEVICES
+#define SENTIENT_MANIFEST_MAX_DEVICES 64
+#endif
+#ifndef SENTIENT_MANIFEST_MAX_DEVICE_TOPICS
+#define SENTIENT_MANIFEST_MAX_DEVICE_TOPICS 256
+#endif
 
 #if defined(__GNUC__)
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
 #endif
 
-class SentientCapabilityManifest
+class SentientCapabilityManifest : public SentientRegistrationSource
 {
 private:
   StaticJsonDocument<4096> doc;
@@ -32,6 +45,224 @@ private:
   JsonArray current_parameters;
   JsonObject current_action;
   JsonArray current_action_parameters;
+  const char *registration_room_id = nullptr;
+
+  // Each device's add_device_topic() entries, chained in the order they were added, so a
+  // device record joins only its own topics. Built once per pass over the records; a record
+  // built outside a pass scans mqtt_topics_publish instead.
+  struct TopicIndex
+  {
+    JsonObject devices[SENTIENT_MANIFEST_MAX_DEVICES];
+    const char *device_ids[SENTIENT_MANIFEST_MAX_DEVICES]; // Looked up once, not per comparison
+    int16_t first_topic[SENTIENT_MANIFEST_MAX_DEVICES];
+    int16_t last_topic[SENTIENT_MANIFEST_MAX_DEVICES];
+    JsonObject topics[SENTIENT_MANIFEST_MAX_DEVICE_TOPICS];
+    int16_t next_topic[SENTIENT_MANIFEST_MAX_DEVICE_TOPICS];
+    size_t device_count = 0;
+    size_t topic_count = 0;
+  };
+
+  // One pass over the records, beginRecords() to endRecords(): heap-allocated for the length of a
+  // registration run only, so the manifest carries no index storage between runs. recordLength()
+  // builds the record into `record` and the writeRecord() that follows sends it without rebuilding.
+  struct RecordPass
+  {
+    TopicIndex topic_index;
+    bool indexed = false;
+    StaticJsonDocument<1024> record;
+    size_t record_index = SIZE_MAX;
+  };
+  RecordPass *record_pass = nullptr;
+  uint8_t record_pass_depth = 0;
+
+  // The record at `index`: the pass's cached one when a pass is open, else built into `scratch`
+  JsonDocument &record_at(size_t index, JsonDocument &scratch)
+  {
+    if (!record_pass)
+    {
+      build_record(index, scratch);
+      return scratch;
+    }
+    if (record_pass->record_index != index)
+    {
+      record_pass->record.clear();
+      build_record(index, record_pass->record, record_pass->indexed ? &record_pass->topic_index : nullptr);
+      record_pass->record_index = index;
+    }
+    return record_pass->record;
+  }
+
+  // FNV-1a over the records, cached until the manifest changes; every connect sends it
+  uint32_t manifest_hash = 0;
+  bool manifest_hash_valid = false;
+
+  // The manifest changed: the cached hash is stale, and mid-pass so are the cached record and
+  // the index, so the rest of the pass scans
+  void manifest_changed()
+  {
+    manifest_hash_valid = false;
+    if (record_pass)
+    {
+      record_pass->indexed = false;
+      record_pass->record_index = SIZE_MAX;
+    }
+  }
+
+  // False when the index cannot reproduce the device_id join: it overflows, or two
+  // devices share an id (the scan gives both of them every matching topic)
+  bool build_topic_index(TopicIndex &index)
+  {
+    for (JsonVariant device_variant : devices)
+    {
+      if (index.device_count >= SENTIENT_MANIFEST_MAX_DEVICES)
+      {
+        return false;
+      }
+      JsonObject device = device_variant.as<JsonObject>();
+      const char *device_id = device["device_id"];
+      if (device_id && find_indexed_device(index, device_id, 0) >= 0)
+      {
+        return false;
+      }
+      index.devices[index.device_count] = device;
+      index.device_ids[index.device_count] = device_id;
+      index.first_topic[index.device_count] = -1;
+      index.last_topic[index.device_count] = -1;
+      ++index.device_count;
+    }
+
+    int owner_hint = 0;
+    for (JsonVariant topic_variant : mqtt_topics_publish)
+    {
+      JsonObject topic = topic_variant.as<JsonObject>();
+      const char *device_id = topic["device_id"];
+      const int owner = device_id ? find_indexed_device(index, device_id, owner_hint) : -1;
+      if (owner < 0)
+      {
+        continue; // Joined to no device
+      }
+      if (index.topic_count >= SENTIENT_MANIFEST_MAX_DEVICE_TOPICS)
+      {
+        return false;
+      }
+      const int16_t slot = static_cast<int16_t>(index.topic_count++);
+      index.topics[slot] = topic;
+      index.next_topic[slot] = -1;
+      if (index.last_topic[owner] < 0)
+      {
+        index.first_topic[owner] = slot;
+      }
+      else
+      {
+        index.next_topic[index.last_topic[owner]] = slot;
+      }
+      index.last_topic[owner] = slot;
+      owner_hint = owner;
+    }
+    return true;
+  }
+
+  // Starts at `hint`: topics are normally added right after their device
+  static int find_indexed_device(const TopicIndex &index, const char *device_id, int hint)
+  {
+    for (size_t n = 0; n < index.device_count; ++n)
+    {
+      const size_t i = (static_cast<size_t>(hint) + n) % index.device_count;
+      const char *indexed_id = index.device_ids[i];
+      if (indexed_id && strcmp(indexed_id, device_id) == 0)
+      {
+        return static_cast<int>(i);
+      }
+    }
+    return -1;
+  }
+
+  static void add_topic_entry(JsonArray device_topics, JsonObject topic)
+  {
+    JsonObject topic_entry = device_topics.add<JsonObject>();
+    topic_entry["topic"] = topic["topic"];
+    topic_entry["topic_type"] = topic["topic_type"];
+  }
+
+  void build_record(size_t index, JsonDocument &record, const TopicIndex *topic_index = nullptr)
+  {
+    const char *controller_id = controller_info["unique_id"] | "UNKNOWN";
+    if (index == 0)
+    {
+      build_controller_record(controller_id, record);
+    }
+    else
+    {
+      build_device_record(controller_id, index - 1, record, topic_index);
+    }
+  }
+
+  void build_controller_record(const char *controller_id, JsonDocument &controller_doc)
+  {
+    const char *friendly_name = controller_info["friendly_name"] | "";
+    const char *firmware_version = controller_info["firmware_version"] | "";
+    const char *room_id_uuid = registration_room_id ? registration_room_id : (controller_info["room_id"] | "");
+
+    controller_doc["controller_id"] = controller_id;
+    controller_doc["room_id"] = room_id_uuid;
+    controller_doc["friendly_name"] = friendly_name;
+    controller_doc["hardware_type"] = "Teensy 4.1";
+    controller_doc["mcu_model"] = "ARM Cortex-M7";
+    controller_doc["clock_speed_mhz"] = 600;
+    controller_doc["firmware_version"] = firmware_version;
+    controller_doc["digital_pins_total"] = 55;
+    controller_doc["analog_pins_total"] = 18;
+    controller_doc["heartbeat_interval_ms"] = 5000;
+    controller_doc["controller_type"] = "microcontroller";
+    controller_doc["device_count"] = devices.size(); // Tell backend how many devices to expect
+
+    // MQTT topic structure (CRITICAL for command routing)
+    const char *mqtt_namespace = "paragon"; // Always paragon for now
+    const char *mqtt_room_id = controller_info["room_id"] | "";
+    const char *mqtt_controller_id = controller_info["controller_id"] | "";
+    controller_doc["mqtt_namespace"] = mqtt_namespace;
+    controller_doc["mqtt_room_id"] = mqtt_room_id;
+    controller_doc["mqtt_controller_id"] = mqtt_controller_id;
+  }
+
+  void build_device_record(const char *controller_id, size_t device_index, JsonDocument &device_doc,
+                           const TopicIndex *topic_index)
+  {
+    // devices[i] walks the array; the index holds every device's handle
+    JsonObject device = topic_index ? topic_index->devices[device_index] : devices[device_index].as<JsonObject>();
+    const char *device_id = device["device_id"];
+
+    device_doc["controller_id"] = controller_id;
+    device_doc["device_index"] = device_index;
+
+    // Copy all device fields
+    for (JsonPair kv : device)
+    {
+      device_doc[kv.key()] = kv.value();
+    }
+
+    // Attach mqtt_topics for this device (enables multi-command support)
+    JsonArray device_topics = device_doc.createNestedArray("mqtt_topics");
+    if (topic_index)
+    {
+      for (int16_t slot = topic_index->first_topic[device_index]; slot >= 0; slot = topic_index->next_topic[slot])
+      {
+        add_topic_entry(device_topics, topic_index->topics[slot]);
+      }
+      return;
+    }
+    for (JsonVariant topic_variant : mqtt_topics_publish)
+    {
+      JsonObject topic = topic_variant.as<JsonObject>();
+      const char *topic_device_id = topic["device_id"];
+
+      // Only include topics that belong to THIS device
+      if (topic_device_id && device_id && strcmp(topic_device_id, device_id) == 0)
+      {
+        add_topic_entry(device_topics, topic);
+      }
+    }
+  }
 
 public:
   SentientCapabilityManifest()
@@ -43,6 +274,14 @@ public:
     actions = doc.createNestedArray("actions");
   }
 
+  ~SentientCapabilityManifest()
+  {
+    delete record_pass;
+  }
+
+  SentientCapabilityManifest(const SentientCapabilityManifest &) = delete;
+  SentientCapabilityManifest &operator=(const SentientCapabilityManifest &) = delete;
+
   /**
    * Set controller metadata
    */
@@ -55,6 +294,7 @@ public:
     controller_info["firmware_version"] = firmware_version;
     controller_info["room_id"] = room_id;
     controller_info["controller_id"] = controller_id;
+    manifest_changed();
   }
 
   /**
@@ -73,6 +313,7 @@ public:
     {
       device["device_command_name"] = primary_command;
     }
+    manifest_changed();
   }
 
   /**
@@ -84,6 +325,7 @@ public:
     topic_obj["device_id"] = device_id;
     topic_obj["topic"] = topic;
     topic_obj["topic_type"] = topic_type;
+    manifest_changed();
   }
 
   /**
@@ -99,126 +341,155 @@ public:
     action["description"] = description;
   }
 
+  /**
+   * Room ID sent in the controller registration record ("room_id"); defaults
+   * to the room_id given to set_controller_info()
+   */
+  void set_registration_room(const char *room_id_uuid)
+  {
+    registration_room_id = room_id_uuid;
+    manifest_changed();
+  }
+
   /**
    * Publish registration to Sentient system in SMALL CHUNKS
    * to avoid W5500 Ethernet TX buffer overflow (2KB hardware limit)
    *
-   * Sends controller info + each device separately
+   * Sends controller info + each device separately, streamed in chunks so the
+   * client's buffer does not have to hold a whole registration message.
+   * Blocks with fixed delays between messages; SentientMQTT::setRegistration(&manifest)
+   * sends the same records from loop() without stalling the sketch.
    */
   bool publish_registration(PubSubClient &mqtt_client, const char *room_id_uuid, const char *mqtt_device_id = "Teensy 4.1")
   {
-    // Extract controller info
-    const char *controller_id = controller_info["unique_id"] | "UNKNOWN";
-    const char *friendly_name = controller_info["friendly_name"] | "";
-    const char *firmware_version = controller_info["firmware_version"] | "";
+    set_registration_room(room_id_uuid);
 
     Serial.println(F("[CapabilityManifest] Starting registration..."));
     Serial.print(F("[CapabilityManifest] Controller: "));
-    Serial.println(controller_id);
+    Serial.println(controller_info["unique_id"] | "UNKNOWN");
     Serial.print(F("[CapabilityManifest] Devices to register: "));
     Serial.println(devices.size());
 
-    // STEP 1: Publish controller metadata (small, ~800 bytes)
+    // Controller metadata (~800 bytes), then each device individually (~200-400 bytes each)
+    beginRecords();
+    const size_t records = recordCount();
+    for (size_t index = 0; index < records; index++)
     {
-      StaticJsonDocument<1024> controller_doc;
-      controller_doc["controller_id"] = controller_id;
-      controller_doc["room_id"] = room_id_uuid;
-      controller_doc["friendly_name"] = friendly_name;
-      controller_doc["hardware_type"] = "Teensy 4.1";
-      controller_doc["mcu_model"] = "ARM Cortex-M7";
-      controller_doc["clock_speed_mhz"] = 600;
-      controller_doc["firmware_version"] = firmware_version;
-      controller_doc["digital_pins_total"] = 55;
-      controller_doc["analog_pins_total"] = 18;
-      controller_doc["heartbeat_interval_ms"] = 5000;
-      controller_doc["controller_type"] = "microcontroller";
-      controller_doc["device_count"] = devices.size(); // Tell backend how many devices to expect
-
-      // MQTT topic structure (CRITICAL for command routing)
-      const char *mqtt_namespace = "paragon"; // Always paragon for now
-      const char *mqtt_room_id = controller_info["room_id"] | "";
-      const char *mqtt_controller_id = controller_info["controller_id"] | "";
-      controller_doc["mqtt_namespace"] = mqtt_namespace;
-      controller_doc["mqtt_room_id"] = mqtt_room_id;
-      controller_doc["mqtt_controller_id"] = mqtt_controller_id;
-
-      String payload;
-      serializeJson(controller_doc, payload);
-
-      Serial.print(F("[CapabilityManifest] Controller payload: "));
-      Serial.print(payload.length());
-      Serial.println(F(" bytes"));
+      StaticJsonDocument<1024> scratch;
+      JsonDocument &record = record_at(index, scratch);
 
-      if (!mqtt_client.publish("sentient/system/register/controller", payload.c_str()))
+      if (index == 0)
       {
-        Serial.println(F("[CapabilityManifest] Controller registration failed!"));
-        return false;
+        Serial.print(F("[CapabilityManifest] Controller payload: "));
       }
-      Serial.println(F("[CapabilityManifest] Controller registered"));
-      delay(100); // Give broker time to process
-    }
-
-    // STEP 2: Publish each device individually (small, ~200-400 bytes each)
-    int device_index = 0;
-    for (JsonVariant device_variant : devices)
-    {
-      JsonObject device = device_variant.as<JsonObject>();
-      const char *device_id = device["device_id"];
-
-      StaticJsonDocument<512> device_doc;
-      device_doc["controller_id"] = controller_id;
-      device_doc["device_index"] = device_index;
-
-      // Copy all device fields
-      for (JsonPair kv : device)
+      else
       {
-        device_doc[kv.key()] = kv.value();
+        Serial.print(F("[CapabilityManifest] Device "));
+        Serial.print(index - 1);
+        Serial.print(F(": "));
       }
+      Serial.print(measureJson(record));
+      Serial.println(F(" bytes"));
 
-      // Attach mqtt_topics for this device (enables multi-command support)
-      JsonArray device_topics = device_doc.createNestedArray("mqtt_topics");
-      for (JsonVariant topic_variant : mqtt_topics_publish)
+      if (!SentientStreamWriter::publish(mqtt_client, recordTopic(index), record))
       {
-        JsonObject topic = topic_variant.as<JsonObject>();
-        const char *topic_device_id = topic["device_id"];
-
-        // Only include topics that belong to THIS device
-        if (topic_device_id && device_id && strcmp(topic_device_id, device_id) == 0)
+        if (index == 0)
         {
-          JsonObject topic_entry = device_topics.add<JsonObject>();
-          topic_entry["topic"] = topic["topic"];
-          topic_entry["topic_type"] = topic["topic_type"];
+          Serial.println(F("[CapabilityManifest] Controller registration failed!"));
         }
+        else
+        {
+          Serial.print(F("[CapabilityManifest] Device "));
+          Serial.print(index - 1);
+          Serial.println(F(" registration failed!"));
+        }
+        endRecords();
+        return false;
       }
-
-      String device_payload;
-      serializeJson(device_doc, device_payload);
-
-      Serial.print(F("[CapabilityManifest] Device "));
-      Serial.print(device_index);
-      Serial.print(F(": "));
-      Serial.print(device_payload.length());
-      Serial.println(F(" bytes"));
-
-      if (!mqtt_client.publish("sentient/system/register/device", device_payload.c_str()))
+      if (index == 0)
       {
-        Serial.print(F("[CapabilityManifest] Device "));
-        Serial.print(device_index);
-        Serial.println(F(" registration failed!"));
-        return false;
+        Serial.println(F("[CapabilityManifest] Controller registered"));
       }
-
-      device_index++;
-      delay(50); // Small delay between device registrations
+      delay(index == 0 ? 100 : 50); // Give broker time to process
     }
 
+    endRecords();
+
     Serial.print(F("[CapabilityManifest] Registration complete! "));
-    Serial.print(device_index);
+    Serial.print(records - 1);
     Serial.println(F(" devices registered"));
 
     return true;
   }
 
+  // SentientRegistrationSource: record 0 is the controller, record N is device N-1
+  size_t recordCount() override
+  {
+    return devices.size() + 1;
+  }
+
+  const char *recordTopic(size_t index) override
+  {
+    return index == 0 ? "sentient/system/register/controller" : "sentient/system/register/device";
+  }
+
+  size_t recordLength(size_t index) override
+  {
+    StaticJsonDocument<1024> scratch;
+    return measureJson(record_at(index, scratch));
+  }
+
+  void writeRecord(size_t index, Print &out) override
+  {
+    StaticJsonDocument<1024> scratch;
+    serializeJson(record_at(index, scratch), out);
+  }
+
+  void beginRecords() override
+  {
+    if (record_pass_depth++ > 0)
+    {
+      return;
+    }
+    // Without the memory the pass builds every record from a scan, as before
+    record_pass = new (std::nothrow) RecordPass;
+    if (record_pass)
+    {
+      record_pass->indexed = build_topic_index(record_pass->topic_index);
+    }
+  }
+
+  void endRecords() override
+  {
+    if (record_pass_depth == 0 || --record_pass_depth > 0)
+    {
+      return;
+    }
+    delete record_pass;
+    record_pass = nullptr;
+  }
+
+  // Hashed once, not on every connect. Changes made through getManifest() are not seen.
+  uint32_t manifestHash() override
+  {
+    if (!manifest_hash_valid)
+    {
+      manifest_hash = SentientRegistrationSource::manifestHash();
+      manifest_hash_valid = true;
+    }
+    return manifest_hash;
+  }
+
+  const char *controllerId() override
+  {
+    return controller_info["unique_id"] | "UNKNOWN";
+  }
+
+  const char *firmwareVersion() override
+  {
+    return controller_info["firmware_version"] | "";
+  }
+
   /**
    * Add a device to the manifest (legacy API)
    */
@@ -230,6 +501,7 @@ public:
     device["device_type"] = deviceType;
     device["friendly_name"] = friendlyName;
     device["pin"] = pin;
+    manifest_changed();
     return *this;
   }
 
@@ -244,6 +516,7 @@ public:
     device["device_type"] = deviceType;
     device["friendly_name"] = friendlyName;
     device["pin"] = pin;
+    manifest_changed();
     return *this;
   }
 
@@ -255,6 +528,7 @@ public:
     if (devices.size() > 0)
     {
       devices[devices.size() - 1]["pin_type"] = pinType;
+      manifest_changed();
     }
     return *this;
   }
@@ -272,6 +546,7 @@ public:
         props = devices[devices.size() - 1]["properties"].to<JsonObject>();
       }
       props[key] = value;
+      manifest_changed();
     }
     return *this;
   }
@@ -286,6 +561,7 @@ public:
         props = devices[devices.size() - 1]["properties"].to<JsonObject>();
       }
       props[key] = value;
+      manifest_changed();
     }
     return *this;
   }
@@ -300,6 +576,7 @@ public:
         props = devices[devices.size() - 1]["properties"].to<JsonObject>();
       }
       props[key] = value;
+      manifest_changed();
     }
     return *this;
   }
@@ -13,6 +13,15 @@
  * 1. Define devices in your .ino file
  * 2. Call buildManifestFromRegistry() to auto-generate manifest
  * 3. That's it!
+ *
+ * findDevice() and isValidCommand() go through a hash index built by
+ * addDevice(); deviceHandle() and commandHandle() return the small integer
+ * handles behind them, ready to index a handler table.
+ *
+ * With constexpr device definitions, SentientDeviceTable.h holds them as a
+ * fixed-size table in flash (no heap, duplicate IDs are compile errors) and
+ * SentientManifestImage.h renders the registration messages at compile time
+ * (see USAGE_EXAMPLE.md).
  */
 
 #ifndef SENTIENT_DEVICE_REGISTRY_H
@@ -34,97 +43,282 @@ struct SentientDeviceDef {
   const char* device_type;         // Type: "relay", "sensor", "led_strip", etc.
   const char* category;            // "input", "output", "bidirectional"
 
-  // Commands this device responds to (output devices)
-  const char* commands[MAX_TOPICS_PER_DEVICE];
+  // Commands this device responds to (output devices); points at the sketch's own array
+  const char* const* commands;
   int command_count;
 
-  // Sensor topics this device publishes (input devices)
-  const char* sensors[MAX_TOPICS_PER_DEVICE];
+  // Sensor topics this device publishes (input devices); points at the sketch's own array
+  const char* const* sensors;
   int sensor_count;
 
+  // The lists are referenced, not copied, so they must outlive the definition
+  // (sketches declare them at file scope). Constructors are constexpr so a
+  // sketch can declare its devices as constexpr tables, from which
+  // SentientDeviceTable and SentientManifestImage work at compile time.
+
   // Constructor for output device with commands
-  SentientDeviceDef(const char* id, const char* name, const char* type,
-                    const char** cmds, int cmd_count)
+  constexpr SentientDeviceDef(const char* id, const char* name, const char* type,
+                              const char* const* cmds, int cmd_count)
     : device_id(id), friendly_name(name), device_type(type),
-      category("output"), command_count(cmd_count), sensor_count(0) {
-    for (int i = 0; i < cmd_count && i < MAX_TOPICS_PER_DEVICE; i++) {
-      commands[i] = cmds[i];
-    }
-    for (int i = cmd_count; i < MAX_TOPICS_PER_DEVICE; i++) {
-      commands[i] = nullptr;
-    }
-    for (int i = 0; i < MAX_TOPICS_PER_DEVICE; i++) {
-      sensors[i] = nullptr;
-    }
-  }
+      category("output"), commands(cmds), command_count(cmd_count), sensors(nullptr), sensor_count(0) {}
 
   // Constructor for input device with sensors
-  SentientDeviceDef(const char* id, const char* name, const char* type,
-                    const char** snsr, int snsr_count, bool is_input)
+  constexpr SentientDeviceDef(const char* id, const char* name, const char* type,
+                              const char* const* snsr, int snsr_count, bool is_input)
     : device_id(id), friendly_name(name), device_type(type),
-      category("input"), command_count(0), sensor_count(snsr_count) {
-    for (int i = 0; i < snsr_count && i < MAX_TOPICS_PER_DEVICE; i++) {
-      sensors[i] = snsr[i];
-    }
-    for (int i = snsr_count; i < MAX_TOPICS_PER_DEVICE; i++) {
-      sensors[i] = nullptr;
-    }
-    for (int i = 0; i < MAX_TOPICS_PER_DEVICE; i++) {
-      commands[i] = nullptr;
-    }
-  }
+      category("input"), commands(nullptr), command_count(0), sensors(snsr), sensor_count(snsr_count) {}
 
   // Constructor for bidirectional device
-  SentientDeviceDef(const char* id, const char* name, const char* type,
-                    const char** cmds, int cmd_count,
-                    const char** snsr, int snsr_count)
+  constexpr SentientDeviceDef(const char* id, const char* name, const char* type,
+                              const char* const* cmds, int cmd_count,
+                              const char* const* snsr, int snsr_count)
     : device_id(id), friendly_name(name), device_type(type),
-      category("bidirectional"), command_count(cmd_count), sensor_count(snsr_count) {
-    for (int i = 0; i < cmd_count && i < MAX_TOPICS_PER_DEVICE; i++) {
-      commands[i] = cmds[i];
+      category("bidirectional"), commands(cmds), command_count(cmd_count), sensors(snsr), sensor_count(snsr_count) {}
+
+  // Adds this device and its command/sensor topics to a runtime manifest
+  void addToManifest(SentientCapabilityManifest& manifest) const {
+    // Add device with primary command name (first command in the list)
+    const char* primary_command = (command_count > 0) ? commands[0] : nullptr;
+    manifest.add_device(device_id, friendly_name, device_type, category, primary_command);
+
+    // Add command topics
+    for (int j = 0; j < command_count && j < MAX_TOPICS_PER_DEVICE; j++) {
+      if (commands[j]) {
+        String topic = String("commands/") + commands[j];
+        manifest.add_device_topic(device_id, topic.c_str(), "command");
+
+        Serial.print(F("  [Registry] Added command: "));
+        Serial.print(device_id);
+        Serial.print(F(" -> "));
+        Serial.println(topic);
+      }
     }
-    for (int i = cmd_count; i < MAX_TOPICS_PER_DEVICE; i++) {
-      commands[i] = nullptr;
+
+    // Add sensor topics
+    for (int j = 0; j < sensor_count && j < MAX_TOPICS_PER_DEVICE; j++) {
+      if (sensors[j]) {
+        String topic = String("sensors/") + sensors[j];
+        manifest.add_device_topic(device_id, topic.c_str(), "sensor");
+
+        Serial.print(F("  [Registry] Added sensor: "));
+        Serial.print(device_id);
+        Serial.print(F(" -> "));
+        Serial.println(topic);
+      }
     }
-    for (int i = 0; i < snsr_count && i < MAX_TOPICS_PER_DEVICE; i++) {
-      sensors[i] = snsr[i];
+  }
+
+  bool hasCommand(const char* command) const {
+    for (int j = 0; j < command_count; j++) {
+      if (commands[j] && strcmp(commands[j], command) == 0) {
+        return true;
+      }
     }
-    for (int i = snsr_count; i < MAX_TOPICS_PER_DEVICE; i++) {
-      sensors[i] = nullptr;
+    return false;
+  }
+
+  void printSummary() const {
+    Serial.println();
+    Serial.print(F("Device: "));
+    Serial.println(friendly_name);
+    Serial.print(F("  ID: "));
+    Serial.println(device_id);
+    Serial.print(F("  Type: "));
+    Serial.println(device_type);
+    Serial.print(F("  Category: "));
+    Serial.println(category);
+
+    if (command_count > 0) {
+      Serial.println(F("  Commands:"));
+      for (int j = 0; j < command_count; j++) {
+        if (commands[j]) {
+          Serial.print(F("    - "));
+          Serial.println(commands[j]);
+        }
+      }
+    }
+
+    if (sensor_count > 0) {
+      Serial.println(F("  Sensors:"));
+      for (int j = 0; j < sensor_count; j++) {
+        if (sensors[j]) {
+          Serial.print(F("    - "));
+          Serial.println(sensors[j]);
+        }
+      }
     }
   }
 };
 
+// ============================================================================
+// LOOKUP INDEX
+// ============================================================================
+
+// A command handle names one (device, command) pair
+struct SentientCommandRef {
+  uint16_t device;   // Device handle
+  uint16_t command;  // Position in that device's commands
+};
+
+// Open-addressing hash tables over device IDs and command names, shared by
+// SentientDeviceRegistry (built at addDevice) and SentientDeviceTable (built
+// by the compiler). Slots hold handle + 1, 0 is empty; the capacity is a power
+// of two at least twice the entries, probed linearly. Lookups return the
+// handle (an index usable for handler tables) or -1.
+namespace sentient_device_index {
+
+// FNV-1a
+constexpr uint32_t hashText(const char* text) {
+  uint32_t hash = 2166136261u;
+  while (text && *text) {
+    hash = (hash ^ static_cast<uint8_t>(*text++)) * 16777619u;
+  }
+  return hash;
+}
+
+constexpr bool sameText(const char* a, const char* b) {
+  if (!a || !b) return false;
+  while (*a && *a == *b) {
+    a++;
+    b++;
+  }
+  return *a == *b;
+}
+
+constexpr size_t slotsFor(size_t entries) {
+  size_t slots = 4;
+  while (slots < entries * 2) slots <<= 1;
+  return slots;
+}
+
+constexpr void insert(uint16_t* slots, size_t capacity, uint32_t hash, size_t handle) {
+  size_t i = hash & (capacity - 1);
+  while (slots[i]) i = (i + 1) & (capacity - 1);
+  slots[i] = static_cast<uint16_t>(handle + 1);
+}
+
+// The registry holds pointers, the table holds the definitions themselves
+inline const SentientDeviceDef& deviceAt(const SentientDeviceDef* const* devices, size_t handle) {
+  return *devices[handle];
+}
+constexpr const SentientDeviceDef& deviceAt(const SentientDeviceDef* devices, size_t handle) {
+  return devices[handle];
+}
+
+// Equal keys probe in insertion order, so a duplicate ID finds the first device added
+template <typename Devices>
+constexpr int findDevice(const uint16_t* slots, size_t capacity, const Devices& devices, const char* device_id) {
+  for (size_t i = hashText(device_id) & (capacity - 1); slots[i]; i = (i + 1) & (capacity - 1)) {
+    const size_t handle = slots[i] - 1;
+    if (sameText(deviceAt(devices, handle).device_id, device_id)) return static_cast<int>(handle);
+  }
+  return -1;
+}
+
+// device < 0 matches the command on any device
+template <typename Devices>
+constexpr int findCommand(const uint16_t* slots, size_t capacity, const SentientCommandRef* refs,
+                          const Devices& devices, int device, const char* command) {
+  for (size_t i = hashText(command) & (capacity - 1); slots[i]; i = (i + 1) & (capacity - 1)) {
+    const size_t handle = slots[i] - 1;
+    const SentientCommandRef& ref = refs[handle];
+    if ((device < 0 || ref.device == device) && sameText(deviceAt(devices, ref.device).commands[ref.command], command)) {
+      return static_cast<int>(handle);
+    }
+  }
+  return -1;
+}
+
+} // namespace sentient_device_index
+
 // ============================================================================
 // DEVICE REGISTRY
 // ============================================================================
 
 class SentientDeviceRegistry {
 private:
-  SentientDeviceDef** devices;
+  const SentientDeviceDef** devices;
   int device_count;
   int max_devices;
 
+  // Hash index, kept current by addDevice()
+  uint16_t* device_slots;
+  size_t device_slot_count;
+  SentientCommandRef* command_refs = nullptr;
+  size_t command_count = 0;
+  size_t command_capacity = 0;
+  uint16_t* command_slots = nullptr;
+  size_t command_slot_count = 0;
+
+  // Grows the command index (rehashing every command) when `total` would not fit
+  void reserveCommands(size_t total) {
+    if (total <= command_capacity) {
+      return;
+    }
+    size_t capacity = command_capacity ? command_capacity * 2 : 16;
+    while (capacity < total) capacity *= 2;
+    SentientCommandRef* refs = new SentientCommandRef[capacity];
+    for (size_t i = 0; i < command_count; i++) {
+      refs[i] = command_refs[i];
+    }
+    delete[] command_refs;
+    command_refs = refs;
+    command_capacity = capacity;
+
+    delete[] command_slots;
+    command_slot_count = sentient_device_index::slotsFor(capacity);
+    command_slots = new uint16_t[command_slot_count]();
+    for (size_t i = 0; i < command_count; i++) {
+      const SentientCommandRef& ref = command_refs[i];
+      sentient_device_index::insert(command_slots, command_slot_count,
+                                    sentient_device_index::hashText(devices[ref.device]->commands[ref.command]), i);
+    }
+  }
+
 public:
   SentientDeviceRegistry(int max_devs = 20)
     : device_count(0), max_devices(max_devs) {
-    devices = new SentientDeviceDef*[max_devices];
+    devices = new const SentientDeviceDef*[max_devices];
     for (int i = 0; i < max_devices; i++) {
       devices[i] = nullptr;
     }
+    device_slot_count = sentient_device_index::slotsFor(max_devices);
+    device_slots = new uint16_t[device_slot_count]();
   }
 
   ~SentientDeviceRegistry() {
     delete[] devices;
+    delete[] device_slots;
+    delete[] command_refs;
+    delete[] command_slots;
   }
 
   // Add a device to the registry
-  bool addDevice(SentientDeviceDef* device) {
+  bool addDevice(const SentientDeviceDef* device) {
     if (device_count >= max_devices) {
       Serial.println(F("[Registry] ERROR: Max devices reached"));
       return false;
     }
-    devices[device_count++] = device;
+    if (!device) {
+      return false;
+    }
+    const int handle = device_count++;
+    devices[handle] = device;
+    sentient_device_index::insert(device_slots, device_slot_count,
+                                  sentient_device_index::hashText(device->device_id), handle);
+
+    size_t commands = 0;
+    for (int j = 0; j < device->command_count; j++) {
+      if (device->commands[j]) commands++;
+    }
+    reserveCommands(command_count + commands);
+    for (int j = 0; j < device->command_count; j++) {
+      if (!device->commands[j]) continue;
+      command_refs[command_count] = {static_cast<uint16_t>(handle), static_cast<uint16_t>(j)};
+      sentient_device_index::insert(command_slots, command_slot_count,
+                                    sentient_device_index::hashText(device->commands[j]), command_count);
+      command_count++;
+    }
     return true;
   }
 
@@ -135,39 +329,7 @@ public:
     Serial.println(F(" devices"));
 
     for (int i = 0; i < device_count; i++) {
-      SentientDeviceDef* dev = devices[i];
-      if (!dev) continue;
-
-      // Add device with primary command name (first command in the list)
-      const char* primary_command = (dev->command_count > 0) ? dev->commands[0] : nullptr;
-      manifest.add_device(dev->device_id, dev->friendly_name,
-                         dev->device_type, dev->category, primary_command);
-
-      // Add command topics
-      for (int j = 0; j < dev->command_count && j < MAX_TOPICS_PER_DEVICE; j++) {
-        if (dev->commands[j]) {
-          String topic = String("commands/") + dev->commands[j];
-          manifest.add_device_topic(dev->device_id, topic.c_str(), "command");
-
-          Serial.print(F("  [Registry] Added command: "));
-          Serial.print(dev->device_id);
-          Serial.print(F(" -> "));
-          Serial.println(topic);
-        }
-      }
-
-      // Add sensor topics
-      for (int j = 0; j < dev->sensor_count && j < MAX_TOPICS_PER_DEVICE; j++) {
-        if (dev->sensors[j]) {
-          String topic = String("sensors/") + dev->sensors[j];
-          manifest.add_device_topic(dev->device_id, topic.c_str(), "sensor");
-
-          Serial.print(F("  [Registry] Added sensor: "));
-          Serial.print(dev->device_id);
-          Serial.print(F(" -> "));
-          Serial.println(topic);
-        }
-      }
+      devices[i]->addToManifest(manifest);
     }
 
     Serial.println(F("[Registry] Manifest build complete"));
@@ -176,37 +338,50 @@ public:
   // Get device count
   int getDeviceCount() const { return device_count; }
 
-  // Get device by index
-  SentientDeviceDef* getDevice(int index) {
+  // Get device by index (the device handle)
+  const SentientDeviceDef* getDevice(int index) const {
     if (index >= 0 && index < device_count) {
       return devices[index];
     }
     return nullptr;
   }
 
+  // Handle of the device with this ID, or -1
+  int deviceHandle(const char* device_id) const {
+    return sentient_device_index::findDevice(device_slots, device_slot_count, devices, device_id);
+  }
+
+  // Handle of this command on any device (the first one added), or -1
+  int commandHandle(const char* command) const {
+    return command_count ? sentient_device_index::findCommand(command_slots, command_slot_count, command_refs,
+                                                             devices, -1, command)
+                         : -1;
+  }
+
+  // Handle of this command on one device, or -1
+  int commandHandle(int device, const char* command) const {
+    return command_count && device >= 0 ? sentient_device_index::findCommand(command_slots, command_slot_count,
+                                                                             command_refs, devices, device, command)
+                                        : -1;
+  }
+
+  // Command handles run from 0 to getCommandCount() - 1, in the order devices and their commands were added
+  int getCommandCount() const { return static_cast<int>(command_count); }
+  int commandDevice(int handle) const { return command_refs[handle].device; }
+  const char* commandName(int handle) const {
+    const SentientCommandRef& ref = command_refs[handle];
+    return devices[ref.device]->commands[ref.command];
+  }
+
   // Find device by ID
-  SentientDeviceDef* findDevice(const char* device_id) {
-    for (int i = 0; i < device_count; i++) {
-      if (devices[i] && strcmp(devices[i]->device_id, device_id) == 0) {
-        return devices[i];
-      }
-    }
-    return nullptr;
+  const SentientDeviceDef* findDevice(const char* device_id) const {
+    const int handle = deviceHandle(device_id);
+    return handle >= 0 ? devices[handle] : nullptr;
   }
 
   // Check if command exists for any device
-  bool isValidCommand(const char* command) {
-    for (int i = 0; i < device_count; i++) {
-      SentientDeviceDef* dev = devices[i];
-      if (!dev) continue;
-
-      for (int j = 0; j < dev->command_count; j++) {
-        if (dev->commands[j] && strcmp(dev->commands[j], command) == 0) {
-          return true;
-        }
-      }
-    }
-    return false;
+  bool isValidCommand(const char* command) const {
+    return commandHandle(command) >= 0;
   }
 
   // Print registry summary
@@ -218,38 +393,7 @@ public:
     Serial.println(device_count);
 
     for (int i = 0; i < device_count; i++) {
-      SentientDeviceDef* dev = devices[i];
-      if (!dev) continue;
-
-      Serial.println();
-      Serial.print(F("Device: "));
-      Serial.println(dev->friendly_name);
-      Serial.print(F("  ID: "));
-      Serial.println(dev->device_id);
-      Serial.print(F("  Type: "));
-      Serial.println(dev->device_type);
-      Serial.print(F("  Category: "));
-      Serial.println(dev->category);
-
-      if (dev->command_count > 0) {
-        Serial.println(F("  Commands:"));
-        for (int j = 0; j < dev->command_count; j++) {
-          if (dev->commands[j]) {
-            Serial.print(F("    - "));
-            Serial.println(dev->commands[j]);
-          }
-        }
-      }
-
-      if (dev->sensor_count > 0) {
-        Serial.println(F("  Sensors:"));
-        for (int j = 0; j < dev->sensor_count; j++) {
-          if (dev->sensors[j]) {
-            Serial.print(F("    - "));
-            Serial.println(dev->sensors[j]);
-          }
-        }
-      }
+      devices[i]->printSummary();
     }
     Serial.println(F("========================================\n"));
   }
@@ -0,0 +1,199 @@
+/*
+ * SentientDeviceTable.h
+ *
+ * A controller's devices as a constexpr table in flash.
+ *
+ * SentientDeviceRegistry fills a heap-allocated pointer table at boot and
+ * reports "Max devices reached" or a duplicate ID only when the sketch runs.
+ * SentientDeviceTable<N, Commands> is sized by the compiler from the devices it is given:
+ * no heap, no RAM for the definitions, N is a compile-time constant, and the
+ * mistakes the runtime registry cannot see (two devices with one device_id, a
+ * device without an ID, more than MAX_TOPICS_PER_DEVICE commands or sensors)
+ * fail the build. Lookups go through a hash index the compiler builds into
+ * the table; deviceHandle() and commandHandle() are constexpr, so handles
+ * into handler tables can be fixed at compile time.
+ *
+ * USAGE:
+ *   constexpr const char* light_commands[] = {"light_on", "light_off"};
+ *   constexpr SentientDeviceDef dev_light("light", "Ceiling Light", "relay", light_commands, 2);
+ *   constexpr SentientDeviceDef dev_door("door", "Door Sensor", "sensor", door_sensors, 1, true);
+ *   SENTIENT_DEVICE_TABLE(devices, dev_light, dev_door);
+ *
+ *   static_assert(decltype(devices)::deviceCount() == 2, "");
+ *   const SentientDeviceDef* light = devices.findDevice("light");
+ *   static_assert(devices.commandHandle("light_off") == 1, "");
+ *   SENTIENT_MANIFEST_IMAGE(manifest_image, manifest_controller, devices);
+ */
+
+#ifndef SENTIENT_DEVICE_TABLE_H
+#define SENTIENT_DEVICE_TABLE_H
+
+#include <Arduino.h>
+#include "SentientDeviceRegistry.h"
+
+template <size_t N, size_t Commands>
+class SentientDeviceTable {
+  static_assert(N > 0, "SentientDeviceTable needs at least one device");
+
+public:
+  template <typename... Devices>
+  constexpr explicit SentientDeviceTable(const Devices&... definitions)
+    : devices{definitions...}, command_refs{}, device_slots{}, command_slots{} {
+    // Same index SentientDeviceRegistry builds at addDevice(), built here by the compiler
+    size_t command = 0;
+    for (size_t i = 0; i < N; i++) {
+      sentient_device_index::insert(device_slots, DeviceSlots, sentient_device_index::hashText(devices[i].device_id), i);
+      for (int j = 0; j < devices[i].command_count; j++) {
+        if (!devices[i].commands[j]) continue;
+        command_refs[command] = {static_cast<uint16_t>(i), static_cast<uint16_t>(j)};
+        sentient_device_index::insert(command_slots, CommandSlots,
+                                      sentient_device_index::hashText(devices[i].commands[j]), command);
+        command++;
+      }
+    }
+  }
+
+  static constexpr size_t deviceCount() { return N; }
+  static constexpr size_t commandCount() { return Commands; }
+  int getDeviceCount() const { return static_cast<int>(N); }
+  int getCommandCount() const { return static_cast<int>(Commands); }
+
+  constexpr const SentientDeviceDef& operator[](size_t index) const { return devices[index]; }
+  constexpr const SentientDeviceDef* begin() const { return devices; }
+  constexpr const SentientDeviceDef* end() const { return devices + N; }
+
+  // Get device by index (the device handle)
+  const SentientDeviceDef* getDevice(int index) const {
+    return index >= 0 && static_cast<size_t>(index) < N ? &devices[index] : nullptr;
+  }
+
+  // Handle of the device with this ID, or -1; constexpr, so handles can size or index tables at compile time
+  constexpr int deviceHandle(const char* device_id) const {
+    return sentient_device_index::findDevice(device_slots, DeviceSlots, devices, device_id);
+  }
+
+  // Handle of this command on any device (the first in the table), or -1
+  constexpr int commandHandle(const char* command) const {
+    return Commands ? sentient_device_index::findCommand(command_slots, CommandSlots, command_refs, devices, -1, command)
+                    : -1;
+  }
+
+  // Handle of this command on one device, or -1
+  constexpr int commandHandle(int device, const char* command) const {
+    return Commands && device >= 0
+             ? sentient_device_index::findCommand(command_slots, CommandSlots, command_refs, devices, device, command)
+             : -1;
+  }
+
+  // Command handles run from 0 to commandCount() - 1, in table order
+  constexpr int commandDevice(int handle) const { return command_refs[handle].device; }
+  constexpr const char* commandName(int handle) const {
+    return devices[command_refs[handle].device].commands[command_refs[handle].command];
+  }
+
+  // Find device by ID
+  const SentientDeviceDef* findDevice(const char* device_id) const {
+    const int handle = deviceHandle(device_id);
+    return handle >= 0 ? &devices[handle] : nullptr;
+  }
+
+  // Check if command exists for any device
+  bool isValidCommand(const char* command) const {
+    return commandHandle(command) >= 0;
+  }
+
+  // Build a runtime manifest from the table (SentientManifestImage needs none)
+  void buildManifest(SentientCapabilityManifest& manifest) const {
+    Serial.print(F("[Registry] Building manifest for "));
+    Serial.print(N);
+    Serial.println(F(" devices"));
+    for (const SentientDeviceDef& device : devices) {
+      device.addToManifest(manifest);
+    }
+    Serial.println(F("[Registry] Manifest build complete"));
+  }
+
+  void printSummary() const {
+    Serial.println(F("\n========================================"));
+    Serial.println(F("DEVICE TABLE SUMMARY"));
+    Serial.println(F("========================================"));
+    Serial.print(F("Total Devices: "));
+    Serial.println(N);
+    for (const SentientDeviceDef& device : devices) {
+      device.printSummary();
+    }
+    Serial.println(F("========================================\n"));
+  }
+
+  const SentientDeviceDef devices[N];
+
+private:
+  static constexpr size_t DeviceSlots = sentient_device_index::slotsFor(N);
+  static constexpr size_t CommandSlots = sentient_device_index::slotsFor(Commands);
+
+  // Sized at least 1 so a table without commands still has arrays
+  SentientCommandRef command_refs[Commands ? Commands : 1];
+  uint16_t device_slots[DeviceSlots];
+  uint16_t command_slots[CommandSlots];
+};
+
+namespace sentient_device_table {
+
+constexpr size_t commandsOf(const SentientDeviceDef& device) {
+  size_t count = 0;
+  for (int j = 0; j < device.command_count; j++) {
+    if (device.commands[j]) count++;
+  }
+  return count;
+}
+
+constexpr size_t commandTotal() { return 0; }
+
+template <typename... Devices>
+constexpr size_t commandTotal(const SentientDeviceDef& first, const Devices&... rest) {
+  return commandsOf(first) + commandTotal(rest...);
+}
+
+template <size_t Commands, typename... Devices>
+constexpr SentientDeviceTable<sizeof...(Devices), Commands> make(const Devices&... definitions) {
+  return SentientDeviceTable<sizeof...(Devices), Commands>(definitions...);
+}
+
+template <size_t N, size_t C>
+constexpr bool idsPresent(const SentientDeviceTable<N, C>& table) {
+  for (size_t i = 0; i < N; i++) {
+    if (!table[i].device_id || table[i].device_id[0] == '\0') return false;
+  }
+  return true;
+}
+
+template <size_t N, size_t C>
+constexpr bool idsUnique(const SentientDeviceTable<N, C>& table) {
+  for (size_t i = 0; i < N; i++) {
+    for (size_t j = i + 1; j < N; j++) {
+      if (sentient_device_index::sameText(table[i].device_id, table[j].device_id)) return false;
+    }
+  }
+  return true;
+}
+
+template <size_t N, size_t C>
+constexpr bool topicsFit(const SentientDeviceTable<N, C>& table) {
+  for (size_t i = 0; i < N; i++) {
+    if (table[i].command_count > MAX_TOPICS_PER_DEVICE || table[i].sensor_count > MAX_TOPICS_PER_DEVICE) return false;
+  }
+  return true;
+}
+
+} // namespace sentient_device_table
+
+// Defines `name` as a constexpr, flash-resident SentientDeviceTable of the given
+// SentientDeviceDef objects, and rejects bad tables at compile time
+#define SENTIENT_DEVICE_TABLE(name, ...)                                                          \
+  constexpr auto name PROGMEM = sentient_device_table::make<sentient_device_table::commandTotal(__VA_ARGS__)>(__VA_ARGS__); \
+  static_assert(sentient_device_table::idsPresent(name), #name ": every device needs a device_id"); \
+  static_assert(sentient_device_table::idsUnique(name), #name ": two devices share a device_id");  \
+  static_assert(sentient_device_table::topicsFit(name),                                           \
+                #name ": a device has more than MAX_TOPICS_PER_DEVICE commands or sensors")
+
+#endif // SENTIENT_DEVICE_TABLE_H
@@ -0,0 +1,397 @@
+/*
+ * SentientManifestImage.h
+ *
+ * Registration messages rendered at compile time and kept in flash.
+ *
+ * SentientCapabilityManifest builds the registration JSON at boot in a 4 KB
+ * StaticJsonDocument (plus 1 KB / 512 B documents while publishing) and
+ * silently drops whatever does not fit. When the controller info and device
+ * table are constexpr, the same messages can be produced by the compiler
+ * instead: the image below holds the exact bytes publish_registration() would
+ * have sent, sized to fit, so registration just streams them out of flash.
+ * Its FNV-1a manifest hash (the fingerprint SentientMQTT publishes before any
+ * record) is computed by the compiler as well.
+ *
+ * USAGE:
+ *   constexpr const char* light_commands[] = {"light_on", "light_off"};
+ *   constexpr SentientDeviceDef dev_light("light", "Ceiling Light", "relay", light_commands, 2);
+ *   constexpr const SentientDeviceDef* manifest_devices[] = {&dev_light};
+ *   constexpr SentientManifestController manifest_controller = {
+ *     naming::CONTROLLER_ID, naming::CONTROLLER_FRIENDLY_NAME, firmware::VERSION,
+ *     naming::ROOM_ID, naming::CONTROLLER_ID};
+ *   SENTIENT_MANIFEST_IMAGE(manifest_image, manifest_controller, manifest_devices);
+ *
+ * The devices may also be a SENTIENT_DEVICE_TABLE (see SentientDeviceTable.h).
+ *
+ *   SentientManifestImageSource registration(manifest_image);
+ *   mqtt.setRegistration(&registration);   // sent from mqtt.loop() on every (re)connect
+ *
+ * or, blocking: manifest_image.publish_registration(mqtt.get_client());
+ */
+
+#ifndef SENTIENT_MANIFEST_IMAGE_H
+#define SENTIENT_MANIFEST_IMAGE_H
+
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <SentientRegistration.h>
+#include <SentientStreamWriter.h>
+#include "SentientDeviceRegistry.h"
+#include "SentientDeviceTable.h"
+
+#define SENTIENT_MANIFEST_CONTROLLER_TOPIC "sentient/system/register/controller"
+#define SENTIENT_MANIFEST_DEVICE_TOPIC "sentient/system/register/device"
+
+// Same fields, in the same order, as SentientCapabilityManifest::set_controller_info().
+// registration_room_id is the room_id_uuid publish_registration() used to take;
+// left null it falls back to room_id.
+struct SentientManifestController {
+  const char* unique_id;
+  const char* friendly_name;
+  const char* firmware_version;
+  const char* room_id;
+  const char* controller_id;
+  const char* registration_room_id = nullptr;
+};
+
+namespace sentient_manifest {
+
+// Not constexpr: reaching it during constant evaluation is a compile error.
+inline void nullDeviceInManifestTable() {}
+
+// Appends JSON to a buffer, or only counts the bytes when the buffer is null.
+// Output matches ArduinoJson's serializeJson() for the same documents.
+class Writer {
+public:
+  constexpr explicit Writer(char* out) : out_(out), length_(0) {}
+
+  constexpr size_t length() const { return length_; }
+
+  constexpr void raw(char c) {
+    if (out_) out_[length_] = c;
+    length_++;
+  }
+
+  constexpr void raw(const char* text) {
+    while (*text) raw(*text++);
+  }
+
+  constexpr void string(const char* text) {
+    if (!text) {
+      raw("null");
+      return;
+    }
+    raw('"');
+    escaped(text);
+    raw('"');
+  }
+
+  // "prefix" + text as one JSON string
+  constexpr void joined(const char* prefix, const char* text) {
+    raw('"');
+    escaped(prefix);
+    escaped(text);
+    raw('"');
+  }
+
+  constexpr void number(unsigned long value) {
+    char digits[20] = {};
+    int count = 0;
+    do {
+      digits[count++] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while (value);
+    while (count) raw(digits[--count]);
+  }
+
+  // ,"key": (no comma before the first member)
+  constexpr void key(const char* name, bool first = false) {
+    if (!first) raw(',');
+    string(name);
+    raw(':');
+  }
+
+private:
+  constexpr void escaped(const char* text) {
+    for (; *text; text++) {
+      const char c = *text;
+      switch (c) {
+        case '"': raw("\\\""); break;
+        case '\\': raw("\\\\"); break;
+        case '\b': raw("\\b"); break;
+        case '\f': raw("\\f"); break;
+        case '\n': raw("\\n"); break;
+        case '\r': raw("\\r"); break;
+        case '\t': raw("\\t"); break;
+        default:
+          if (static_cast<unsigned char>(c) < 0x20) {
+            raw("\\u00");
+            raw("0123456789abcdef"[(c >> 4) & 0x0F]);
+            raw("0123456789abcdef"[c & 0x0F]);
+          } else {
+            raw(c);
+          }
+      }
+    }
+  }
+
+  char* out_;
+  size_t length_;
+};
+
+constexpr const char* orDefault(const char* text, const char* fallback) {
+  return text ? text : fallback;
+}
+
+constexpr void writeController(Writer& w, const SentientManifestController& c, size_t device_count) {
+  w.raw('{');
+  w.key("controller_id", true);
+  w.string(orDefault(c.unique_id, "UNKNOWN"));
+  w.key("room_id");
+  w.string(c.registration_room_id ? c.registration_room_id : c.room_id);
+  w.key("friendly_name");
+  w.string(orDefault(c.friendly_name, ""));
+  w.key("hardware_type");
+  w.string("Teensy 4.1");
+  w.key("mcu_model");
+  w.string("ARM Cortex-M7");
+  w.key("clock_speed_mhz");
+  w.number(600);
+  w.key("firmware_version");
+  w.string(orDefault(c.firmware_version, ""));
+  w.key("digital_pins_total");
+  w.number(55);
+  w.key("analog_pins_total");
+  w.number(18);
+  w.key("heartbeat_interval_ms");
+  w.number(5000);
+  w.key("controller_type");
+  w.string("microcontroller");
+  w.key("device_count");
+  w.number(device_count);
+  w.key("mqtt_namespace");
+  w.string("paragon");
+  w.key("mqtt_room_id");
+  w.string(orDefault(c.room_id, ""));
+  w.key("mqtt_controller_id");
+  w.string(orDefault(c.controller_id, ""));
+  w.raw('}');
+}
+
+constexpr void writeTopics(Writer& w, const char* const* names, int count, const char* prefix,
+                           const char* type, bool& first) {
+  for (int j = 0; j < count && j < MAX_TOPICS_PER_DEVICE; j++) {
+    if (!names[j]) continue;
+    if (!first) w.raw(',');
+    first = false;
+    w.raw('{');
+    w.key("topic", true);
+    w.joined(prefix, names[j]);
+    w.key("topic_type");
+    w.string(type);
+    w.raw('}');
+  }
+}
+
+constexpr void writeDevice(Writer& w, const SentientManifestController& c, size_t index,
+                           const SentientDeviceDef& dev) {
+  w.raw('{');
+  w.key("controller_id", true);
+  w.string(orDefault(c.unique_id, "UNKNOWN"));
+  w.key("device_index");
+  w.number(index);
+  w.key("device_id");
+  w.string(dev.device_id);
+  w.key("friendly_name");
+  w.string(dev.friendly_name);
+  w.key("device_type");
+  w.string(dev.device_type);
+  w.key("device_category");
+  w.string(dev.category);
+  const char* primary_command = dev.command_count > 0 ? dev.commands[0] : nullptr;
+  if (primary_command && primary_command[0] != '\0') {
+    w.key("device_command_name");
+    w.string(primary_command);
+  }
+  w.key("mqtt_topics");
+  w.raw('[');
+  // The runtime builder joins topics by device_id, so a device without one gets none
+  if (dev.device_id) {
+    bool first = true;
+    writeTopics(w, dev.commands, dev.command_count, "commands/", "command", first);
+    writeTopics(w, dev.sensors, dev.sensor_count, "sensors/", "sensor", first);
+  }
+  w.raw(']');
+  w.raw('}');
+}
+
+template <size_t N>
+constexpr const SentientDeviceDef& deviceAt(const SentientDeviceDef* const (&devices)[N], size_t index) {
+  return *devices[index];
+}
+
+template <size_t N, size_t C>
+constexpr const SentientDeviceDef& deviceAt(const SentientDeviceTable<N, C>& devices, size_t index) {
+  return devices[index];
+}
+
+// Total bytes of all registration messages; the template argument for render()
+template <size_t N>
+constexpr size_t measure(const SentientManifestController& controller,
+                         const SentientDeviceDef* const (&devices)[N]) {
+  Writer w(nullptr);
+  writeController(w, controller, N);
+  for (size_t i = 0; i < N; i++) {
+    if (!devices[i]) nullDeviceInManifestTable();
+    writeDevice(w, controller, i, *devices[i]);
+  }
+  return w.length();
+}
+
+template <size_t N, size_t C>
+constexpr size_t measure(const SentientManifestController& controller, const SentientDeviceTable<N, C>& devices) {
+  Writer w(nullptr);
+  writeController(w, controller, N);
+  for (size_t i = 0; i < N; i++) {
+    writeDevice(w, controller, i, devices[i]);
+  }
+  return w.length();
+}
+
+} // namespace sentient_manifest
+
+// Controller message followed by one message per device, back to back.
+template <size_t Bytes, size_t Records>
+struct SentientManifestImage {
+  char bytes[Bytes] = {};
+  uint32_t ends[Records] = {};   // End offset of each message in bytes
+  uint32_t hash = 0;             // FNV-1a over bytes, the manifest fingerprint
+  const char* controller_id = nullptr;
+  const char* firmware_version = nullptr;
+
+  static constexpr size_t recordCount() { return Records; }
+  static constexpr size_t deviceCount() { return Records - 1; }
+  static constexpr size_t totalBytes() { return Bytes; }
+
+  const uint8_t* record(size_t index, size_t& length) const {
+    const uint32_t start = index == 0 ? 0 : ends[index - 1];
+    length = ends[index] - start;
+    return reinterpret_cast<const uint8_t*>(bytes) + start;
+  }
+
+  /**
+   * Publish registration: the controller message, then each device, the same
+   * messages and pacing as SentientCapabilityManifest::publish_registration().
+   * Blocks; SentientManifestImageSource sends them from SentientMQTT::loop() instead.
+   */
+  bool publish_registration(PubSubClient& mqtt_client) const {
+    Serial.println(F("[ManifestImage] Starting registration..."));
+    Serial.print(F("[ManifestImage] Devices to register: "));
+    Serial.print(deviceCount());
+    Serial.print(F(", "));
+    Serial.print(Bytes);
+    Serial.println(F(" bytes in flash"));
+
+    for (size_t i = 0; i < Records; i++) {
+      size_t length = 0;
+      const uint8_t* payload = record(i, length);
+      const char* topic = i == 0 ? SENTIENT_MANIFEST_CONTROLLER_TOPIC : SENTIENT_MANIFEST_DEVICE_TOPIC;
+      if (!SentientStreamWriter::publish(mqtt_client, topic, payload, length)) {
+        if (i == 0) {
+          Serial.println(F("[ManifestImage] Controller registration failed!"));
+        } else {
+          Serial.print(F("[ManifestImage] Device "));
+          Serial.print(i - 1);
+          Serial.println(F(" registration failed!"));
+        }
+        return false;
+      }
+      delay(i == 0 ? 100 : 50); // Give broker time to process
+    }
+
+    Serial.print(F("[ManifestImage] Registration complete! "));
+    Serial.print(deviceCount());
+    Serial.println(F(" devices registered"));
+    return true;
+  }
+};
+
+namespace sentient_manifest {
+
+// Devices is an array of SentientDeviceDef pointers or a SentientDeviceTable
+template <size_t Bytes, size_t N, typename Devices>
+constexpr SentientManifestImage<Bytes, N + 1> renderDevices(const SentientManifestController& controller,
+                                                            const Devices& devices) {
+  SentientManifestImage<Bytes, N + 1> image{};
+  Writer w(image.bytes);
+  writeController(w, controller, N);
+  image.ends[0] = static_cast<uint32_t>(w.length());
+  for (size_t i = 0; i < N; i++) {
+    writeDevice(w, controller, i, deviceAt(devices, i));
+    image.ends[i + 1] = static_cast<uint32_t>(w.length());
+  }
+  uint32_t hash = sentient_fnv::Offset;
+  for (size_t i = 0; i < Bytes; i++) {
+    hash = sentient_fnv::step(hash, static_cast<uint8_t>(image.bytes[i]));
+  }
+  image.hash = hash;
+  image.controller_id = orDefault(controller.unique_id, "UNKNOWN");
+  image.firmware_version = orDefault(controller.firmware_version, "");
+  return image;
+}
+
+template <size_t Bytes, size_t N>
+constexpr SentientManifestImage<Bytes, N + 1> render(const SentientManifestController& controller,
+                                                     const SentientDeviceDef* const (&devices)[N]) {
+  return renderDevices<Bytes, N>(controller, devices);
+}
+
+template <size_t Bytes, size_t N, size_t C>
+constexpr SentientManifestImage<Bytes, N + 1> render(const SentientManifestController& controller,
+                                                     const SentientDeviceTable<N, C>& devices) {
+  return renderDevices<Bytes, N>(controller, devices);
+}
+
+} // namespace sentient_manifest
+
+// Feeds a flash image to SentientMQTT::setRegistration(); the bytes are written straight from flash
+class SentientManifestImageSource : public SentientRegistrationSource {
+public:
+  template <size_t Bytes, size_t Records>
+  explicit SentientManifestImageSource(const SentientManifestImage<Bytes, Records>& image)
+    : bytes(reinterpret_cast<const uint8_t*>(image.bytes)), ends(image.ends), records(Records),
+      hash(image.hash), controller_id(image.controller_id), firmware_version(image.firmware_version) {}
+
+  size_t recordCount() override { return records; }
+
+  const char* recordTopic(size_t index) override {
+    return index == 0 ? SENTIENT_MANIFEST_CONTROLLER_TOPIC : SENTIENT_MANIFEST_DEVICE_TOPIC;
+  }
+
+  size_t recordLength(size_t index) override {
+    return ends[index] - (index == 0 ? 0 : ends[index - 1]);
+  }
+
+  void writeRecord(size_t index, Print& out) override {
+    out.write(bytes + (index == 0 ? 0 : ends[index - 1]), recordLength(index));
+  }
+
+  const char* controllerId() override { return controller_id; }
+  const char* firmwareVersion() override { return firmware_version; }
+  uint32_t manifestHash() override { return hash; }
+
+private:
+  const uint8_t* bytes;
+  const uint32_t* ends;
+  size_t records;
+  uint32_t hash;
+  const char* controller_id;
+  const char* firmware_version;
+};
+
+// Defines `name` as the constexpr, flash-resident image of the registration messages
+#define SENTIENT_MANIFEST_IMAGE(name, controller, devices)                                          \
+  constexpr auto name PROGMEM = sentient_manifest::render<sentient_manifest::measure(controller, devices)>( \
+      controller, devices)
+
+#endif // SENTIENT_MANIFEST_IMAGE_H
@@ -0,0 +1,104 @@
+#include "SentientClockSync.h"
+
+namespace
+{
+  int64_t driftOver(int32_t driftPpb, int64_t elapsed)
+  {
+    return static_cast<int64_t>(driftPpb) * elapsed / 1'000'000'000;
+  }
+} // namespace
+
+uint64_t SentientClockSync::localMicros()
+{
+  const uint32_t now = micros();
+  if (now < _lastMicros)
+  {
+    ++_microsHigh;
+  }
+  _lastMicros = now;
+  return (static_cast<uint64_t>(_microsHigh) << 32) | now;
+}
+
+bool SentientClockSync::addSample(uint64_t t1, uint64_t t2, uint64_t t3, uint64_t t4)
+{
+  const int64_t delay = static_cast<int64_t>(t4 - t1) - static_cast<int64_t>(t3 - t2);
+  if (t4 < t1 || t3 < t2 || delay < 0)
+  {
+    ++_stats.rejected;
+    return false;
+  }
+
+  // A reply that sat in a queue measures the queue, not the clock. Let the best
+  // delay creep upwards so a permanently slower path is eventually accepted.
+  const uint32_t delayUs = static_cast<uint32_t>(delay);
+  if (_synced && delayUs > _bestDelayUs * 4 + 1'000)
+  {
+    _bestDelayUs += _bestDelayUs / 8 + 1;
+    ++_stats.rejected;
+    return false;
+  }
+  if (!_synced || delayUs < _bestDelayUs)
+  {
+    _bestDelayUs = delayUs;
+  }
+
+  const int64_t offset = (static_cast<int64_t>(t2 - t1) + (static_cast<int64_t>(t3) - static_cast<int64_t>(t4))) / 2;
+  const uint64_t midpoint = t1 + (t4 - t1) / 2;
+
+  // First exchange, or the backend clock stepped: adopt the new offset outright
+  const int64_t elapsed = static_cast<int64_t>(midpoint - _anchorLocal);
+  const int64_t predicted = _synced ? _offset + driftOver(_driftPpb, elapsed) : 0;
+  if (!_synced || predicted - offset > kStepMicros || offset - predicted > kStepMicros)
+  {
+    _offset = offset;
+    _driftPpb = 0;
+    _synced = true;
+  }
+  else
+  {
+    const int64_t error = offset - predicted;
+
+    // Frequency correction needs a baseline long enough to rise above the jitter
+    if (elapsed >= 1'000'000)
+    {
+      int64_t drift = _driftPpb + error * 1'000'000'000 / elapsed / 4;
+      if (drift > kMaxDriftPpb)
+      {
+        drift = kMaxDriftPpb;
+      }
+      else if (drift < -kMaxDriftPpb)
+      {
+        drift = -kMaxDriftPpb;
+      }
+      _driftPpb = static_cast<int32_t>(drift);
+    }
+    _offset = predicted + error / 2;
+  }
+
+  _anchorLocal = midpoint;
+  _stats.lastDelayUs = delayUs;
+  ++_stats.accepted;
+  return true;
+}
+
+uint64_t SentientClockSync::toEpochMicros(uint64_t local) const
+{
+  if (!_synced)
+  {
+    return 0;
+  }
+  const int64_t elapsed = static_cast<int64_t>(local - _anchorLocal);
+  return static_cast<uint64_t>(static_cast<int64_t>(local) + _offset + driftOver(_driftPpb, elapsed));
+}
+
+uint64_t SentientClockSync::toLocalMicros(uint64_t epoch) const
+{
+  if (!_synced)
+  {
+    return 0;
+  }
+  // Drift is tiny, so evaluating it at the offset-only estimate is exact to well under a microsecond
+  const int64_t estimate = static_cast<int64_t>(epoch) - _offset;
+  const int64_t elapsed = estimate - static_cast<int64_t>(_anchorLocal);
+  return static_cast<uint64_t>(estimate - driftOver(_driftPpb, elapsed));
+}
@@ -0,0 +1,58 @@
+/*
+ * SentientClockSync - Broker-synchronized wall clock for SentientMQTT.
+ *
+ * The controller sends a time-sync request stamped with its local clock (t1).
+ * The backend replies with that t1, its receive time t2 and its send time t3,
+ * all in epoch microseconds, and the controller stamps the reply's arrival (t4).
+ * Each exchange gives the usual NTP estimates:
+ *   offset = ((t2 - t1) + (t3 - t4)) / 2
+ *   delay  = (t4 - t1) - (t3 - t2)
+ * Successive offsets feed a small phase/frequency loop, so the clock also
+ * tracks crystal drift between exchanges. Exchanges whose round trip is far
+ * slower than the best recently seen are discarded as queued or delayed.
+ */
+
+#ifndef SENTIENT_CLOCK_SYNC_H
+#define SENTIENT_CLOCK_SYNC_H
+
+#include <Arduino.h>
+
+class SentientClockSync
+{
+public:
+  struct Stats
+  {
+    uint32_t accepted = 0;
+    uint32_t rejected = 0;
+    uint32_t lastDelayUs = 0;
+  };
+
+  // micros() widened to 64 bits. Must be called at least once per 71-minute wrap (loop() does).
+  uint64_t localMicros();
+
+  // Feeds one completed exchange, all values in microseconds. Returns false when it was discarded.
+  bool addSample(uint64_t t1, uint64_t t2, uint64_t t3, uint64_t t4);
+
+  bool synced() const { return _synced; }
+  uint64_t toEpochMicros(uint64_t local) const;
+  uint64_t toLocalMicros(uint64_t epoch) const; // Inverse of toEpochMicros(); 0 until synced
+  int64_t offsetMicros() const { return _offset; }
+  int32_t driftPpb() const { return _driftPpb; }
+  const Stats &stats() const { return _stats; }
+
+private:
+  static constexpr int32_t kMaxDriftPpb = 500'000; // Crystals are good to far better than 500 ppm
+  static constexpr int64_t kStepMicros = 1'000'000; // Larger errors are a clock step, not drift
+
+  uint32_t _lastMicros = 0;
+  uint32_t _microsHigh = 0;
+
+  bool _synced = false;
+  uint64_t _anchorLocal = 0; // Local time of the last accepted exchange's midpoint
+  int64_t _offset = 0;       // Epoch minus local at _anchorLocal
+  int32_t _driftPpb = 0;     // Epoch clock rate relative to the local clock, in parts per billion
+  uint32_t _bestDelayUs = 0;
+  Stats _stats;
+};
+
+#endif // SENTIENT_CLOCK_SYNC_H
@@ -0,0 +1,249 @@
+/*
+ * SentientCommandRouter - Compile-time command dispatch table.
+ *
+ * Replaces strcmp()/String::equals() chains in command callbacks. Each sketch
+ * declares its {command, handler} pairs once, as a constexpr array built from
+ * the slugs in controller_naming.h:
+ *
+ *   constexpr SentientCommandRoute command_routes[] = {
+ *       {naming::CMD_CEILING_OFF, on_ceiling_off},
+ *       {naming::CMD_CEILING_PATTERN_1, on_ceiling_pattern_1},
+ *   };
+ *   constexpr auto command_router = makeSentientCommandRouter(command_routes);
+ *
+ *   void handle_mqtt_command(const char *command, const JsonDocument &payload, void *ctx)
+ *   {
+ *     if (!command_router.dispatch(command, payload, ctx)) { ... unknown command ... }
+ *   }
+ *
+ * The compiler builds a perfect hash over the slugs (hash and displace): each
+ * slug falls into a small bucket, and every bucket gets its own displacement
+ * seed that places all of its slugs in free slots, largest buckets first. So
+ * dispatch is one hash, two table reads and one strcmp() regardless of how
+ * many commands a controller has, and a few hundred slugs still place within
+ * the compiler's constexpr limits. A duplicate slug fails the build with
+ * duplicateCommand(); unhashableCommands() is reserved for a set no
+ * displacement can place.
+ */
+
+#ifndef SENTIENT_COMMAND_ROUTER_H
+#define SENTIENT_COMMAND_ROUTER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+using SentientCommandHandler = void (*)(const JsonDocument &payload, void *context);
+
+struct SentientCommandRoute
+{
+  const char *command;
+  SentientCommandHandler handler;
+};
+
+namespace sentient_router
+{
+  constexpr uint8_t kEmptySlot = 0xFF;
+  constexpr uint32_t kMaxDisplacement = 0xFFFF;
+
+  // Spreads every input bit over the low bits that the tables mask off
+  constexpr uint32_t mix(uint32_t value)
+  {
+    value ^= value >> 16;
+    value *= 0x7FEB352Du;
+    value ^= value >> 15;
+    value *= 0x846CA68Bu;
+    value ^= value >> 16;
+    return value;
+  }
+
+  // FNV-1a; the only pass over the text, bucket and slot are both derived from it
+  constexpr uint32_t hash(const char *text)
+  {
+    uint32_t value = 2166136261u;
+    while (*text)
+    {
+      value ^= static_cast<uint8_t>(*text++);
+      value *= 16777619u;
+    }
+    return value;
+  }
+
+  constexpr bool sameText(const char *a, const char *b)
+  {
+    while (*a && *a == *b)
+    {
+      ++a;
+      ++b;
+    }
+    return *a == *b;
+  }
+
+  constexpr size_t powerOfTwoAtLeast(size_t count)
+  {
+    size_t size = 1;
+    while (size < count)
+    {
+      size <<= 1;
+    }
+    return size;
+  }
+
+  // Half the slots stay empty, so most buckets place at their first few displacements
+  constexpr size_t tableSizeFor(size_t routeCount) { return powerOfTwoAtLeast(routeCount * 2); }
+  // Two to four slugs per bucket
+  constexpr size_t bucketCountFor(size_t routeCount) { return powerOfTwoAtLeast((routeCount + 3) / 4); }
+
+  // Not constexpr, so reaching either during constant evaluation turns into a
+  // compile error at the call site that names the problem.
+  inline void duplicateCommand() {}
+  inline void unhashableCommands() {}
+} // namespace sentient_router
+
+template <size_t RouteCount>
+class SentientCommandRouter
+{
+  static_assert(RouteCount > 0, "SentientCommandRouter needs at least one route");
+  static_assert(RouteCount < sentient_router::kEmptySlot, "SentientCommandRouter supports at most 254 routes");
+
+public:
+  static constexpr size_t kTableSize = sentient_router::tableSizeFor(RouteCount);
+  static constexpr size_t kBucketCount = sentient_router::bucketCountFor(RouteCount);
+
+  constexpr explicit SentientCommandRouter(const SentientCommandRoute (&routes)[RouteCount])
+      : _routes(routes), _displacements{}, _slots{}
+  {
+    for (size_t i = 0; i < RouteCount; ++i)
+    {
+      for (size_t j = i + 1; j < RouteCount; ++j)
+      {
+        if (sentient_router::sameText(routes[i].command, routes[j].command))
+        {
+          sentient_router::duplicateCommand();
+        }
+      }
+    }
+
+    for (size_t slot = 0; slot < kTableSize; ++slot)
+    {
+      _slots[slot] = sentient_router::kEmptySlot;
+    }
+    uint32_t hashes[RouteCount] = {};
+    size_t bucketOf[RouteCount] = {};
+    size_t bucketSize[kBucketCount] = {};
+    size_t largest = 0;
+    for (size_t i = 0; i < RouteCount; ++i)
+    {
+      hashes[i] = sentient_router::hash(routes[i].command);
+      bucketOf[i] = bucketFor(hashes[i]);
+      if (++bucketSize[bucketOf[i]] > largest)
+      {
+        largest = bucketSize[bucketOf[i]];
+      }
+    }
+    // Largest buckets first, while the table is emptiest
+    for (size_t size = largest; size > 0; --size)
+    {
+      for (size_t bucket = 0; bucket < kBucketCount; ++bucket)
+      {
+        if (bucketSize[bucket] == size && !placeBucket(hashes, bucketOf, bucket))
+        {
+          sentient_router::unhashableCommands();
+        }
+      }
+    }
+  }
+
+  // Runs the handler registered for `command`. Returns false for unknown commands.
+  bool dispatch(const char *command, const JsonDocument &payload, void *context) const
+  {
+    const int index = find(command);
+    if (index < 0)
+    {
+      return false;
+    }
+    _routes[index].handler(payload, context);
+    return true;
+  }
+
+  // Index of `command` in the route table, or -1. Usable as a handle into
+  // parallel per-command tables.
+  int find(const char *command) const
+  {
+    if (!command)
+    {
+      return -1;
+    }
+    const uint32_t hash = sentient_router::hash(command);
+    const uint8_t index = _slots[slotFor(hash, _displacements[bucketFor(hash)])];
+    if (index == sentient_router::kEmptySlot || strcmp(_routes[index].command, command) != 0)
+    {
+      return -1;
+    }
+    return index;
+  }
+
+  static constexpr size_t size() { return RouteCount; }
+
+private:
+  static constexpr size_t bucketFor(uint32_t hash)
+  {
+    return sentient_router::mix(hash) & (kBucketCount - 1);
+  }
+
+  static constexpr size_t slotFor(uint32_t hash, uint32_t displacement)
+  {
+    return sentient_router::mix(hash + displacement * 0x9E3779B9u) & (kTableSize - 1);
+  }
+
+  // Finds the first displacement that puts every route of `bucket` in a free slot of its own.
+  // Two slugs with the same 32-bit hash never separate; that is the unhashable case.
+  constexpr bool placeBucket(const uint32_t (&hashes)[RouteCount], const size_t (&bucketOf)[RouteCount],
+                             size_t bucket)
+  {
+    for (uint32_t displacement = 1; displacement <= sentient_router::kMaxDisplacement; ++displacement)
+    {
+      size_t placed = 0;
+      bool fits = true;
+      for (; placed < RouteCount; ++placed)
+      {
+        if (bucketOf[placed] != bucket)
+        {
+          continue;
+        }
+        const size_t slot = slotFor(hashes[placed], displacement);
+        if (_slots[slot] != sentient_router::kEmptySlot)
+        {
+          fits = false;
+          break;
+        }
+        _slots[slot] = static_cast<uint8_t>(placed);
+      }
+      if (fits)
+      {
+        _displacements[bucket] = static_cast<uint16_t>(displacement);
+        return true;
+      }
+      // Take back this attempt's slots; the one that collided was never claimed
+      for (size_t i = 0; i < placed; ++i)
+      {
+        if (bucketOf[i] == bucket)
+        {
+          _slots[slotFor(hashes[i], displacement)] = sentient_router::kEmptySlot;
+        }
+      }
+    }
+    return false;
+  }
+
+  const SentientCommandRoute *_routes;
+  uint16_t _displacements[kBucketCount];
+  uint8_t _slots[kTableSize];
+};
+
+template <size_t RouteCount>
+constexpr SentientCommandRouter<RouteCount> makeSentientCommandRouter(const SentientCommandRoute (&routes)[RouteCount])
+{
+  return SentientCommandRouter<RouteCount>(routes);
+}
+
+#endif // SENTIENT_COMMAND_ROUTER_H
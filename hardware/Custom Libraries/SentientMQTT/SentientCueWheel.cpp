@@ -0,0 +1,94 @@
+#include "SentientCueWheel.h"
+
+#include <cstring>
+
+bool SentientCueWheel::schedule(uint64_t dueLocalUs, uint64_t receivedLocalUs, const char *command,
+                                const uint8_t *payload, size_t length)
+{
+  int slot = -1;
+  for (int i = 0; i < SENTIENT_MQTT_CUE_SLOTS; ++i)
+  {
+    if (!_cues[i].used)
+    {
+      slot = i;
+      break;
+    }
+  }
+  // A truncated "<device>/<command>" would fire the wrong command; run it now instead
+  if (slot < 0 || length > SENTIENT_MQTT_CUE_PAYLOAD_SIZE || !command || strlen(command) >= kCommandSize)
+  {
+    ++_stats.rejected;
+    return false;
+  }
+
+  Cue &cue = _cues[slot];
+  cue.dueLocalUs = dueLocalUs;
+  cue.receivedLocalUs = receivedLocalUs;
+  cue.payloadLength = static_cast<uint16_t>(length);
+  cue.used = true;
+  strncpy(cue.command, command, sizeof(cue.command) - 1);
+  cue.command[sizeof(cue.command) - 1] = '\0';
+  if (length > 0)
+  {
+    memcpy(cue.payload, payload, length);
+  }
+
+  // A cue already due lands in the next bucket to be swept rather than one already passed
+  uint64_t tick = dueLocalUs >> SENTIENT_MQTT_CUE_TICK_SHIFT;
+  if (tick < _cursorTick)
+  {
+    tick = _cursorTick;
+  }
+  const uint8_t bucket = bucketFor(tick);
+  cue.next = _heads[bucket];
+  _heads[bucket] = static_cast<int8_t>(slot);
+
+  ++_count;
+  ++_stats.scheduled;
+  return true;
+}
+
+SentientCueWheel::Cue *SentientCueWheel::due(uint64_t nowLocalUs)
+{
+  if (_count == 0)
+  {
+    _cursorTick = nowLocalUs >> SENTIENT_MQTT_CUE_TICK_SHIFT;
+    return nullptr;
+  }
+
+  const uint64_t nowTick = nowLocalUs >> SENTIENT_MQTT_CUE_TICK_SHIFT;
+  if (nowTick - _cursorTick >= kBuckets)
+  {
+    // Fell a whole revolution behind: one pass over every bucket covers it
+    _cursorTick = nowTick - (kBuckets - 1);
+  }
+
+  for (uint64_t tick = _cursorTick; tick <= nowTick; ++tick)
+  {
+    for (int8_t *link = &_heads[bucketFor(tick)]; *link >= 0; link = &_cues[*link].next)
+    {
+      Cue &cue = _cues[*link];
+      if (cue.dueLocalUs <= nowLocalUs)
+      {
+        *link = cue.next;
+        cue.next = -1;
+        --_count;
+        ++_stats.fired;
+        return &cue;
+      }
+    }
+    if (tick < nowTick)
+    {
+      _cursorTick = tick + 1;
+    }
+  }
+  return nullptr;
+}
+
+void SentientCueWheel::release(Cue *cue)
+{
+  if (cue)
+  {
+    cue->used = false;
+  }
+}
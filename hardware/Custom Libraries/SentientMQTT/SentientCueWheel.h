@@ -0,0 +1,74 @@
+/*
+ * SentientCueWheel - Fixed-memory timer wheel for commands scheduled with
+ * "execute_at" in the synchronized clock domain.
+ *
+ * Each cue keeps a copy of the raw command payload and the local 64-bit
+ * microsecond time it is due. Cues hang off one of kBuckets buckets by due
+ * tick (SENTIENT_MQTT_CUE_TICK_SHIFT microseconds per tick), so due() only
+ * looks at the buckets the clock has moved through since the last call,
+ * however many cues are pending. Cues more than one revolution out share a
+ * bucket with nearer ones and are skipped until their own time comes.
+ */
+
+#ifndef SENTIENT_CUE_WHEEL_H
+#define SENTIENT_CUE_WHEEL_H
+
+#include <Arduino.h>
+
+#ifndef SENTIENT_MQTT_CUE_SLOTS
+#define SENTIENT_MQTT_CUE_SLOTS 16
+#endif
+#ifndef SENTIENT_MQTT_CUE_PAYLOAD_SIZE
+#define SENTIENT_MQTT_CUE_PAYLOAD_SIZE 256 // Raw command payload bytes kept per cue
+#endif
+#ifndef SENTIENT_MQTT_CUE_TICK_SHIFT
+#define SENTIENT_MQTT_CUE_TICK_SHIFT 13 // 8.192 ms per tick, ~262 ms per revolution
+#endif
+
+class SentientCueWheel
+{
+public:
+  static constexpr uint8_t kBuckets = 32; // Power of two
+  static constexpr size_t kCommandSize = 64;
+
+  struct Cue
+  {
+    uint64_t dueLocalUs;
+    uint64_t receivedLocalUs;
+    uint16_t payloadLength;
+    int8_t next;
+    bool used;
+    char command[kCommandSize];
+    uint8_t payload[SENTIENT_MQTT_CUE_PAYLOAD_SIZE];
+  };
+
+  struct Stats
+  {
+    uint32_t scheduled = 0;
+    uint32_t fired = 0;
+    uint32_t rejected = 0; // Full wheel or oversized payload; the command ran immediately instead
+  };
+
+  bool schedule(uint64_t dueLocalUs, uint64_t receivedLocalUs, const char *command, const uint8_t *payload,
+                size_t length);
+
+  // Unlinks and returns one cue due at or before `nowLocalUs`, or nullptr. The
+  // cue stays valid until release(), so its payload can be dispatched in place.
+  Cue *due(uint64_t nowLocalUs);
+  void release(Cue *cue);
+
+  uint8_t pending() const { return _count; }
+  const Stats &stats() const { return _stats; }
+
+private:
+  static uint8_t bucketFor(uint64_t tick) { return static_cast<uint8_t>(tick & (kBuckets - 1)); }
+
+  Cue _cues[SENTIENT_MQTT_CUE_SLOTS] = {};
+  int8_t _heads[kBuckets] = {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                             -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+  uint64_t _cursorTick = 0; // Every bucket before this tick has been fully swept
+  uint8_t _count = 0;
+  Stats _stats;
+};
+
+#endif // SENTIENT_CUE_WHEEL_H
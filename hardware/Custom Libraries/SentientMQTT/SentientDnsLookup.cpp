@@ -0,0 +1,215 @@
+#include "SentientDnsLookup.h"
+
+#include <cstring>
+
+namespace
+{
+  constexpr uint16_t kDnsPort = 53;
+  constexpr uint8_t kTypeA = 1;
+  constexpr uint8_t kClassIn = 1;
+  constexpr size_t kHeaderSize = 12;
+  constexpr size_t kMaxHostLength = 253;
+  constexpr size_t kMaxLabelLength = 63;
+
+  // Dot-separated labels of 1..63 characters; one trailing dot is allowed
+  bool validHostName(const char *host)
+  {
+    if (!host || !*host || strlen(host) > kMaxHostLength)
+    {
+      return false;
+    }
+    size_t label = 0;
+    for (const char *c = host; *c; ++c)
+    {
+      if (*c != '.')
+      {
+        if (++label > kMaxLabelLength)
+        {
+          return false;
+        }
+        continue;
+      }
+      if (label == 0)
+      {
+        return false;
+      }
+      label = 0;
+    }
+    return true;
+  }
+} // namespace
+
+bool SentientDnsLookup::start(const IPAddress &server, const char *host)
+{
+  cancel();
+  if (!validHostName(host))
+  {
+    return false;
+  }
+  // Port and query id only have to differ from the previous lookup's, so a late answer to it is ignored
+  if (_udp.begin(static_cast<uint16_t>(49152 + (micros() & 0x3FFF))) != 1)
+  {
+    return false;
+  }
+  _server = server;
+  _host = host;
+  _queryId = static_cast<uint16_t>(_queryId * 31421u + 6927u + micros());
+  _sends = 0;
+  _active = true;
+  if (!sendQuery())
+  {
+    cancel();
+    return false;
+  }
+  return true;
+}
+
+SentientDnsLookup::Status SentientDnsLookup::poll(IPAddress &address)
+{
+  if (!_active)
+  {
+    return Idle;
+  }
+  while (_udp.parsePacket() > 0)
+  {
+    const Status status = _udp.remotePort() == kDnsPort ? readAnswer(address) : Pending;
+    if (status != Pending)
+    {
+      cancel();
+      return status;
+    }
+  }
+
+  if (millis() - _sentAt < kResendMs)
+  {
+    return Pending;
+  }
+  if (_sends >= kAttempts || !sendQuery())
+  {
+    cancel();
+    return Failed;
+  }
+  return Pending;
+}
+
+void SentientDnsLookup::cancel()
+{
+  if (_active)
+  {
+    _udp.stop();
+    _active = false;
+  }
+}
+
+bool SentientDnsLookup::sendQuery()
+{
+  if (_udp.beginPacket(_server, kDnsPort) != 1)
+  {
+    return false;
+  }
+  // One question, recursion desired
+  const uint8_t header[kHeaderSize] = {static_cast<uint8_t>(_queryId >> 8), static_cast<uint8_t>(_queryId), 0x01, 0x00,
+                                       0, 1, 0, 0, 0, 0, 0, 0};
+  _udp.write(header, sizeof(header));
+  for (const char *label = _host; *label;)
+  {
+    const char *dot = strchr(label, '.');
+    const size_t length = dot ? static_cast<size_t>(dot - label) : strlen(label);
+    _udp.write(static_cast<uint8_t>(length));
+    _udp.write(reinterpret_cast<const uint8_t *>(label), length);
+    label += dot ? length + 1 : length;
+  }
+  const uint8_t question[5] = {0, 0, kTypeA, 0, kClassIn};
+  _udp.write(question, sizeof(question));
+  if (_udp.endPacket() != 1)
+  {
+    return false;
+  }
+  ++_sends;
+  _sentAt = millis();
+  return true;
+}
+
+SentientDnsLookup::Status SentientDnsLookup::readAnswer(IPAddress &address)
+{
+  uint8_t header[kHeaderSize];
+  if (_udp.read(header, sizeof(header)) != static_cast<int>(sizeof(header)))
+  {
+    return Pending;
+  }
+  // Someone else's datagram, or the answer to a query this lookup already gave up on
+  const uint16_t id = static_cast<uint16_t>(header[0] << 8 | header[1]);
+  if (id != _queryId || !(header[2] & 0x80))
+  {
+    return Pending;
+  }
+  if ((header[3] & 0x0F) != 0)
+  {
+    return Failed; // NXDOMAIN, SERVFAIL, ...
+  }
+
+  for (uint16_t questions = static_cast<uint16_t>(header[4] << 8 | header[5]); questions > 0; --questions)
+  {
+    if (!skipName() || !skip(4))
+    {
+      return Failed;
+    }
+  }
+  // CNAME records come first; the A record they lead to follows in the same answer
+  for (uint16_t answers = static_cast<uint16_t>(header[6] << 8 | header[7]); answers > 0; --answers)
+  {
+    uint8_t record[10]; // type, class, TTL, data length
+    if (!skipName() || _udp.read(record, sizeof(record)) != static_cast<int>(sizeof(record)))
+    {
+      return Failed;
+    }
+    const uint16_t length = static_cast<uint16_t>(record[8] << 8 | record[9]);
+    if (record[0] == 0 && record[1] == kTypeA && record[2] == 0 && record[3] == kClassIn && length == 4)
+    {
+      uint8_t ip[4];
+      if (_udp.read(ip, sizeof(ip)) != static_cast<int>(sizeof(ip)))
+      {
+        return Failed;
+      }
+      address = IPAddress(ip[0], ip[1], ip[2], ip[3]);
+      return Resolved;
+    }
+    if (!skip(length))
+    {
+      return Failed;
+    }
+  }
+  return Failed;
+}
+
+bool SentientDnsLookup::skipName()
+{
+  for (;;)
+  {
+    const int length = _udp.read();
+    if (length <= 0)
+    {
+      return length == 0;
+    }
+    if ((length & 0xC0) == 0xC0)
+    {
+      return _udp.read() >= 0; // A compression pointer ends the name
+    }
+    if (!skip(static_cast<size_t>(length)))
+    {
+      return false;
+    }
+  }
+}
+
+bool SentientDnsLookup::skip(size_t count)
+{
+  for (; count > 0; --count)
+  {
+    if (_udp.read() < 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,56 @@
+/*
+ * SentientDnsLookup - DNS A-record lookup polled across loop() calls.
+ *
+ * DNSClient::getHostByName() and WiFi.hostByName() send the query and then
+ * wait for the answer: seconds, when the DNS server is slow or gone. This
+ * sends the query from start() and leaves it to poll(), called once per
+ * loop(), to read the answer once one has arrived. An unanswered query is
+ * sent again every kResendMs; after kAttempts sends the lookup fails.
+ */
+
+#ifndef SENTIENT_DNS_LOOKUP_H
+#define SENTIENT_DNS_LOOKUP_H
+
+#include <Arduino.h>
+#include <Udp.h>
+
+class SentientDnsLookup
+{
+public:
+  static constexpr uint32_t kResendMs = 1'000;
+  static constexpr uint8_t kAttempts = 3;
+
+  enum Status : uint8_t
+  {
+    Idle,
+    Pending,
+    Resolved,
+    Failed
+  };
+
+  explicit SentientDnsLookup(UDP &udp) : _udp(udp) {}
+
+  // Sends the first query for `host` to `server`. False for a malformed host name or when no UDP socket is
+  // free; `host` must stay valid until the lookup ends.
+  bool start(const IPAddress &server, const char *host);
+  // Never waits. Resolved fills `address`; Resolved and Failed end the lookup.
+  Status poll(IPAddress &address);
+  void cancel();
+  bool pending() const { return _active; }
+
+private:
+  bool sendQuery();
+  Status readAnswer(IPAddress &address);
+  bool skipName();
+  bool skip(size_t count);
+
+  UDP &_udp;
+  IPAddress _server;
+  const char *_host = nullptr;
+  unsigned long _sentAt = 0;
+  uint16_t _queryId = 0;
+  uint8_t _sends = 0;
+  bool _active = false;
+};
+
+#endif // SENTIENT_DNS_LOOKUP_H
@@ -0,0 +1,132 @@
+#include "SentientHandshakeClient.h"
+
+#include <cstring>
+
+void SentientHandshakeClient::adopt(const uint8_t *connack, size_t length)
+{
+  if (length > kMaxReplay)
+  {
+    length = kMaxReplay;
+  }
+  memcpy(_replay, connack, length);
+  _replayLength = static_cast<uint8_t>(length);
+  _replayPosition = 0;
+  resetInbound();
+}
+
+size_t SentientHandshakeClient::write(uint8_t value)
+{
+  // The broker already has our CONNECT; drop PubSubClient's copy
+  return adopting() ? 1 : _inner.write(value);
+}
+
+size_t SentientHandshakeClient::write(const uint8_t *buffer, size_t size)
+{
+  return adopting() ? size : _inner.write(buffer, size);
+}
+
+int SentientHandshakeClient::available()
+{
+  return adopting() ? _replayLength - _replayPosition : _inner.available();
+}
+
+int SentientHandshakeClient::read()
+{
+  const int value = adopting() ? _replay[_replayPosition++] : _inner.read();
+  if (value >= 0)
+  {
+    const uint8_t byte = static_cast<uint8_t>(value);
+    track(&byte, 1);
+  }
+  return value;
+}
+
+int SentientHandshakeClient::read(uint8_t *buffer, size_t size)
+{
+  if (!adopting())
+  {
+    const int count = _inner.read(buffer, size);
+    if (count > 0)
+    {
+      track(buffer, static_cast<size_t>(count));
+    }
+    return count;
+  }
+  size_t count = 0;
+  while (count < size && adopting())
+  {
+    buffer[count++] = _replay[_replayPosition++];
+  }
+  track(buffer, count);
+  return static_cast<int>(count);
+}
+
+int SentientHandshakeClient::peek()
+{
+  return adopting() ? _replay[_replayPosition] : _inner.peek();
+}
+
+void SentientHandshakeClient::stop()
+{
+  _replayLength = 0;
+  _replayPosition = 0;
+  resetInbound();
+  _inner.stop();
+}
+
+void SentientHandshakeClient::track(const uint8_t *bytes, size_t count)
+{
+  size_t i = 0;
+  while (i < count)
+  {
+    switch (_inboundStage)
+    {
+    case InboundHeader:
+      ++i;
+      _inboundStage = InboundLength;
+      _inboundLengthBytes = 0;
+      _inboundMultiplier = 1;
+      _inboundRemaining = 0;
+      break;
+
+    case InboundLength:
+    {
+      const uint8_t digit = bytes[i++];
+      _inboundRemaining += (digit & 127) * _inboundMultiplier;
+      _inboundMultiplier <<= 7;
+      ++_inboundLengthBytes;
+      if ((digit & 128) != 0 && _inboundLengthBytes < 4)
+      {
+        break;
+      }
+      // Whole packet as PubSubClient stores it: header byte, length bytes, body
+      const uint32_t length = 1 + _inboundLengthBytes + _inboundRemaining;
+      if (_inboundLimit > 0 && length > _inboundLimit)
+      {
+        ++_oversizedPackets;
+        _lastOversizedLength = length;
+      }
+      _inboundStage = _inboundRemaining > 0 ? InboundBody : InboundHeader;
+      break;
+    }
+
+    case InboundBody:
+    {
+      const size_t skip = count - i < _inboundRemaining ? count - i : _inboundRemaining;
+      i += skip;
+      _inboundRemaining -= static_cast<uint32_t>(skip);
+      if (_inboundRemaining == 0)
+      {
+        _inboundStage = InboundHeader;
+      }
+      break;
+    }
+    }
+  }
+}
+
+void SentientHandshakeClient::resetInbound()
+{
+  _inboundStage = InboundHeader;
+  _inboundRemaining = 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * SentientHandshakeClient - Client decorator that lets PubSubClient adopt a
+ * broker session SentientMQTT negotiated itself.
+ *
+ * PubSubClient::connect() writes CONNECT and then spins until CONNACK arrives,
+ * which can stall loop() for the whole socket timeout. SentientMQTT instead
+ * sends CONNECT and polls for CONNACK across loop() calls, then hands the
+ * received CONNACK to this wrapper with adopt(). While adopting, the wrapper
+ * swallows PubSubClient's duplicate CONNECT and replays the buffered CONNACK,
+ * so PubSubClient::connect() returns immediately with the session established.
+ *
+ * It also follows the fixed header of every inbound packet PubSubClient reads:
+ * PubSubClient discards a packet larger than its buffer without a word, so the
+ * wrapper counts those (oversizedPackets()) for SentientMQTT to report.
+ */
+
+#ifndef SENTIENT_HANDSHAKE_CLIENT_H
+#define SENTIENT_HANDSHAKE_CLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+class SentientHandshakeClient : public Client
+{
+public:
+  static constexpr size_t kMaxReplay = 4; // CONNACK is always 4 bytes
+
+  explicit SentientHandshakeClient(Client &inner) : _inner(inner) {}
+
+  void adopt(const uint8_t *connack, size_t length);
+  bool adopting() const { return _replayPosition < _replayLength; }
+
+  // Inbound packets longer than this (PubSubClient's buffer size) are counted; 0 counts none
+  void setInboundLimit(size_t bytes) { _inboundLimit = bytes; }
+  uint32_t oversizedPackets() const { return _oversizedPackets; }
+  uint32_t lastOversizedLength() const { return _lastOversizedLength; }
+
+  int connect(IPAddress ip, uint16_t port) override { return _inner.connect(ip, port); }
+  int connect(const char *host, uint16_t port) override { return _inner.connect(host, port); }
+  size_t write(uint8_t value) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buffer, size_t size) override;
+  int peek() override;
+  void flush() override { _inner.flush(); }
+  void stop() override;
+  uint8_t connected() override { return _inner.connected(); }
+  operator bool() override { return static_cast<bool>(_inner); }
+
+private:
+  enum InboundStage : uint8_t
+  {
+    InboundHeader,
+    InboundLength,
+    InboundBody
+  };
+
+  void track(const uint8_t *bytes, size_t count);
+  void resetInbound();
+
+  Client &_inner;
+  uint8_t _replay[kMaxReplay] = {0};
+  uint8_t _replayLength = 0;
+  uint8_t _replayPosition = 0;
+
+  size_t _inboundLimit = 0;
+  InboundStage _inboundStage = InboundHeader;
+  uint8_t _inboundLengthBytes = 0;
+  uint32_t _inboundMultiplier = 1;
+  uint32_t _inboundRemaining = 0;
+  uint32_t _oversizedPackets = 0;
+  uint32_t _lastOversizedLength = 0;
+};
+
+#endif // SENTIENT_HANDSHAKE_CLIENT_H
@@ -0,0 +1,170 @@
+#include "SentientJsonArena.h"
+#include "SentientMemoryStats.h"
+
+#include <cstdlib>
+#include <cstring>
+
+void *SentientJsonArenaBase::allocate(size_t size)
+{
+  const size_t total = kHeaderSize + alignUp(size);
+  if (total > _capacity - _top)
+  {
+    ++_overflowCount;
+    SentientMemoryStats::recordAllocation();
+    return malloc(size);
+  }
+
+  uint8_t *block = _storage + _top;
+  setBlockSize(block, size);
+  _top += total;
+  if (_top > _highWater)
+  {
+    _highWater = _top;
+  }
+  ++_liveBlocks;
+  return block + kHeaderSize;
+}
+
+void SentientJsonArenaBase::deallocate(void *ptr)
+{
+  if (!ptr)
+  {
+    return;
+  }
+  if (!owns(ptr))
+  {
+    SentientMemoryStats::recordFree();
+    free(ptr);
+    return;
+  }
+
+  uint8_t *block = static_cast<uint8_t *>(ptr) - kHeaderSize;
+  if (_liveBlocks > 0)
+  {
+    --_liveBlocks;
+  }
+
+  if (_liveBlocks == 0)
+  {
+    _top = 0;
+  }
+  else if (block + kHeaderSize + alignUp(blockSize(block)) == _storage + _top)
+  {
+    // Releasing the most recent block: give its space back immediately.
+    _top = static_cast<size_t>(block - _storage);
+  }
+}
+
+void *SentientJsonArenaBase::reallocate(void *ptr, size_t newSize)
+{
+  if (!ptr)
+  {
+    return allocate(newSize);
+  }
+  if (!owns(ptr))
+  {
+    return realloc(ptr, newSize);
+  }
+
+  uint8_t *block = static_cast<uint8_t *>(ptr) - kHeaderSize;
+  const size_t oldSize = blockSize(block);
+  const size_t offset = static_cast<size_t>(block - _storage);
+
+  // The most recent block can grow or shrink in place.
+  if (block + kHeaderSize + alignUp(oldSize) == _storage + _top &&
+      kHeaderSize + alignUp(newSize) <= _capacity - offset)
+  {
+    setBlockSize(block, newSize);
+    _top = offset + kHeaderSize + alignUp(newSize);
+    if (_top > _highWater)
+    {
+      _highWater = _top;
+    }
+    return ptr;
+  }
+
+  if (newSize <= oldSize)
+  {
+    return ptr;
+  }
+
+  void *moved = allocate(newSize);
+  if (!moved)
+  {
+    return nullptr;
+  }
+  memcpy(moved, ptr, oldSize);
+  deallocate(ptr);
+  return moved;
+}
+
+bool SentientJsonArenaBase::attach(uint8_t *storage, size_t capacity)
+{
+  if (_liveBlocks > 0)
+  {
+    return false;
+  }
+  _storage = storage;
+  _capacity = capacity;
+  _top = 0;
+  _highWater = 0;
+  return true;
+}
+
+bool SentientJsonArenaBase::owns(const void *ptr) const
+{
+  const uint8_t *p = static_cast<const uint8_t *>(ptr);
+  return p >= _storage && p < _storage + _capacity;
+}
+
+size_t SentientJsonArenaBase::blockSize(const uint8_t *block) const
+{
+  uint32_t size;
+  memcpy(&size, block, sizeof(size));
+  return size;
+}
+
+void SentientJsonArenaBase::setBlockSize(uint8_t *block, size_t size)
+{
+  const uint32_t stored = static_cast<uint32_t>(size);
+  memcpy(block, &stored, sizeof(stored));
+}
+
+SentientJsonHeapArena::~SentientJsonHeapArena()
+{
+  if (_heap)
+  {
+    SentientMemoryStats::recordFree();
+    free(_heap);
+  }
+}
+
+bool SentientJsonHeapArena::reserve(size_t capacity)
+{
+  if (_heap && capacity == this->capacity())
+  {
+    return true;
+  }
+  // malloc() alignment covers the arena's 8-byte blocks on every supported target
+  uint8_t *storage = capacity > 0 ? static_cast<uint8_t *>(malloc(capacity)) : nullptr;
+  if (capacity > 0 && !storage)
+  {
+    return false;
+  }
+  if (!attach(storage, storage ? capacity : 0))
+  {
+    free(storage);
+    return false;
+  }
+  if (_heap)
+  {
+    SentientMemoryStats::recordFree();
+    free(_heap);
+  }
+  if (storage)
+  {
+    SentientMemoryStats::recordAllocation();
+  }
+  _heap = storage;
+  return true;
+}
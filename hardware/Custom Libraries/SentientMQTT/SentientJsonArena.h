@@ -0,0 +1,91 @@
+/*
+ * SentientJsonArena - Fixed-memory allocator for ArduinoJson documents.
+ *
+ * Backs a JsonDocument with a bump arena carved out of storage owned by the
+ * caller, so building or parsing a document never touches the heap once the
+ * arena is sized for the workload. The arena rewinds as soon as every block
+ * has been released (i.e. on JsonDocument::clear()).
+ *
+ * Requests that do not fit are served by malloc() and counted in
+ * overflowCount(), so the arena can be sized from field data instead of
+ * failing publishes outright.
+ *
+ * SentientJsonArena<N> embeds its storage; SentientJsonHeapArena takes one
+ * heap block at a size chosen at run time (e.g. from SentientMQTTConfig) and
+ * keeps it for the arena's lifetime.
+ */
+
+#ifndef SENTIENT_JSON_ARENA_H
+#define SENTIENT_JSON_ARENA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+class SentientJsonArenaBase : public ArduinoJson::Allocator
+{
+public:
+  void *allocate(size_t size) override;
+  void deallocate(void *ptr) override;
+  void *reallocate(void *ptr, size_t newSize) override;
+
+  size_t capacity() const { return _capacity; }
+  size_t used() const { return _top; }
+  size_t highWater() const { return _highWater; }
+  uint32_t overflowCount() const { return _overflowCount; }
+
+protected:
+  SentientJsonArenaBase(uint8_t *storage, size_t capacity)
+      : _storage(storage), _capacity(capacity) {}
+  ~SentientJsonArenaBase() = default;
+
+  // Swaps in new storage; only while no arena block is live
+  bool attach(uint8_t *storage, size_t capacity);
+
+private:
+  static constexpr size_t kAlignment = 8;
+  static constexpr size_t kHeaderSize = kAlignment;
+
+  static size_t alignUp(size_t size) { return (size + kAlignment - 1) & ~(kAlignment - 1); }
+  bool owns(const void *ptr) const;
+  size_t blockSize(const uint8_t *block) const;
+  void setBlockSize(uint8_t *block, size_t size);
+
+  uint8_t *_storage;
+  size_t _capacity;
+  size_t _top = 0;
+  size_t _highWater = 0;
+  uint16_t _liveBlocks = 0;
+  uint32_t _overflowCount = 0;
+};
+
+template <size_t Capacity>
+class SentientJsonArena : public SentientJsonArenaBase
+{
+public:
+  SentientJsonArena() : SentientJsonArenaBase(_buffer, Capacity) {}
+
+  SentientJsonArena(const SentientJsonArena &) = delete;
+  SentientJsonArena &operator=(const SentientJsonArena &) = delete;
+
+private:
+  alignas(8) uint8_t _buffer[Capacity];
+};
+
+class SentientJsonHeapArena : public SentientJsonArenaBase
+{
+public:
+  // Until reserve() succeeds every request is an overflow served by malloc()
+  SentientJsonHeapArena() : SentientJsonArenaBase(nullptr, 0) {}
+  ~SentientJsonHeapArena();
+
+  SentientJsonHeapArena(const SentientJsonHeapArena &) = delete;
+  SentientJsonHeapArena &operator=(const SentientJsonHeapArena &) = delete;
+
+  // Allocates `capacity` bytes of storage, once; false when out of memory or while documents hold blocks
+  bool reserve(size_t capacity);
+
+private:
+  uint8_t *_heap = nullptr;
+};
+
+#endif // SENTIENT_JSON_ARENA_H
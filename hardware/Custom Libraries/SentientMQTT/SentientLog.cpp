@@ -0,0 +1,199 @@
+#include "SentientLog.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+  constexpr uint32_t kMask = SENTIENT_LOG_BUFFER_SIZE - 1;
+  constexpr uint8_t kNoForward = 0x80; // Level flag: produced by the forwarder itself
+
+  const char kLevelLetters[] = "-EWIDT";
+} // namespace
+
+uint8_t SentientLog::s_ring[SENTIENT_LOG_BUFFER_SIZE];
+uint32_t SentientLog::s_head = 0;
+uint32_t SentientLog::s_tail = 0;
+uint32_t SentientLog::s_dropped = 0;
+uint32_t SentientLog::s_droppedTotal = 0;
+bool SentientLog::s_forwarding = false;
+
+Print *SentientLog::s_output = &Serial;
+SentientLog::Forwarder SentientLog::s_forwarder = nullptr;
+SentientLog::Level SentientLog::s_forwardLevel = SentientLog::None;
+void *SentientLog::s_forwardContext = nullptr;
+
+char SentientLog::s_line[SENTIENT_LOG_MAX_LINE + 24];
+uint16_t SentientLog::s_lineLength = 0;
+uint16_t SentientLog::s_lineSent = 0;
+
+void SentientLog::write(Level level, const char *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  vwrite(level, format, args);
+  va_end(args);
+}
+
+void SentientLog::vwrite(Level level, const char *format, va_list args)
+{
+  char text[SENTIENT_LOG_MAX_LINE];
+  const int formatted = vsnprintf(text, sizeof(text), format, args);
+  if (formatted < 0)
+  {
+    return;
+  }
+  const uint8_t length = static_cast<size_t>(formatted) < sizeof(text) ? formatted : sizeof(text) - 1;
+
+  const uint32_t head = s_head;
+  const uint32_t tail = __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE);
+  if (kHeaderSize + length > SENTIENT_LOG_BUFFER_SIZE - (head - tail))
+  {
+    ++s_dropped;
+    ++s_droppedTotal;
+    return;
+  }
+
+  const uint32_t timeMs = millis();
+  const uint8_t header[kHeaderSize] = {
+      static_cast<uint8_t>(timeMs), static_cast<uint8_t>(timeMs >> 8), static_cast<uint8_t>(timeMs >> 16),
+      static_cast<uint8_t>(timeMs >> 24), static_cast<uint8_t>(level | (s_forwarding ? kNoForward : 0)), length};
+  copyIn(head, header, kHeaderSize);
+  copyIn(head + kHeaderSize, text, length);
+  __atomic_store_n(&s_head, head + kHeaderSize + length, __ATOMIC_RELEASE);
+}
+
+void SentientLog::drain()
+{
+  for (uint8_t lines = 0; lines < SENTIENT_LOG_DRAIN_LINES; ++lines)
+  {
+    if (!flushLine())
+    {
+      return;
+    }
+
+    Level level;
+    uint32_t timeMs;
+    char text[SENTIENT_LOG_MAX_LINE];
+    size_t length;
+    if (!pop(level, timeMs, text, length))
+    {
+      return;
+    }
+    const bool forward = (level & kNoForward) == 0;
+    level = static_cast<Level>(level & ~kNoForward);
+
+    if (s_output)
+    {
+      int written = snprintf(s_line, sizeof(s_line), "[%lu] %c %.*s\r\n", static_cast<unsigned long>(timeMs),
+                             kLevelLetters[level < sizeof(kLevelLetters) - 1 ? level : 0], static_cast<int>(length), text);
+      s_lineLength = written < 0 ? 0 : (static_cast<size_t>(written) < sizeof(s_line) ? written : sizeof(s_line) - 1);
+      s_lineSent = 0;
+    }
+
+    if (forward && s_forwarder && level <= s_forwardLevel)
+    {
+      s_forwarding = true;
+      s_forwarder(level, timeMs, text, s_forwardContext);
+      s_forwarding = false;
+    }
+  }
+}
+
+bool SentientLog::flushLine()
+{
+  if (s_lineSent >= s_lineLength)
+  {
+    return true;
+  }
+  // Nothing listening on USB: let the line go instead of holding up the ring
+  if (!s_output || (s_output == &Serial && !Serial))
+  {
+    s_lineSent = s_lineLength;
+    return true;
+  }
+
+  const int space = s_output->availableForWrite();
+  if (space <= 0)
+  {
+    return false;
+  }
+  const size_t pending = s_lineLength - s_lineSent;
+  const size_t chunk = pending < static_cast<size_t>(space) ? pending : static_cast<size_t>(space);
+  s_lineSent += s_output->write(reinterpret_cast<const uint8_t *>(s_line) + s_lineSent, chunk);
+  return s_lineSent >= s_lineLength;
+}
+
+bool SentientLog::pop(Level &level, uint32_t &timeMs, char *text, size_t &length)
+{
+  const uint32_t tail = s_tail;
+  const uint32_t head = __atomic_load_n(&s_head, __ATOMIC_ACQUIRE);
+  if (head == tail)
+  {
+    if (s_dropped == 0)
+    {
+      return false;
+    }
+    // Report the gap once the ring has room to spare again
+    level = Warn;
+    timeMs = millis();
+    const int written = snprintf(text, SENTIENT_LOG_MAX_LINE, "[SentientLog] %lu lines dropped",
+                                 static_cast<unsigned long>(s_dropped));
+    length = written < 0 ? 0 : written;
+    s_dropped = 0;
+    return true;
+  }
+
+  uint8_t header[kHeaderSize];
+  copyOut(tail, header, kHeaderSize);
+  timeMs = static_cast<uint32_t>(header[0]) | static_cast<uint32_t>(header[1]) << 8 |
+           static_cast<uint32_t>(header[2]) << 16 | static_cast<uint32_t>(header[3]) << 24;
+  level = static_cast<Level>(header[4]);
+  length = header[5];
+  copyOut(tail + kHeaderSize, text, length);
+  text[length] = '\0';
+  __atomic_store_n(&s_tail, tail + kHeaderSize + length, __ATOMIC_RELEASE);
+  return true;
+}
+
+void SentientLog::copyIn(uint32_t at, const void *data, size_t length)
+{
+  const size_t offset = at & kMask;
+  const size_t first = length < SENTIENT_LOG_BUFFER_SIZE - offset ? length : SENTIENT_LOG_BUFFER_SIZE - offset;
+  memcpy(s_ring + offset, data, first);
+  memcpy(s_ring, static_cast<const uint8_t *>(data) + first, length - first);
+}
+
+void SentientLog::copyOut(uint32_t at, void *data, size_t length)
+{
+  const size_t offset = at & kMask;
+  const size_t first = length < SENTIENT_LOG_BUFFER_SIZE - offset ? length : SENTIENT_LOG_BUFFER_SIZE - offset;
+  memcpy(data, s_ring + offset, first);
+  memcpy(static_cast<uint8_t *>(data) + first, s_ring, length - first);
+}
+
+void SentientLog::setForwarder(Forwarder forwarder, Level level, void *context)
+{
+  s_forwarder = forwarder;
+  s_forwardLevel = level;
+  s_forwardContext = context;
+}
+
+const char *SentientLog::levelName(Level level)
+{
+  switch (level)
+  {
+  case Error:
+    return "error";
+  case Warn:
+    return "warn";
+  case Info:
+    return "info";
+  case Debug:
+    return "debug";
+  case Trace:
+    return "trace";
+  default:
+    return "none";
+  }
+}
@@ -0,0 +1,140 @@
+/*
+ * SentientLog - Leveled, non-blocking logging for Sentient controllers.
+ *
+ *   SENTIENT_LOG_WARN("stepper %d stalled at %ld", motor, position);
+ *
+ * A call formats into a fixed ring buffer and returns; it never waits on USB.
+ * drain() (run by SentientMQTT::loop(), or by the sketch when it has no
+ * SentientMQTT) moves lines to Serial only as far as availableForWrite()
+ * allows, so a host that stops reading costs dropped lines, not stalled motion.
+ * When the ring is full new lines are dropped and counted; the next drained
+ * line reports how many.
+ *
+ * Calls above SENTIENT_LOG_LEVEL (default Info) compile to nothing, arguments
+ * included; define it before including this header, per sketch or in the
+ * build flags. The format string stays in flash on Teensy 4.x.
+ *
+ * The ring has one producer and one consumer: log from loop() context only,
+ * not from interrupts. setForwarder() hands each drained line to a callback as
+ * well, which SentientMQTT uses for its logs/<level> topic.
+ */
+
+#ifndef SENTIENT_LOG_H
+#define SENTIENT_LOG_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+
+#define SENTIENT_LOG_LEVEL_NONE 0
+#define SENTIENT_LOG_LEVEL_ERROR 1
+#define SENTIENT_LOG_LEVEL_WARN 2
+#define SENTIENT_LOG_LEVEL_INFO 3
+#define SENTIENT_LOG_LEVEL_DEBUG 4
+#define SENTIENT_LOG_LEVEL_TRACE 5
+
+#ifndef SENTIENT_LOG_LEVEL
+#define SENTIENT_LOG_LEVEL SENTIENT_LOG_LEVEL_INFO
+#endif
+#ifndef SENTIENT_LOG_BUFFER_SIZE
+#define SENTIENT_LOG_BUFFER_SIZE 2048 // Ring capacity in bytes; a power of two
+#endif
+#ifndef SENTIENT_LOG_MAX_LINE
+#define SENTIENT_LOG_MAX_LINE 160 // Longer messages are truncated
+#endif
+#ifndef SENTIENT_LOG_DRAIN_LINES
+#define SENTIENT_LOG_DRAIN_LINES 8 // Upper bound on lines one drain() takes from the ring
+#endif
+
+class SentientLog
+{
+public:
+  enum Level : uint8_t
+  {
+    None = SENTIENT_LOG_LEVEL_NONE,
+    Error = SENTIENT_LOG_LEVEL_ERROR,
+    Warn = SENTIENT_LOG_LEVEL_WARN,
+    Info = SENTIENT_LOG_LEVEL_INFO,
+    Debug = SENTIENT_LOG_LEVEL_DEBUG,
+    Trace = SENTIENT_LOG_LEVEL_TRACE
+  };
+
+  // Called from drain() for each line at or above the forwarder's level
+  using Forwarder = void (*)(Level level, uint32_t timeMs, const char *text, void *context);
+
+  static void write(Level level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+  static void vwrite(Level level, const char *format, va_list args);
+
+  static void drain();
+  static void setOutput(Print *output) { s_output = output; } // nullptr discards; forwarding continues
+  static void setForwarder(Forwarder forwarder, Level level, void *context = nullptr);
+
+  static const char *levelName(Level level);
+  static uint32_t dropped() { return s_droppedTotal; }
+
+private:
+  static constexpr size_t kHeaderSize = 6; // uint32 millis, level, text length
+  static_assert((SENTIENT_LOG_BUFFER_SIZE & (SENTIENT_LOG_BUFFER_SIZE - 1)) == 0,
+                "SENTIENT_LOG_BUFFER_SIZE must be a power of two");
+  static_assert(SENTIENT_LOG_MAX_LINE <= 255, "line length is stored in one byte");
+
+  static bool pop(Level &level, uint32_t &timeMs, char *text, size_t &length);
+  static void copyIn(uint32_t at, const void *data, size_t length);
+  static void copyOut(uint32_t at, void *data, size_t length);
+  static bool flushLine();
+
+  static uint8_t s_ring[SENTIENT_LOG_BUFFER_SIZE];
+  static uint32_t s_head; // Producer position, free-running
+  static uint32_t s_tail; // Consumer position, free-running
+  static uint32_t s_dropped;
+  static uint32_t s_droppedTotal;
+  static bool s_forwarding;
+
+  static Print *s_output;
+  static Forwarder s_forwarder;
+  static Level s_forwardLevel;
+  static void *s_forwardContext;
+
+  // Line being written to the output; resumed on the next drain() when the port is full
+  static char s_line[SENTIENT_LOG_MAX_LINE + 24];
+  static uint16_t s_lineLength;
+  static uint16_t s_lineSent;
+};
+
+#if defined(PSTR) && defined(__IMXRT1062__)
+#define SENTIENT_LOG_FORMAT(format) PSTR(format)
+#else
+#define SENTIENT_LOG_FORMAT(format) format
+#endif
+
+#define SENTIENT_LOG_DISABLED(...) \
+  do                               \
+  {                                \
+  } while (0)
+
+#if SENTIENT_LOG_LEVEL >= SENTIENT_LOG_LEVEL_ERROR
+#define SENTIENT_LOG_ERROR(format, ...) SentientLog::write(SentientLog::Error, SENTIENT_LOG_FORMAT(format), ##__VA_ARGS__)
+#else
+#define SENTIENT_LOG_ERROR(...) SENTIENT_LOG_DISABLED()
+#endif
+#if SENTIENT_LOG_LEVEL >= SENTIENT_LOG_LEVEL_WARN
+#define SENTIENT_LOG_WARN(format, ...) SentientLog::write(SentientLog::Warn, SENTIENT_LOG_FORMAT(format), ##__VA_ARGS__)
+#else
+#define SENTIENT_LOG_WARN(...) SENTIENT_LOG_DISABLED()
+#endif
+#if SENTIENT_LOG_LEVEL >= SENTIENT_LOG_LEVEL_INFO
+#define SENTIENT_LOG_INFO(format, ...) SentientLog::write(SentientLog::Info, SENTIENT_LOG_FORMAT(format), ##__VA_ARGS__)
+#else
+#define SENTIENT_LOG_INFO(...) SENTIENT_LOG_DISABLED()
+#endif
+#if SENTIENT_LOG_LEVEL >= SENTIENT_LOG_LEVEL_DEBUG
+#define SENTIENT_LOG_DEBUG(format, ...) SentientLog::write(SentientLog::Debug, SENTIENT_LOG_FORMAT(format), ##__VA_ARGS__)
+#else
+#define SENTIENT_LOG_DEBUG(...) SENTIENT_LOG_DISABLED()
+#endif
+#if SENTIENT_LOG_LEVEL >= SENTIENT_LOG_LEVEL_TRACE
+#define SENTIENT_LOG_TRACE(format, ...) SentientLog::write(SentientLog::Trace, SENTIENT_LOG_FORMAT(format), ##__VA_ARGS__)
+#else
+#define SENTIENT_LOG_TRACE(...) SENTIENT_LOG_DISABLED()
+#endif
+
+#endif // SENTIENT_LOG_H
@@ -1,14 +1,7 @@
 #include "SentientMQTT.h"
 
-// Temporarily suppress ArduinoJson v7 deprecation warnings for DynamicJsonDocument
-// until we fully migrate to the new JsonDocument API across the codebase.
-#if defined(__GNUC__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
-#endif
-
+#include <cstdlib>
 #include <cstring>
-#include <new>
 
 namespace
 {
@@ -21,12 +14,221 @@ namespace
   {
     return millis() / 1000;
   }
+
+  bool hasText(const char *value)
+  {
+    return value && value[0] != '\0';
+  }
+
+  uint32_t fnv1a(const char *text)
+  {
+    uint32_t hash = 2166136261u;
+    for (; text && *text; ++text)
+    {
+      hash ^= static_cast<uint8_t>(*text);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  // Loop time histogram bounds in microseconds; the last bucket counts anything slower
+  const uint32_t kLoopUsBounds[] = {100, 500, 1'000, 5'000, 20'000, 100'000};
+
+  // Appends a segment at `length`, inserting a '/' separator when needed.
+  // Returns the new length, or 0 when the segment does not fit.
+  size_t appendSegment(char *buffer, size_t capacity, size_t length, const char *segment, size_t segmentLength)
+  {
+    if (segmentLength == 0)
+    {
+      return length;
+    }
+    const bool needsSlash = length > 0 && buffer[length - 1] != '/';
+    if (length + (needsSlash ? 1 : 0) + segmentLength >= capacity)
+    {
+      return 0;
+    }
+    if (needsSlash)
+    {
+      buffer[length++] = '/';
+    }
+    memcpy(buffer + length, segment, segmentLength);
+    length += segmentLength;
+    buffer[length] = '\0';
+    return length;
+  }
+
+  size_t appendSegment(char *buffer, size_t capacity, size_t length, const char *segment)
+  {
+    return hasText(segment) ? appendSegment(buffer, capacity, length, segment, strlen(segment)) : length;
+  }
+
+  size_t appendMqttString(uint8_t *buffer, size_t position, const char *text)
+  {
+    const size_t length = strlen(text);
+    buffer[position++] = static_cast<uint8_t>(length >> 8);
+    buffer[position++] = static_cast<uint8_t>(length & 0xFF);
+    memcpy(buffer + position, text, length);
+    return position + length;
+  }
+
+  // MQTT 3.1.1 CONNECT with clean session and optional credentials, matching
+  // what PubSubClient::connect() would send. Returns 0 when it does not fit.
+  size_t buildConnectPacket(uint8_t *buffer, size_t capacity, const char *clientId,
+                            const char *username, const char *password, uint16_t keepAlive)
+  {
+    const bool credentials = username && password;
+    size_t remaining = 10 + 2 + strlen(clientId);
+    if (credentials)
+    {
+      remaining += 2 + strlen(username) + 2 + strlen(password);
+    }
+    if (remaining + 5 > capacity)
+    {
+      return 0;
+    }
+
+    size_t position = 0;
+    buffer[position++] = 0x10; // CONNECT
+    size_t length = remaining;
+    do
+    {
+      uint8_t digit = length % 128;
+      length /= 128;
+      buffer[position++] = length > 0 ? (digit | 0x80) : digit;
+    } while (length > 0);
+
+    position = appendMqttString(buffer, position, "MQTT");
+    buffer[position++] = 4;                         // protocol level 3.1.1
+    buffer[position++] = credentials ? 0xC2 : 0x02; // username, password, clean session
+    buffer[position++] = static_cast<uint8_t>(keepAlive >> 8);
+    buffer[position++] = static_cast<uint8_t>(keepAlive & 0xFF);
+    position = appendMqttString(buffer, position, clientId);
+    if (credentials)
+    {
+      position = appendMqttString(buffer, position, username);
+      position = appendMqttString(buffer, position, password);
+    }
+    return position;
+  }
+
+  // Must follow the order of SentientMQTT::TopicCategory
+  const char *const kCategoryNames[] = {"sensors", "metrics", "events", "status"};
+
+  // Sensor, metric and state topics only matter for their latest value; everything
+  // else (events, custom categories) is replayed in order after a reconnect.
+  SentientOutboundQueue::Policy queuePolicyFor(const char *category)
+  {
+    if (category && (strcasecmp(category, "sensors") == 0 || strcasecmp(category, "metrics") == 0 ||
+                     strcasecmp(category, "status") == 0))
+    {
+      return SentientOutboundQueue::Coalesce;
+    }
+    return SentientOutboundQueue::Ordered;
+  }
+
+  // Events are the safety-critical traffic; custom categories default to the state lane.
+  SentientPublishLanes::Lane laneFor(const char *category)
+  {
+    if (!category)
+    {
+      return SentientPublishLanes::State;
+    }
+    if (strcasecmp(category, "events") == 0)
+    {
+      return SentientPublishLanes::Safety;
+    }
+    if (strcasecmp(category, "sensors") == 0)
+    {
+      return SentientPublishLanes::Sensors;
+    }
+    if (strcasecmp(category, "metrics") == 0 || strcasecmp(category, "telemetry") == 0)
+    {
+      return SentientPublishLanes::Metrics;
+    }
+    return SentientPublishLanes::State;
+  }
+
+  // Serializes `doc` and turns `{"a":1}` into `,"a":1}` so it can close a payload
+  // whose leading fields are written per message. Returns 0 when it does not fit.
+  size_t buildPayloadTail(const JsonDocument &doc, char *buffer, size_t capacity)
+  {
+    const size_t length = serializeJson(doc, buffer + 1, capacity - 1);
+    if (length < 2 || length >= capacity - 2)
+    {
+      buffer[0] = '\0';
+      return 0;
+    }
+    if (length == 2)
+    {
+      buffer[0] = '}';
+      buffer[1] = '\0';
+      return 1;
+    }
+    buffer[0] = ',';
+    memmove(buffer + 1, buffer + 2, length - 1);
+    buffer[length] = '\0';
+    return length;
+  }
+
+  // Writes `head` followed by `tail` into `buffer`. Returns 0 when it does not fit.
+  size_t joinPayload(char *buffer, size_t capacity, int headLength, const char *tail, size_t tailLength)
+  {
+    if (headLength <= 0 || tailLength == 0 || static_cast<size_t>(headLength) + tailLength >= capacity)
+    {
+      return 0;
+    }
+    memcpy(buffer + headLength, tail, tailLength);
+    buffer[headLength + tailLength] = '\0';
+    return headLength + tailLength;
+  }
 } // namespace
 
 SentientMQTT *SentientMQTT::s_activeInstance = nullptr;
 
 SentientMQTT::SentientMQTT(const SentientMQTTConfig &config)
-    : _config(config), _mqttClient(_networkClient) {}
+    : _config(config), _handshakeClient(_networkClient), _mqttClient(_handshakeClient), _publishDoc(&_publishArena),
+      _batchDoc(&_batchArena)
+{
+  _metrics.publishesAttempted = SentientMetrics::counter("publishes_attempted");
+  _metrics.publishesSucceeded = SentientMetrics::counter("publishes_ok");
+  _metrics.publishesFailed = SentientMetrics::counter("publishes_failed");
+  _metrics.bytesSent = SentientMetrics::counter("bytes_sent");
+  _metrics.reconnects = SentientMetrics::counter("reconnects");
+  _metrics.commandsReceived = SentientMetrics::counter("commands_received");
+  _metrics.parseFailures = SentientMetrics::counter("parse_failures");
+  _metrics.inboundOversized = SentientMetrics::counter("inbound_oversized");
+  _metrics.publishesDropped = SentientMetrics::counter("publishes_dropped");
+  _metrics.loopsPerSecond = SentientMetrics::gauge("loop_hz");
+  _metrics.loopMaxUs = SentientMetrics::gauge("loop_max_us");
+  _metrics.loopUs = SentientMetrics::histogram("loop_us", kLoopUsBounds, sizeof(kLoopUsBounds) / sizeof(kLoopUsBounds[0]));
+  _metrics.registrationProgress = SentientMetrics::gauge("registration_progress");
+  _metrics.registrationMs = SentientMetrics::gauge("registration_ms");
+  _registration.setFingerprintTimeout(_config.registrationFingerprintTimeoutMs);
+  for (CommandSlot &slot : _commandSlots)
+  {
+    slot.arena.reserve(_config.commandJsonCapacity);
+  }
+  _publishArena.reserve(_config.publishJsonCapacity);
+  const size_t payloadBufferSize = _config.payloadBufferSize > SentientTrace::kChunkCapacity
+                                       ? _config.payloadBufferSize
+                                       : SentientTrace::kChunkCapacity;
+  _payloadBuffer = static_cast<char *>(malloc(payloadBufferSize));
+  if (_payloadBuffer)
+  {
+    _payloadBuffer[0] = '\0';
+    _payloadBufferSize = payloadBufferSize;
+  }
+}
+
+SentientMQTT::~SentientMQTT()
+{
+  if (s_activeInstance == this)
+  {
+    s_activeInstance = nullptr;
+  }
+  free(_deferredPayload);
+  free(_payloadBuffer);
+}
 
 bool SentientMQTT::begin()
 {
@@ -38,6 +240,12 @@ bool SentientMQTT::begin()
     return false;
   }
 
+  if (!_payloadBuffer)
+  {
+    Serial.println(F("[SentientMQTT] no memory for the payload buffer"));
+    return false;
+  }
+
   if (!configureNetwork())
   {
     Serial.println(F("[SentientMQTT] network configuration failed"));
@@ -50,12 +258,19 @@ bool SentientMQTT::begin()
   }
   _mqttClient.setKeepAlive(_config.keepAliveSeconds);
 
-  // Set buffer size based on publishJsonCapacity
-  size_t required = static_cast<size_t>(_config.publishJsonCapacity) * 4;
-  if (required < 2048)
+  SentientMemoryStats::paintStack();
+  SentientTrace::begin();
+  buildTemplates();
+  if (_config.logForwardLevel != SentientLog::None)
   {
-    required = 2048;
+    SentientLog::setForwarder(&SentientMQTT::forwardLog, _config.logForwardLevel, this);
   }
+
+  // Outbound messages that do not fit are streamed in chunks, so the buffer only
+  // has to hold the command subscription and inbound command packets.
+  const uint16_t required = _config.clientBufferSize < SENTIENT_MQTT_MAX_TOPIC_LENGTH * 2
+                                ? SENTIENT_MQTT_MAX_TOPIC_LENGTH * 2
+                                : _config.clientBufferSize;
   Serial.print(F("[SentientMQTT] Setting buffer size to: "));
   Serial.println(required);
   if (!_mqttClient.setBufferSize(required))
@@ -68,6 +283,7 @@ bool SentientMQTT::begin()
     Serial.print(F("[SentientMQTT] buffer size set successfully to: "));
     Serial.println(_mqttClient.getBufferSize());
   }
+  _handshakeClient.setInboundLimit(_mqttClient.getBufferSize());
 
   if (isValidIp(_config.brokerIp))
   {
@@ -91,6 +307,15 @@ bool SentientMQTT::begin()
     return false;
   }
 
+  _lanes.configure(_config.laneBudgets, millis());
+
+  _brokerTarget = isValidIp(_config.brokerIp) ? TargetIp : TargetHost;
+  _jitterSeed = fnv1a(_config.puzzleId) ^ fnv1a(_config.deviceId);
+  if (_config.reconnectMinDelayMs == 0 || _config.reconnectMinDelayMs > _config.reconnectDelayMs)
+  {
+    _config.reconnectMinDelayMs = _config.reconnectDelayMs;
+  }
+
   s_activeInstance = this;
   _mqttClient.setCallback(mqttCallbackThunk);
 
@@ -112,8 +337,18 @@ void SentientMQTT::loop()
   fnet_service_poll();
 #endif
 
+  _clock.localMicros(); // Keeps the 64-bit clock across micros() wrap-around
+  sampleLoop();
+  runDueCues();
+  stepBrokerLookup();
   ensureConnected();
   _mqttClient.loop();
+  reportOversizedPackets();
+  runDueCues();
+  drainOutbound();
+  stepRegistration();
+  stepTimeSync();
+  stepTraceDump();
 
   if (_config.autoHeartbeat && _mqttClient.connected())
   {
@@ -123,11 +358,257 @@ void SentientMQTT::loop()
       publishHeartbeat();
     }
   }
+
+  if (_config.metricsIntervalMs > 0 && _mqttClient.connected() &&
+      millis() - _lastMetricsPublish >= _config.metricsIntervalMs)
+  {
+    publishMetricsRegistry();
+  }
+
+  SentientLog::drain();
+
+  if (millis() - _lastTracePersist >= 250)
+  {
+    _lastTracePersist = millis();
+    SentientTrace::persist();
+  }
+}
+
+void SentientMQTT::reportOversizedPackets()
+{
+  // PubSubClient consumes and drops these silently; the command never reaches the sketch
+  const uint32_t oversized = _handshakeClient.oversizedPackets();
+  if (oversized == _oversizedReported)
+  {
+    return;
+  }
+  SentientMetrics::add(_metrics.inboundOversized, oversized - _oversizedReported);
+  _oversizedReported = oversized;
+  SENTIENT_LOG_ERROR("[SentientMQTT] inbound packet of %lu bytes dropped: larger than clientBufferSize (%u)",
+                     static_cast<unsigned long>(_handshakeClient.lastOversizedLength()),
+                     static_cast<unsigned>(_mqttClient.getBufferSize()));
+}
+
+void SentientMQTT::sampleLoop()
+{
+  // The gap between loop() calls is the sketch's whole loop time, including this library
+  const uint32_t nowUs = micros();
+  if (_lastLoopUs != 0)
+  {
+    const uint32_t loopUs = nowUs - _lastLoopUs;
+    SentientMetrics::observe(_metrics.loopUs, loopUs);
+    if (loopUs > _loopMaxUs)
+    {
+      _loopMaxUs = loopUs;
+    }
+  }
+  _lastLoopUs = nowUs;
+
+  ++_loopsThisSecond;
+  const unsigned long now = millis();
+  const unsigned long elapsed = now - _loopRateStart;
+  if (elapsed >= 1'000)
+  {
+    SentientMetrics::set(_metrics.loopsPerSecond, _loopsThisSecond * 1000.0f / elapsed);
+    _loopsThisSecond = 0;
+    _loopRateStart = now;
+  }
+}
+
+bool SentientMQTT::publishMetricsRegistry()
+{
+  _lastMetricsPublish = millis();
+
+  // Worst loop since the previous frame, so one slow show cue is not masked by a later quiet period
+  SentientMetrics::set(_metrics.loopMaxUs, static_cast<float>(_loopMaxUs));
+  _loopMaxUs = 0;
+
+  JsonDocument &doc = _publishDoc;
+  doc.clear();
+  doc["timestamp"] = secondsSinceBoot();
+  stampEpoch(doc);
+  SentientMetrics::write(doc.as<JsonObject>());
+  return publishJson(TopicMetrics, "registry", doc, false, SentientOutboundQueue::Coalesce,
+                     SentientPublishLanes::Metrics);
+}
+
+void SentientMQTT::stepTraceDump()
+{
+  // One chunk per loop, and only behind an empty queue, so a dump never crowds out live traffic
+  if (!SentientTrace::dumping() || !_mqttClient.connected() || !_outbound.empty())
+  {
+    return;
+  }
+  // The constructor never sizes the payload buffer below SentientTrace::kChunkCapacity
+  const size_t length = SentientTrace::nextChunk(reinterpret_cast<uint8_t *>(_payloadBuffer), _payloadBufferSize);
+  if (length == 0)
+  {
+    SENTIENT_LOG_INFO("[SentientMQTT] trace dump complete");
+    return;
+  }
+  if (buildTopic(_topicBuffer, sizeof(_topicBuffer), "trace", "dump"))
+  {
+    publishRaw(_topicBuffer, reinterpret_cast<const uint8_t *>(_payloadBuffer), length, false,
+               SentientOutboundQueue::Ordered, SentientPublishLanes::Metrics);
+  }
+}
+
+void SentientMQTT::stepRegistration()
+{
+  // Not before completeConnect(): its sessionStarted() decides between resuming and starting over,
+  // and the fingerprint verdict arrives on the command subscription it makes
+  if (!_mqttClient.connected() || !_wasConnected)
+  {
+    return;
+  }
+  _registration.checkVerdict(millis());
+  if (_registration.fingerprintDue())
+  {
+    publishRegistrationFingerprint();
+    return;
+  }
+
+  // One record per loop, behind live traffic, and only once the socket can take it
+  if (!_registration.pending() || !_outbound.empty())
+  {
+    return;
+  }
+  SentientRegistrationSource &source = *_registration.source();
+  const size_t index = _registration.next();
+  const char *topic = source.recordTopic(index);
+  const size_t length = source.recordLength(index);
+  const size_t packetSize = SentientStreamWriter::packetSize(topic, length);
+  const size_t needed = packetSize < _config.registrationTxBytes ? packetSize : _config.registrationTxBytes;
+  if (socketWriteSpace() < needed)
+  {
+    return;
+  }
+
+  if (!sendRegistrationRecord(source, index, topic, length))
+  {
+    // Stays at this record; a dropped session resumes here after the reconnect
+    SENTIENT_LOG_WARN("[SentientMQTT] registration record %u/%u failed", static_cast<unsigned>(index + 1),
+                      static_cast<unsigned>(_registration.total()));
+    return;
+  }
+  const bool done = _registration.sent(millis());
+  SentientMetrics::set(_metrics.registrationProgress, _registration.progress());
+  if (done)
+  {
+    SentientMetrics::set(_metrics.registrationMs, static_cast<float>(_registration.lastDurationMs()));
+    SENTIENT_LOG_INFO("[SentientMQTT] registration complete: %u records in %lu ms",
+                      static_cast<unsigned>(_registration.total()),
+                      static_cast<unsigned long>(_registration.lastDurationMs()));
+  }
+}
+
+bool SentientMQTT::publishRegistrationFingerprint()
+{
+  if (!buildTopic(_topicBuffer, sizeof(_topicBuffer), "register", "fingerprint"))
+  {
+    return false;
+  }
+  SentientRegistrationSource &source = *_registration.source();
+  const uint32_t hash = source.manifestHash();
+  char hashText[9];
+  snprintf(hashText, sizeof(hashText), "%08lx", static_cast<unsigned long>(hash));
+
+  JsonDocument &doc = _publishDoc;
+  doc.clear();
+  doc["controller_id"] = source.controllerId();
+  doc["firmware_version"] = source.firmwareVersion();
+  doc["manifest_hash"] = hashText;
+  // Never queued: a fingerprint from an old session would start a verdict timer for nothing
+  if (!publishSerialized(doc, false, SentientOutboundQueue::DropWhenOffline, SentientPublishLanes::Ack))
+  {
+    return false;
+  }
+  _registration.fingerprintSent(hash, millis());
+  return true;
+}
+
+void SentientMQTT::handleManifestKnown(const JsonDocument &reply)
+{
+  const char *hashText = reply["manifest_hash"] | "";
+  if (hashText[0] == '\0')
+  {
+    return;
+  }
+  const uint32_t hash = static_cast<uint32_t>(strtoul(hashText, nullptr, 16));
+  if (_registration.known(hash, millis()))
+  {
+    SentientMetrics::set(_metrics.registrationProgress, 1.0f);
+    SentientMetrics::set(_metrics.registrationMs, static_cast<float>(_registration.lastDurationMs()));
+    SENTIENT_LOG_INFO("[SentientMQTT] manifest %08lx already registered; %u records skipped",
+                      static_cast<unsigned long>(hash), static_cast<unsigned>(_registration.total()));
+  }
+}
+
+bool SentientMQTT::sendRegistrationRecord(SentientRegistrationSource &source, size_t index, const char *topic,
+                                          size_t length)
+{
+  const uint16_t tracedLength = length > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(length);
+  SentientMetrics::add(_metrics.publishesAttempted);
+  bool ok = _mqttClient.beginPublish(topic, static_cast<unsigned int>(length), false);
+  if (ok)
+  {
+    SentientStreamWriter writer(_mqttClient, _config.streamStallUs);
+    source.writeRecord(index, writer);
+    if (!writer.finish() || writer.written() != length)
+    {
+      // The broker has a partial packet it can never complete; start a fresh session
+      _mqttClient.disconnect();
+      ok = false;
+    }
+    else
+    {
+      ok = _mqttClient.endPublish();
+    }
+  }
+  if (!ok)
+  {
+    SentientMetrics::add(_metrics.publishesFailed);
+    SentientTrace::record(SentientTrace::PublishFailed, tracedLength, SentientTrace::hash(topic));
+    return false;
+  }
+  SentientTrace::record(SentientTrace::Publish, tracedLength, SentientTrace::hash(topic));
+  SentientMetrics::add(_metrics.publishesSucceeded);
+  SentientMetrics::add(_metrics.bytesSent, SentientStreamWriter::packetSize(topic, length));
+  return true;
+}
+
+size_t SentientMQTT::socketWriteSpace()
+{
+#if defined(ESP32)
+  // WiFiClient does not report its send buffer; lwIP queues whatever write() hands it
+  return SIZE_MAX;
+#else
+  const int space = _networkClient.availableForWrite();
+  return space > 0 ? static_cast<size_t>(space) : 0;
+#endif
+}
+
+void SentientMQTT::forwardLog(SentientLog::Level level, uint32_t timeMs, const char *text, void *context)
+{
+  SentientMQTT *self = static_cast<SentientMQTT *>(context);
+  if (!self)
+  {
+    return;
+  }
+  JsonDocument &doc = self->_publishDoc;
+  doc.clear();
+  doc["level"] = SentientLog::levelName(level);
+  doc["message"] = text;
+  doc["uptimeMs"] = timeMs;
+  doc["timestamp"] = secondsSinceBoot();
+  self->stampEpoch(doc);
+  self->publishJson("logs", SentientLog::levelName(level), doc, false, SentientPublishLanes::Metrics);
 }
 
 bool SentientMQTT::publishSensor(const char *name, float value, const char *unit)
 {
-  DynamicJsonDocument doc(_config.publishJsonCapacity);
+  JsonDocument &doc = _publishDoc;
+  doc.clear();
   doc["name"] = name ? name : "sensor";
   doc["value"] = value;
   if (unit && unit[0] != '\0')
@@ -135,12 +616,14 @@ bool SentientMQTT::publishSensor(const char *name, float value, const char *unit
     doc["unit"] = unit;
   }
   doc["timestamp"] = secondsSinceBoot();
-  return publishJson("sensors", name, doc);
+  stampEpoch(doc);
+  return publishJson(TopicSensors, name, doc, false, SentientOutboundQueue::Coalesce, SentientPublishLanes::Sensors);
 }
 
 bool SentientMQTT::publishMetric(const char *name, float value, const char *unit)
 {
-  DynamicJsonDocument doc(_config.publishJsonCapacity);
+  JsonDocument &doc = _publishDoc;
+  doc.clear();
   doc["name"] = name ? name : "metric";
   doc["value"] = value;
   if (unit && unit[0] != '\0')
@@ -148,26 +631,31 @@ bool SentientMQTT::publishMetric(const char *name, float value, const char *unit
     doc["unit"] = unit;
   }
   doc["timestamp"] = secondsSinceBoot();
-  return publishJson("metrics", name, doc);
+  stampEpoch(doc);
+  return publishJson(TopicMetrics, name, doc, false, SentientOutboundQueue::Coalesce, SentientPublishLanes::Metrics);
 }
 
 bool SentientMQTT::publishState(const char *state)
 {
-  DynamicJsonDocument doc(_config.publishJsonCapacity);
+  JsonDocument &doc = _publishDoc;
+  doc.clear();
   doc["state"] = state ? state : "unknown";
   doc["timestamp"] = secondsSinceBoot();
+  stampEpoch(doc);
   if (_config.deviceId)
   {
     doc["deviceId"] = _config.deviceId;
   }
-  return publishJson("status", "state", doc, true);
+  return publishJson(TopicStatus, "state", doc, true, SentientOutboundQueue::Coalesce, SentientPublishLanes::State);
 }
 
 bool SentientMQTT::publishState(const char *state, const JsonDocument &extras)
 {
-  DynamicJsonDocument doc(_config.publishJsonCapacity);
+  JsonDocument &doc = _publishDoc;
+  doc.clear();
   doc["state"] = state ? state : "unknown";
   doc["timestamp"] = secondsSinceBoot();
+  stampEpoch(doc);
   if (_config.deviceId)
   {
     doc["deviceId"] = _config.deviceId;
@@ -178,33 +666,71 @@ bool SentientMQTT::publishState(const char *state, const JsonDocument &extras)
   {
     doc[kv.key()] = kv.value();
   }
-  return publishJson("status", "state", doc, true);
+  return publishJson(TopicStatus, "state", doc, true, SentientOutboundQueue::Coalesce, SentientPublishLanes::State);
 }
 
 bool SentientMQTT::publishEvent(const char *eventName, const JsonDocument &payload)
 {
   const char *name = (eventName && eventName[0] != '\0') ? eventName : "Event";
-  return publishJson("events", name, payload);
+  return publishJson(TopicEvents, name, payload, false, SentientOutboundQueue::Ordered, SentientPublishLanes::Safety);
 }
 
 bool SentientMQTT::publishJson(const char *category, const char *item, const JsonDocument &payload, bool retain)
 {
-  String topic = buildTopic(category, item);
-  String message;
-  serializeJson(payload, message);
-  return publishRaw(topic, message.c_str(), retain);
+  return publishJson(category, item, payload, retain, laneFor(category));
+}
+
+bool SentientMQTT::publishJson(const char *category, const char *item, const JsonDocument &payload, bool retain,
+                               SentientPublishLanes::Lane lane)
+{
+  if (!buildTopic(_topicBuffer, sizeof(_topicBuffer), category, item))
+  {
+    SENTIENT_LOG_WARN("[SentientMQTT] topic too long: %s/%s", category ? category : "", item ? item : "");
+    return false;
+  }
+  return publishSerialized(payload, retain, queuePolicyFor(category), lane);
+}
+
+bool SentientMQTT::publishJson(TopicCategory category, const char *item, const JsonDocument &payload, bool retain,
+                               SentientOutboundQueue::Policy policy, SentientPublishLanes::Lane lane)
+{
+  if (!buildTopic(_topicBuffer, sizeof(_topicBuffer), category, item))
+  {
+    SENTIENT_LOG_WARN("[SentientMQTT] topic too long: %s/%s", kCategoryNames[category], item ? item : "");
+    return false;
+  }
+  return publishSerialized(payload, retain, policy, lane);
+}
+
+bool SentientMQTT::publishSerialized(const JsonDocument &payload, bool retain, SentientOutboundQueue::Policy policy,
+                                     SentientPublishLanes::Lane lane)
+{
+  // serializeJson() stops one byte short of the end to null-terminate, so a
+  // payload that fills the scratch buffer may have been truncated: stream it.
+  const size_t length = serializeJson(payload, _payloadBuffer, _payloadBufferSize);
+  if (length >= _payloadBufferSize - 1)
+  {
+    return publishStreamed(_topicBuffer, payload, retain, policy, lane);
+  }
+  return publishRaw(_topicBuffer, reinterpret_cast<const uint8_t *>(_payloadBuffer), length, retain, policy, lane);
 }
 
 bool SentientMQTT::publishText(const char *category, const char *item, const char *payload, bool retain)
 {
-  String topic = buildTopic(category, item);
+  if (!buildTopic(_topicBuffer, sizeof(_topicBuffer), category, item))
+  {
+    SENTIENT_LOG_WARN("[SentientMQTT] topic too long: %s/%s", category ? category : "", item ? item : "");
+    return false;
+  }
   const char *safePayload = (payload && payload[0] != '\0') ? payload : "";
-  return publishRaw(topic, safePayload, retain);
+  return publishRaw(_topicBuffer, reinterpret_cast<const uint8_t *>(safePayload), strlen(safePayload), retain,
+                    queuePolicyFor(category), laneFor(category));
 }
 
 bool SentientMQTT::publishHeartbeat()
 {
-  DynamicJsonDocument doc(_config.publishJsonCapacity);
+  JsonDocument &doc = _publishDoc;
+  doc.clear();
 
   // If custom heartbeat builder is provided, use ONLY its output (stateless minimal heartbeat)
   if (_heartbeatBuilder)
@@ -214,10 +740,15 @@ bool SentientMQTT::publishHeartbeat()
       return false;
     }
   }
+  else if (_heartbeatTailLength > 0)
+  {
+    return publishDefaultHeartbeat();
+  }
   else
   {
     // Default heartbeat (legacy - for backward compatibility)
     doc["timestamp"] = secondsSinceBoot();
+    stampEpoch(doc);
     doc["state"] = _mqttClient.connected() ? "online" : "disconnected";
     if (_config.deviceId)
     {
@@ -232,6 +763,10 @@ bool SentientMQTT::publishHeartbeat()
     {
       doc["puzzleId"] = _config.puzzleId;
     }
+    if (_config.heartbeatMemory)
+    {
+      SentientMemoryStats::write(doc["memory"].to<JsonObject>());
+    }
   }
 
   return publishHeartbeat(doc);
@@ -239,7 +774,8 @@ bool SentientMQTT::publishHeartbeat()
 
 bool SentientMQTT::publishHeartbeat(const JsonDocument &payload)
 {
-  bool ok = publishJson("status", "heartbeat", payload, false);
+  bool ok = publishJson(TopicStatus, "heartbeat", payload, false, SentientOutboundQueue::DropWhenOffline,
+                        SentientPublishLanes::State);
   if (ok)
   {
     _lastHeartbeat = millis();
@@ -247,31 +783,176 @@ bool SentientMQTT::publishHeartbeat(const JsonDocument &payload)
   return ok;
 }
 
-void SentientMQTT::setCommandCallback(SentientCommandCallback callback, void *context)
+bool SentientMQTT::publishDefaultHeartbeat()
 {
-  _commandCallback = callback;
-  _commandContext = context;
-}
+  if (!buildTopic(_topicBuffer, sizeof(_topicBuffer), TopicStatus, "heartbeat"))
+  {
+    return false;
+  }
 
-void SentientMQTT::setHeartbeatBuilder(SentientHeartbeatBuilder callback, void *context)
-{
-  _heartbeatBuilder = callback;
-  _heartbeatContext = context;
-}
+  int headLength = snprintf(_payloadBuffer, _payloadBufferSize, "{\"timestamp\":%lu,\"state\":\"%s\"",
+                            secondsSinceBoot(), _mqttClient.connected() ? "online" : "disconnected");
+  headLength = appendEpochMs(_payloadBuffer, _payloadBufferSize, headLength);
+  if (_config.heartbeatMemory)
+  {
+    headLength = appendMemoryStats(_payloadBuffer, _payloadBufferSize, headLength);
+  }
+  const size_t length = joinPayload(_payloadBuffer, _payloadBufferSize, headLength, _heartbeatTail, _heartbeatTailLength);
+  if (length == 0)
+  {
+    return false;
+  }
 
-void SentientMQTT::setOnConnect(SentientConnectionCallback callback, void *context)
-{
-  _onConnect = callback;
-  _onConnectContext = context;
+  bool ok = publishRaw(_topicBuffer, reinterpret_cast<const uint8_t *>(_payloadBuffer), length, false,
+                       SentientOutboundQueue::DropWhenOffline, SentientPublishLanes::State);
+  if (ok)
+  {
+    _lastHeartbeat = millis();
+  }
+  return ok;
 }
 
-void SentientMQTT::setOnDisconnect(SentientConnectionCallback callback, void *context)
+bool SentientMQTT::beginBatch()
 {
-  _onDisconnect = callback;
-  _onDisconnectContext = context;
+  if (_batchOpen)
+  {
+    return false;
+  }
+  _batchDoc.clear();
+  if (_batchArena.capacity() == 0)
+  {
+    _batchArena.reserve(_config.batchJsonCapacity); // Sketches that never batch never pay for the arena
+  }
+  _batchDoc["timestamp"] = secondsSinceBoot();
+  stampEpoch(_batchDoc);
+  _batchItems = _batchDoc["items"].to<JsonArray>();
+  _batchCount = 0;
+  _batchOpen = true;
+  return true;
 }
 
-bool SentientMQTT::configureNetwork()
+bool SentientMQTT::add(const char *item, const JsonDocument &payload)
+{
+  JsonObject entry = addBatchItem(item);
+  if (entry.isNull())
+  {
+    return false;
+  }
+
+  if (!payload.is<JsonObjectConst>())
+  {
+    entry["value"] = payload.as<JsonVariantConst>();
+  }
+  else
+  {
+    for (JsonPairConst kv : payload.as<JsonObjectConst>())
+    {
+      entry[kv.key()] = kv.value();
+    }
+  }
+  flushFullBatch();
+  return true;
+}
+
+bool SentientMQTT::add(const char *item, float value, const char *unit)
+{
+  JsonObject entry = addBatchItem(item);
+  if (entry.isNull())
+  {
+    return false;
+  }
+
+  entry["value"] = value;
+  if (hasText(unit))
+  {
+    entry["unit"] = unit;
+  }
+  flushFullBatch();
+  return true;
+}
+
+bool SentientMQTT::commitBatch()
+{
+  if (!_batchOpen)
+  {
+    return false;
+  }
+  _batchOpen = false;
+  if (_batchCount == 0)
+  {
+    return true;
+  }
+
+  _batchDoc["count"] = _batchCount;
+  // Every frame carries distinct changes, so frames are replayed in order rather than coalesced
+  const bool ok =
+      publishJson(TopicSensors, "batch", _batchDoc, false, SentientOutboundQueue::Ordered, SentientPublishLanes::Sensors);
+  _batchDoc.clear();
+  _batchCount = 0;
+  return ok;
+}
+
+JsonObject SentientMQTT::addBatchItem(const char *item)
+{
+  if (!_batchOpen || !hasText(item))
+  {
+    return JsonObject();
+  }
+
+  JsonObject entry = _batchItems.add<JsonObject>();
+  entry["item"] = item;
+  entry["timestamp"] = secondsSinceBoot();
+  stampEpoch(entry);
+  entry["uptimeMs"] = millis();
+  ++_batchCount;
+  return entry;
+}
+
+void SentientMQTT::flushFullBatch()
+{
+  // Leave a quarter of the arena as headroom for the next item's fields
+  const bool arenaFull = _batchArena.used() >= _batchArena.capacity() - _batchArena.capacity() / 4;
+  if (_batchCount >= SENTIENT_MQTT_BATCH_MAX_ITEMS || arenaFull)
+  {
+    commitBatch();
+    beginBatch();
+  }
+}
+
+void SentientMQTT::setCommandCallback(SentientCommandCallback callback, void *context)
+{
+  _commandCallback = callback;
+  _commandContext = context;
+}
+
+void SentientMQTT::setHeartbeatBuilder(SentientHeartbeatBuilder callback, void *context)
+{
+  _heartbeatBuilder = callback;
+  _heartbeatContext = context;
+}
+
+void SentientMQTT::setOnConnect(SentientConnectionCallback callback, void *context)
+{
+  _onConnect = callback;
+  _onConnectContext = context;
+}
+
+void SentientMQTT::setOnDisconnect(SentientConnectionCallback callback, void *context)
+{
+  _onDisconnect = callback;
+  _onDisconnectContext = context;
+}
+
+void SentientMQTT::setRegistration(SentientRegistrationSource *source)
+{
+  _registration.setSource(source);
+  if (source && _mqttClient.connected())
+  {
+    _registration.sessionStarted(millis());
+  }
+}
+
+bool SentientMQTT::configureNetwork()
 {
   if (!Serial)
   {
@@ -426,15 +1107,24 @@ void SentientMQTT::ensureConnected()
 {
   if (_mqttClient.connected())
   {
-    if (!_wasConnected)
+    if (_connectStage == ConnectSubscribe)
+    {
+      completeConnect();
+    }
+    else if (!_wasConnected)
     {
       _wasConnected = true;
       if (_onConnect)
       {
         _onConnect(_onConnectContext);
       }
-      String onlinePayload = buildConnectionPayload("online");
-      publishRaw(buildTopic("status", "connection"), onlinePayload.c_str(), true);
+      const size_t length = buildConnectionPayload("online");
+      if (buildTopic(_topicBuffer, sizeof(_topicBuffer), TopicStatus, "connection"))
+      {
+        publishRaw(_topicBuffer, reinterpret_cast<const uint8_t *>(_payloadBuffer), length, true,
+                   SentientOutboundQueue::DropWhenOffline, SentientPublishLanes::Safety);
+      }
+      _registration.sessionStarted(millis());
     }
     return;
   }
@@ -442,61 +1132,326 @@ void SentientMQTT::ensureConnected()
   if (_wasConnected)
   {
     _wasConnected = false;
+    SentientTrace::record(SentientTrace::Disconnect, 0, static_cast<uint32_t>(_mqttClient.state()));
     if (_onDisconnect)
     {
       _onDisconnect(_onDisconnectContext);
     }
+    // Spread reconnects so a broker restart is not met by every controller at once
+    _connectFailures = 0;
+    scheduleReconnect();
   }
 
-  const unsigned long now = millis();
-  if (now - _lastConnectAttempt < _config.reconnectDelayMs)
+  // Connecting without a link only burns the socket timeout; retry the moment it returns
+  if (!linkUp())
   {
+    if (_linkWasUp)
+    {
+      SENTIENT_LOG_WARN("[SentientMQTT] Network link down");
+      _linkWasUp = false;
+    }
+    if (_connectStage != ConnectIdle)
+    {
+      _handshakeClient.stop();
+      _connectStage = ConnectIdle;
+    }
     return;
   }
-  _lastConnectAttempt = now;
+  if (!_linkWasUp)
+  {
+    SENTIENT_LOG_INFO("[SentientMQTT] Network link up, reconnecting");
+    _linkWasUp = true;
+    _connectFailures = 0;
+    _nextConnectAt = millis();
+  }
 
-  String clientId = buildClientId();
-  String willTopic = buildTopic("status", "connection");
-  String willPayload = buildConnectionPayload("offline");
+  stepConnect();
+}
 
-  // Debug output for connection attempt
-  Serial.println(F("\n[SentientMQTT] Attempting broker connection:"));
-  Serial.print(F("  Client ID: "));
-  Serial.println(clientId);
-  Serial.print(F("  Will Topic: "));
-  Serial.println(willTopic);
-  Serial.print(F("  Will Topic Length: "));
-  Serial.println(willTopic.length());
-  Serial.print(F("  Will Payload: "));
-  Serial.println(willPayload);
-  Serial.print(F("  Will Payload Length: "));
-  Serial.println(willPayload.length());
-  Serial.print(F("  Username: "));
-  Serial.println(_config.username ? _config.username : "null");
-  Serial.print(F("  Password: "));
-  Serial.println(_config.password ? "***SET***" : "null");
+bool SentientMQTT::linkUp()
+{
+#if defined(ESP32)
+  return WiFi.status() == WL_CONNECTED;
+#else
+  // Unknown (no PHY status) is treated as up so boards without link detection still connect
+  return Ethernet.linkStatus() != LinkOFF;
+#endif
+}
 
-  bool connected = false;
+void SentientMQTT::scheduleReconnect()
+{
+  uint32_t delayMs = _config.reconnectMinDelayMs;
+  for (uint8_t i = 0; i < _connectFailures && delayMs < _config.reconnectDelayMs; ++i)
+  {
+    delayMs *= 2;
+  }
+  if (delayMs > _config.reconnectDelayMs)
+  {
+    delayMs = _config.reconnectDelayMs;
+  }
+
+  // Up to +50%, fixed per controller and attempt, so 35 controllers never retry in lockstep
+  const uint32_t jitter = (_jitterSeed ^ (_connectFailures * 2654435761u)) % 512;
+  _nextConnectAt = millis() + delayMs + (delayMs * jitter) / 1024;
+}
+
+bool SentientMQTT::brokerAddress(IPAddress &address) const
+{
+  if (_brokerTarget == TargetIp)
+  {
+    address = _config.brokerIp;
+    return true;
+  }
+  // Past its TTL the cached answer still serves until the refresh comes back
+  if (!_resolvedBrokerValid)
+  {
+    return false;
+  }
+  address = _resolvedBroker;
+  return true;
+}
+
+void SentientMQTT::stepBrokerLookup()
+{
+  if (!_brokerLookup.pending())
+  {
+    // Looked up for a connect attempt, when there is no answer yet or it is past its TTL
+    const bool stale = !_resolvedBrokerValid ||
+                       (_config.brokerHostTtlMs != 0 && millis() - _resolvedBrokerAt >= _config.brokerHostTtlMs);
+    if (_brokerTarget != TargetHost || !stale || _connectStage == ConnectIdle || _mqttClient.connected())
+    {
+      return;
+    }
+#if defined(ESP32)
+    const IPAddress dnsServer = WiFi.dnsIP();
+#else
+    const IPAddress dnsServer = Ethernet.dnsServerIP();
+#endif
+    if (!_brokerLookup.start(dnsServer, _config.brokerHost))
+    {
+      SENTIENT_LOG_WARN("[SentientMQTT] Could not start lookup of %s", _config.brokerHost);
+    }
+    return;
+  }
+
+  IPAddress resolvedAddress;
+  const SentientDnsLookup::Status status = _brokerLookup.poll(resolvedAddress);
+  if (status == SentientDnsLookup::Pending)
+  {
+    return;
+  }
+  if (status != SentientDnsLookup::Resolved || !isValidIp(resolvedAddress))
+  {
+    if (!_resolvedBrokerValid)
+    {
+      SENTIENT_LOG_WARN("[SentientMQTT] Lookup of %s failed", _config.brokerHost);
+      return;
+    }
+    // DNS is down but the host was known: keep using that address for another TTL
+    SENTIENT_LOG_WARN("[SentientMQTT] Lookup of %s failed; keeping %u.%u.%u.%u", _config.brokerHost,
+                      _resolvedBroker[0], _resolvedBroker[1], _resolvedBroker[2], _resolvedBroker[3]);
+    _resolvedBrokerAt = millis();
+    return;
+  }
+  _resolvedBroker = resolvedAddress;
+
+  SENTIENT_LOG_INFO("[SentientMQTT] Resolved %s to %u.%u.%u.%u", _config.brokerHost, _resolvedBroker[0],
+                    _resolvedBroker[1], _resolvedBroker[2], _resolvedBroker[3]);
+  _resolvedBrokerValid = true;
+  _resolvedBrokerAt = millis();
+}
+
+void SentientMQTT::stepConnect()
+{
+  switch (_connectStage)
+  {
+  case ConnectIdle:
+  {
+    // Signed distance keeps the comparison correct across millis() wrap-around
+    if (static_cast<int32_t>(millis() - _nextConnectAt) < 0)
+    {
+      return;
+    }
+    _socketSliceMs = 0;
+    _connectStage = ConnectSocketOpen;
+    return;
+  }
+
+  case ConnectSocketOpen:
+    if (openSocket())
+    {
+      _connectStage = ConnectSendConnect;
+    }
+    return;
+
+  case ConnectSendConnect:
+    if (sendConnect())
+    {
+      _connackDeadline = millis() + _config.connackTimeoutMs;
+      _connectStage = ConnectAwaitConnack;
+    }
+    return;
+
+  case ConnectAwaitConnack:
+    if (pollConnack())
+    {
+      _connectStage = ConnectSubscribe;
+    }
+    return;
+
+  case ConnectSubscribe:
+    // PubSubClient dropped the session before we could subscribe; start over
+    abortConnect(F("session lost before subscribe"));
+    return;
+  }
+}
+
+bool SentientMQTT::openSocket()
+{
+  // The client libraries only offer a blocking TCP connect, so it is polled in
+  // slices: each loop() tries with a timeout that starts at the step budget and
+  // doubles, so a nearby broker never costs more than a short stall while one
+  // further away still gets a try long enough for its round trip. Only
+  // connectTimeoutMs without an answer fails the attempt, and no slice runs
+  // past it.
+  if (_socketSliceMs == 0)
+  {
+    // Always connect by address: the host is looked up once and cached, not on every reconnect,
+    // and the lookup runs in its own loop() step, so only a first one still out holds the attempt
+    if (!brokerAddress(_socketAddress))
+    {
+      if (!_brokerLookup.pending())
+      {
+        abortConnect(F("broker host lookup failed"));
+      }
+      return false;
+    }
+    buildClientId();
+    SENTIENT_LOG_INFO("[SentientMQTT] Attempting broker connection: %u.%u.%u.%u client=%s user=%s password=%s",
+                      _socketAddress[0], _socketAddress[1], _socketAddress[2], _socketAddress[3], _clientId,
+                      _config.username ? _config.username : "null", _config.password ? "***SET***" : "null");
+    uint32_t firstSliceMs = _config.connectStepBudgetUs / 1000;
+    if (firstSliceMs == 0)
+    {
+      firstSliceMs = 1;
+    }
+    _socketSliceMs = firstSliceMs;
+    _socketDeadline = millis() + _config.connectTimeoutMs;
+  }
+
+  uint32_t timeoutMs = _socketSliceMs;
+  const long remainingMs = static_cast<long>(_socketDeadline - millis());
+  if (remainingMs < static_cast<long>(timeoutMs))
+  {
+    timeoutMs = remainingMs > 0 ? static_cast<uint32_t>(remainingMs) : 1;
+  }
+
+  const unsigned long startedMs = millis();
+  int result = 0;
+#if defined(ESP32)
+  result = _networkClient.connect(_socketAddress, _config.brokerPort, static_cast<int32_t>(timeoutMs));
+#else
+  _networkClient.setConnectionTimeout(static_cast<uint16_t>(timeoutMs < 0xFFFF ? timeoutMs : 0xFFFF));
+  result = _networkClient.connect(_socketAddress, _config.brokerPort);
+#endif
+  if (result == 1)
+  {
+    return true;
+  }
+
+  // An answer inside the slice (refused, unreachable) ends the attempt; silence only means not yet
+  if (millis() - startedMs < timeoutMs)
+  {
+    abortConnect(F("socket open failed"));
+    return false;
+  }
+  if (static_cast<long>(millis() - _socketDeadline) >= 0)
+  {
+    abortConnect(F("socket open timed out"));
+    return false;
+  }
+  // The time left clips every slice, so doubling only has to stop before it overflows
+  _socketSliceMs = _socketSliceMs < _config.connectTimeoutMs ? _socketSliceMs * 2u : _config.connectTimeoutMs;
+  return false;
+}
+
+bool SentientMQTT::sendConnect()
+{
+  // Still connecting WITHOUT a Will message until the broker-side issue with it is isolated
+  uint8_t *packet = reinterpret_cast<uint8_t *>(_payloadBuffer);
+  const size_t length = buildConnectPacket(packet, _payloadBufferSize, _clientId,
+                                           _config.username, _config.password, _config.keepAliveSeconds);
+  if (length == 0 || _networkClient.write(packet, length) != length)
+  {
+    abortConnect(F("CONNECT write failed"));
+    return false;
+  }
+  return true;
+}
+
+bool SentientMQTT::pollConnack()
+{
+  if (!_networkClient.connected())
+  {
+    abortConnect(F("socket closed before CONNACK"));
+    return false;
+  }
+  if (_networkClient.available() < 4)
+  {
+    if (static_cast<long>(millis() - _connackDeadline) >= 0)
+    {
+      abortConnect(F("CONNACK timeout"));
+    }
+    return false;
+  }
 
-  // TEMPORARY: Try connecting WITHOUT Will message to isolate the issue
-  Serial.println(F("[SentientMQTT] DEBUG: Connecting WITHOUT Will message"));
+  uint8_t connack[4];
+  for (uint8_t &value : connack)
+  {
+    value = static_cast<uint8_t>(_networkClient.read());
+  }
+  if (connack[0] != 0x20 || connack[1] != 0x02 || connack[3] != 0)
+  {
+    SENTIENT_LOG_WARN("[SentientMQTT] Broker refused connection, rc=%u", connack[3]);
+    abortConnect(F("CONNACK refused"));
+    return false;
+  }
+
+  // Let PubSubClient adopt the session: its CONNECT is swallowed and the
+  // buffered CONNACK replayed, so connect() returns without waiting.
+  _handshakeClient.adopt(connack, sizeof(connack));
+  bool connected = false;
   if (_config.username && _config.password)
   {
-    connected = _mqttClient.connect(clientId.c_str(), _config.username, _config.password);
+    connected = _mqttClient.connect(_clientId, _config.username, _config.password);
   }
   else
   {
-    connected = _mqttClient.connect(clientId.c_str());
+    connected = _mqttClient.connect(_clientId);
   }
 
   if (!connected)
   {
-    Serial.print(F("[SentientMQTT] Broker connect failed, rc="));
-    Serial.println(_mqttClient.state());
-    return;
+    SENTIENT_LOG_WARN("[SentientMQTT] Broker connect failed, rc=%d", _mqttClient.state());
+    abortConnect(F("session adoption failed"));
+    return false;
   }
 
-  Serial.println(F("[SentientMQTT] Broker connected"));
+  SENTIENT_LOG_INFO("[SentientMQTT] Broker connected");
+  return true;
+}
+
+void SentientMQTT::completeConnect()
+{
+  SentientTrace::record(SentientTrace::Connect, static_cast<uint16_t>(_connectFailures));
+  _connectStage = ConnectIdle;
+  _connectFailures = 0;
+  _timeSyncDue = true;
+  if (_hasConnected)
+  {
+    SentientMetrics::add(_metrics.reconnects);
+  }
+  _hasConnected = true;
 
   // Subscribe to commands for this controller
   // Canonical structure: [namespace]/[room]/commands/[controller_id]/[device_id]/[specific_command]
@@ -520,8 +1475,7 @@ void SentientMQTT::ensureConnected()
     topic += "/#";
 
     _mqttClient.subscribe(topic.c_str());
-    Serial.print(F("[SentientMQTT] Subscribed to commands: "));
-    Serial.println(topic);
+    SENTIENT_LOG_INFO("[SentientMQTT] Subscribed to commands: %s", topic.c_str());
   }
 
   if (_onConnect)
@@ -531,16 +1485,151 @@ void SentientMQTT::ensureConnected()
 
   _wasConnected = true;
   _lastHeartbeat = millis();
-  publishRaw(willTopic, buildConnectionPayload("online").c_str(), true);
+  const size_t onlineLength = buildConnectionPayload("online");
+  if (buildTopic(_topicBuffer, sizeof(_topicBuffer), TopicStatus, "connection"))
+  {
+    publishRaw(_topicBuffer, reinterpret_cast<const uint8_t *>(_payloadBuffer), onlineLength, true,
+               SentientOutboundQueue::DropWhenOffline, SentientPublishLanes::Safety);
+  }
+  _registration.sessionStarted(millis());
 }
 
-void SentientMQTT::handleIncoming(char *topic, uint8_t *payload, unsigned int length)
+void SentientMQTT::abortConnect(const __FlashStringHelper *reason)
+{
+  // F() strings are plain addresses on Teensy 4.x and ESP32
+  SENTIENT_LOG_WARN("[SentientMQTT] Broker connect aborted: %s", reinterpret_cast<const char *>(reason));
+  _handshakeClient.stop();
+  _connectStage = ConnectIdle;
+
+  // Alternate between the configured IP and host so one bad entry cannot strand the controller
+  if (isValidIp(_config.brokerIp) && hasText(_config.brokerHost))
+  {
+    _brokerTarget = _brokerTarget == TargetIp ? TargetHost : TargetIp;
+  }
+  if (_connectFailures < 255)
+  {
+    ++_connectFailures;
+  }
+  scheduleReconnect();
+}
+
+void SentientMQTT::stepTimeSync()
 {
-  if (!_commandCallback)
+  if (_config.timeSyncIntervalMs == 0 || !_mqttClient.connected())
   {
     return;
   }
 
+  // Gather a few exchanges quickly after (re)connecting, then settle to the configured interval
+  const unsigned long now = millis();
+  const uint32_t interval = _clock.stats().accepted < 4 ? 1'000 : _config.timeSyncIntervalMs;
+  if (!_timeSyncDue && now - _lastTimeSync < interval)
+  {
+    return;
+  }
+  if (!buildTopic(_topicBuffer, sizeof(_topicBuffer), "timesync", "request"))
+  {
+    return;
+  }
+  _timeSyncDue = false;
+  _lastTimeSync = now;
+
+  JsonDocument &doc = _publishDoc;
+  doc.clear();
+  _timeSyncT1 = _clock.localMicros();
+  doc["t1"] = _timeSyncT1;
+  // Never queued: a stale request would only measure the queue
+  publishSerialized(doc, false, SentientOutboundQueue::DropWhenOffline, SentientPublishLanes::Ack);
+}
+
+void SentientMQTT::handleTimeSync(const JsonDocument &reply, uint64_t t4)
+{
+  const uint64_t t1 = reply["t1"] | static_cast<uint64_t>(0);
+  // Only the reply to the outstanding request is usable; anything else is late or duplicated
+  if (t1 == 0 || t1 != _timeSyncT1)
+  {
+    return;
+  }
+  _timeSyncT1 = 0;
+  _clock.addSample(t1, reply["t2"] | static_cast<uint64_t>(0), reply["t3"] | static_cast<uint64_t>(0), t4);
+}
+
+uint64_t SentientMQTT::nowEpochMicros()
+{
+  return _clock.toEpochMicros(_clock.localMicros());
+}
+
+void SentientMQTT::stampEpoch(JsonVariant target)
+{
+  if (_clock.synced())
+  {
+    target["epochMs"] = nowEpochMicros() / 1000;
+  }
+}
+
+int SentientMQTT::appendEpochMs(char *buffer, size_t capacity, int length)
+{
+  if (!_clock.synced() || length <= 0 || static_cast<size_t>(length) >= capacity)
+  {
+    return length;
+  }
+  // Printed as seconds plus a zero-padded millisecond part; newlib-nano has no %llu
+  const uint64_t epochMs = nowEpochMicros() / 1000;
+  const int written = snprintf(buffer + length, capacity - length, ",\"epochMs\":%lu%03lu",
+                               static_cast<unsigned long>(epochMs / 1000), static_cast<unsigned long>(epochMs % 1000));
+  return written > 0 ? length + written : length;
+}
+
+int SentientMQTT::appendMemoryStats(char *buffer, size_t capacity, int length)
+{
+  if (length <= 0 || static_cast<size_t>(length) >= capacity)
+  {
+    return length;
+  }
+  // Same fields as SentientMemoryStats::write(), printed straight into the payload buffer
+  const SentientMemoryStats::Snapshot memory = SentientMemoryStats::sample();
+  int written = snprintf(buffer + length, capacity - length,
+                         ",\"memory\":{\"heapUsed\":%lu,\"heapFree\":%lu,\"heapLargest\":%lu,\"heapChunks\":%lu,"
+                         "\"stackFree\":%lu,\"stackSize\":%lu",
+                         static_cast<unsigned long>(memory.heapUsed), static_cast<unsigned long>(memory.heapFree),
+                         static_cast<unsigned long>(memory.heapLargestBlock), static_cast<unsigned long>(memory.heapFreeChunks),
+                         static_cast<unsigned long>(memory.stackFree), static_cast<unsigned long>(memory.stackSize));
+  if (written <= 0 || static_cast<size_t>(length + written) >= capacity)
+  {
+    buffer[length] = '\0';
+    return length;
+  }
+  int total = length + written;
+  if (memory.dtcmSize > 0)
+  {
+    written = snprintf(buffer + total, capacity - total,
+                       ",\"dtcmUsed\":%lu,\"dtcmSize\":%lu,\"ocramUsed\":%lu,\"ocramSize\":%lu",
+                       static_cast<unsigned long>(memory.dtcmUsed), static_cast<unsigned long>(memory.dtcmSize),
+                       static_cast<unsigned long>(memory.ocramUsed), static_cast<unsigned long>(memory.ocramSize));
+    if (written <= 0 || static_cast<size_t>(total + written) >= capacity)
+    {
+      buffer[length] = '\0';
+      return length;
+    }
+    total += written;
+  }
+  written = snprintf(buffer + total, capacity - total, ",\"allocs\":%lu,\"frees\":%lu}",
+                     static_cast<unsigned long>(memory.allocations), static_cast<unsigned long>(memory.frees));
+  if (written <= 0 || static_cast<size_t>(total + written) >= capacity)
+  {
+    // Never leave a half-written object in front of the identity tail
+    buffer[length] = '\0';
+    return length;
+  }
+  return total + written;
+}
+
+void SentientMQTT::handleIncoming(char *topic, uint8_t *payload, unsigned int length)
+{
+  // Stamp arrival before parsing so a traced ack covers the whole on-device path
+  // and a time-sync reply gets the tightest possible t4
+  const uint64_t receivedLocal = _clock.localMicros();
+
   const char *lastSlash = strrchr(topic, '/');
   const char *commandStart = lastSlash ? lastSlash + 1 : topic;
   if (commandStart[0] == '\0' || strcmp(commandStart, "#") == 0)
@@ -548,111 +1637,579 @@ void SentientMQTT::handleIncoming(char *topic, uint8_t *payload, unsigned int le
     return;
   }
 
-  DynamicJsonDocument doc(_config.commandJsonCapacity);
-  const size_t bufferSize = static_cast<size_t>(length) + 1;
-  char *buffer = new (std::nothrow) char[bufferSize];
-  if (!buffer)
+  SentientMetrics::add(_metrics.commandsReceived);
+  SentientTrace::record(SentientTrace::CommandReceived, static_cast<uint16_t>(length), SentientTrace::hash(commandStart));
+  if (strcmp(commandStart, "dump_trace") == 0)
+  {
+    SENTIENT_LOG_INFO("[SentientMQTT] dumping %u trace entries", SentientTrace::beginDump());
+    return;
+  }
+  if (strcmp(commandStart, "send_manifest") == 0)
   {
-    Serial.println(F("[SentientMQTT] command buffer allocation failed"));
+    _registration.requested(millis());
     return;
   }
-  memcpy(buffer, payload, length);
-  buffer[length] = '\0';
 
-  DeserializationError error = deserializeJson(doc, buffer);
+  // <namespace>/<room>/commands/<controller>/<device>/<command>: the device travels with the
+  // command (cues included) and dispatchCommand() splits it off again for commandDevice()
+  const char *commandPath = commandStart;
+  int slashes = 0;
+  for (const char *p = topic; p < commandStart; ++p)
+  {
+    slashes += *p == '/';
+  }
+  if (slashes >= 5)
+  {
+    commandPath = lastSlash;
+    while (commandPath > topic && commandPath[-1] != '/')
+    {
+      --commandPath;
+    }
+  }
+  dispatchCommand(commandPath, payload, length, receivedLocal, true);
+}
+
+void SentientMQTT::dispatchCommand(const char *commandPath, const uint8_t *payload, size_t length,
+                                   uint64_t receivedLocal, bool fromNetwork)
+{
+  // "<device>/<command>" or just "<command>"
+  const char *separator = strrchr(commandPath, '/');
+  const char *command = separator ? separator + 1 : commandPath;
+  const bool timeSyncReply = fromNetwork && strcmp(command, "timesync") == 0;
+  const bool manifestVerdict = fromNetwork && strcmp(command, "manifest_known") == 0;
+  if (!_commandCallback && !timeSyncReply && !manifestVerdict)
+  {
+    return;
+  }
+
+  CommandSlot *slot = nullptr;
+  for (CommandSlot &candidate : _commandSlots)
+  {
+    if (!candidate.busy)
+    {
+      slot = &candidate;
+      break;
+    }
+  }
+  if (!slot)
+  {
+    SENTIENT_LOG_ERROR("[SentientMQTT] command dropped: no free command document");
+    return;
+  }
+  slot->busy = true;
+  JsonDocument &doc = slot->doc;
+
+  // Parse straight out of PubSubClient's receive buffer (or a cue's copy); strings land in the slot's arena
+  DeserializationError error = deserializeJson(doc, payload, length);
   if (error)
+  {
+    SentientMetrics::add(_metrics.parseFailures);
+
+    // Plain-text payload: the receive buffer is not null-terminated, so go through a bounded copy
+    const size_t textLength = length < sizeof(_commandText) ? length : sizeof(_commandText) - 1;
+    memcpy(_commandText, payload, textLength);
+    _commandText[textLength] = '\0';
+    doc.clear();
+    doc["value"] = _commandText;
+  }
+
+  if (timeSyncReply || manifestVerdict)
+  {
+    if (!error)
+    {
+      if (timeSyncReply)
+      {
+        handleTimeSync(doc, receivedLocal);
+      }
+      else
+      {
+        handleManifestKnown(doc);
+      }
+    }
+    doc.clear();
+    slot->busy = false;
+    return;
+  }
+
+  // A cue fires from its own copy of the payload, so it is never rescheduled
+  JsonVariantConst executeAt = doc["execute_at"];
+  if (fromNetwork && !error && !executeAt.isNull() && scheduleCue(commandPath, payload, length, receivedLocal, executeAt))
   {
     doc.clear();
-    doc["value"] = buffer;
+    slot->busy = false;
+    return;
+  }
+
+  JsonVariantConst traceId = doc["traceId"];
+  const bool traced = _config.ackTracedCommands && !traceId.isNull();
+  if (traced)
+  {
+    strncpy(slot->tracedCommand, command, sizeof(slot->tracedCommand) - 1);
+    slot->tracedCommand[sizeof(slot->tracedCommand) - 1] = '\0';
+  }
+
+  // `command` points into PubSubClient's receive buffer, which a publish from the handler can overwrite
+  const uint32_t commandHash = SentientTrace::hash(command);
+  size_t deviceLength = separator ? static_cast<size_t>(separator - commandPath) : 0;
+  if (deviceLength >= sizeof(slot->device))
+  {
+    deviceLength = sizeof(slot->device) - 1;
   }
+  memcpy(slot->device, commandPath, deviceLength);
+  slot->device[deviceLength] = '\0';
+  const char *outerDevice = _commandDevice; // A handler that calls loop() may dispatch another command
+  _commandDevice = slot->device;
+  _commandCallback(command, doc, _commandContext);
+  _commandDevice = outerDevice;
 
-  _commandCallback(commandStart, doc, _commandContext);
-  delete[] buffer;
+  const uint32_t handlerUs = static_cast<uint32_t>(_clock.localMicros() - receivedLocal);
+  SentientTrace::record(SentientTrace::CommandDispatched, handlerUs > 0xFFFF ? 0xFFFF : handlerUs, commandHash);
+
+  if (traced)
+  {
+    publishCommandAck(slot->tracedCommand, traceId, receivedLocal, _clock.localMicros());
+  }
+
+  doc.clear();
+  slot->busy = false;
 }
 
-bool SentientMQTT::publishRaw(const String &topic, const char *payload, bool retain)
+bool SentientMQTT::scheduleCue(const char *commandPath, const uint8_t *payload, size_t length, uint64_t receivedLocal,
+                               JsonVariantConst executeAt)
 {
-  ensureConnected();
-  if (!_mqttClient.connected())
+  // Without a synchronized clock there is no instant to wait for; run the command now
+  if (!_clock.synced())
+  {
+    SENTIENT_LOG_WARN("[SentientMQTT] clock not synced, running cue now: %s", commandPath);
+    return false;
+  }
+
+  const uint64_t dueLocal = _clock.toLocalMicros(executeAt.as<uint64_t>() * 1000);
+  if (dueLocal <= _clock.localMicros())
+  {
+    return false;
+  }
+  if (!_cues.schedule(dueLocal, receivedLocal, commandPath, payload, length))
   {
+    SENTIENT_LOG_WARN("[SentientMQTT] cue wheel full or payload too large, running cue now: %s", commandPath);
     return false;
   }
+  return true;
+}
+
+void SentientMQTT::runDueCues()
+{
+  while (SentientCueWheel::Cue *cue = _cues.due(_clock.localMicros()))
+  {
+    dispatchCommand(cue->command, cue->payload, cue->payloadLength, cue->receivedLocalUs, false);
+    _cues.release(cue);
+  }
+}
 
-  if (!payload)
+void SentientMQTT::publishCommandAck(const char *command, JsonVariantConst traceId, uint64_t receivedLocal,
+                                     uint64_t handledLocal)
+{
+  JsonDocument &ack = _publishDoc;
+  ack.clear();
+  ack["traceId"] = traceId;
+  ack["command"] = command;
+  ack["receivedUs"] = static_cast<uint32_t>(receivedLocal);
+  ack["handledUs"] = static_cast<uint32_t>(handledLocal);
+  ack["handlerUs"] = static_cast<uint32_t>(handledLocal - receivedLocal);
+  ack["timestamp"] = secondsSinceBoot();
+  if (_clock.synced())
   {
-    payload = "";
+    ack["receivedEpochUs"] = _clock.toEpochMicros(receivedLocal);
+    ack["handledEpochUs"] = _clock.toEpochMicros(handledLocal);
   }
+  stampEpoch(ack);
+  publishJson(TopicEvents, "command_ack", ack, false, SentientOutboundQueue::Ordered, SentientPublishLanes::Ack);
+}
 
-  bool ok = _mqttClient.publish(topic.c_str(), payload, retain);
+bool SentientMQTT::publishRaw(const char *topic, const uint8_t *payload, size_t length, bool retain,
+                              SentientOutboundQueue::Policy policy, SentientPublishLanes::Lane lane)
+{
+  // Reconnection is driven from loop(); reconnecting here would clobber the
+  // scratch buffers that topic and payload point into.
+  // A queued message counts as accepted.
+  if (!_mqttClient.connected())
+  {
+    return _config.queueWhileOffline && queueOutbound(topic, payload, length, retain, policy, lane);
+  }
+
+  // Until this lane's backlog (and anything more urgent) has drained, queue behind it
+  // so a fresh value never overtakes (or is later overwritten by) a stale queued one.
+  if (policy != SentientOutboundQueue::DropWhenOffline &&
+      (_outbound.pendingAtOrAbove(lane) || streamDeferredAtOrAbove(lane)))
+  {
+    return queueOutbound(topic, payload, length, retain, policy, lane);
+  }
+
+  if (!_lanes.acquire(lane, millis()))
+  {
+    // Over budget: defer to drainOutbound(), where repeated sensor/state values coalesce
+    if (policy == SentientOutboundQueue::DropWhenOffline)
+    {
+      _lanes.countDropped(lane);
+      SentientMetrics::add(_metrics.publishesDropped);
+      SENTIENT_LOG_WARN("[SentientMQTT] lane %u over budget: dropped %s", static_cast<unsigned>(lane), topic);
+      return false;
+    }
+    if (queueOutbound(topic, payload, length, retain, policy, lane))
+    {
+      _lanes.countDeferred(lane);
+      return true;
+    }
+    _lanes.countDropped(lane);
+    return false;
+  }
+
+  bool ok = sendPublish(topic, payload, length, retain);
   if (!ok)
   {
-    Serial.print(F("[SentientMQTT] publish failed for topic "));
-    Serial.print(topic);
-    Serial.print(F(" len="));
-    Serial.print(strlen(payload));
-    Serial.print(F(" buffer="));
-    Serial.print(_mqttClient.getBufferSize());
-    Serial.print(F(" state="));
-    Serial.println(_mqttClient.state());
+    SENTIENT_LOG_WARN("[SentientMQTT] publish failed for topic %s len=%u buffer=%u state=%d", topic,
+                      static_cast<unsigned>(length), static_cast<unsigned>(_mqttClient.getBufferSize()),
+                      _mqttClient.state());
   }
   return ok;
 }
 
-String SentientMQTT::buildTopic(const char *category, const char *item) const
+bool SentientMQTT::queueOutbound(const char *topic, const uint8_t *payload, size_t length, bool retain,
+                                 SentientOutboundQueue::Policy policy, SentientPublishLanes::Lane lane)
 {
-  String topic;
-  topic.reserve(96);
+  if (policy == SentientOutboundQueue::DropWhenOffline)
+  {
+    return false; // Never meant to be held back (heartbeats, online status)
+  }
+  const SentientOutboundQueue::Stats before = _outbound.stats();
+  const bool queued = _outbound.push(topic, payload, length, retain, policy, lane);
+  const SentientOutboundQueue::Stats &after = _outbound.stats();
+  if (!queued)
+  {
+    SentientMetrics::add(_metrics.publishesDropped);
+    SENTIENT_LOG_WARN("[SentientMQTT] outbound queue cannot hold %s (%u bytes): dropped", topic,
+                      static_cast<unsigned>(length));
+  }
+  else if (after.evicted != before.evicted)
+  {
+    SentientMetrics::add(_metrics.publishesDropped);
+    SENTIENT_LOG_WARN("[SentientMQTT] outbound queue full: evicted an older low-priority value to make room for %s", topic);
+  }
+  return queued;
+}
 
-  auto appendSegment = [&topic](const char *segment)
+void SentientMQTT::drainOutbound()
+{
+  drainDeferredStream();
+  if (_outbound.empty() || !_mqttClient.connected())
   {
-    if (!segment || segment[0] == '\0')
+    return;
+  }
+
+  // Pace by bytes rather than messages so a backlog of large payloads cannot
+  // overrun the Ethernet TX buffer in a single loop.
+  size_t budget = _config.queueDrainBytesPerLoop;
+  bool first = true;
+  const char *topic;
+  const uint8_t *payload;
+  size_t length;
+  bool retain;
+  uint8_t lane;
+  const unsigned long now = millis();
+  while (_outbound.front(topic, payload, length, retain, lane))
+  {
+    const size_t cost = strlen(topic) + length;
+    if (!first && cost > budget)
     {
-      return;
+      break;
+    }
+    // The most urgent entry waits for its lane to refill; nothing less urgent jumps it
+    if (!_lanes.acquire(static_cast<SentientPublishLanes::Lane>(lane), now))
+    {
+      break;
     }
-    if (topic.length() > 0 && topic[topic.length() - 1] != '/')
+    if (!sendPublish(topic, payload, length, retain))
     {
-      topic += '/';
+      break;
     }
-    topic += segment;
-  };
+    _outbound.pop();
+    budget = cost >= budget ? 0 : budget - cost;
+    first = false;
+  }
+}
+
+bool SentientMQTT::publishStreamed(const char *topic, const JsonDocument &payload, bool retain,
+                                   SentientOutboundQueue::Policy policy, SentientPublishLanes::Lane lane)
+{
+  // Same rules as publishRaw(), except a held-back payload is too large for the outbound queue
+  // and waits in the single deferred-stream slot instead
+  const size_t length = measureJson(payload);
+  if (!_mqttClient.connected())
+  {
+    return _config.queueWhileOffline && deferStreamed(topic, payload, length, retain, policy, lane);
+  }
+  if (_outbound.pendingAtOrAbove(lane) || streamDeferredAtOrAbove(lane) || !socketTakesStream(topic, length))
+  {
+    return deferStreamed(topic, payload, length, retain, policy, lane);
+  }
+  if (!_lanes.acquire(lane, millis()))
+  {
+    if (deferStreamed(topic, payload, length, retain, policy, lane))
+    {
+      _lanes.countDeferred(lane);
+      return true;
+    }
+    _lanes.countDropped(lane);
+    return false;
+  }
+  return sendStreamed(topic, payload, length, retain);
+}
+
+bool SentientMQTT::sendStreamed(const char *topic, const JsonDocument &payload, size_t length, bool retain)
+{
+  SentientMetrics::add(_metrics.publishesAttempted);
+  if (!SentientStreamWriter::publish(_mqttClient, topic, payload, retain, _config.streamStallUs))
+  {
+    SentientMetrics::add(_metrics.publishesFailed);
+    SentientTrace::record(SentientTrace::PublishFailed, 0xFFFF, SentientTrace::hash(topic));
+    SENTIENT_LOG_WARN("[SentientMQTT] streamed publish failed for topic %s", topic);
+    return false;
+  }
+  SentientMetrics::add(_metrics.publishesSucceeded);
+  SentientMetrics::add(_metrics.bytesSent, SentientStreamWriter::packetSize(topic, length));
+  SentientTrace::record(SentientTrace::Publish, length > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(length),
+                        SentientTrace::hash(topic));
+  return true;
+}
 
+bool SentientMQTT::deferStreamed(const char *topic, const JsonDocument &payload, size_t length, bool retain,
+                                 SentientOutboundQueue::Policy policy, SentientPublishLanes::Lane lane)
+{
+  if (policy == SentientOutboundQueue::DropWhenOffline)
+  {
+    SentientMetrics::add(_metrics.publishesDropped);
+    SENTIENT_LOG_WARN("[SentientMQTT] streamed publish cannot go out now: dropped %s", topic);
+    return false;
+  }
+  // A newer value for the waiting topic replaces it; a different topic has to wait its turn
+  if (_deferredPending && strcmp(_deferredTopic, topic) != 0)
+  {
+    SentientMetrics::add(_metrics.publishesDropped);
+    SENTIENT_LOG_WARN("[SentientMQTT] streamed publish for %s still waiting: dropped %s", _deferredTopic, topic);
+    return false;
+  }
+  if (length + 1 > _deferredCapacity)
+  {
+    uint8_t *grown = static_cast<uint8_t *>(realloc(_deferredPayload, length + 1));
+    if (!grown)
+    {
+      SentientMetrics::add(_metrics.publishesDropped);
+      SENTIENT_LOG_ERROR("[SentientMQTT] no memory to defer %u bytes: dropped %s", static_cast<unsigned>(length),
+                         topic);
+      return false;
+    }
+    _deferredPayload = grown;
+    _deferredCapacity = length + 1;
+  }
+  snprintf(_deferredTopic, sizeof(_deferredTopic), "%s", topic);
+  _deferredLength = serializeJson(payload, reinterpret_cast<char *>(_deferredPayload), _deferredCapacity);
+  _deferredRetain = retain;
+  _deferredLane = lane;
+  _deferredPending = true;
+  return true;
+}
+
+void SentientMQTT::drainDeferredStream()
+{
+  if (!_deferredPending || !_mqttClient.connected())
+  {
+    return;
+  }
+  // Goes ahead of its own lane's queued values (they were queued behind it), but not of a more urgent lane's
+  const SentientPublishLanes::Lane lane = static_cast<SentientPublishLanes::Lane>(_deferredLane);
+  if ((lane > 0 && _outbound.pendingAtOrAbove(lane - 1)) || !socketTakesStream(_deferredTopic, _deferredLength) ||
+      !_lanes.acquire(lane, millis()))
+  {
+    return;
+  }
+  // A failed stream drops the session; the payload stays here and goes out after the reconnect
+  if (sendPublish(_deferredTopic, _deferredPayload, _deferredLength, _deferredRetain))
+  {
+    _deferredPending = false;
+  }
+}
+
+bool SentientMQTT::streamDeferredAtOrAbove(SentientPublishLanes::Lane lane) const
+{
+  return _deferredPending && _deferredLane <= lane;
+}
+
+bool SentientMQTT::socketTakesStream(const char *topic, size_t length)
+{
+  // With this much room the writer does not wait on the socket for more than the tail of the packet
+  const size_t packetSize = SentientStreamWriter::packetSize(topic, length);
+  const size_t needed = packetSize < _config.queueDrainBytesPerLoop ? packetSize : _config.queueDrainBytesPerLoop;
+  return socketWriteSpace() >= needed;
+}
+
+bool SentientMQTT::sendPublish(const char *topic, const uint8_t *payload, size_t length, bool retain)
+{
+  // Small messages go out in one write from PubSubClient's buffer; larger ones are chunked
+  const size_t packetSize = SentientStreamWriter::packetSize(topic, length);
+  const uint16_t tracedLength = length > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(length);
+  SentientMetrics::add(_metrics.publishesAttempted);
+  const bool ok = packetSize <= _mqttClient.getBufferSize()
+                      ? _mqttClient.publish(topic, payload, static_cast<unsigned int>(length), retain)
+                      : SentientStreamWriter::publish(_mqttClient, topic, payload, length, retain,
+                                                      _config.streamStallUs);
+  if (!ok)
+  {
+    SentientMetrics::add(_metrics.publishesFailed);
+    SentientTrace::record(SentientTrace::PublishFailed, tracedLength, SentientTrace::hash(topic));
+    return false;
+  }
+  SentientTrace::record(SentientTrace::Publish, tracedLength, SentientTrace::hash(topic));
+  SentientMetrics::add(_metrics.publishesSucceeded);
+  SentientMetrics::add(_metrics.bytesSent, packetSize);
+  return true;
+}
+
+void SentientMQTT::buildTemplates()
+{
   // New topic structure: [namespace]/[room]/[category]/[controller_id]/[device_id]/[item]
-  appendSegment(_config.namespaceId ? _config.namespaceId : "paragon");
-  appendSegment(_config.roomId);
-  appendSegment(category);
-  appendSegment(_config.puzzleId); // This is controller_id
-  appendSegment(_config.deviceId);
-  appendSegment(item);
+  // Only category and item vary per message, so the rest is assembled once here.
+  _topicPrefix[0] = '\0';
+  size_t length = appendSegment(_topicPrefix, sizeof(_topicPrefix), 0, _config.namespaceId ? _config.namespaceId : "paragon");
+  length = length ? appendSegment(_topicPrefix, sizeof(_topicPrefix), length, _config.roomId) : 0;
+  _topicPrefixLength = length;
+
+  _topicOwner[0] = '\0';
+  length = appendSegment(_topicOwner, sizeof(_topicOwner), 0, _config.puzzleId); // This is controller_id
+  length = appendSegment(_topicOwner, sizeof(_topicOwner), length, _config.deviceId);
+  _topicOwnerLength = length;
+
+  // Library categories get their full prefix cached so a publish only appends the item
+  for (uint8_t i = 0; i < TopicCategoryCount; ++i)
+  {
+    _categoryTopicLengths[i] = 0;
+  }
+  for (uint8_t i = 0; i < TopicCategoryCount; ++i)
+  {
+    _categoryTopicLengths[i] = buildTopic(_categoryTopics[i], sizeof(_categoryTopics[i]), kCategoryNames[i], nullptr);
+  }
+
+  // Identity fields of the connection and default heartbeat payloads never change either
+  JsonDocument &doc = _publishDoc;
+  doc.clear();
+  if (_config.deviceId)
+  {
+    doc["deviceId"] = _config.deviceId;
+  }
+  if (_config.roomId)
+  {
+    doc["roomId"] = _config.roomId;
+  }
+  if (_config.puzzleId)
+  {
+    doc["puzzleId"] = _config.puzzleId;
+  }
+  _connectionTailLength = buildPayloadTail(doc, _connectionTail, sizeof(_connectionTail));
+
+  doc.clear();
+  if (_config.deviceId)
+  {
+    doc["deviceId"] = _config.deviceId;
+    doc["displayName"] = _config.displayName ? _config.displayName : _config.deviceId;
+  }
+  if (_config.roomId)
+  {
+    doc["roomId"] = _config.roomId;
+  }
+  if (_config.puzzleId)
+  {
+    doc["puzzleId"] = _config.puzzleId;
+  }
+  _heartbeatTailLength = buildPayloadTail(doc, _heartbeatTail, sizeof(_heartbeatTail));
+  doc.clear();
+
+  if (_connectionTailLength == 0 || _heartbeatTailLength == 0)
+  {
+    Serial.println(F("[SentientMQTT] identity too long for payload templates, building per message"));
+  }
+}
+
+size_t SentientMQTT::buildTopic(char *buffer, size_t capacity, const char *category, const char *item) const
+{
+  if (category)
+  {
+    for (uint8_t i = 0; i < TopicCategoryCount; ++i)
+    {
+      if (_categoryTopicLengths[i] > 0 && strcmp(category, kCategoryNames[i]) == 0)
+      {
+        return buildTopic(buffer, capacity, static_cast<TopicCategory>(i), item);
+      }
+    }
+  }
 
-  return topic;
+  buffer[0] = '\0';
+  size_t length = appendSegment(buffer, capacity, 0, _topicPrefix, _topicPrefixLength);
+  length = appendSegment(buffer, capacity, length, category);
+  if (length)
+  {
+    length = appendSegment(buffer, capacity, length, _topicOwner, _topicOwnerLength);
+  }
+  if (length)
+  {
+    length = appendSegment(buffer, capacity, length, item);
+  }
+  return length;
 }
 
-String SentientMQTT::buildClientId() const
+size_t SentientMQTT::buildTopic(char *buffer, size_t capacity, TopicCategory category, const char *item) const
+{
+  const size_t prefixLength = _categoryTopicLengths[category];
+  if (prefixLength == 0 || prefixLength >= capacity)
+  {
+    return 0;
+  }
+  memcpy(buffer, _categoryTopics[category], prefixLength + 1);
+  return appendSegment(buffer, capacity, prefixLength, item);
+}
+
+void SentientMQTT::buildClientId()
 {
-  String clientId;
   // Use puzzleId (controller_id) for client ID, not deviceId
+  const char *base = "controller";
   if (_config.puzzleId)
   {
-    clientId += _config.puzzleId;
+    base = _config.puzzleId;
   }
   else if (_config.deviceId)
   {
-    clientId += _config.deviceId;
+    base = _config.deviceId;
   }
-  else
-  {
-    clientId += "controller";
-  }
-  clientId += '-';
-  clientId += String(millis() & 0xFFFF, HEX);
-  return clientId;
+  snprintf(_clientId, sizeof(_clientId), "%s-%lx", base, millis() & 0xFFFF);
 }
 
-String SentientMQTT::buildConnectionPayload(const char *state) const
+size_t SentientMQTT::buildConnectionPayload(const char *state)
 {
-  DynamicJsonDocument doc(_config.publishJsonCapacity);
+  if (_connectionTailLength > 0)
+  {
+    int headLength = snprintf(_payloadBuffer, _payloadBufferSize, "{\"state\":\"%s\",\"timestamp\":%lu",
+                              state, secondsSinceBoot());
+    headLength = appendEpochMs(_payloadBuffer, _payloadBufferSize, headLength);
+    const size_t length = joinPayload(_payloadBuffer, _payloadBufferSize, headLength, _connectionTail, _connectionTailLength);
+    if (length > 0)
+    {
+      return length;
+    }
+  }
+
+  JsonDocument &doc = _publishDoc;
+  doc.clear();
   doc["state"] = state;
   doc["timestamp"] = secondsSinceBoot();
+  stampEpoch(doc);
   if (_config.deviceId)
   {
     doc["deviceId"] = _config.deviceId;
@@ -665,10 +2222,7 @@ String SentientMQTT::buildConnectionPayload(const char *state) const
   {
     doc["puzzleId"] = _config.puzzleId;
   }
-
-  String payload;
-  serializeJson(doc, payload);
-  return payload;
+  return serializeJson(doc, _payloadBuffer, _payloadBufferSize);
 }
 
 void SentientMQTT::mqttCallbackThunk(char *topic, uint8_t *payload, unsigned int length)
@@ -678,7 +2232,3 @@ void SentientMQTT::mqttCallbackThunk(char *topic, uint8_t *payload, unsigned int
     s_activeInstance->handleIncoming(topic, payload, length);
   }
 }
-
-#if defined(__GNUC__)
-#pragma GCC diagnostic pop
-#endif
@@ -4,7 +4,24 @@
  * Wraps PubSubClient with project conventions:
  * - Hierarchical topics: <namespace>/<room>/<puzzle>/<device>/<category>/<item>
  * - Command routing via /Commands/<CommandName>
+ * - Latency acks on events/command_ack for commands that carry a traceId
+ * - Broker-synchronized epoch clock (timesync/request -> commands/.../timesync);
+ *   library-built payloads carry "epochMs" once it has synced
+ * - Commands with "execute_at" (epoch ms) held in a timer wheel and dispatched
+ *   at that instant (see SentientCueWheel)
+ * - Transport and loop health in the SentientMetrics registry, published on
+ *   metrics/registry together with any entries the sketch adds
  * - JSON helpers for sensors, metrics, events, state, and heartbeat
+ * - Flight-recorder trace of commands, publishes and connects (see SentientTrace),
+ *   streamed on trace/dump by the "dump_trace" command
+ * - Library diagnostics through SentientLog, optionally forwarded to logs/<level>
+ * - Heap, stack and RAM-region figures in the default heartbeat (see SentientMemoryStats)
+ * - Controller registration sent one record per loop() on every (re)connect,
+ *   resuming where a dropped session left off (see SentientRegistration);
+ *   a manifest fingerprint on register/fingerprint goes first, and the records
+ *   only follow on "send_manifest" or when "manifest_known" does not arrive
+ * - Batched sensor frames (beginBatch/add/commitBatch) on sensors/batch
+ * - Per-priority publish lanes with token-bucket rate limits
  * - Automatic connection + heartbeat publishing
  *
  * Supported platforms:
@@ -17,22 +34,60 @@
 
 #include <Arduino.h>
 #include <ArduinoJson.h>
-#ifndef MQTT_MAX_PACKET_SIZE
-#define MQTT_MAX_PACKET_SIZE 8192 // Increased for large registration messages
+
+#include "SentientClockSync.h"
+#include "SentientCueWheel.h"
+#include "SentientDnsLookup.h"
+#include "SentientHandshakeClient.h"
+#include "SentientJsonArena.h"
+#include "SentientLog.h"
+#include "SentientMemoryStats.h"
+#include "SentientMetrics.h"
+#include "SentientOutboundQueue.h"
+#include "SentientPublishLanes.h"
+#include "SentientRegistration.h"
+#include "SentientStreamWriter.h"
+#include "SentientTrace.h"
+
+#ifndef SENTIENT_MQTT_MAX_TOPIC_LENGTH
+#define SENTIENT_MQTT_MAX_TOPIC_LENGTH 160
+#endif
+#ifndef SENTIENT_MQTT_PAYLOAD_BUFFER_SIZE
+#define SENTIENT_MQTT_PAYLOAD_BUFFER_SIZE 1024 // Default payloadBufferSize
+#endif
+#ifndef SENTIENT_MQTT_MAX_FRAGMENT_LENGTH
+#define SENTIENT_MQTT_MAX_FRAGMENT_LENGTH 256 // Precomputed identity tail of connection/heartbeat payloads
+#endif
+#ifndef SENTIENT_MQTT_JSON_ARENA_SIZE
+#define SENTIENT_MQTT_JSON_ARENA_SIZE 1536 // Default publishJsonCapacity: one 1 KB ArduinoJson slot pool + strings
+#endif
+#ifndef SENTIENT_MQTT_BATCH_ARENA_SIZE
+#define SENTIENT_MQTT_BATCH_ARENA_SIZE 2048 // Default batchJsonCapacity
+#endif
+#ifndef SENTIENT_MQTT_BATCH_MAX_ITEMS
+#define SENTIENT_MQTT_BATCH_MAX_ITEMS 32 // Items per frame before the batch is sent early
+#endif
+#ifndef SENTIENT_MQTT_COMMAND_ARENA_SIZE
+#define SENTIENT_MQTT_COMMAND_ARENA_SIZE 1536 // Default commandJsonCapacity, sized like the publish arena
 #endif
-#ifndef MQTT_MAX_TRANSFER_SIZE
-#define MQTT_MAX_TRANSFER_SIZE 512 // Chunk large messages into 512-byte writes to prevent Ethernet buffer overflow
+#ifndef SENTIENT_MQTT_COMMAND_DOC_POOL
+#define SENTIENT_MQTT_COMMAND_DOC_POOL 2 // Commands in flight at once (a handler may call loop())
+#endif
+#ifndef SENTIENT_MQTT_COMMAND_TEXT_SIZE
+#define SENTIENT_MQTT_COMMAND_TEXT_SIZE 128 // Longest non-JSON command payload passed on as {"value": ...}
 #endif
-#include <PubSubClient.h>
 
 #if defined(ESP32)
 #include <WiFi.h>
+#include <WiFiUdp.h>
 #define SENTIENT_NETWORK_CLIENT WiFiClient
+#define SENTIENT_NETWORK_UDP WiFiUDP
 #else
 #include <NativeEthernet.h>
 #include <TeensyID.h>
 #include <fnet.h>
 #define SENTIENT_NETWORK_CLIENT EthernetClient
+#define SENTIENT_NETWORK_UDP EthernetUDP
 #endif
 
 struct SentientMQTTConfig
@@ -51,12 +106,54 @@ struct SentientMQTTConfig
   const char *hostnamePrefix = nullptr; // Optional prefix for network hostname (e.g., "CL" for Clockwork)
 
   uint16_t keepAliveSeconds = 60;
-  uint32_t reconnectDelayMs = 5'000;
+  uint32_t reconnectDelayMs = 5'000;     // Backoff ceiling between failed connect attempts
+  uint32_t reconnectMinDelayMs = 250;    // First retry delay; doubles per failure up to reconnectDelayMs
+  uint32_t connectStepBudgetUs = 2'000; // One loop()'s share of a broker (re)connect; the first TCP try's timeout
+  uint32_t connectTimeoutMs = 3'000;    // Whole TCP connect, retried across loop() calls, before it counts as failed
+  uint32_t connackTimeoutMs = 5'000;
+  uint32_t brokerHostTtlMs = 300'000; // brokerHost is looked up again after this long; 0 keeps the first answer
   uint32_t heartbeatIntervalMs = 5'000;
   bool autoHeartbeat = true;
+  bool heartbeatMemory = true; // Adds a "memory" object (SentientMemoryStats) to the default heartbeat
+
+  uint32_t timeSyncIntervalMs = 60'000; // Between time-sync exchanges once synced; 0 disables time sync
+  uint32_t metricsIntervalMs = 10'000; // SentientMetrics frame on metrics/registry; 0 disables it
+  SentientLog::Level logForwardLevel = SentientLog::None; // Publish SentientLog lines at or above this on logs/<level>
+  bool ackTracedCommands = true; // Publish receive/handled timestamps for commands carrying a "traceId"
+
+  // JSON arenas, taken from the heap once: the command pool's in the constructor, the batch frame's on the first
+  // beginBatch(). A document that outgrows its arena spills to malloc() and shows in the arena's overflowCount().
+  uint16_t commandJsonCapacity = SENTIENT_MQTT_COMMAND_ARENA_SIZE; // Each of the SENTIENT_MQTT_COMMAND_DOC_POOL documents
+  uint16_t batchJsonCapacity = SENTIENT_MQTT_BATCH_ARENA_SIZE;     // The open sensor batch frame
+  uint16_t publishJsonCapacity = SENTIENT_MQTT_JSON_ARENA_SIZE;    // Library-built sensor/state/heartbeat documents
+  // Scratch buffer every publish serializes into, allocated in the constructor; larger payloads are streamed.
+  // Trace dump chunks and the CONNECT packet are built here too, so it never goes below SentientTrace::kChunkCapacity.
+  uint16_t payloadBufferSize = SENTIENT_MQTT_PAYLOAD_BUFFER_SIZE;
+  uint16_t clientBufferSize = 512;    // PubSubClient buffer: must hold the largest inbound command packet (topic + payload)
+
+  // Store-and-forward while the broker is unreachable (see SentientOutboundQueue)
+  bool queueWhileOffline = true;
+  uint16_t queueDrainBytesPerLoop = 1024; // Keeps the post-reconnect flush under the W5500's 2 KB TX buffer
+  // A payload too large for the scratch buffer is streamed only once the socket has queueDrainBytesPerLoop free
+  // (or room for the whole packet), and deferred to a later loop() until then. Once started, a socket that stops
+  // draining may stall it this long before the publish fails and the session is dropped.
+  uint32_t streamStallUs = 5'000;
 
-  uint16_t commandJsonCapacity = 512;
-  uint16_t publishJsonCapacity = 512;
+  // Free socket TX space a registration record waits for before it is sent (a smaller record waits for its own size)
+  uint16_t registrationTxBytes = 1024;
+  // Wait for "manifest_known"/"send_manifest" after the fingerprint; 0 always sends the full registration
+  uint32_t registrationFingerprintTimeoutMs = 2'000;
+
+  // Token-bucket budget per publish lane, in SentientPublishLanes::Lane order: {messages per second, burst}.
+  // A rate of 0 leaves the lane unlimited, which every lane is until the sketch opts in.
+  // Over-budget messages are deferred to the outbound queue; anything it cannot hold is logged and counted.
+  SentientPublishLanes::Budget laneBudgets[SentientPublishLanes::LaneCount] = {
+      {0, 0}, // Safety
+      {0, 0}, // Ack
+      {0, 0}, // State
+      {0, 0}, // Sensors
+      {0, 0}, // Metrics
+  };
 
 #if defined(ESP32)
   const char *wifiSsid = nullptr;
@@ -79,6 +176,9 @@ class SentientMQTT
 {
 public:
   explicit SentientMQTT(const SentientMQTTConfig &config);
+  ~SentientMQTT();
+  SentientMQTT(const SentientMQTT &) = delete;
+  SentientMQTT &operator=(const SentientMQTT &) = delete;
 
   bool begin();
   void loop();
@@ -89,33 +189,247 @@ public:
   bool publishState(const char *state, const JsonDocument &extras);
   bool publishEvent(const char *eventName, const JsonDocument &payload);
   bool publishJson(const char *category, const char *item, const JsonDocument &payload, bool retain = false);
+  bool publishJson(const char *category, const char *item, const JsonDocument &payload, bool retain,
+                   SentientPublishLanes::Lane lane);
   bool publishText(const char *category, const char *item, const char *payload, bool retain = false);
   bool publishHeartbeat();
   bool publishHeartbeat(const JsonDocument &payload);
 
+  // Sensor batching: every add() between beginBatch() and commitBatch() becomes
+  // one entry, with its own timestamp, in a single frame on sensors/batch.
+  // A batch that reaches SENTIENT_MQTT_BATCH_MAX_ITEMS (or fills its arena) is
+  // sent early and a new one started, so add() never loses an item.
+  bool beginBatch();
+  bool add(const char *item, const JsonDocument &payload);
+  bool add(const char *item, float value, const char *unit = nullptr);
+  bool commitBatch();
+  bool batchOpen() const { return _batchOpen; }
+
   void setCommandCallback(SentientCommandCallback callback, void *context = nullptr);
+  // Inside the command callback: the <device> of commands/<controller>/<device>/<command>, so a
+  // multi-device controller can route a shared command name; "" for commands/<controller>/<command>
+  const char *commandDevice() const { return _commandDevice; }
   void setHeartbeatBuilder(SentientHeartbeatBuilder callback, void *context = nullptr);
   void setOnConnect(SentientConnectionCallback callback, void *context = nullptr);
   void setOnDisconnect(SentientConnectionCallback callback, void *context = nullptr);
 
+  // Registration sent from loop() on every broker session; the source must outlive this object
+  void setRegistration(SentientRegistrationSource *source);
+  const SentientRegistration &registration() const { return _registration; }
+
   bool isConnected() { return _mqttClient.connected(); }
   const SentientMQTTConfig &config() const { return _config; }
   PubSubClient &get_client() { return _mqttClient; }
+  const SentientJsonArenaBase &publishArena() const { return _publishArena; }
+  const SentientOutboundQueue &outboundQueue() const { return _outbound; }
+  const SentientPublishLanes &publishLanes() const { return _lanes; }
+
+  // Microseconds since the Unix epoch on the backend's clock; 0 until the first time-sync exchange
+  uint64_t nowEpochMicros();
+  bool clockSynced() const { return _clock.synced(); }
+  const SentientClockSync &clockSync() const { return _clock; }
+  const SentientCueWheel &cueWheel() const { return _cues; }
 
 private:
+  // Categories the library publishes to itself; their topic prefixes are cached at begin()
+  enum TopicCategory : uint8_t
+  {
+    TopicSensors,
+    TopicMetrics,
+    TopicEvents,
+    TopicStatus,
+    TopicCategoryCount
+  };
+
+  // Broker connect runs one stage per loop() so motion and animation never stall on it
+  enum ConnectStage : uint8_t
+  {
+    ConnectIdle,
+    ConnectSocketOpen,
+    ConnectSendConnect,
+    ConnectAwaitConnack,
+    ConnectSubscribe
+  };
+
+  // Broker addresses tried in turn when both brokerIp and brokerHost are configured
+  enum BrokerTarget : uint8_t
+  {
+    TargetIp,
+    TargetHost
+  };
+
   bool configureNetwork();
+  bool linkUp();
   void ensureConnected();
+  bool brokerAddress(IPAddress &address) const;
+  void stepBrokerLookup();
+  void scheduleReconnect();
+  void stepConnect();
+  bool openSocket();
+  bool sendConnect();
+  bool pollConnack();
+  void completeConnect();
+  void abortConnect(const __FlashStringHelper *reason);
   void handleIncoming(char *topic, uint8_t *payload, unsigned int length);
-  bool publishRaw(const String &topic, const char *payload, bool retain);
+  void dispatchCommand(const char *commandPath, const uint8_t *payload, size_t length, uint64_t receivedLocal,
+                       bool fromNetwork);
+  bool scheduleCue(const char *commandPath, const uint8_t *payload, size_t length, uint64_t receivedLocal,
+                   JsonVariantConst executeAt);
+  void runDueCues();
+  void sampleLoop();
+  void reportOversizedPackets();
+  bool queueOutbound(const char *topic, const uint8_t *payload, size_t length, bool retain,
+                     SentientOutboundQueue::Policy policy, SentientPublishLanes::Lane lane);
+  bool publishMetricsRegistry();
+  void stepTraceDump();
+  void stepRegistration();
+  bool publishRegistrationFingerprint();
+  void handleManifestKnown(const JsonDocument &reply);
+  bool sendRegistrationRecord(SentientRegistrationSource &source, size_t index, const char *topic, size_t length);
+  size_t socketWriteSpace();
+  static void forwardLog(SentientLog::Level level, uint32_t timeMs, const char *text, void *context);
+  void publishCommandAck(const char *command, JsonVariantConst traceId, uint64_t receivedLocal, uint64_t handledLocal);
+  void stepTimeSync();
+  void handleTimeSync(const JsonDocument &reply, uint64_t t4);
+  void stampEpoch(JsonVariant target);
+  int appendEpochMs(char *buffer, size_t capacity, int length);
+  int appendMemoryStats(char *buffer, size_t capacity, int length);
+  bool publishRaw(const char *topic, const uint8_t *payload, size_t length, bool retain,
+                  SentientOutboundQueue::Policy policy, SentientPublishLanes::Lane lane);
+  bool publishStreamed(const char *topic, const JsonDocument &payload, bool retain,
+                       SentientOutboundQueue::Policy policy, SentientPublishLanes::Lane lane);
+  bool sendStreamed(const char *topic, const JsonDocument &payload, size_t length, bool retain);
+  bool deferStreamed(const char *topic, const JsonDocument &payload, size_t length, bool retain,
+                     SentientOutboundQueue::Policy policy, SentientPublishLanes::Lane lane);
+  void drainDeferredStream();
+  bool streamDeferredAtOrAbove(SentientPublishLanes::Lane lane) const;
+  bool socketTakesStream(const char *topic, size_t length);
+  bool sendPublish(const char *topic, const uint8_t *payload, size_t length, bool retain);
+  bool publishJson(TopicCategory category, const char *item, const JsonDocument &payload, bool retain,
+                   SentientOutboundQueue::Policy policy, SentientPublishLanes::Lane lane);
+  bool publishSerialized(const JsonDocument &payload, bool retain, SentientOutboundQueue::Policy policy,
+                         SentientPublishLanes::Lane lane);
+  void drainOutbound();
+  bool publishDefaultHeartbeat();
+  JsonObject addBatchItem(const char *item);
+  void flushFullBatch();
 
-  String buildTopic(const char *category, const char *item = nullptr) const;
-  String buildClientId() const;
-  String buildConnectionPayload(const char *state) const;
+  void buildTemplates();
+  size_t buildTopic(char *buffer, size_t capacity, const char *category, const char *item = nullptr) const;
+  size_t buildTopic(char *buffer, size_t capacity, TopicCategory category, const char *item) const;
+  void buildClientId();
+  size_t buildConnectionPayload(const char *state);
 
   SentientMQTTConfig _config;
   SENTIENT_NETWORK_CLIENT _networkClient;
+  SentientHandshakeClient _handshakeClient;
   PubSubClient _mqttClient;
-  unsigned long _lastConnectAttempt = 0;
+  SENTIENT_NETWORK_UDP _dnsUdp;
+  SentientDnsLookup _brokerLookup{_dnsUdp};
+
+  // Topic segments that never change after begin(): "<namespace>/<room>" and "<controller>/<device>"
+  char _topicPrefix[SENTIENT_MQTT_MAX_TOPIC_LENGTH] = {0};
+  size_t _topicPrefixLength = 0;
+  char _topicOwner[SENTIENT_MQTT_MAX_TOPIC_LENGTH] = {0};
+  size_t _topicOwnerLength = 0;
+
+  // "<namespace>/<room>/<category>/<controller>/<device>" for each library category
+  char _categoryTopics[TopicCategoryCount][SENTIENT_MQTT_MAX_TOPIC_LENGTH] = {{0}};
+  size_t _categoryTopicLengths[TopicCategoryCount] = {0};
+
+  // Static `,"deviceId":...}` tails appended after the dynamic state/timestamp fields
+  char _connectionTail[SENTIENT_MQTT_MAX_FRAGMENT_LENGTH] = {0};
+  size_t _connectionTailLength = 0;
+  char _heartbeatTail[SENTIENT_MQTT_MAX_FRAGMENT_LENGTH] = {0};
+  size_t _heartbeatTailLength = 0;
+
+  // Per-message scratch space, reused so the publish path never allocates
+  char _topicBuffer[SENTIENT_MQTT_MAX_TOPIC_LENGTH] = {0};
+  char *_payloadBuffer = nullptr;
+  size_t _payloadBufferSize = 0;
+  SentientJsonHeapArena _publishArena;
+  JsonDocument _publishDoc;
+
+  SentientOutboundQueue _outbound;
+  SentientPublishLanes _lanes;
+
+  // The one streamed publish held back by its lane, a full socket or a dropped session: too large for the
+  // outbound queue, it is kept serialized here. The buffer grows to the largest such payload and is reused.
+  char _deferredTopic[SENTIENT_MQTT_MAX_TOPIC_LENGTH] = {0};
+  uint8_t *_deferredPayload = nullptr;
+  size_t _deferredCapacity = 0;
+  size_t _deferredLength = 0;
+  uint8_t _deferredLane = 0;
+  bool _deferredRetain = false;
+  bool _deferredPending = false;
+
+  SentientClockSync _clock;
+  SentientCueWheel _cues;
+  SentientRegistration _registration;
+
+  // Ids of the entries this library keeps in SentientMetrics
+  struct MetricIds
+  {
+    SentientMetrics::Id publishesAttempted;
+    SentientMetrics::Id publishesSucceeded;
+    SentientMetrics::Id publishesFailed;
+    SentientMetrics::Id bytesSent;
+    SentientMetrics::Id reconnects;
+    SentientMetrics::Id commandsReceived;
+    SentientMetrics::Id parseFailures;
+    SentientMetrics::Id inboundOversized;
+    SentientMetrics::Id publishesDropped;
+    SentientMetrics::Id loopsPerSecond;
+    SentientMetrics::Id loopMaxUs;
+    SentientMetrics::Id loopUs;
+    SentientMetrics::Id registrationProgress;
+    SentientMetrics::Id registrationMs;
+  };
+  MetricIds _metrics;
+  uint32_t _oversizedReported = 0;
+  uint32_t _lastLoopUs = 0;
+  uint32_t _loopMaxUs = 0;
+  uint32_t _loopsThisSecond = 0;
+  unsigned long _loopRateStart = 0;
+  unsigned long _lastMetricsPublish = 0;
+  bool _hasConnected = false;
+  unsigned long _lastTracePersist = 0;
+  uint64_t _timeSyncT1 = 0; // Local send time of the outstanding time-sync request
+  unsigned long _lastTimeSync = 0;
+  bool _timeSyncDue = false;
+
+  SentientJsonHeapArena _batchArena;
+  JsonDocument _batchDoc;
+  JsonArray _batchItems;
+  uint16_t _batchCount = 0;
+  bool _batchOpen = false;
+
+  // Preallocated documents for inbound commands, so the receive path never allocates
+  struct CommandSlot
+  {
+    SentientJsonHeapArena arena;
+    JsonDocument doc{&arena};
+    bool busy = false;
+    char tracedCommand[64] = {0}; // Copied out of the receive buffer, which a re-entrant loop() may reuse
+    char device[64] = {0};        // Same, for commandDevice()
+  };
+  CommandSlot _commandSlots[SENTIENT_MQTT_COMMAND_DOC_POOL];
+  char _commandText[SENTIENT_MQTT_COMMAND_TEXT_SIZE] = {0};
+
+  unsigned long _nextConnectAt = 0;
+  uint8_t _connectFailures = 0;
+  uint32_t _jitterSeed = 0; // Derived from the controller ID so controllers spread their retries
+  BrokerTarget _brokerTarget = TargetIp;
+  IPAddress _resolvedBroker; // Cached brokerHost lookup; refreshed after brokerHostTtlMs, in use until then
+  bool _resolvedBrokerValid = false;
+  unsigned long _resolvedBrokerAt = 0;
+  bool _linkWasUp = true;
+  unsigned long _socketDeadline = 0;
+  uint32_t _socketSliceMs = 0; // Timeout of the next TCP connect try; 0 until the attempt has started
+  IPAddress _socketAddress;
+  unsigned long _connackDeadline = 0;
+  ConnectStage _connectStage = ConnectIdle;
+  char _clientId[64] = {0};
   unsigned long _lastHeartbeat = 0;
   bool _wasConnected = false;
 
@@ -127,6 +441,7 @@ private:
 
   SentientCommandCallback _commandCallback = nullptr;
   void *_commandContext = nullptr;
+  const char *_commandDevice = ""; // The dispatching slot's device while its callback runs
 
   SentientHeartbeatBuilder _heartbeatBuilder = nullptr;
   void *_heartbeatContext = nullptr;
@@ -0,0 +1,229 @@
+#include "SentientMemoryStats.h"
+
+#include <cstdlib>
+
+#if defined(__IMXRT1062__)
+#include <malloc.h>
+#elif defined(ESP32)
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#elif !defined(ARDUINO)
+#include <cstddef>
+#include <new>
+#endif
+
+uint32_t SentientMemoryStats::s_allocations = 0;
+uint32_t SentientMemoryStats::s_frees = 0;
+
+#if defined(__IMXRT1062__)
+// Teensy 4.x linker script and startup.c
+extern unsigned long _ebss;
+extern unsigned long _estack;
+extern unsigned long _heap_end;
+extern char *__brkval;
+
+namespace
+{
+  constexpr uint32_t kDtcmStart = 0x20000000;
+  constexpr uint32_t kOcramStart = 0x20200000;
+  constexpr uint32_t kStackPaint = 0xA5A5A5A5;
+  constexpr size_t kPaintMarginWords = 64; // Left below the caller's frame for paintStack() itself
+
+  uint32_t *stackBottom() { return reinterpret_cast<uint32_t *>(&_ebss); }
+} // namespace
+
+void SentientMemoryStats::paintStack()
+{
+  // Interrupts share this stack, but an ISR's frame is gone before the loop resumes
+  volatile uint32_t marker = 0;
+  uint32_t *const top = const_cast<uint32_t *>(&marker) - kPaintMarginWords;
+  for (uint32_t *word = stackBottom(); word < top; ++word)
+  {
+    *word = kStackPaint;
+  }
+}
+
+SentientMemoryStats::Snapshot SentientMemoryStats::sample()
+{
+  Snapshot snapshot;
+
+  const struct mallinfo info = mallinfo();
+  const uint32_t aboveBreak = reinterpret_cast<uint32_t>(&_heap_end) - reinterpret_cast<uint32_t>(__brkval);
+  snapshot.heapUsed = info.uordblks;
+  snapshot.heapFree = info.fordblks + aboveBreak;
+  snapshot.heapLargestBlock = aboveBreak;
+  snapshot.heapFreeChunks = info.ordblks;
+
+  const uint32_t *word = stackBottom();
+  const uint32_t *const end = reinterpret_cast<const uint32_t *>(&_estack);
+  while (word < end && *word == kStackPaint)
+  {
+    ++word;
+  }
+  snapshot.stackFree = reinterpret_cast<uint32_t>(word) - reinterpret_cast<uint32_t>(stackBottom());
+  snapshot.stackSize = reinterpret_cast<uint32_t>(end) - reinterpret_cast<uint32_t>(stackBottom());
+
+  snapshot.dtcmSize = reinterpret_cast<uint32_t>(&_estack) - kDtcmStart;
+  snapshot.dtcmUsed = snapshot.dtcmSize - snapshot.stackFree;
+  snapshot.ocramSize = reinterpret_cast<uint32_t>(&_heap_end) - kOcramStart;
+  snapshot.ocramUsed = reinterpret_cast<uint32_t>(__brkval) - kOcramStart - info.fordblks;
+
+  snapshot.allocations = s_allocations;
+  snapshot.frees = s_frees;
+  return snapshot;
+}
+
+#elif defined(ESP32)
+
+void SentientMemoryStats::paintStack()
+{
+  // FreeRTOS fills every task stack at creation
+}
+
+SentientMemoryStats::Snapshot SentientMemoryStats::sample()
+{
+  Snapshot snapshot;
+
+  multi_heap_info_t info;
+  heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+  snapshot.heapUsed = info.total_allocated_bytes;
+  snapshot.heapFree = info.total_free_bytes;
+  snapshot.heapLargestBlock = info.largest_free_block;
+  snapshot.heapFreeChunks = info.free_blocks;
+
+  // ESP-IDF reports the high-water mark in bytes
+  snapshot.stackFree = uxTaskGetStackHighWaterMark(nullptr);
+#ifdef CONFIG_ARDUINO_LOOP_STACK_SIZE
+  snapshot.stackSize = CONFIG_ARDUINO_LOOP_STACK_SIZE;
+#endif
+
+  snapshot.allocations = s_allocations;
+  snapshot.frees = s_frees;
+  return snapshot;
+}
+
+#else
+
+namespace
+{
+  uint32_t s_liveBytes = 0;
+} // namespace
+
+void SentientMemoryStats::paintStack() {}
+
+SentientMemoryStats::Snapshot SentientMemoryStats::sample()
+{
+  Snapshot snapshot;
+  snapshot.heapUsed = s_liveBytes;
+  snapshot.allocations = s_allocations;
+  snapshot.frees = s_frees;
+  return snapshot;
+}
+
+#if !defined(ARDUINO)
+// Host builds: every C++ allocation goes through this counting allocator. The header keeps the
+// block size so live bytes can be tracked without the platform's malloc introspection.
+namespace
+{
+  constexpr size_t kHeaderSize = alignof(std::max_align_t);
+
+  void *countedAllocate(size_t size)
+  {
+    uint8_t *block = static_cast<uint8_t *>(malloc(kHeaderSize + size));
+    if (!block)
+    {
+      throw std::bad_alloc();
+    }
+    *reinterpret_cast<size_t *>(block) = size;
+    s_liveBytes += static_cast<uint32_t>(size);
+    SentientMemoryStats::recordAllocation();
+    return block + kHeaderSize;
+  }
+
+  void countedFree(void *pointer)
+  {
+    if (!pointer)
+    {
+      return;
+    }
+    uint8_t *block = static_cast<uint8_t *>(pointer) - kHeaderSize;
+    s_liveBytes -= static_cast<uint32_t>(*reinterpret_cast<size_t *>(block));
+    SentientMemoryStats::recordFree();
+    free(block);
+  }
+} // namespace
+
+void *operator new(size_t size) { return countedAllocate(size); }
+void *operator new[](size_t size) { return countedAllocate(size); }
+void operator delete(void *pointer) noexcept { countedFree(pointer); }
+void operator delete[](void *pointer) noexcept { countedFree(pointer); }
+void operator delete(void *pointer, size_t) noexcept { countedFree(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { countedFree(pointer); }
+#endif
+
+#endif
+
+void SentientMemoryStats::write(JsonObject target)
+{
+  write(target, sample());
+}
+
+void SentientMemoryStats::write(JsonObject target, const Snapshot &snapshot)
+{
+  target["heapUsed"] = snapshot.heapUsed;
+  target["heapFree"] = snapshot.heapFree;
+  target["heapLargest"] = snapshot.heapLargestBlock;
+  target["heapChunks"] = snapshot.heapFreeChunks;
+  target["stackFree"] = snapshot.stackFree;
+  target["stackSize"] = snapshot.stackSize;
+  if (snapshot.dtcmSize > 0)
+  {
+    target["dtcmUsed"] = snapshot.dtcmUsed;
+    target["dtcmSize"] = snapshot.dtcmSize;
+    target["ocramUsed"] = snapshot.ocramUsed;
+    target["ocramSize"] = snapshot.ocramSize;
+  }
+  target["allocs"] = snapshot.allocations;
+  target["frees"] = snapshot.frees;
+}
+
+SentientCountingAllocator &SentientCountingAllocator::instance()
+{
+  static SentientCountingAllocator allocator;
+  return allocator;
+}
+
+void *SentientCountingAllocator::allocate(size_t size)
+{
+  void *pointer = malloc(size);
+  if (pointer)
+  {
+    SentientMemoryStats::recordAllocation();
+  }
+  return pointer;
+}
+
+void SentientCountingAllocator::deallocate(void *pointer)
+{
+  if (pointer)
+  {
+    SentientMemoryStats::recordFree();
+  }
+  free(pointer);
+}
+
+void *SentientCountingAllocator::reallocate(void *pointer, size_t newSize)
+{
+  // A moved block counts as a free plus an allocation, matching what malloc's free list sees
+  void *moved = realloc(pointer, newSize);
+  if (moved && moved != pointer)
+  {
+    if (pointer)
+    {
+      SentientMemoryStats::recordFree();
+    }
+    SentientMemoryStats::recordAllocation();
+  }
+  return moved;
+}
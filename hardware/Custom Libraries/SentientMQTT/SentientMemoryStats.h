@@ -0,0 +1,74 @@
+/*
+ * SentientMemoryStats - Heap, stack and RAM-region figures for the heartbeat.
+ *
+ * paintStack() fills the unused stack below the caller with a known pattern;
+ * sample() later scans for the deepest overwritten word, which gives the
+ * stack high-water mark since painting. SentientMQTT::begin() paints, so the
+ * mark covers everything after setup() reaches it.
+ *
+ * Per platform:
+ *   - Teensy 4.1: DTCM holds .data/.bss and the stack, OCRAM (RAM2) holds
+ *     DMAMEM and the heap. Region use comes from the linker symbols and the
+ *     heap break; free chunk count from newlib's mallinfo().
+ *   - ESP32: heap_caps free/largest-block figures; FreeRTOS already paints the
+ *     loop task's stack, so its high-water mark is used directly.
+ *   - Host builds: global operator new/delete are replaced by a counting
+ *     allocator, so allocation counts and live bytes track the same way.
+ *
+ * Allocation counts come from recordAllocation()/recordFree(). Besides the host
+ * allocator, SentientCountingAllocator feeds them for any JsonDocument built on
+ * it; newlib's malloc has no hook a library can install on the device.
+ */
+
+#ifndef SENTIENT_MEMORY_STATS_H
+#define SENTIENT_MEMORY_STATS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+class SentientMemoryStats
+{
+public:
+  struct Snapshot
+  {
+    uint32_t heapUsed = 0;         // Bytes in live allocations
+    uint32_t heapFree = 0;         // Free heap bytes, including never-used space above the break
+    uint32_t heapLargestBlock = 0; // Largest contiguous free block (Teensy: the space above the break, a lower bound)
+    uint32_t heapFreeChunks = 0;   // Free-list fragments; growth with steady heapFree means fragmentation
+    uint32_t stackFree = 0;        // Stack never touched since paintStack(); 0 when unknown
+    uint32_t stackSize = 0;
+    uint32_t dtcmUsed = 0; // Teensy 4.x only: static data plus the stack high-water mark
+    uint32_t dtcmSize = 0;
+    uint32_t ocramUsed = 0; // Teensy 4.x only: DMAMEM plus the heap
+    uint32_t ocramSize = 0;
+    uint32_t allocations = 0;
+    uint32_t frees = 0;
+  };
+
+  static void paintStack();
+  static Snapshot sample();
+
+  // Writes the snapshot's fields into `target` (regions only where the platform has them)
+  static void write(JsonObject target);
+  static void write(JsonObject target, const Snapshot &snapshot);
+
+  static void recordAllocation() { ++s_allocations; }
+  static void recordFree() { ++s_frees; }
+
+private:
+  static uint32_t s_allocations;
+  static uint32_t s_frees;
+};
+
+// ArduinoJson allocator that counts into SentientMemoryStats: JsonDocument doc(&SentientCountingAllocator::instance());
+class SentientCountingAllocator : public ArduinoJson::Allocator
+{
+public:
+  static SentientCountingAllocator &instance();
+
+  void *allocate(size_t size) override;
+  void deallocate(void *pointer) override;
+  void *reallocate(void *pointer, size_t newSize) override;
+};
+
+#endif // SENTIENT_MEMORY_STATS_H
@@ -0,0 +1,125 @@
+#include "SentientMetrics.h"
+
+#include <cstring>
+
+SentientMetrics::Entry SentientMetrics::s_entries[SENTIENT_METRICS_MAX_ENTRIES] = {};
+uint8_t SentientMetrics::s_count = 0;
+
+SentientMetrics::Id SentientMetrics::counter(const char *name)
+{
+  return add(name, Counter, nullptr, 0);
+}
+
+SentientMetrics::Id SentientMetrics::gauge(const char *name)
+{
+  return add(name, Gauge, nullptr, 0);
+}
+
+SentientMetrics::Id SentientMetrics::histogram(const char *name, const uint32_t *bounds, uint8_t boundCount)
+{
+  if (boundCount > SENTIENT_METRICS_MAX_BUCKETS)
+  {
+    boundCount = SENTIENT_METRICS_MAX_BUCKETS;
+  }
+  return add(name, Histogram, bounds, boundCount);
+}
+
+SentientMetrics::Id SentientMetrics::add(const char *name, Kind kind, const uint32_t *bounds, uint8_t boundCount)
+{
+  if (!name)
+  {
+    return kInvalid;
+  }
+  for (uint8_t i = 0; i < s_count; ++i)
+  {
+    if (strcmp(s_entries[i].name, name) == 0)
+    {
+      return s_entries[i].kind == kind ? i : kInvalid;
+    }
+  }
+  if (s_count >= SENTIENT_METRICS_MAX_ENTRIES)
+  {
+    return kInvalid;
+  }
+
+  Entry &entry = s_entries[s_count];
+  entry.name = name;
+  entry.kind = kind;
+  entry.bounds = bounds;
+  entry.boundCount = bounds ? boundCount : 0;
+  return s_count++;
+}
+
+SentientMetrics::Entry *SentientMetrics::entry(Id id, Kind kind)
+{
+  return id < s_count && s_entries[id].kind == kind ? &s_entries[id] : nullptr;
+}
+
+void SentientMetrics::add(Id id, uint32_t delta)
+{
+  if (Entry *counter = entry(id, Counter))
+  {
+    counter->count += delta;
+  }
+}
+
+void SentientMetrics::set(Id id, float value)
+{
+  if (Entry *gauge = entry(id, Gauge))
+  {
+    gauge->gauge = value;
+  }
+}
+
+void SentientMetrics::observe(Id id, uint32_t value)
+{
+  Entry *histogram = entry(id, Histogram);
+  if (!histogram)
+  {
+    return;
+  }
+  uint8_t bucket = 0;
+  while (bucket < histogram->boundCount && value > histogram->bounds[bucket])
+  {
+    ++bucket;
+  }
+  ++histogram->buckets[bucket];
+  ++histogram->count;
+}
+
+uint32_t SentientMetrics::count(Id id)
+{
+  return id < s_count ? s_entries[id].count : 0;
+}
+
+float SentientMetrics::value(Id id)
+{
+  const Entry *gauge = entry(id, Gauge);
+  return gauge ? gauge->gauge : 0.0f;
+}
+
+void SentientMetrics::write(JsonObject target)
+{
+  for (uint8_t i = 0; i < s_count; ++i)
+  {
+    const Entry &entry = s_entries[i];
+    switch (entry.kind)
+    {
+    case Counter:
+      target[entry.name] = entry.count;
+      break;
+    case Gauge:
+      target[entry.name] = entry.gauge;
+      break;
+    case Histogram:
+    {
+      JsonArray buckets = target[entry.name].to<JsonArray>();
+      for (uint8_t b = 0; b <= entry.boundCount; ++b)
+      {
+        buckets.add(entry.buckets[b]);
+      }
+      break;
+    }
+    }
+  }
+}
@@ -0,0 +1,78 @@
+/*
+ * SentientMetrics - Static registry of runtime counters, gauges and histograms.
+ *
+ * Entries are registered once by name (registering a name again returns the
+ * same id) and live in a fixed table of SENTIENT_METRICS_MAX_ENTRIES, so
+ * updating one is an array write. SentientMQTT registers its own transport
+ * and loop health entries and publishes the whole table as one flat frame on
+ * metrics/<controller>/<device>/registry; sketches add theirs the same way:
+ *
+ *   static const SentientMetrics::Id steps = SentientMetrics::counter("steps_issued");
+ *   SentientMetrics::add(steps);
+ *
+ * Counters are cumulative; the backend derives rates from successive frames.
+ * Histogram buckets are upper bounds (value <= bound) plus an overflow bucket.
+ */
+
+#ifndef SENTIENT_METRICS_H
+#define SENTIENT_METRICS_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#ifndef SENTIENT_METRICS_MAX_ENTRIES
+#define SENTIENT_METRICS_MAX_ENTRIES 32
+#endif
+#ifndef SENTIENT_METRICS_MAX_BUCKETS
+#define SENTIENT_METRICS_MAX_BUCKETS 8 // Histogram bounds per entry; one more bucket counts overflow
+#endif
+
+class SentientMetrics
+{
+public:
+  using Id = uint8_t;
+  static constexpr Id kInvalid = 0xFF; // Returned when the table is full; updates to it are ignored
+
+  enum Kind : uint8_t
+  {
+    Counter,
+    Gauge,
+    Histogram
+  };
+
+  static Id counter(const char *name);
+  static Id gauge(const char *name);
+  // `bounds` must be ascending and outlive the registry (a static array)
+  static Id histogram(const char *name, const uint32_t *bounds, uint8_t boundCount);
+
+  static void add(Id id, uint32_t delta = 1);
+  static void set(Id id, float value);
+  static void observe(Id id, uint32_t value);
+
+  static uint32_t count(Id id);
+  static float value(Id id);
+
+  // Writes every entry as "name": value (histograms as bucket-count arrays)
+  static void write(JsonObject target);
+  static uint8_t size() { return s_count; }
+
+private:
+  struct Entry
+  {
+    const char *name;
+    Kind kind;
+    uint8_t boundCount;
+    const uint32_t *bounds;
+    uint32_t count;
+    float gauge;
+    uint32_t buckets[SENTIENT_METRICS_MAX_BUCKETS + 1];
+  };
+
+  static Id add(const char *name, Kind kind, const uint32_t *bounds, uint8_t boundCount);
+  static Entry *entry(Id id, Kind kind);
+
+  static Entry s_entries[SENTIENT_METRICS_MAX_ENTRIES];
+  static uint8_t s_count;
+};
+
+#endif // SENTIENT_METRICS_H
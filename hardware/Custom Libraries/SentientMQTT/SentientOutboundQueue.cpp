@@ -0,0 +1,199 @@
+#include "SentientOutboundQueue.h"
+
+#include <cstring>
+
+namespace
+{
+  uint32_t fnv1a(const char *text, size_t length)
+  {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; ++i)
+    {
+      hash ^= static_cast<uint8_t>(text[i]);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  // Sequence numbers are compared as a signed distance so wrap-around is harmless
+  bool isOlder(uint32_t a, uint32_t b)
+  {
+    return static_cast<int32_t>(a - b) < 0;
+  }
+} // namespace
+
+bool SentientOutboundQueue::push(const char *topic, const uint8_t *payload, size_t length, bool retain, Policy policy,
+                                 uint8_t priority)
+{
+  if (policy == DropWhenOffline || !topic)
+  {
+    return false;
+  }
+
+  const size_t topicLength = strlen(topic);
+  if (topicLength + 1 + length > SENTIENT_MQTT_QUEUE_ENTRY_SIZE)
+  {
+    ++_stats.dropped;
+    return false;
+  }
+
+  const uint32_t topicHash = fnv1a(topic, topicLength);
+  int slot = -1;
+  if (policy == Coalesce)
+  {
+    slot = findTopic(topic, topicHash);
+    if (slot >= 0)
+    {
+      ++_stats.coalesced;
+    }
+  }
+
+  if (slot < 0)
+  {
+    slot = findFree();
+    if (slot < 0)
+    {
+      slot = findEvictable();
+      if (slot < 0)
+      {
+        ++_stats.dropped;
+        return false;
+      }
+      ++_stats.evicted;
+      _entries[slot].used = false;
+      --_count;
+    }
+
+    Entry &entry = _entries[slot];
+    entry.sequence = _nextSequence++;
+    entry.topicHash = topicHash;
+    entry.topicLength = static_cast<uint16_t>(topicLength);
+    entry.policy = policy;
+    entry.used = true;
+    memcpy(entry.data, topic, topicLength + 1);
+    ++_count;
+  }
+
+  Entry &entry = _entries[slot];
+  entry.priority = priority;
+  entry.retain = retain;
+  entry.payloadLength = static_cast<uint16_t>(length);
+  if (length > 0)
+  {
+    memcpy(entry.data + entry.topicLength + 1, payload, length);
+  }
+  ++_stats.queued;
+  return true;
+}
+
+bool SentientOutboundQueue::front(const char *&topic, const uint8_t *&payload, size_t &length, bool &retain,
+                                  uint8_t &priority) const
+{
+  const int slot = findNext();
+  if (slot < 0)
+  {
+    return false;
+  }
+
+  const Entry &entry = _entries[slot];
+  topic = entry.data;
+  payload = reinterpret_cast<const uint8_t *>(entry.data + entry.topicLength + 1);
+  length = entry.payloadLength;
+  retain = entry.retain;
+  priority = entry.priority;
+  return true;
+}
+
+void SentientOutboundQueue::pop()
+{
+  const int slot = findNext();
+  if (slot >= 0)
+  {
+    _entries[slot].used = false;
+    --_count;
+  }
+}
+
+void SentientOutboundQueue::clear()
+{
+  for (Entry &entry : _entries)
+  {
+    entry.used = false;
+  }
+  _count = 0;
+}
+
+bool SentientOutboundQueue::pendingAtOrAbove(uint8_t priority) const
+{
+  for (int i = 0; i < SENTIENT_MQTT_QUEUE_SLOTS; ++i)
+  {
+    if (_entries[i].used && _entries[i].priority <= priority)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+int SentientOutboundQueue::findNext() const
+{
+  int next = -1;
+  for (int i = 0; i < SENTIENT_MQTT_QUEUE_SLOTS; ++i)
+  {
+    const Entry &entry = _entries[i];
+    if (!entry.used)
+    {
+      continue;
+    }
+    if (next < 0 || entry.priority < _entries[next].priority ||
+        (entry.priority == _entries[next].priority && isOlder(entry.sequence, _entries[next].sequence)))
+    {
+      next = i;
+    }
+  }
+  return next;
+}
+
+int SentientOutboundQueue::findEvictable() const
+{
+  int victim = -1;
+  for (int i = 0; i < SENTIENT_MQTT_QUEUE_SLOTS; ++i)
+  {
+    const Entry &entry = _entries[i];
+    if (!entry.used || entry.policy != Coalesce)
+    {
+      continue;
+    }
+    if (victim < 0 || entry.priority > _entries[victim].priority ||
+        (entry.priority == _entries[victim].priority && isOlder(entry.sequence, _entries[victim].sequence)))
+    {
+      victim = i;
+    }
+  }
+  return victim;
+}
+
+int SentientOutboundQueue::findTopic(const char *topic, uint32_t topicHash) const
+{
+  for (int i = 0; i < SENTIENT_MQTT_QUEUE_SLOTS; ++i)
+  {
+    const Entry &entry = _entries[i];
+    if (entry.used && entry.policy == Coalesce && entry.topicHash == topicHash && strcmp(entry.data, topic) == 0)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int SentientOutboundQueue::findFree() const
+{
+  for (int i = 0; i < SENTIENT_MQTT_QUEUE_SLOTS; ++i)
+  {
+    if (!_entries[i].used)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
@@ -0,0 +1,83 @@
+/*
+ * SentientOutboundQueue - Fixed-memory store-and-forward queue for SentientMQTT.
+ *
+ * Holds messages published while the broker is unreachable, or deferred
+ * because their publish lane is over budget:
+ * - Coalesce entries (sensors, state) keep only the latest payload per topic,
+ *   in the position of the first queued value.
+ * - Ordered entries (events) are kept in publish order.
+ * Each entry carries a priority (0 = most urgent, see SentientPublishLanes):
+ * front() returns the oldest entry of the most urgent priority queued, so a
+ * backlog of sensor values never delays a safety event.
+ * When full, the oldest coalesce entry of the least urgent priority is evicted
+ * to make room; if every slot holds an ordered entry, the new message is
+ * dropped and counted.
+ */
+
+#ifndef SENTIENT_OUTBOUND_QUEUE_H
+#define SENTIENT_OUTBOUND_QUEUE_H
+
+#include <Arduino.h>
+
+#ifndef SENTIENT_MQTT_QUEUE_SLOTS
+#define SENTIENT_MQTT_QUEUE_SLOTS 16
+#endif
+#ifndef SENTIENT_MQTT_QUEUE_ENTRY_SIZE
+#define SENTIENT_MQTT_QUEUE_ENTRY_SIZE 256 // Topic + payload bytes per queued message
+#endif
+
+class SentientOutboundQueue
+{
+public:
+  enum Policy : uint8_t
+  {
+    Ordered,
+    Coalesce,
+    DropWhenOffline
+  };
+
+  struct Stats
+  {
+    uint32_t queued = 0;
+    uint32_t coalesced = 0;
+    uint32_t evicted = 0;
+    uint32_t dropped = 0;
+  };
+
+  bool push(const char *topic, const uint8_t *payload, size_t length, bool retain, Policy policy,
+            uint8_t priority = 0);
+  bool front(const char *&topic, const uint8_t *&payload, size_t &length, bool &retain, uint8_t &priority) const;
+  void pop();
+  void clear();
+
+  bool empty() const { return _count == 0; }
+  bool pendingAtOrAbove(uint8_t priority) const; // Anything queued at `priority` or more urgent
+  uint8_t size() const { return _count; }
+  const Stats &stats() const { return _stats; }
+
+private:
+  struct Entry
+  {
+    uint32_t sequence;
+    uint32_t topicHash;
+    uint16_t topicLength;
+    uint16_t payloadLength;
+    Policy policy;
+    uint8_t priority;
+    bool retain;
+    bool used;
+    char data[SENTIENT_MQTT_QUEUE_ENTRY_SIZE]; // "<topic>\0<payload>"
+  };
+
+  int findNext() const;
+  int findEvictable() const;
+  int findTopic(const char *topic, uint32_t topicHash) const;
+  int findFree() const;
+
+  Entry _entries[SENTIENT_MQTT_QUEUE_SLOTS] = {};
+  uint8_t _count = 0;
+  uint32_t _nextSequence = 0;
+  Stats _stats;
+};
+
+#endif // SENTIENT_OUTBOUND_QUEUE_H
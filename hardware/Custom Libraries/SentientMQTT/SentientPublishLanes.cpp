@@ -0,0 +1,53 @@
+#include "SentientPublishLanes.h"
+
+namespace
+{
+  uint32_t bucketCapacity(const SentientPublishLanes::Budget &budget, uint32_t scale)
+  {
+    return static_cast<uint32_t>(budget.burst > 0 ? budget.burst : 1) * scale;
+  }
+} // namespace
+
+void SentientPublishLanes::configure(const Budget (&budgets)[LaneCount], unsigned long nowMs)
+{
+  for (uint8_t lane = 0; lane < LaneCount; ++lane)
+  {
+    Bucket &bucket = _buckets[lane];
+    bucket.budget = budgets[lane];
+    bucket.tokens = bucketCapacity(bucket.budget, kTokenScale);
+    bucket.lastRefill = nowMs;
+  }
+}
+
+bool SentientPublishLanes::acquire(Lane lane, unsigned long nowMs)
+{
+  Bucket &bucket = _buckets[lane];
+  if (bucket.budget.ratePerSecond == 0)
+  {
+    return true;
+  }
+
+  // rate tokens/s over elapsed ms is exactly rate * elapsed thousandths of a token
+  const uint32_t capacity = bucketCapacity(bucket.budget, kTokenScale);
+  const uint32_t elapsed = nowMs - bucket.lastRefill;
+  bucket.lastRefill = nowMs;
+  if (elapsed >= capacity / bucket.budget.ratePerSecond)
+  {
+    bucket.tokens = capacity;
+  }
+  else
+  {
+    bucket.tokens += elapsed * bucket.budget.ratePerSecond;
+    if (bucket.tokens > capacity)
+    {
+      bucket.tokens = capacity;
+    }
+  }
+
+  if (bucket.tokens < kTokenScale)
+  {
+    return false;
+  }
+  bucket.tokens -= kTokenScale;
+  return true;
+}
@@ -0,0 +1,65 @@
+/*
+ * SentientPublishLanes - Per-priority token buckets for SentientMQTT publishes.
+ *
+ * Every publish belongs to a lane. Lanes are listed from most to least urgent:
+ * safety events, command acks, state, sensors, metrics. Each lane refills at
+ * its own rate up to a burst size. A publish that finds its lane empty is
+ * deferred into the outbound queue (where sensor/state values coalesce) or,
+ * for fire-and-forget traffic such as heartbeats, dropped. Both outcomes are
+ * counted per lane so limits can be sized from field data.
+ */
+
+#ifndef SENTIENT_PUBLISH_LANES_H
+#define SENTIENT_PUBLISH_LANES_H
+
+#include <Arduino.h>
+
+class SentientPublishLanes
+{
+public:
+  enum Lane : uint8_t
+  {
+    Safety,
+    Ack,
+    State,
+    Sensors,
+    Metrics,
+    LaneCount
+  };
+
+  struct Budget
+  {
+    uint16_t ratePerSecond; // 0 = unlimited
+    uint16_t burst;
+  };
+
+  struct Stats
+  {
+    uint32_t deferred = 0;
+    uint32_t dropped = 0;
+  };
+
+  void configure(const Budget (&budgets)[LaneCount], unsigned long nowMs);
+
+  // Takes one token from `lane`. Returns false when the lane is over budget.
+  bool acquire(Lane lane, unsigned long nowMs);
+
+  void countDeferred(Lane lane) { ++_stats[lane].deferred; }
+  void countDropped(Lane lane) { ++_stats[lane].dropped; }
+  const Stats &stats(Lane lane) const { return _stats[lane]; }
+
+private:
+  static constexpr uint32_t kTokenScale = 1000; // Tokens are tracked in thousandths so ms refills stay exact
+
+  struct Bucket
+  {
+    Budget budget = {0, 0};
+    uint32_t tokens = 0;
+    unsigned long lastRefill = 0;
+  };
+
+  Bucket _buckets[LaneCount];
+  Stats _stats[LaneCount];
+};
+
+#endif // SENTIENT_PUBLISH_LANES_H
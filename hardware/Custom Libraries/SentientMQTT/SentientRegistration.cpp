@@ -0,0 +1,153 @@
+#include "SentientRegistration.h"
+
+namespace
+{
+  // Hashes whatever is written to it instead of sending it
+  class HashPrint : public Print
+  {
+  public:
+    size_t write(uint8_t byte) override
+    {
+      hash = sentient_fnv::step(hash, byte);
+      return 1;
+    }
+
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+      for (size_t i = 0; i < size; ++i)
+      {
+        hash = sentient_fnv::step(hash, buffer[i]);
+      }
+      return size;
+    }
+
+    uint32_t hash = sentient_fnv::Offset;
+  };
+} // namespace
+
+uint32_t SentientRegistrationSource::manifestHash()
+{
+  HashPrint out;
+  beginRecords();
+  const size_t records = recordCount();
+  for (size_t i = 0; i < records; ++i)
+  {
+    writeRecord(i, out);
+  }
+  endRecords();
+  return out.hash;
+}
+
+void SentientRegistration::setSource(SentientRegistrationSource *source)
+{
+  endRun();
+  _source = source;
+  _phase = Idle;
+  _next = 0;
+  _total = source ? source->recordCount() : 0;
+  _hash = 0;
+  _completions = 0;
+  _skips = 0;
+  _resumes = 0;
+}
+
+void SentientRegistration::sessionStarted(unsigned long nowMs)
+{
+  if (!_source)
+  {
+    return;
+  }
+  if (_phase == Records && _next > 0 && _next < _total)
+  {
+    // The previous session dropped mid-way; the records before _next already reached the broker
+    ++_resumes;
+    return;
+  }
+  _startedMs = nowMs;
+  endRun(); // A run that dropped before its first record starts over
+  if (_fingerprintTimeoutMs > 0)
+  {
+    _phase = Fingerprint;
+    return;
+  }
+  startRecords();
+}
+
+void SentientRegistration::fingerprintSent(uint32_t hash, unsigned long nowMs)
+{
+  if (_phase != Fingerprint)
+  {
+    return;
+  }
+  _hash = hash;
+  _fingerprintMs = nowMs;
+  _phase = AwaitingVerdict;
+}
+
+void SentientRegistration::checkVerdict(unsigned long nowMs)
+{
+  if (_phase == AwaitingVerdict && nowMs - _fingerprintMs >= _fingerprintTimeoutMs)
+  {
+    startRecords();
+  }
+}
+
+bool SentientRegistration::known(uint32_t hash, unsigned long nowMs)
+{
+  // A verdict for another hash (or a late one, after the records started) changes nothing
+  if (_phase != AwaitingVerdict || hash != _hash)
+  {
+    return false;
+  }
+  _phase = Idle;
+  _lastDurationMs = static_cast<uint32_t>(nowMs - _startedMs);
+  ++_skips;
+  return true;
+}
+
+void SentientRegistration::requested(unsigned long nowMs)
+{
+  if (!_source || _phase == Records)
+  {
+    return;
+  }
+  if (_phase == Idle)
+  {
+    _startedMs = nowMs;
+  }
+  startRecords();
+}
+
+bool SentientRegistration::sent(unsigned long nowMs)
+{
+  if (!pending())
+  {
+    return false;
+  }
+  if (++_next < _total)
+  {
+    return false;
+  }
+  endRun();
+  _lastDurationMs = static_cast<uint32_t>(nowMs - _startedMs);
+  ++_completions;
+  return true;
+}
+
+void SentientRegistration::startRecords()
+{
+  // Device count can change between sessions (the runtime manifest is mutable)
+  _source->beginRecords();
+  _total = _source->recordCount();
+  _next = 0;
+  _phase = Records;
+}
+
+void SentientRegistration::endRun()
+{
+  if (_source && _phase == Records)
+  {
+    _source->endRecords();
+  }
+  _phase = Idle;
+}
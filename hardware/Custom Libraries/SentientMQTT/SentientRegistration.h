@@ -0,0 +1,123 @@
+/*
+ * SentientRegistration - Resumable progress through a controller's
+ * registration messages.
+ *
+ * A SentientRegistrationSource presents the registration as numbered records:
+ * the controller record first, then one per device, each with its own topic.
+ * SentientMQTT::loop() sends at most one record per call, and only once the
+ * socket has room for it, instead of the blocking publish_registration() with
+ * its fixed delays. Every new broker session starts a finished registration
+ * over; a session that dropped partway resumes at the record that did not go
+ * out. SentientCapabilityManifest and SentientManifestImageSource are sources.
+ *
+ * Fingerprint handshake: with a fingerprint timeout set, a session first
+ * publishes only {controller_id, firmware_version, manifest_hash}, where the
+ * hash is FNV-1a over every record's bytes in order. The backend answers
+ * "manifest_known" (nothing more is sent) or "send_manifest" (the records
+ * follow); no answer within the timeout also sends the records, so a backend
+ * that does not know the handshake still gets a full registration.
+ */
+
+#ifndef SENTIENT_REGISTRATION_H
+#define SENTIENT_REGISTRATION_H
+
+#include <Arduino.h>
+
+// FNV-1a, 32-bit; constexpr so flash images hash themselves at compile time
+namespace sentient_fnv
+{
+  constexpr uint32_t Offset = 2166136261u;
+  constexpr uint32_t Prime = 16777619u;
+
+  constexpr uint32_t step(uint32_t hash, uint8_t byte) { return (hash ^ byte) * Prime; }
+} // namespace sentient_fnv
+
+class SentientRegistrationSource
+{
+public:
+  virtual size_t recordCount() = 0;
+  virtual const char *recordTopic(size_t index) = 0;
+  virtual size_t recordLength(size_t index) = 0;
+  // Writes exactly recordLength(index) bytes
+  virtual void writeRecord(size_t index, Print &out) = 0;
+  // Bracket one pass over the records (a registration run, or hashing them). A source may build
+  // lookup state here that its records share, and drop it again; passes may nest.
+  virtual void beginRecords() {}
+  virtual void endRecords() {}
+
+  // Identity carried by the fingerprint; controller_id is the one the controller record uses
+  virtual const char *controllerId() = 0;
+  virtual const char *firmwareVersion() = 0;
+  // FNV-1a over all records; the default serializes each one, sources with fixed bytes override it
+  virtual uint32_t manifestHash();
+
+protected:
+  ~SentientRegistrationSource() = default;
+};
+
+class SentientRegistration
+{
+public:
+  // Wait this long for the backend's verdict on a fingerprint; 0 skips the handshake and always sends the records
+  void setFingerprintTimeout(uint32_t timeoutMs) { _fingerprintTimeoutMs = timeoutMs; }
+
+  void setSource(SentientRegistrationSource *source);
+  SentientRegistrationSource *source() const { return _source; }
+
+  // A broker session began: restart a finished registration, resume an unfinished one
+  void sessionStarted(unsigned long nowMs);
+
+  bool fingerprintDue() const { return _source && _phase == Fingerprint; }
+  void fingerprintSent(uint32_t hash, unsigned long nowMs);
+  // No verdict in time: fall back to the records
+  void checkVerdict(unsigned long nowMs);
+  // The backend holds this manifest; returns true when that finished the registration
+  bool known(uint32_t hash, unsigned long nowMs);
+  // The backend asked for the records
+  void requested(unsigned long nowMs);
+
+  bool pending() const { return _source && _phase == Records && _next < _total; }
+  size_t next() const { return _next; }
+  // The record at next() went out; returns true when that completed the registration
+  bool sent(unsigned long nowMs);
+
+  size_t total() const { return _total; }
+  bool complete() const { return _source && _phase == Idle && _completions + _skips > 0; }
+  bool awaitingVerdict() const { return _phase == AwaitingVerdict; }
+  float progress() const { return _total > 0 ? static_cast<float>(_next) / _total : 0.0f; }
+  uint32_t hash() const { return _hash; }
+  uint32_t completions() const { return _completions; }
+  // Sessions the backend confirmed by fingerprint, without any records
+  uint32_t skips() const { return _skips; }
+  uint32_t resumes() const { return _resumes; }
+  // From the start of the run to its last record (or the backend's verdict), across any reconnects in between
+  uint32_t lastDurationMs() const { return _lastDurationMs; }
+
+private:
+  enum Phase : uint8_t
+  {
+    Idle,
+    Fingerprint,
+    AwaitingVerdict,
+    Records,
+  };
+
+  // The records pass brackets the source's beginRecords()/endRecords()
+  void startRecords();
+  void endRun();
+
+  SentientRegistrationSource *_source = nullptr;
+  Phase _phase = Idle;
+  size_t _next = 0;
+  size_t _total = 0;
+  uint32_t _hash = 0;
+  uint32_t _fingerprintTimeoutMs = 0;
+  unsigned long _startedMs = 0;
+  unsigned long _fingerprintMs = 0;
+  uint32_t _lastDurationMs = 0;
+  uint32_t _completions = 0;
+  uint32_t _skips = 0;
+  uint32_t _resumes = 0;
+};
+
+#endif // SENTIENT_REGISTRATION_H
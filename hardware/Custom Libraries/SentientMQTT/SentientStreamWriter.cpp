@@ -0,0 +1,116 @@
+#include "SentientStreamWriter.h"
+
+#include <cstring>
+
+size_t SentientStreamWriter::packetSize(const char *topic, size_t payloadLength)
+{
+  return MQTT_MAX_HEADER_SIZE + 2 + strlen(topic) + payloadLength;
+}
+
+bool SentientStreamWriter::publish(PubSubClient &client, const char *topic, const JsonDocument &payload, bool retain,
+                                   uint32_t stallUs)
+{
+  const size_t length = measureJson(payload);
+  if (!client.beginPublish(topic, static_cast<unsigned int>(length), retain))
+  {
+    return false;
+  }
+
+  SentientStreamWriter writer(client, stallUs);
+  serializeJson(payload, writer);
+  const bool ok = writer.finish() && writer.written() == length;
+  if (!ok)
+  {
+    // The broker has a partial packet it can never complete; start a fresh session
+    client.disconnect();
+    return false;
+  }
+  return client.endPublish();
+}
+
+bool SentientStreamWriter::publish(PubSubClient &client, const char *topic, const uint8_t *payload, size_t length,
+                                   bool retain, uint32_t stallUs)
+{
+  if (!client.beginPublish(topic, static_cast<unsigned int>(length), retain))
+  {
+    return false;
+  }
+
+  SentientStreamWriter writer(client, stallUs);
+  if (!writer.sendChunk(payload, length))
+  {
+    client.disconnect();
+    return false;
+  }
+  return client.endPublish();
+}
+
+size_t SentientStreamWriter::write(uint8_t value)
+{
+  return write(&value, 1);
+}
+
+size_t SentientStreamWriter::write(const uint8_t *buffer, size_t size)
+{
+  if (_failed)
+  {
+    return 0;
+  }
+
+  size_t accepted = 0;
+  while (accepted < size)
+  {
+    if (_used == sizeof(_chunk) && !finish())
+    {
+      break;
+    }
+    size_t take = sizeof(_chunk) - _used;
+    if (take > size - accepted)
+    {
+      take = size - accepted;
+    }
+    memcpy(_chunk + _used, buffer + accepted, take);
+    _used += take;
+    accepted += take;
+  }
+  return accepted;
+}
+
+bool SentientStreamWriter::finish()
+{
+  if (_used > 0 && !_failed)
+  {
+    _failed = !sendChunk(_chunk, _used);
+    _used = 0;
+  }
+  return !_failed;
+}
+
+bool SentientStreamWriter::sendChunk(const uint8_t *data, size_t length)
+{
+  // A short write means the TX buffer is full: wait for it to drain rather than drop bytes
+  unsigned long lastProgress = micros();
+  size_t sent = 0;
+  while (sent < length)
+  {
+    size_t take = length - sent;
+    if (take > SENTIENT_MQTT_STREAM_CHUNK_SIZE)
+    {
+      take = SENTIENT_MQTT_STREAM_CHUNK_SIZE;
+    }
+    const size_t count = _client.write(data + sent, take);
+    if (count > 0)
+    {
+      sent += count;
+      _written += count;
+      lastProgress = micros();
+      continue;
+    }
+    if (!_client.connected() || micros() - lastProgress >= _stallUs)
+    {
+      return false;
+    }
+    yield();
+  }
+  return true;
+}
@@ -0,0 +1,68 @@
+/*
+ * SentientStreamWriter - Chunked MQTT publish straight to the socket.
+ *
+ * PubSubClient::publish() copies the whole packet into its receive/transmit
+ * buffer, so that buffer has to be as large as the largest message ever sent.
+ * This writer instead opens the packet with beginPublish(), serializes into a
+ * small chunk buffer and hands the network client one chunk at a time. Short
+ * writes (the W5500 TX buffer is full) are retried until the socket drains or
+ * the stall budget runs out; SentientMQTT passes its own, much shorter budget
+ * so a full socket cannot hold up loop(). PubSubClient's own buffer then only
+ * needs to hold the topic and the largest inbound command.
+ */
+
+#ifndef SENTIENT_STREAM_WRITER_H
+#define SENTIENT_STREAM_WRITER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#ifndef MQTT_MAX_TRANSFER_SIZE
+#define MQTT_MAX_TRANSFER_SIZE 512 // Chunk large messages into 512-byte writes to prevent Ethernet buffer overflow
+#endif
+#include <PubSubClient.h>
+
+#ifndef SENTIENT_MQTT_STREAM_CHUNK_SIZE
+#define SENTIENT_MQTT_STREAM_CHUNK_SIZE MQTT_MAX_TRANSFER_SIZE
+#endif
+#ifndef SENTIENT_MQTT_STREAM_STALL_MS
+#define SENTIENT_MQTT_STREAM_STALL_MS 250 // Default: give up when the socket accepts nothing for this long
+#endif
+
+class SentientStreamWriter : public Print
+{
+public:
+  // Bytes PubSubClient::publish() needs in its buffer for this message (fixed header + topic + payload)
+  static size_t packetSize(const char *topic, size_t payloadLength);
+
+  static constexpr uint32_t DefaultStallUs = SENTIENT_MQTT_STREAM_STALL_MS * 1000UL;
+
+  static bool publish(PubSubClient &client, const char *topic, const JsonDocument &payload, bool retain = false,
+                      uint32_t stallUs = DefaultStallUs);
+  static bool publish(PubSubClient &client, const char *topic, const uint8_t *payload, size_t length,
+                      bool retain = false, uint32_t stallUs = DefaultStallUs);
+
+  // stallUs: how long one chunk may wait on a socket that accepts nothing before the publish fails
+  explicit SentientStreamWriter(PubSubClient &client, uint32_t stallUs = DefaultStallUs)
+      : _client(client), _stallUs(stallUs)
+  {
+  }
+
+  size_t write(uint8_t value) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+
+  // Sends whatever is still buffered. Returns false once any chunk failed to go out.
+  bool finish();
+  size_t written() const { return _written; }
+
+private:
+  bool sendChunk(const uint8_t *data, size_t length);
+
+  PubSubClient &_client;
+  uint32_t _stallUs;
+  uint8_t _chunk[SENTIENT_MQTT_STREAM_CHUNK_SIZE];
+  size_t _used = 0;
+  size_t _written = 0;
+  bool _failed = false;
+};
+
+#endif // SENTIENT_STREAM_WRITER_H
@@ -0,0 +1,142 @@
+#include "SentientTrace.h"
+
+#include <string.h>
+
+#if defined(ESP32)
+#include <esp_attr.h>
+#include <esp_system.h>
+#endif
+
+namespace
+{
+  constexpr uint32_t kMagic = 0x53545243; // Marks a ring that survived a reset
+  constexpr uint8_t kFormatVersion = 1;
+
+  void putU16(uint8_t *out, uint16_t value)
+  {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+  }
+
+  void putU32(uint8_t *out, uint32_t value)
+  {
+    putU16(out, static_cast<uint16_t>(value));
+    putU16(out + 2, static_cast<uint16_t>(value >> 16));
+  }
+
+  uint32_t resetReason()
+  {
+#if defined(__IMXRT1062__)
+    return SRC_SRSR;
+#elif defined(ESP32)
+    return static_cast<uint32_t>(esp_reset_reason());
+#else
+    return 0;
+#endif
+  }
+} // namespace
+
+// Left alone by the startup code, so a soft reset keeps the previous run's events
+#if defined(__IMXRT1062__)
+DMAMEM SentientTrace::State SentientTrace::s_state;
+#elif defined(ESP32)
+__NOINIT_ATTR SentientTrace::State SentientTrace::s_state;
+#else
+SentientTrace::State SentientTrace::s_state;
+#endif
+
+volatile bool SentientTrace::s_paused = false;
+uint32_t SentientTrace::s_dumpStart = 0;
+uint16_t SentientTrace::s_dumpEntries = 0;
+uint16_t SentientTrace::s_dumpSent = 0;
+uint16_t SentientTrace::s_dumpChunk = 0;
+bool SentientTrace::s_survived = false;
+
+void SentientTrace::begin()
+{
+  s_survived = s_state.magic == kMagic;
+  if (!s_survived)
+  {
+    memset(&s_state, 0, sizeof(s_state));
+    s_state.magic = kMagic;
+  }
+  ++s_state.boots;
+  s_paused = false;
+  record(Boot, s_survived ? 1 : 0, resetReason());
+  persist();
+}
+
+uint32_t SentientTrace::hash(const char *text)
+{
+  uint32_t value = 2166136261u;
+  while (text && *text)
+  {
+    value ^= static_cast<uint8_t>(*text++);
+    value *= 16777619u;
+  }
+  return value;
+}
+
+void SentientTrace::persist()
+{
+#if defined(__IMXRT1062__)
+  // OCRAM is write-back cached: anything still in the cache is lost on reset
+  arm_dcache_flush(&s_state, sizeof(s_state));
+#endif
+}
+
+uint16_t SentientTrace::beginDump()
+{
+  s_paused = true;
+  const uint32_t head = s_state.head;
+  const uint32_t available = head < SENTIENT_TRACE_ENTRIES ? head : SENTIENT_TRACE_ENTRIES;
+  s_dumpStart = head - available;
+  s_dumpEntries = static_cast<uint16_t>(available);
+  s_dumpSent = 0;
+  s_dumpChunk = 0;
+  return s_dumpEntries;
+}
+
+size_t SentientTrace::nextChunk(uint8_t *buffer, size_t capacity)
+{
+  if (!s_paused || capacity < kChunkCapacity)
+  {
+    return 0;
+  }
+  const uint16_t chunkCount = s_dumpEntries == 0 ? 1 : (s_dumpEntries + SENTIENT_TRACE_CHUNK_ENTRIES - 1) / SENTIENT_TRACE_CHUNK_ENTRIES;
+  if (s_dumpChunk >= chunkCount)
+  {
+    // Past the last chunk: record the dump itself and let recording continue
+    s_paused = false;
+    record(Dumped, s_dumpEntries, 0);
+    return 0;
+  }
+
+  uint16_t entries = s_dumpEntries - s_dumpSent;
+  if (entries > SENTIENT_TRACE_CHUNK_ENTRIES)
+  {
+    entries = SENTIENT_TRACE_CHUNK_ENTRIES;
+  }
+
+  memcpy(buffer, "STRC", 4);
+  buffer[4] = kFormatVersion;
+  buffer[5] = s_survived ? 1 : 0;
+  putU16(buffer + 6, s_dumpChunk);
+  putU16(buffer + 8, chunkCount);
+  putU16(buffer + 10, entries);
+  putU32(buffer + 12, s_state.boots);
+
+  uint8_t *out = buffer + kChunkHeaderSize;
+  for (uint16_t i = 0; i < entries; ++i, out += sizeof(Entry))
+  {
+    const Entry &entry = s_state.entries[(s_dumpStart + s_dumpSent + i) & kMask];
+    putU32(out, entry.timeUs);
+    out[4] = entry.event;
+    out[5] = 0;
+    putU16(out + 6, entry.a);
+    putU32(out + 8, entry.b);
+  }
+  s_dumpSent += entries;
+  ++s_dumpChunk;
+  return kChunkHeaderSize + entries * sizeof(Entry);
+}
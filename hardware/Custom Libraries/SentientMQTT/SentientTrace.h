@@ -0,0 +1,116 @@
+/*
+ * SentientTrace - Flight-recorder ring of timestamped controller events.
+ *
+ * record() writes one 12-byte entry (micros(), event, two arguments) into a
+ * fixed ring with an atomic index bump, so it is safe from interrupts and
+ * costs a few dozen cycles. SentientMQTT records command receipt/dispatch,
+ * publishes and connect/disconnect; sketches add sensor edges and motion:
+ *
+ *   SentientTrace::record(SentientTrace::SensorEdge, PIN_DOOR, digitalRead(PIN_DOOR));
+ *   SentientTrace::record(SentientTrace::MotionStart, motor, target);
+ *
+ * The ring lives in memory the startup code does not clear (DMAMEM on Teensy
+ * 4.x, .noinit on ESP32), so after a soft reset or watchdog the previous run's
+ * events are still there, followed by a Boot entry carrying the reset reason.
+ * On Teensy the ring sits behind the data cache; persist() writes it back and
+ * SentientMQTT::loop() calls it a few times a second.
+ *
+ * The "dump_trace" command streams the ring in binary chunks on
+ * trace/<controller>/<device>/dump; hardware/scripts/decode_trace.py turns
+ * them into a timeline. Names are recorded as FNV-1a hashes (hash()); the
+ * decoder maps them back given the command and topic names.
+ */
+
+#ifndef SENTIENT_TRACE_H
+#define SENTIENT_TRACE_H
+
+#include <Arduino.h>
+
+#ifndef SENTIENT_TRACE_ENTRIES
+#define SENTIENT_TRACE_ENTRIES 512 // Ring capacity; a power of two
+#endif
+#ifndef SENTIENT_TRACE_CHUNK_ENTRIES
+#define SENTIENT_TRACE_CHUNK_ENTRIES 32 // Entries per dump message
+#endif
+
+class SentientTrace
+{
+public:
+  enum Event : uint8_t
+  {
+    Boot = 1,          // a: 1 when the previous run's ring survived, b: platform reset reason
+    CommandReceived,   // a: payload length, b: hash(command)
+    CommandDispatched, // a: us from receipt to handler return (saturating), b: hash(command)
+    SensorEdge,        // a: pin or sensor id, b: new level/value
+    Publish,           // a: payload length (saturating), b: hash(topic)
+    PublishFailed,     // a: payload length (saturating), b: hash(topic)
+    Connect,           // a: failed attempts before this one
+    Disconnect,        // b: PubSubClient state
+    MotionStart,       // a: axis, b: target
+    MotionStop,        // a: axis, b: position
+    Mark,              // Sketch-defined
+    Dumped             // a: entries sent by a dump; recording was paused while it ran
+  };
+
+  struct Entry
+  {
+    uint32_t timeUs;
+    uint8_t event;
+    uint8_t reserved;
+    uint16_t a;
+    uint32_t b;
+  };
+  static_assert(sizeof(Entry) == 12, "dump format assumes 12-byte entries");
+
+  // Keeps a surviving ring (and records Boot), otherwise starts an empty one
+  static void begin();
+
+  static inline void record(Event event, uint16_t a = 0, uint32_t b = 0)
+  {
+    if (s_paused)
+    {
+      return;
+    }
+    Entry &entry = s_state.entries[__atomic_fetch_add(&s_state.head, 1, __ATOMIC_RELAXED) & kMask];
+    entry.timeUs = micros();
+    entry.event = event;
+    entry.a = a;
+    entry.b = b;
+  }
+
+  static uint32_t hash(const char *text);
+  static void persist();
+
+  // Dump: pauses recording, then hands out the ring oldest-first, one chunk per call
+  // into a buffer of at least kChunkCapacity; returns 0 (and resumes) once done
+  static uint16_t beginDump();
+  static size_t nextChunk(uint8_t *buffer, size_t capacity);
+  static bool dumping() { return s_paused; }
+
+  // Chunk: "STRC", version, flags (bit 0: ring survived a reset), chunk index, chunk count,
+  // entry count (uint16 each), boot count (uint32), then the entries; all little-endian
+  static constexpr size_t kChunkHeaderSize = 16;
+  static constexpr size_t kChunkCapacity = kChunkHeaderSize + SENTIENT_TRACE_CHUNK_ENTRIES * sizeof(Entry);
+
+private:
+  static constexpr uint32_t kMask = SENTIENT_TRACE_ENTRIES - 1;
+  static_assert((SENTIENT_TRACE_ENTRIES & kMask) == 0, "SENTIENT_TRACE_ENTRIES must be a power of two");
+
+  struct State
+  {
+    uint32_t magic;
+    uint32_t head; // Free-running write position
+    uint32_t boots;
+    Entry entries[SENTIENT_TRACE_ENTRIES];
+  };
+
+  static State s_state;
+  static volatile bool s_paused;
+  static uint32_t s_dumpStart;
+  static uint16_t s_dumpEntries;
+  static uint16_t s_dumpSent;
+  static uint16_t s_dumpChunk;
+  static bool s_survived;
+};
+
+#endif // SENTIENT_TRACE_H
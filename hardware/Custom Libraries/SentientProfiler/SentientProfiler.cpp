@@ -0,0 +1,77 @@
+#include "SentientProfiler.h"
+
+#include <string.h>
+
+SentientProfiler::Zone SentientProfiler::s_zones[SENTIENT_PROFILER_MAX_ZONES] = {};
+uint8_t SentientProfiler::s_zoneCount = 0;
+
+uint8_t SentientProfiler::registerZone(const char *name)
+{
+#if defined(__IMXRT1062__)
+  // The Teensy 4 core already runs the cycle counter for micros(); make sure regardless
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+#endif
+
+  // A zone macro in a header is instantiated once per translation unit; share one entry by name
+  for (uint8_t i = 0; i < s_zoneCount; ++i)
+  {
+    if (strcmp(s_zones[i].name, name) == 0)
+    {
+      return i;
+    }
+  }
+  if (s_zoneCount >= SENTIENT_PROFILER_MAX_ZONES)
+  {
+    return kNoZone;
+  }
+  s_zones[s_zoneCount].name = name;
+  return s_zoneCount++;
+}
+
+void SentientProfiler::record(uint8_t zone, uint32_t ticks)
+{
+  if (zone >= s_zoneCount)
+  {
+    return;
+  }
+
+  Zone &entry = s_zones[zone];
+  ++entry.count;
+  entry.totalTicks += ticks;
+  if (ticks > entry.maxTicks)
+  {
+    entry.maxTicks = ticks;
+  }
+
+  const uint32_t micros = ticks / ticksPerMicrosecond();
+  uint8_t bucket = micros == 0 ? 0 : static_cast<uint8_t>(32 - __builtin_clz(micros));
+  if (bucket >= kHistogramBuckets)
+  {
+    bucket = kHistogramBuckets - 1;
+  }
+  ++entry.histogram[bucket];
+}
+
+void SentientProfiler::reset()
+{
+  for (uint8_t i = 0; i < s_zoneCount; ++i)
+  {
+    Zone &entry = s_zones[i];
+    entry.count = 0;
+    entry.totalTicks = 0;
+    entry.maxTicks = 0;
+    memset(entry.histogram, 0, sizeof(entry.histogram));
+  }
+}
+
+uint32_t SentientProfiler::ticksPerMicrosecond()
+{
+#if defined(__IMXRT1062__)
+  return F_CPU_ACTUAL / 1'000'000;
+#elif defined(ESP32)
+  return getCpuFrequencyMhz();
+#else
+  return 1'000; // std::chrono nanoseconds
+#endif
+}
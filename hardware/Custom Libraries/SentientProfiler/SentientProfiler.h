@@ -0,0 +1,116 @@
+/*
+ * SentientProfiler - Scoped timing zones for Sentient controller sketches.
+ *
+ *   void runSteppers()
+ *   {
+ *     SENTIENT_PROFILE_ZONE("runSteppers");
+ *     ...
+ *   }
+ *
+ * Each zone times its enclosing scope with the Cortex-M7 DWT cycle counter
+ * (the Xtensa cycle counter on ESP32, std::chrono on a host build) and keeps
+ * count, total, max and a log2 histogram of microseconds in a fixed table of
+ * SENTIENT_PROFILER_MAX_ZONES entries. Zones nest; each reports inclusive time.
+ * Zones are not interrupt-safe: use them from loop() context only.
+ *
+ * Profiling is off unless SENTIENT_PROFILING is defined to 1 before this header
+ * is included. When off, the macros expand to nothing and cost nothing.
+ * See SentientProfilerReporter.h for publishing the table over SentientMQTT.
+ */
+
+#ifndef SENTIENT_PROFILER_H
+#define SENTIENT_PROFILER_H
+
+#ifndef SENTIENT_PROFILING
+#define SENTIENT_PROFILING 0
+#endif
+#ifndef SENTIENT_PROFILER_MAX_ZONES
+#define SENTIENT_PROFILER_MAX_ZONES 16
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(ARDUINO)
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+class SentientProfiler
+{
+public:
+  static constexpr uint8_t kNoZone = 0xFF;
+  static constexpr uint8_t kHistogramBuckets = 16; // Bucket 0: under 1 us; bucket n: [2^(n-1), 2^n) us; last is open
+
+  struct Zone
+  {
+    const char *name;
+    uint32_t count;
+    uint64_t totalTicks;
+    uint32_t maxTicks;
+    uint32_t histogram[kHistogramBuckets];
+  };
+
+  // Returns the zone's index, or kNoZone once the table is full (the zone is then ignored)
+  static uint8_t registerZone(const char *name);
+  static void record(uint8_t zone, uint32_t ticks);
+  static void reset();
+
+  static uint8_t zoneCount() { return s_zoneCount; }
+  static const Zone &zone(uint8_t index) { return s_zones[index]; }
+  static uint32_t ticksPerMicrosecond();
+  static uint32_t toMicros(uint64_t ticks) { return static_cast<uint32_t>(ticks / ticksPerMicrosecond()); }
+
+  static inline uint32_t now()
+  {
+#if defined(__IMXRT1062__)
+    return ARM_DWT_CYCCNT;
+#elif defined(ESP32)
+    return ESP.getCycleCount();
+#else
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+#endif
+  }
+
+private:
+  static Zone s_zones[SENTIENT_PROFILER_MAX_ZONES];
+  static uint8_t s_zoneCount;
+};
+
+class SentientProfileScope
+{
+public:
+  explicit SentientProfileScope(uint8_t zone) : _zone(zone), _start(SentientProfiler::now()) {}
+  ~SentientProfileScope() { SentientProfiler::record(_zone, SentientProfiler::now() - _start); }
+
+  SentientProfileScope(const SentientProfileScope &) = delete;
+  SentientProfileScope &operator=(const SentientProfileScope &) = delete;
+
+private:
+  uint8_t _zone;
+  uint32_t _start;
+};
+
+#if SENTIENT_PROFILING
+#define SENTIENT_PROFILE_CONCAT_(a, b) a##b
+#define SENTIENT_PROFILE_CONCAT(a, b) SENTIENT_PROFILE_CONCAT_(a, b)
+// The zone registers once, on first entry; afterwards entering it is two counter reads
+#define SENTIENT_PROFILE_ZONE(name)                                                                          \
+  static const uint8_t SENTIENT_PROFILE_CONCAT(sentientZone_, __LINE__) = SentientProfiler::registerZone(name); \
+  SentientProfileScope SENTIENT_PROFILE_CONCAT(sentientScope_, __LINE__)(SENTIENT_PROFILE_CONCAT(sentientZone_, __LINE__))
+#define SENTIENT_PROFILE_FUNCTION() SENTIENT_PROFILE_ZONE(__func__)
+#else
+#define SENTIENT_PROFILE_ZONE(name) \
+  do                                \
+  {                                 \
+  } while (0)
+#define SENTIENT_PROFILE_FUNCTION() \
+  do                                \
+  {                                 \
+  } while (0)
+#endif
+
+#endif // SENTIENT_PROFILER_H
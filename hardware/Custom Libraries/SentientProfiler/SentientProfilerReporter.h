@@ -0,0 +1,135 @@
+/*
+ * SentientProfilerReporter - Publishes the SentientProfiler zone table on the
+ * SentientMQTT metrics category (<namespace>/<room>/metrics/<controller>/<device>/profile).
+ *
+ *   SentientProfilerReporter profiler(sentient, 10'000);
+ *   loop():    profiler.loop();
+ *   commands:  if (profiler.handleCommand(command)) return;
+ *
+ * Each report covers the interval since the previous one unless
+ * resetAfterPublish is cleared. The "profile_dump" command publishes at once
+ * and prints the table to Serial; "profile_reset" clears it. Header-only so
+ * the profiler itself does not depend on SentientMQTT. Without
+ * SENTIENT_PROFILING every member is an empty inline.
+ */
+
+#ifndef SENTIENT_PROFILER_REPORTER_H
+#define SENTIENT_PROFILER_REPORTER_H
+
+#include <SentientMQTT.h>
+
+#include "SentientProfiler.h"
+
+#ifndef SENTIENT_PROFILER_REPORT_ARENA_SIZE
+#define SENTIENT_PROFILER_REPORT_ARENA_SIZE 4096 // Backs the report document
+#endif
+
+class SentientProfilerReporter
+{
+public:
+  explicit SentientProfilerReporter(SentientMQTT &mqtt, uint32_t intervalMs = 10'000)
+      : _mqtt(mqtt), _intervalMs(intervalMs) {}
+
+  bool resetAfterPublish = true;
+
+#if SENTIENT_PROFILING
+  void loop()
+  {
+    const unsigned long now = millis();
+    if (_intervalMs == 0 || now - _lastPublish < _intervalMs)
+    {
+      return;
+    }
+    _lastPublish = now;
+    publish();
+  }
+
+  bool handleCommand(const char *command)
+  {
+    if (strcmp(command, "profile_dump") == 0)
+    {
+      dump(Serial);
+      publish();
+      return true;
+    }
+    if (strcmp(command, "profile_reset") == 0)
+    {
+      SentientProfiler::reset();
+      return true;
+    }
+    return false;
+  }
+
+  bool publish()
+  {
+    _doc.clear();
+    _doc["timestamp"] = millis() / 1000;
+    _doc["windowMs"] = millis() - _windowStart;
+    JsonArray zones = _doc["zones"].to<JsonArray>();
+    for (uint8_t i = 0; i < SentientProfiler::zoneCount(); ++i)
+    {
+      const SentientProfiler::Zone &zone = SentientProfiler::zone(i);
+      JsonObject entry = zones.add<JsonObject>();
+      entry["name"] = zone.name;
+      entry["count"] = zone.count;
+      entry["totalUs"] = SentientProfiler::toMicros(zone.totalTicks);
+      entry["maxUs"] = SentientProfiler::toMicros(zone.maxTicks);
+      entry["meanUs"] = zone.count ? SentientProfiler::toMicros(zone.totalTicks / zone.count) : 0;
+
+      // Trailing empty buckets are implied
+      uint8_t used = SentientProfiler::kHistogramBuckets;
+      while (used > 0 && zone.histogram[used - 1] == 0)
+      {
+        --used;
+      }
+      JsonArray histogram = entry["histogram"].to<JsonArray>();
+      for (uint8_t b = 0; b < used; ++b)
+      {
+        histogram.add(zone.histogram[b]);
+      }
+    }
+
+    const bool ok = _mqtt.publishJson("metrics", "profile", _doc);
+    _doc.clear();
+    if (resetAfterPublish)
+    {
+      SentientProfiler::reset();
+      _windowStart = millis();
+    }
+    return ok;
+  }
+
+  void dump(Print &out) const
+  {
+    out.println(F("[Profiler] zone                 count    total_us   mean_us    max_us"));
+    for (uint8_t i = 0; i < SentientProfiler::zoneCount(); ++i)
+    {
+      const SentientProfiler::Zone &zone = SentientProfiler::zone(i);
+      char line[96];
+      snprintf(line, sizeof(line), "[Profiler] %-20.20s %8lu %11lu %9lu %9lu", zone.name,
+               static_cast<unsigned long>(zone.count),
+               static_cast<unsigned long>(SentientProfiler::toMicros(zone.totalTicks)),
+               static_cast<unsigned long>(zone.count ? SentientProfiler::toMicros(zone.totalTicks / zone.count) : 0),
+               static_cast<unsigned long>(SentientProfiler::toMicros(zone.maxTicks)));
+      out.println(line);
+    }
+  }
+#else
+  void loop() {}
+  bool handleCommand(const char *) { return false; }
+  bool publish() { return false; }
+  void dump(Print &) const {}
+#endif
+
+private:
+  SentientMQTT &_mqtt;
+  uint32_t _intervalMs;
+#if SENTIENT_PROFILING
+  unsigned long _lastPublish = 0;
+  unsigned long _windowStart = 0;
+  SentientJsonArena<SENTIENT_PROFILER_REPORT_ARENA_SIZE> _arena;
+  JsonDocument _doc{&_arena};
+#endif
+};
+
+#endif // SENTIENT_PROFILER_REPORTER_H
@@ -0,0 +1,63 @@
+/**
+ * LoopZones - Profiling a controller loop with SentientProfiler
+ *
+ * Set SENTIENT_PROFILING to 0 (or remove the define) and every zone and
+ * reporter call compiles away.
+ */
+
+#define SENTIENT_PROFILING 1
+
+#include <SentientMQTT.h>
+#include <SentientProfiler.h>
+#include <SentientProfilerReporter.h>
+
+SentientMQTTConfig makeConfig()
+{
+  SentientMQTTConfig cfg;
+  cfg.brokerHost = "192.168.20.3";
+  cfg.namespaceId = "paragon";
+  cfg.roomId = "Clockwork";
+  cfg.puzzleId = "ProfilerDemo";
+  cfg.deviceId = "ProfilerDemo";
+  return cfg;
+}
+
+SentientMQTT sentient(makeConfig());
+SentientProfilerReporter profiler(sentient, 10'000); // Publish metrics/profile every 10 s
+
+void runSteppers()
+{
+  SENTIENT_PROFILE_FUNCTION();
+  delayMicroseconds(40);
+}
+
+void renderLeds()
+{
+  SENTIENT_PROFILE_ZONE("FastLED.show");
+  delayMicroseconds(900);
+}
+
+void handleCommand(const char *command, const JsonDocument &payload, void * /*ctx*/)
+{
+  // profile_dump / profile_reset
+  if (profiler.handleCommand(command))
+  {
+    return;
+  }
+}
+
+void setup()
+{
+  Serial.begin(115200);
+  sentient.begin();
+  sentient.setCommandCallback(handleCommand);
+}
+
+void loop()
+{
+  SENTIENT_PROFILE_ZONE("loop");
+  sentient.loop();
+  runSteppers();
+  renderLeds();
+  profiler.loop();
+}
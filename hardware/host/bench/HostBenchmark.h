@@ -0,0 +1,256 @@
+/*
+ * HostBenchmark - the subset of Google Benchmark's API the host benchmarks use.
+ *
+ *   static void BM_PublishSensor(benchmark::State &state)
+ *   {
+ *     for (auto _ : state) { ... }
+ *   }
+ *   BENCHMARK(BM_PublishSensor);
+ *   BENCHMARK(BM_Registration)->Arg(4)->Arg(16);
+ *   BENCHMARK_MAIN();
+ *
+ * Configure with -DSENTIENT_HOST_GOOGLE_BENCHMARK=ON to build the same files
+ * against the real library instead. Iterations grow until a run lasts
+ * --benchmark_min_time seconds (default 0.2); times are wall clock, unaffected
+ * by the virtual HostClock the libraries see.
+ */
+
+#ifndef SENTIENT_HOST_BENCHMARK_H
+#define SENTIENT_HOST_BENCHMARK_H
+
+#if defined(SENTIENT_HOST_USE_GOOGLE_BENCHMARK)
+#include <benchmark/benchmark.h>
+#else
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace benchmark
+{
+  template <typename T>
+  inline void DoNotOptimize(T const &value)
+  {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  inline void ClobberMemory()
+  {
+    asm volatile("" : : : "memory");
+  }
+
+  class State
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    State(int64_t maxIterations, const std::vector<int64_t> &args) : _maxIterations(maxIterations), _args(args) {}
+
+    struct Iterator
+    {
+      State *state;
+      int64_t remaining;
+      bool operator!=(const Iterator &) const
+      {
+        if (remaining > 0)
+        {
+          return true;
+        }
+        state->finish();
+        return false;
+      }
+      void operator++() { --remaining; }
+      // Like Google Benchmark's, so `for (auto _ : state)` does not trip -Wunused-variable
+      struct __attribute__((unused)) Value
+      {
+      };
+      Value operator*() const { return {}; }
+    };
+
+    Iterator begin()
+    {
+      start();
+      return {this, _maxIterations};
+    }
+    Iterator end() { return {this, 0}; }
+
+    bool KeepRunning()
+    {
+      if (!_started)
+      {
+        start();
+      }
+      if (_completed < _maxIterations)
+      {
+        ++_completed;
+        return true;
+      }
+      finish();
+      return false;
+    }
+
+    void PauseTiming() { _elapsed += Clock::now() - _resumed; }
+    void ResumeTiming() { _resumed = Clock::now(); }
+
+    int64_t iterations() const { return _maxIterations; }
+    int64_t range(size_t index = 0) const { return index < _args.size() ? _args[index] : 0; }
+    void SetItemsProcessed(int64_t items) { _items = items; }
+    void SetBytesProcessed(int64_t bytes) { _bytes = bytes; }
+    void SetLabel(const std::string &label) { _label = label; }
+
+    double seconds() const { return std::chrono::duration<double>(_elapsed).count(); }
+    int64_t items() const { return _items; }
+    int64_t bytes() const { return _bytes; }
+    const std::string &label() const { return _label; }
+
+  private:
+    void start()
+    {
+      _started = true;
+      _resumed = Clock::now();
+    }
+    void finish()
+    {
+      if (!_finished)
+      {
+        _finished = true;
+        _elapsed += Clock::now() - _resumed;
+      }
+    }
+
+    int64_t _maxIterations;
+    int64_t _completed = 0;
+    std::vector<int64_t> _args;
+    bool _started = false;
+    bool _finished = false;
+    Clock::time_point _resumed;
+    Clock::duration _elapsed{0};
+    int64_t _items = 0;
+    int64_t _bytes = 0;
+    std::string _label;
+  };
+
+  namespace internal
+  {
+    using Function = void (*)(State &);
+
+    class Benchmark
+    {
+    public:
+      Benchmark(const char *name, Function function) : _name(name), _function(function) {}
+
+      Benchmark *Arg(int64_t value)
+      {
+        _args.push_back(value);
+        return this;
+      }
+
+      void run(const char *filter, double minSeconds) const
+      {
+        if (_args.empty())
+        {
+          runOne(_name, {}, filter, minSeconds);
+        }
+        for (int64_t arg : _args)
+        {
+          runOne(_name + "/" + std::to_string(arg), {arg}, filter, minSeconds);
+        }
+      }
+
+    private:
+      void runOne(const std::string &name, const std::vector<int64_t> &args, const char *filter,
+                  double minSeconds) const
+      {
+        if (filter && !strstr(name.c_str(), filter))
+        {
+          return;
+        }
+        for (int64_t iterations = 1;; iterations *= 10)
+        {
+          State state(iterations, args);
+          _function(state);
+          if (state.seconds() < minSeconds && iterations < 1'000'000'000)
+          {
+            continue;
+          }
+          const double nsPerIteration = state.seconds() * 1e9 / static_cast<double>(iterations);
+          printf("%-40s %12.1f ns %12lld", name.c_str(), nsPerIteration, static_cast<long long>(iterations));
+          if (state.items() > 0)
+          {
+            printf("  items_per_second=%.4gk/s", static_cast<double>(state.items()) / state.seconds() / 1e3);
+          }
+          if (state.bytes() > 0)
+          {
+            printf("  bytes_per_second=%.4gMi/s", static_cast<double>(state.bytes()) / state.seconds() / 1048576.0);
+          }
+          if (!state.label().empty())
+          {
+            printf("  %s", state.label().c_str());
+          }
+          printf("\n");
+          fflush(stdout);
+          return;
+        }
+      }
+
+      std::string _name;
+      Function _function;
+      std::vector<int64_t> _args;
+    };
+
+    inline std::vector<Benchmark *> &registry()
+    {
+      static std::vector<Benchmark *> benchmarks;
+      return benchmarks;
+    }
+
+    inline Benchmark *Register(const char *name, Function function)
+    {
+      registry().push_back(new Benchmark(name, function));
+      return registry().back();
+    }
+
+    inline int RunAll(int argc, char **argv)
+    {
+      const char *filter = nullptr;
+      double minSeconds = 0.2;
+      for (int i = 1; i < argc; ++i)
+      {
+        if (strncmp(argv[i], "--benchmark_filter=", 19) == 0)
+        {
+          filter = argv[i] + 19;
+        }
+        else if (strncmp(argv[i], "--benchmark_min_time=", 21) == 0)
+        {
+          minSeconds = atof(argv[i] + 21);
+        }
+      }
+      printf("%-40s %15s %12s\n", "Benchmark", "Time", "Iterations");
+      for (const Benchmark *benchmark : registry())
+      {
+        benchmark->run(filter, minSeconds);
+      }
+      return 0;
+    }
+  } // namespace internal
+} // namespace benchmark
+
+#define SENTIENT_BENCHMARK_CONCAT_(a, b) a##b
+#define SENTIENT_BENCHMARK_CONCAT(a, b) SENTIENT_BENCHMARK_CONCAT_(a, b)
+#define BENCHMARK(function) \
+  static ::benchmark::internal::Benchmark *SENTIENT_BENCHMARK_CONCAT(sentient_benchmark_, __LINE__) = \
+      ::benchmark::internal::Register(#function, function)
+#define BENCHMARK_MAIN() \
+  int main(int argc, char **argv) \
+  { \
+    return ::benchmark::internal::RunAll(argc, argv); \
+  } \
+  static_assert(true, "")
+
+#endif // SENTIENT_HOST_USE_GOOGLE_BENCHMARK
+#endif // SENTIENT_HOST_BENCHMARK_H
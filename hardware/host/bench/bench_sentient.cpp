@@ -0,0 +1,348 @@
+// Micro-benchmarks for the publish, command-dispatch, manifest and registration paths
+
+#include <SentientCommandRouter.h>
+#include <SentientDeviceRegistry.h>
+
+#include "ControllerFixture.h"
+#include "HostBenchmark.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+  // Quiet, non-recording broker: benchmarks measure the controller side
+  void prepare(ControllerFixture &fixture)
+  {
+    Serial.setEcho(false);
+    fixture.broker.setRecording(false);
+    fixture.config.autoHeartbeat = false;
+    fixture.config.timeSyncIntervalMs = 0;
+    fixture.config.metricsIntervalMs = 0;
+    if (!fixture.start())
+    {
+      fprintf(stderr, "controller failed to connect to the fake broker\n");
+      abort();
+    }
+  }
+
+  // Devices with three commands and two sensors each, named like the sketches' slugs
+  struct DeviceSet
+  {
+    explicit DeviceSet(int count)
+    {
+      names.reserve(static_cast<size_t>(count) * 6);
+      for (int i = 0; i < count; ++i)
+      {
+        const std::string id = "device_" + std::to_string(i);
+        names.push_back(id);
+        for (const char *suffix : {"_on", "_off", "_pulse", "_state", "_level"})
+        {
+          names.push_back(id + suffix);
+        }
+      }
+      for (int i = 0; i < count; ++i)
+      {
+        const char **slugs = &pointers[i * 5];
+        for (int j = 0; j < 5; ++j)
+        {
+          slugs[j] = names[i * 6 + 1 + j].c_str();
+        }
+        devices.emplace_back(names[i * 6].c_str(), names[i * 6].c_str(), "relay", slugs, 3, slugs + 3, 2);
+      }
+      for (SentientDeviceDef &device : devices)
+      {
+        registry.addDevice(&device);
+      }
+    }
+
+    std::vector<std::string> names;
+    const char *pointers[64 * 5] = {};
+    std::vector<SentientDeviceDef> devices;
+    SentientDeviceRegistry registry{64};
+  };
+
+  // Heap allocations per iteration since `before`: the host's operator new and any JsonDocument on
+  // SentientCountingAllocator feed SentientMemoryStats, and so does a JSON arena that overflows
+  void labelAllocations(benchmark::State &state, uint32_t before)
+  {
+    const uint32_t allocations = SentientMemoryStats::sample().allocations - before;
+    char label[40];
+    snprintf(label, sizeof(label), "allocs/publish=%.2f",
+             static_cast<double>(allocations) / static_cast<double>(state.iterations()));
+    state.SetLabel(label);
+  }
+
+  void fillReading(JsonDocument &doc)
+  {
+    doc["value"] = 21.5f;
+    doc["units"] = "C";
+    doc["timestamp"] = 1234;
+  }
+
+  void onCommand(const char *, const JsonDocument &payload, void *context)
+  {
+    *static_cast<int *>(context) += payload["level"] | 0;
+  }
+
+  void routeHandler(const JsonDocument &payload, void *context)
+  {
+    *static_cast<int *>(context) += payload["level"] | 0;
+  }
+
+  // A controller's worth of commands, for the router and the chains it replaces
+  constexpr SentientCommandRoute kRoutes[] = {
+      {"light_on", routeHandler},     {"light_off", routeHandler},  {"door_open", routeHandler},
+      {"door_close", routeHandler},   {"fog_on", routeHandler},     {"fog_off", routeHandler},
+      {"audio_play", routeHandler},   {"audio_stop", routeHandler}, {"reset", routeHandler},
+      {"solve", routeHandler},        {"hint_1", routeHandler},     {"hint_2", routeHandler},
+      {"motor_home", routeHandler},   {"motor_move", routeHandler}, {"led_pattern", routeHandler},
+      {"maglock_release", routeHandler},
+  };
+  // Read through volatile so the compiler cannot fold the chain's comparisons away
+  const char *volatile kChainCommand = "led_pattern";
+} // namespace
+
+static void BM_PublishSensor(benchmark::State &state)
+{
+  ControllerFixture fixture;
+  prepare(fixture);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(fixture.mqtt->publishSensor("temperature", 21.5f, "C"));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PublishSensor);
+
+static void BM_PublishState(benchmark::State &state)
+{
+  ControllerFixture fixture;
+  prepare(fixture);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(fixture.mqtt->publishState("running"));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PublishState);
+
+// A payload larger than the client buffer goes through SentientStreamWriter
+static void BM_PublishStreamed(benchmark::State &state)
+{
+  ControllerFixture fixture;
+  prepare(fixture);
+  JsonDocument doc;
+  const std::string filler(static_cast<size_t>(state.range(0)), 'x');
+  doc["blob"] = filler.c_str();
+  const size_t bytes = measureJson(doc);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(fixture.mqtt->publishJson("diagnostics", "blob", doc));
+  }
+  state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_PublishStreamed)->Arg(1024)->Arg(4096);
+
+// Baseline for BM_PublishJson: the sketch-side document published the way the library used to,
+// with a String topic, a heap document and a String payload per message
+static void BM_PublishJsonStringPath(benchmark::State &state)
+{
+  ControllerFixture fixture;
+  prepare(fixture);
+  PubSubClient &client = fixture.mqtt->get_client();
+  JsonDocument reading;
+  fillReading(reading);
+  const uint32_t before = SentientMemoryStats::sample().allocations;
+  for (auto _ : state)
+  {
+    JsonDocument doc(&SentientCountingAllocator::instance());
+    doc.set(reading);
+    String topic = String(ControllerFixture::kTopicRoot) + "/sensors/" + "ctrl" + "/" + "dev" + "/" + "temperature";
+    String payload;
+    serializeJson(doc, payload);
+    benchmark::DoNotOptimize(client.publish(topic.c_str(), payload.c_str()));
+  }
+  labelAllocations(state, before);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PublishJsonStringPath);
+
+static void BM_PublishJson(benchmark::State &state)
+{
+  ControllerFixture fixture;
+  prepare(fixture);
+  JsonDocument reading;
+  fillReading(reading);
+  const uint32_t before = SentientMemoryStats::sample().allocations;
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(fixture.mqtt->publishJson("sensors", "temperature", reading));
+  }
+  labelAllocations(state, before);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PublishJson);
+
+// Broker delivery, PubSubClient parse, topic split, JSON parse and callback
+static void BM_CommandDispatch(benchmark::State &state)
+{
+  ControllerFixture fixture;
+  prepare(fixture);
+  int total = 0;
+  fixture.mqtt->setCommandCallback(onCommand, &total);
+  for (auto _ : state)
+  {
+    fixture.sendCommand("device_3_on", "{\"level\":1}");
+    fixture.mqtt->loop();
+  }
+  benchmark::DoNotOptimize(total);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CommandDispatch);
+
+static void BM_LoopIdle(benchmark::State &state)
+{
+  ControllerFixture fixture;
+  prepare(fixture);
+  for (auto _ : state)
+  {
+    fixture.mqtt->loop();
+  }
+}
+BENCHMARK(BM_LoopIdle);
+
+static void BM_RouterDispatch(benchmark::State &state)
+{
+  static constexpr auto router = makeSentientCommandRouter(kRoutes);
+  JsonDocument payload;
+  payload["level"] = 1;
+  int total = 0;
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(router.dispatch("led_pattern", payload, &total));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RouterDispatch);
+
+// The chains the router replaces, over the same table: gauge_6_leds_v2 compared a String copy of the
+// command with equals(); other sketches call strcmp() directly. "led_pattern" is 15th of 16 in both.
+static void BM_StrcmpChainDispatch(benchmark::State &state)
+{
+  JsonDocument payload;
+  payload["level"] = 1;
+  int total = 0;
+  for (auto _ : state)
+  {
+    const char *command = kChainCommand;
+    for (const SentientCommandRoute &route : kRoutes)
+    {
+      if (strcmp(command, route.command) == 0)
+      {
+        route.handler(payload, &total);
+        break;
+      }
+    }
+  }
+  benchmark::DoNotOptimize(total);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StrcmpChainDispatch);
+
+static void BM_StringChainDispatch(benchmark::State &state)
+{
+  JsonDocument payload;
+  payload["level"] = 1;
+  int total = 0;
+  for (auto _ : state)
+  {
+    const char *command = kChainCommand;
+    String cmd = String(command);
+    for (const SentientCommandRoute &route : kRoutes)
+    {
+      if (cmd.equals(route.command))
+      {
+        route.handler(payload, &total);
+        break;
+      }
+    }
+  }
+  benchmark::DoNotOptimize(total);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_StringChainDispatch);
+
+static void BM_ManifestBuild(benchmark::State &state)
+{
+  Serial.setEcho(false);
+  DeviceSet set(static_cast<int>(state.range(0)));
+  for (auto _ : state)
+  {
+    SentientCapabilityManifest manifest;
+    manifest.set_controller_info("ctrl", "Host Controller", "1.0.0", "room1", "ctrl");
+    set.registry.buildManifest(manifest);
+    benchmark::DoNotOptimize(manifest.getManifest());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ManifestBuild)->Arg(4)->Arg(16);
+
+static void BM_Registration(benchmark::State &state)
+{
+  ControllerFixture fixture;
+  prepare(fixture);
+  DeviceSet set(static_cast<int>(state.range(0)));
+  SentientCapabilityManifest manifest;
+  manifest.set_controller_info("ctrl", "Host Controller", "1.0.0", "room1", "ctrl");
+  set.registry.buildManifest(manifest);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(manifest.publish_registration(fixture.mqtt->get_client(), "room-uuid"));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Registration)->Arg(4)->Arg(16)->Arg(50);
+
+// Device records alone, without the broker, the way SentientMQTT sends them: one pass, and
+// recordLength() before each writeRecord()
+static void BM_DeviceRecords(benchmark::State &state)
+{
+  struct NullPrint : Print
+  {
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t *, size_t size) override { return size; }
+  } out;
+  DeviceSet set(static_cast<int>(state.range(0)));
+  SentientCapabilityManifest manifest;
+  manifest.set_controller_info("ctrl", "Host Controller", "1.0.0", "room1", "ctrl");
+  set.registry.buildManifest(manifest);
+  const size_t records = manifest.recordCount();
+  for (auto _ : state)
+  {
+    manifest.beginRecords();
+    for (size_t index = 1; index < records; ++index)
+    {
+      benchmark::DoNotOptimize(manifest.recordLength(index));
+      manifest.writeRecord(index, out);
+    }
+    manifest.endRecords();
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DeviceRecords)->Arg(16)->Arg(50);
+
+static void BM_FindDevice(benchmark::State &state)
+{
+  DeviceSet set(static_cast<int>(state.range(0)));
+  const std::string last = "device_" + std::to_string(state.range(0) - 1);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(set.registry.findDevice(last.c_str()));
+    benchmark::DoNotOptimize(set.registry.isValidCommand("no_such_command"));
+  }
+}
+BENCHMARK(BM_FindDevice)->Arg(4)->Arg(32)->Arg(64);
+
+BENCHMARK_MAIN();
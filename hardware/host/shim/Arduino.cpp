@@ -0,0 +1,404 @@
+#include "Arduino.h"
+
+#include <chrono>
+#include <thread>
+
+namespace
+{
+  bool s_virtualTime = false;
+  uint64_t s_virtualMicros = 0;
+  const std::chrono::steady_clock::time_point s_start = std::chrono::steady_clock::now();
+  uint32_t s_randomState = 1;
+  int s_pins[64] = {0};
+} // namespace
+
+HostSerial Serial;
+
+void HostClock::useVirtualTime(bool enabled)
+{
+  if (enabled && !s_virtualTime)
+  {
+    s_virtualMicros = nowMicros();
+  }
+  s_virtualTime = enabled;
+}
+
+bool HostClock::virtualTime()
+{
+  return s_virtualTime;
+}
+
+void HostClock::advance(uint64_t microseconds)
+{
+  s_virtualMicros += microseconds;
+}
+
+uint64_t HostClock::nowMicros()
+{
+  if (s_virtualTime)
+  {
+    return s_virtualMicros;
+  }
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s_start).count());
+}
+
+// Truncated to 32 bits like the targets, so wrap-around handling is exercised too
+unsigned long millis()
+{
+  return static_cast<uint32_t>(HostClock::nowMicros() / 1000);
+}
+
+unsigned long micros()
+{
+  return static_cast<uint32_t>(HostClock::nowMicros());
+}
+
+void delay(unsigned long ms)
+{
+  delayMicroseconds(static_cast<unsigned int>(ms * 1000));
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  if (s_virtualTime)
+  {
+    s_virtualMicros += us;
+    return;
+  }
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield()
+{
+  // Lets a spinning sendChunk() reach its stall timeout under virtual time
+  if (s_virtualTime)
+  {
+    s_virtualMicros += 1;
+  }
+}
+
+void pinMode(uint8_t, uint8_t)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  s_pins[pin % 64] = value;
+}
+
+int digitalRead(uint8_t pin)
+{
+  return s_pins[pin % 64];
+}
+
+int analogRead(uint8_t)
+{
+  return 0;
+}
+
+long random(long max)
+{
+  return max > 0 ? random(0, max) : 0;
+}
+
+long random(long min, long max)
+{
+  if (max <= min)
+  {
+    return min;
+  }
+  // xorshift32: deterministic across platforms for repeatable tests
+  s_randomState ^= s_randomState << 13;
+  s_randomState ^= s_randomState >> 17;
+  s_randomState ^= s_randomState << 5;
+  return min + static_cast<long>(s_randomState % static_cast<uint32_t>(max - min));
+}
+
+void randomSeed(unsigned long seed)
+{
+  s_randomState = seed ? static_cast<uint32_t>(seed) : 1;
+}
+
+size_t HostSerial::write(uint8_t value)
+{
+  return write(&value, 1);
+}
+
+size_t HostSerial::write(const uint8_t *buffer, size_t size)
+{
+  if (_echo)
+  {
+    fwrite(buffer, 1, size, stdout);
+  }
+  return size;
+}
+
+void HostSerial::flush()
+{
+  fflush(stdout);
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t count = 0;
+  while (count < size && write(buffer[count]))
+  {
+    ++count;
+  }
+  return count;
+}
+
+size_t Print::print(const __FlashStringHelper *text)
+{
+  return print(reinterpret_cast<const char *>(text));
+}
+
+size_t Print::print(const String &text)
+{
+  return write(text.c_str(), text.length());
+}
+
+size_t Print::print(const char *text)
+{
+  return write(text);
+}
+
+size_t Print::print(char value)
+{
+  return write(static_cast<uint8_t>(value));
+}
+
+size_t Print::print(unsigned char value, int base)
+{
+  return printNumber(value, base, false);
+}
+
+size_t Print::print(int value, int base)
+{
+  return print(static_cast<long long>(value), base);
+}
+
+size_t Print::print(unsigned int value, int base)
+{
+  return printNumber(value, base, false);
+}
+
+size_t Print::print(long value, int base)
+{
+  return print(static_cast<long long>(value), base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+  return printNumber(value, base, false);
+}
+
+size_t Print::print(long long value, int base)
+{
+  if (base == DEC && value < 0)
+  {
+    return printNumber(static_cast<unsigned long long>(-(value + 1)) + 1, base, true);
+  }
+  return printNumber(static_cast<unsigned long long>(value), base, false);
+}
+
+size_t Print::print(unsigned long long value, int base)
+{
+  return printNumber(value, base, false);
+}
+
+size_t Print::print(double value, int digits)
+{
+  char text[48];
+  const int length = snprintf(text, sizeof(text), "%.*f", digits, value);
+  return length > 0 ? write(text, static_cast<size_t>(length)) : 0;
+}
+
+size_t Print::print(const Printable &value)
+{
+  return value.printTo(*this);
+}
+
+size_t Print::println()
+{
+  return write("\r\n", 2);
+}
+
+size_t Print::printf(const char *format, ...)
+{
+  char text[256];
+  va_list args;
+  va_start(args, format);
+  const int length = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  if (length <= 0)
+  {
+    return 0;
+  }
+  return write(text, static_cast<size_t>(length) < sizeof(text) ? static_cast<size_t>(length) : sizeof(text) - 1);
+}
+
+size_t Print::printNumber(unsigned long long value, int base, bool negative)
+{
+  if (base < 2)
+  {
+    base = DEC;
+  }
+  char text[68];
+  char *cursor = text + sizeof(text);
+  do
+  {
+    const unsigned digit = static_cast<unsigned>(value % static_cast<unsigned>(base));
+    *--cursor = static_cast<char>(digit < 10 ? '0' + digit : 'A' + digit - 10);
+    value /= static_cast<unsigned>(base);
+  } while (value > 0);
+  if (negative)
+  {
+    *--cursor = '-';
+  }
+  return write(cursor, static_cast<size_t>(text + sizeof(text) - cursor));
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+  size_t count = 0;
+  while (count < length)
+  {
+    const int value = read();
+    if (value < 0)
+    {
+      break;
+    }
+    buffer[count++] = static_cast<char>(value);
+  }
+  return count;
+}
+
+namespace
+{
+  std::string formatNumber(unsigned long long value, unsigned char base, bool negative)
+  {
+    std::string text;
+    do
+    {
+      const unsigned digit = static_cast<unsigned>(value % base);
+      text.insert(text.begin(), static_cast<char>(digit < 10 ? '0' + digit : 'a' + digit - 10));
+      value /= base;
+    } while (value > 0);
+    if (negative)
+    {
+      text.insert(text.begin(), '-');
+    }
+    return text;
+  }
+} // namespace
+
+String::String(int value, unsigned char base) : String(static_cast<long>(value), base)
+{
+}
+
+String::String(unsigned int value, unsigned char base) : String(static_cast<unsigned long>(value), base)
+{
+}
+
+String::String(long value, unsigned char base)
+{
+  const bool negative = base == 10 && value < 0;
+  const unsigned long long magnitude =
+      negative ? static_cast<unsigned long long>(-(value + 1)) + 1 : static_cast<unsigned long>(value);
+  _text = formatNumber(magnitude, base, negative);
+}
+
+String::String(unsigned long value, unsigned char base) : _text(formatNumber(value, base, false))
+{
+}
+
+String::String(double value, unsigned char decimals)
+{
+  char text[48];
+  snprintf(text, sizeof(text), "%.*f", decimals, value);
+  _text = text;
+}
+
+int String::indexOf(char value, unsigned int from) const
+{
+  const size_t position = _text.find(value, from);
+  return position == std::string::npos ? -1 : static_cast<int>(position);
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+  if (from > to)
+  {
+    const unsigned int swap = from;
+    from = to;
+    to = swap;
+  }
+  if (from >= _text.size())
+  {
+    return String();
+  }
+  return String(_text.substr(from, to - from).c_str());
+}
+
+StringSumHelper &operator+(const StringSumHelper &lhs, const String &rhs)
+{
+  StringSumHelper &sum = const_cast<StringSumHelper &>(lhs);
+  sum.concat(rhs);
+  return sum;
+}
+
+StringSumHelper &operator+(const StringSumHelper &lhs, const char *rhs)
+{
+  StringSumHelper &sum = const_cast<StringSumHelper &>(lhs);
+  sum.concat(rhs);
+  return sum;
+}
+
+StringSumHelper &operator+(const StringSumHelper &lhs, char rhs)
+{
+  StringSumHelper &sum = const_cast<StringSumHelper &>(lhs);
+  sum.concat(rhs);
+  return sum;
+}
+
+StringSumHelper &operator+(const StringSumHelper &lhs, int rhs)
+{
+  StringSumHelper &sum = const_cast<StringSumHelper &>(lhs);
+  sum.concat(rhs);
+  return sum;
+}
+
+StringSumHelper &operator+(const StringSumHelper &lhs, unsigned long rhs)
+{
+  StringSumHelper &sum = const_cast<StringSumHelper &>(lhs);
+  sum.concat(rhs);
+  return sum;
+}
+
+bool IPAddress::fromString(const char *text)
+{
+  unsigned parts[4];
+  char trailing;
+  if (!text || sscanf(text, "%u.%u.%u.%u%c", &parts[0], &parts[1], &parts[2], &parts[3], &trailing) != 4)
+  {
+    return false;
+  }
+  for (int i = 0; i < 4; ++i)
+  {
+    if (parts[i] > 255)
+    {
+      return false;
+    }
+    _bytes[i] = static_cast<uint8_t>(parts[i]);
+  }
+  return true;
+}
+
+size_t IPAddress::printTo(Print &out) const
+{
+  char text[16];
+  const int length = snprintf(text, sizeof(text), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+  return out.write(text, static_cast<size_t>(length));
+}
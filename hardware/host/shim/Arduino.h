@@ -0,0 +1,101 @@
+/*
+ * Host shim for the subset of the Arduino core the Sentient libraries use.
+ *
+ * Time comes from HostClock: real (steady_clock) by default, or virtual, in
+ * which case it only moves through delay()/delayMicroseconds() and
+ * HostClock::advance(). Tests and benchmarks use virtual time so delays in
+ * library code cost nothing and timeouts are deterministic.
+ *
+ * ARDUINO is deliberately left undefined: libraries take their portable
+ * paths (SentientProfiler's chrono clock, SentientMemoryStats' counting
+ * allocator), and the Teensy networking headers are served by this shim.
+ */
+
+#ifndef SENTIENT_HOST_ARDUINO_H
+#define SENTIENT_HOST_ARDUINO_H
+
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "Client.h"
+#include "IPAddress.h"
+#include "Print.h"
+#include "Printable.h"
+#include "Stream.h"
+#include "WString.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define PROGMEM
+#define DMAMEM
+#define FLASHMEM
+#define PSTR(s) (s)
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(PSTR(s)))
+#define pgm_read_byte(address) (*reinterpret_cast<const uint8_t *>(address))
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define memcpy_P memcpy
+
+using byte = uint8_t;
+using boolean = bool;
+
+class HostClock
+{
+public:
+  static void useVirtualTime(bool enabled);
+  static bool virtualTime();
+  static void advance(uint64_t microseconds);
+  static uint64_t nowMicros();
+};
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+// Serial writes to stdout. availableForWrite() is unbounded unless a test caps it.
+class HostSerial : public Stream
+{
+public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t value) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  int availableForWrite() override { return _writeSpace; }
+  int available() override { return 0; }
+  int read() override { return -1; }
+  int peek() override { return -1; }
+  void flush() override;
+  explicit operator bool() const { return true; }
+
+  void setWriteSpace(int space) { _writeSpace = space; }
+  void setEcho(bool echo) { _echo = echo; } // false drops output, e.g. inside benchmarks
+
+private:
+  int _writeSpace = 1 << 20;
+  bool _echo = true;
+};
+
+extern HostSerial Serial;
+
+#endif // SENTIENT_HOST_ARDUINO_H
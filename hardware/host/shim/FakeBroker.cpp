@@ -0,0 +1,399 @@
+#include "FakeBroker.h"
+
+#include <algorithm>
+
+namespace
+{
+  std::vector<FakeBroker *> &registry()
+  {
+    static std::vector<FakeBroker *> brokers;
+    return brokers;
+  }
+
+  void appendRemainingLength(std::deque<uint8_t> &out, size_t length)
+  {
+    do
+    {
+      uint8_t digit = static_cast<uint8_t>(length % 128);
+      length /= 128;
+      if (length > 0)
+      {
+        digit |= 0x80;
+      }
+      out.push_back(digit);
+    } while (length > 0);
+  }
+
+  // Reads a length-prefixed MQTT string at `position`; false when it overruns the packet
+  bool readString(const uint8_t *body, size_t length, size_t &position, std::string &out)
+  {
+    if (position + 2 > length)
+    {
+      return false;
+    }
+    const size_t size = (static_cast<size_t>(body[position]) << 8) | body[position + 1];
+    position += 2;
+    if (position + size > length)
+    {
+      return false;
+    }
+    out.assign(reinterpret_cast<const char *>(body + position), size);
+    position += size;
+    return true;
+  }
+} // namespace
+
+FakeBroker::FakeBroker(const IPAddress &address, uint16_t port) : _address(address), _port(port)
+{
+  registry().push_back(this);
+}
+
+FakeBroker::~FakeBroker()
+{
+  dropConnections();
+  auto &brokers = registry();
+  brokers.erase(std::remove(brokers.begin(), brokers.end(), this), brokers.end());
+}
+
+FakeBroker *FakeBroker::find(const IPAddress &address, uint16_t port)
+{
+  for (FakeBroker *broker : registry())
+  {
+    if (broker->_address == address && broker->_port == port)
+    {
+      return broker;
+    }
+  }
+  return nullptr;
+}
+
+FakeBroker *FakeBroker::findHost(const char *host, uint16_t port)
+{
+  IPAddress address;
+  return resolve(host, address) ? find(address, port) : nullptr;
+}
+
+bool FakeBroker::resolve(const char *host, IPAddress &address)
+{
+  if (!host)
+  {
+    return false;
+  }
+  if (address.fromString(host))
+  {
+    return true;
+  }
+  for (FakeBroker *broker : registry())
+  {
+    if (!broker->_host.empty() && strcasecmp(broker->_host.c_str(), host) == 0)
+    {
+      address = broker->_address;
+      return true;
+    }
+  }
+  return false;
+}
+
+void FakeBroker::inject(const char *topic, const char *payload, bool retain)
+{
+  inject(topic, reinterpret_cast<const uint8_t *>(payload), payload ? strlen(payload) : 0, retain);
+}
+
+void FakeBroker::inject(const char *topic, const uint8_t *payload, size_t length, bool retain)
+{
+  route("", topic, payload, length, retain);
+}
+
+void FakeBroker::dropConnections()
+{
+  for (auto &weak : _connections)
+  {
+    if (auto connection = weak.lock())
+    {
+      connection->open = false;
+      connection->sessionUp = false;
+      connection->toClient.clear();
+    }
+  }
+  _connections.clear();
+}
+
+const FakeBroker::Message *FakeBroker::lastOn(const char *topic) const
+{
+  for (auto it = _published.rbegin(); it != _published.rend(); ++it)
+  {
+    if (it->topic == topic)
+    {
+      return &*it;
+    }
+  }
+  return nullptr;
+}
+
+size_t FakeBroker::countOn(const char *topicPrefix) const
+{
+  const size_t prefixLength = strlen(topicPrefix);
+  return static_cast<size_t>(std::count_if(_published.begin(), _published.end(), [&](const Message &message)
+                                           { return message.topic.compare(0, prefixLength, topicPrefix) == 0; }));
+}
+
+size_t FakeBroker::sessions() const
+{
+  size_t count = 0;
+  for (const auto &weak : _connections)
+  {
+    const auto connection = weak.lock();
+    if (connection && connection->open && connection->sessionUp)
+    {
+      ++count;
+    }
+  }
+  return count;
+}
+
+bool FakeBroker::topicMatches(const std::string &filter, const std::string &topic)
+{
+  size_t f = 0;
+  size_t t = 0;
+  while (f < filter.size())
+  {
+    const size_t filterEnd = std::min(filter.find('/', f), filter.size());
+    const std::string level = filter.substr(f, filterEnd - f);
+    if (level == "#")
+    {
+      return true; // Also matches the parent level itself
+    }
+    if (t > topic.size())
+    {
+      return false;
+    }
+    const size_t topicEnd = std::min(topic.find('/', t), topic.size());
+    if (level != "+" && level != topic.substr(t, topicEnd - t))
+    {
+      return false;
+    }
+    f = filterEnd + 1;
+    t = topicEnd + 1;
+  }
+  return t > topic.size();
+}
+
+std::shared_ptr<FakeBrokerConnection> FakeBroker::open()
+{
+  if (!_accepting)
+  {
+    return nullptr;
+  }
+  auto connection = std::make_shared<FakeBrokerConnection>(*this);
+  // Sessions closed by the client side are pruned lazily
+  _connections.erase(std::remove_if(_connections.begin(), _connections.end(),
+                                    [](const std::weak_ptr<FakeBrokerConnection> &weak)
+                                    {
+                                      const auto live = weak.lock();
+                                      return !live || !live->open;
+                                    }),
+                     _connections.end());
+  _connections.push_back(connection);
+  return connection;
+}
+
+void FakeBroker::receive(FakeBrokerConnection &connection, const uint8_t *data, size_t length)
+{
+  if (!connection.open)
+  {
+    return;
+  }
+  std::vector<uint8_t> &pending = connection.fromClient;
+  pending.insert(pending.end(), data, data + length);
+
+  size_t consumed = 0;
+  while (connection.open && pending.size() - consumed >= 2)
+  {
+    size_t remaining = 0;
+    size_t multiplier = 1;
+    size_t position = consumed + 1;
+    bool complete = false;
+    while (position < pending.size() && position - consumed <= 4)
+    {
+      const uint8_t digit = pending[position++];
+      remaining += (digit & 0x7F) * multiplier;
+      multiplier *= 128;
+      if ((digit & 0x80) == 0)
+      {
+        complete = true;
+        break;
+      }
+    }
+    if (!complete || pending.size() - position < remaining)
+    {
+      break;
+    }
+    handlePacket(connection, pending[consumed], pending.data() + position, remaining);
+    consumed = position + remaining;
+  }
+  pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(std::min(consumed, pending.size())));
+}
+
+void FakeBroker::close(FakeBrokerConnection &connection)
+{
+  connection.open = false;
+  connection.sessionUp = false;
+}
+
+void FakeBroker::handlePacket(FakeBrokerConnection &connection, uint8_t header, const uint8_t *body, size_t length)
+{
+  switch (header >> 4)
+  {
+  case 1: // CONNECT
+  {
+    size_t position = 0;
+    std::string protocol;
+    if (!readString(body, length, position, protocol) || position + 4 > length)
+    {
+      close(connection);
+      return;
+    }
+    const uint8_t flags = body[position + 1];
+    position += 4;
+    readString(body, length, position, connection.clientId);
+    std::string ignored;
+    if (flags & 0x04)
+    {
+      readString(body, length, position, ignored); // Will topic
+      readString(body, length, position, ignored); // Will message
+    }
+    if (flags & 0x80)
+    {
+      readString(body, length, position, connection.username);
+    }
+    const uint8_t ack[] = {0x20, 0x02, 0x00, _connackCode};
+    connection.toClient.insert(connection.toClient.end(), ack, ack + sizeof(ack));
+    if (_connackCode != 0)
+    {
+      connection.open = false;
+      return;
+    }
+    connection.sessionUp = true;
+    ++_connectsAccepted;
+    return;
+  }
+
+  case 3: // PUBLISH
+  {
+    size_t position = 0;
+    if (!connection.sessionUp || !readString(body, length, position, _publishTopic))
+    {
+      close(connection);
+      return;
+    }
+    if ((header & 0x06) != 0)
+    {
+      position += 2; // QoS 1/2 packet id; acknowledgements are not simulated
+    }
+    route(connection.clientId, _publishTopic, body + position, length - std::min(position, length), header & 0x01);
+    return;
+  }
+
+  case 8: // SUBSCRIBE
+  {
+    if (!connection.sessionUp || length < 2)
+    {
+      close(connection);
+      return;
+    }
+    size_t position = 2;
+    std::vector<std::string> added;
+    std::string filter;
+    while (position < length && readString(body, length, position, filter))
+    {
+      ++position; // Requested QoS
+      connection.filters.push_back(filter);
+      added.push_back(filter);
+    }
+    connection.toClient.push_back(0x90);
+    appendRemainingLength(connection.toClient, 2 + added.size());
+    connection.toClient.push_back(body[0]);
+    connection.toClient.push_back(body[1]);
+    for (size_t i = 0; i < added.size(); ++i)
+    {
+      connection.toClient.push_back(0x00);
+    }
+    for (const auto &retained : _retained)
+    {
+      for (const auto &entry : added)
+      {
+        if (topicMatches(entry, retained.first))
+        {
+          sendPublish(connection, retained.first, reinterpret_cast<const uint8_t *>(retained.second.data()),
+                      retained.second.size(), true);
+          break;
+        }
+      }
+    }
+    return;
+  }
+
+  case 12: // PINGREQ
+    connection.toClient.push_back(0xD0);
+    connection.toClient.push_back(0x00);
+    return;
+
+  case 14: // DISCONNECT
+    close(connection);
+    return;
+
+  default:
+    return;
+  }
+}
+
+void FakeBroker::route(const std::string &clientId, const std::string &topic, const uint8_t *payload, size_t length,
+                       bool retain)
+{
+  ++_publishCount;
+  _publishBytes += topic.size() + length;
+  if (_recording)
+  {
+    _published.push_back({clientId, topic, std::string(reinterpret_cast<const char *>(payload), length), retain});
+  }
+  if (retain)
+  {
+    if (length == 0)
+    {
+      _retained.erase(topic);
+    }
+    else
+    {
+      _retained[topic].assign(reinterpret_cast<const char *>(payload), length);
+    }
+  }
+
+  for (auto &weak : _connections)
+  {
+    const auto connection = weak.lock();
+    if (!connection || !connection->open || !connection->sessionUp)
+    {
+      continue;
+    }
+    for (const auto &filter : connection->filters)
+    {
+      if (topicMatches(filter, topic))
+      {
+        sendPublish(*connection, topic, payload, length, false);
+        break;
+      }
+    }
+  }
+}
+
+void FakeBroker::sendPublish(FakeBrokerConnection &connection, const std::string &topic, const uint8_t *payload,
+                             size_t length, bool retain)
+{
+  std::deque<uint8_t> &out = connection.toClient;
+  out.push_back(retain ? 0x31 : 0x30);
+  appendRemainingLength(out, 2 + topic.size() + length);
+  out.push_back(static_cast<uint8_t>(topic.size() >> 8));
+  out.push_back(static_cast<uint8_t>(topic.size() & 0xFF));
+  out.insert(out.end(), topic.begin(), topic.end());
+  out.insert(out.end(), payload, payload + length);
+}
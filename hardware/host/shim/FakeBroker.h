@@ -0,0 +1,124 @@
+/*
+ * FakeBroker - in-process MQTT 3.1.1 broker for host tests and benchmarks.
+ *
+ * EthernetClient::connect() looks brokers up by address (or by a host name
+ * registered with setHost()), so SentientMQTT talks to one with no sockets
+ * and no threads. Packets are handled synchronously as the client writes
+ * them: a CONNECT's CONNACK is readable the moment write() returns.
+ *
+ * Supports QoS 0 only: CONNECT, SUBSCRIBE (+ and # filters), PUBLISH with
+ * retained messages, PINGREQ and DISCONNECT. Every publish is recorded so
+ * tests can assert on topics and payloads; inject() delivers a message to
+ * subscribers as if another client had published it.
+ */
+
+#ifndef SENTIENT_HOST_FAKE_BROKER_H
+#define SENTIENT_HOST_FAKE_BROKER_H
+
+#include <Arduino.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+class FakeBroker;
+
+// One client session; shared between the broker and the EthernetClient that opened it
+class FakeBrokerConnection
+{
+public:
+  explicit FakeBrokerConnection(FakeBroker &broker) : broker(&broker) {}
+
+  FakeBroker *broker;
+  bool open = true;
+  bool sessionUp = false; // CONNECT accepted
+  std::string clientId;
+  std::string username;
+  std::vector<std::string> filters;
+  std::vector<uint8_t> fromClient; // Bytes not yet forming a complete packet
+  std::deque<uint8_t> toClient;
+};
+
+class FakeBroker
+{
+public:
+  struct Message
+  {
+    std::string clientId;
+    std::string topic;
+    std::string payload;
+    bool retain;
+  };
+
+  FakeBroker(const IPAddress &address, uint16_t port = 1883);
+  ~FakeBroker();
+  FakeBroker(const FakeBroker &) = delete;
+  FakeBroker &operator=(const FakeBroker &) = delete;
+
+  static FakeBroker *find(const IPAddress &address, uint16_t port);
+  static FakeBroker *findHost(const char *host, uint16_t port);
+  static bool resolve(const char *host, IPAddress &address);
+
+  void setHost(const char *host) { _host = host ? host : ""; }
+  void setAccepting(bool accepting) { _accepting = accepting; } // false refuses TCP connections
+  // Time the TCP handshake takes; a connect with a shorter timeout spends all of it and fails.
+  // NeverAnswers stands in for a host that is down: every connect runs out its timeout.
+  static constexpr uint32_t NeverAnswers = 0xFFFFFFFF;
+  void setHandshakeMs(uint32_t handshakeMs) { _handshakeMs = handshakeMs; }
+  uint32_t handshakeMs() const { return _handshakeMs; }
+  size_t connectAttempts() const { return _connectAttempts; } // TCP connects tried, answered or not
+  void setConnackCode(uint8_t code) { _connackCode = code; }    // Non-zero refuses CONNECT
+  void setRecording(bool recording) { _recording = recording; } // false keeps only counters
+  // Free TX space EthernetClient::availableForWrite() reports to the controller (a W5500 socket holds 2 KB)
+  void setClientWriteSpace(int bytes) { _clientWriteSpace = bytes; }
+  int clientWriteSpace() const { return _clientWriteSpace; }
+
+  // Delivers to every subscribed session, as if another client published it
+  void inject(const char *topic, const char *payload, bool retain = false);
+  void inject(const char *topic, const uint8_t *payload, size_t length, bool retain = false);
+  void dropConnections();
+
+  const std::vector<Message> &published() const { return _published; }
+  const Message *lastOn(const char *topic) const;
+  size_t countOn(const char *topicPrefix) const;
+  void clearPublished() { _published.clear(); }
+  uint64_t publishCount() const { return _publishCount; }
+  uint64_t publishBytes() const { return _publishBytes; }
+  size_t sessions() const;
+  size_t connectsAccepted() const { return _connectsAccepted; }
+
+  static bool topicMatches(const std::string &filter, const std::string &topic);
+
+  // EthernetClient side
+  std::shared_ptr<FakeBrokerConnection> open();
+  void countConnectAttempt() { ++_connectAttempts; }
+  void receive(FakeBrokerConnection &connection, const uint8_t *data, size_t length);
+  void close(FakeBrokerConnection &connection);
+
+private:
+  void handlePacket(FakeBrokerConnection &connection, uint8_t header, const uint8_t *body, size_t length);
+  void route(const std::string &clientId, const std::string &topic, const uint8_t *payload, size_t length, bool retain);
+  static void sendPublish(FakeBrokerConnection &connection, const std::string &topic, const uint8_t *payload,
+                          size_t length, bool retain);
+
+  IPAddress _address;
+  uint16_t _port;
+  std::string _host;
+  bool _accepting = true;
+  uint32_t _handshakeMs = 0;
+  size_t _connectAttempts = 0;
+  bool _recording = true;
+  uint8_t _connackCode = 0;
+  int _clientWriteSpace = 2048;
+  std::vector<std::weak_ptr<FakeBrokerConnection>> _connections;
+  std::map<std::string, std::string> _retained;
+  std::vector<Message> _published;
+  std::string _publishTopic; // Reused, so a non-recording broker adds no allocations to the benchmarks
+  uint64_t _publishCount = 0;
+  uint64_t _publishBytes = 0;
+  size_t _connectsAccepted = 0;
+};
+
+#endif // SENTIENT_HOST_FAKE_BROKER_H
@@ -0,0 +1,31 @@
+#ifndef SENTIENT_HOST_IPADDRESS_H
+#define SENTIENT_HOST_IPADDRESS_H
+
+#include <stdint.h>
+
+#include "Printable.h"
+
+class IPAddress : public Printable
+{
+public:
+  IPAddress() = default;
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d} {}
+  explicit IPAddress(const uint8_t *address) : _bytes{address[0], address[1], address[2], address[3]} {}
+
+  uint8_t operator[](int index) const { return _bytes[index]; }
+  uint8_t &operator[](int index) { return _bytes[index]; }
+  bool operator==(const IPAddress &other) const
+  {
+    return _bytes[0] == other._bytes[0] && _bytes[1] == other._bytes[1] && _bytes[2] == other._bytes[2] &&
+           _bytes[3] == other._bytes[3];
+  }
+  bool operator!=(const IPAddress &other) const { return !(*this == other); }
+
+  bool fromString(const char *text);
+  size_t printTo(Print &out) const override;
+
+private:
+  uint8_t _bytes[4] = {0, 0, 0, 0};
+};
+
+#endif // SENTIENT_HOST_IPADDRESS_H
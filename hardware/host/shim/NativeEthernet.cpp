@@ -0,0 +1,285 @@
+#include <NativeEthernet.h>
+
+#include <TeensyID.h>
+#include <fnet.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "FakeBroker.h"
+
+EthernetClass Ethernet;
+
+int EthernetClass::begin(uint8_t *, unsigned long, unsigned long)
+{
+  return _link == LinkOFF ? 0 : 1;
+}
+
+void EthernetClass::begin(uint8_t *, IPAddress ip, IPAddress dns, IPAddress, IPAddress)
+{
+  _localIp = ip;
+  _dns = dns;
+}
+
+int EthernetClient::connect(IPAddress ip, uint16_t port)
+{
+  // PubSubClient::connect() reconnects the socket SentientMQTT already opened; keep it
+  if (_connection && _connection->open)
+  {
+    return 1;
+  }
+  _connection.reset();
+  if (Ethernet.linkStatus() == LinkOFF)
+  {
+    return 0;
+  }
+  FakeBroker *broker = FakeBroker::find(ip, port);
+  if (!broker)
+  {
+    return 0;
+  }
+  broker->countConnectAttempt();
+  // Like the driver, the call blocks until the handshake completes or the timeout runs out
+  if (broker->handshakeMs() > _timeoutMs)
+  {
+    delay(_timeoutMs);
+    return 0;
+  }
+  delay(broker->handshakeMs());
+  _connection = broker->open();
+  return _connection ? 1 : 0;
+}
+
+int EthernetClient::connect(const char *host, uint16_t port)
+{
+  IPAddress address;
+  return FakeBroker::resolve(host, address) ? connect(address, port) : 0;
+}
+
+size_t EthernetClient::write(const uint8_t *buffer, size_t size)
+{
+  if (!_connection || !_connection->open)
+  {
+    return 0;
+  }
+  _connection->broker->receive(*_connection, buffer, size);
+  return size;
+}
+
+int EthernetClient::available()
+{
+  return _connection ? static_cast<int>(_connection->toClient.size()) : 0;
+}
+
+int EthernetClient::availableForWrite()
+{
+  return _connection && _connection->open ? _connection->broker->clientWriteSpace() : 0;
+}
+
+int EthernetClient::read()
+{
+  if (!_connection || _connection->toClient.empty())
+  {
+    return -1;
+  }
+  const uint8_t value = _connection->toClient.front();
+  _connection->toClient.pop_front();
+  return value;
+}
+
+int EthernetClient::read(uint8_t *buffer, size_t size)
+{
+  if (!_connection || _connection->toClient.empty())
+  {
+    return -1;
+  }
+  size_t count = 0;
+  while (count < size && !_connection->toClient.empty())
+  {
+    buffer[count++] = _connection->toClient.front();
+    _connection->toClient.pop_front();
+  }
+  return static_cast<int>(count);
+}
+
+int EthernetClient::peek()
+{
+  return _connection && !_connection->toClient.empty() ? _connection->toClient.front() : -1;
+}
+
+void EthernetClient::stop()
+{
+  // A dropped session may outlive its broker, so only an open one is handed back
+  if (_connection && _connection->open)
+  {
+    _connection->broker->close(*_connection);
+  }
+  _connection.reset();
+}
+
+uint8_t EthernetClient::connected()
+{
+  // Like the W5500 driver: still "connected" while unread data remains after the peer closed
+  return _connection && (_connection->open || !_connection->toClient.empty()) ? 1 : 0;
+}
+
+uint32_t EthernetUDP::s_dnsDelayMs = 0;
+size_t EthernetUDP::s_dnsQueries = 0;
+
+uint8_t EthernetUDP::begin(uint16_t)
+{
+  _open = true;
+  return 1;
+}
+
+void EthernetUDP::stop()
+{
+  _open = false;
+  _inbox.clear();
+  _packet.clear();
+  _packetPosition = 0;
+}
+
+int EthernetUDP::beginPacket(IPAddress ip, uint16_t port)
+{
+  _sendIp = ip;
+  _sendPort = port;
+  _sending.clear();
+  return _open ? 1 : 0;
+}
+
+int EthernetUDP::beginPacket(const char *host, uint16_t port)
+{
+  IPAddress address;
+  return FakeBroker::resolve(host, address) ? beginPacket(address, port) : 0;
+}
+
+size_t EthernetUDP::write(const uint8_t *buffer, size_t size)
+{
+  _sending.insert(_sending.end(), buffer, buffer + size);
+  return size;
+}
+
+int EthernetUDP::endPacket()
+{
+  if (!_open || Ethernet.linkStatus() == LinkOFF)
+  {
+    return 0;
+  }
+  if (_sendPort == 53 && _sendIp == Ethernet.dnsServerIP())
+  {
+    answerDns(_sending);
+  }
+  _sending.clear();
+  return 1;
+}
+
+void EthernetUDP::answerDns(const std::vector<uint8_t> &query)
+{
+  ++s_dnsQueries;
+  if (s_dnsDelayMs == NeverAnswers || query.size() < 17)
+  {
+    return;
+  }
+  // Question name back to a dotted host
+  std::string host;
+  size_t position = 12;
+  while (position < query.size() && query[position] != 0)
+  {
+    const size_t length = query[position++];
+    if (!host.empty())
+    {
+      host += '.';
+    }
+    host.append(reinterpret_cast<const char *>(&query[position]), length);
+    position += length;
+  }
+  const size_t questionEnd = position + 5;
+  if (questionEnd > query.size())
+  {
+    return;
+  }
+
+  IPAddress address;
+  const bool known = FakeBroker::resolve(host.c_str(), address);
+  Datagram reply{millis() + s_dnsDelayMs, Ethernet.dnsServerIP(), 53,
+                 std::vector<uint8_t>(query.begin(), query.begin() + questionEnd)};
+  reply.bytes[2] = 0x81;              // Response, recursion desired
+  reply.bytes[3] = known ? 0x80 : 0x83; // Recursion available; NXDOMAIN when unknown
+  if (known)
+  {
+    reply.bytes[7] = 1; // One answer: pointer to the question name, A, IN, TTL 300, 4 bytes
+    const uint8_t record[] = {0xC0, 12, 0, 1, 0, 1, 0, 0, 1, 44, 0, 4, address[0], address[1], address[2], address[3]};
+    reply.bytes.insert(reply.bytes.end(), record, record + sizeof(record));
+  }
+  _inbox.push_back(std::move(reply));
+}
+
+int EthernetUDP::parsePacket()
+{
+  _packet.clear();
+  _packetPosition = 0;
+  if (!_open || _inbox.empty() || static_cast<long>(millis() - _inbox.front().readyAt) < 0)
+  {
+    return 0;
+  }
+  _packet = std::move(_inbox.front().bytes);
+  _remoteIp = _inbox.front().from;
+  _remotePort = _inbox.front().port;
+  _inbox.pop_front();
+  return static_cast<int>(_packet.size());
+}
+
+int EthernetUDP::available()
+{
+  return static_cast<int>(_packet.size() - _packetPosition);
+}
+
+int EthernetUDP::read()
+{
+  return _packetPosition < _packet.size() ? _packet[_packetPosition++] : -1;
+}
+
+int EthernetUDP::read(unsigned char *buffer, size_t length)
+{
+  const size_t count = std::min(length, _packet.size() - _packetPosition);
+  memcpy(buffer, _packet.data() + _packetPosition, count);
+  _packetPosition += count;
+  return static_cast<int>(count);
+}
+
+int EthernetUDP::peek()
+{
+  return _packetPosition < _packet.size() ? _packet[_packetPosition] : -1;
+}
+
+void teensyMAC(uint8_t *mac)
+{
+  static const uint8_t kHostMac[6] = {0x02, 0x53, 0x45, 0x4E, 0x54, 0x01};
+  memcpy(mac, kHostMac, sizeof(kHostMac));
+}
+
+namespace
+{
+  int s_fnetService = 0;
+}
+
+fnet_netif_desc_t fnet_netif_get_default()
+{
+  return &s_fnetService;
+}
+
+fnet_mdns_desc_t fnet_mdns_init(const fnet_mdns_params_t *)
+{
+  return &s_fnetService;
+}
+
+fnet_llmnr_desc_t fnet_llmnr_init(const fnet_llmnr_params_t *)
+{
+  return &s_fnetService;
+}
+
+void fnet_service_poll()
+{
+}
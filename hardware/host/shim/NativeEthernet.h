@@ -0,0 +1,122 @@
+#ifndef SENTIENT_HOST_NATIVE_ETHERNET_H
+#define SENTIENT_HOST_NATIVE_ETHERNET_H
+
+#include <Arduino.h>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "Udp.h"
+
+class FakeBrokerConnection;
+
+enum EthernetLinkStatus
+{
+  Unknown,
+  LinkON,
+  LinkOFF
+};
+
+class EthernetClass
+{
+public:
+  int begin(uint8_t *mac, unsigned long timeout = 60000, unsigned long responseTimeout = 4000);
+  void begin(uint8_t *mac, IPAddress ip, IPAddress dns, IPAddress gateway, IPAddress subnet);
+  int maintain() { return 0; }
+  EthernetLinkStatus linkStatus() const { return _link; }
+  IPAddress localIP() const { return _localIp; }
+  IPAddress dnsServerIP() const { return _dns; }
+
+  // Host-only: simulate cable pulls
+  void setLinkStatus(EthernetLinkStatus link) { _link = link; }
+
+private:
+  EthernetLinkStatus _link = LinkON;
+  IPAddress _localIp{10, 0, 0, 50};
+  IPAddress _dns{10, 0, 0, 1};
+};
+
+extern EthernetClass Ethernet;
+
+// Connects to an in-process FakeBroker registered at the address; there is no real socket
+class EthernetClient : public Client
+{
+public:
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char *host, uint16_t port) override;
+  size_t write(uint8_t value) override { return write(&value, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  int available() override;
+  int availableForWrite() override;
+  int read() override;
+  int read(uint8_t *buffer, size_t size) override;
+  int peek() override;
+  void flush() override {}
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override { return _connection != nullptr; }
+
+  void setConnectionTimeout(uint16_t timeoutMs) { _timeoutMs = timeoutMs; }
+
+private:
+  std::shared_ptr<FakeBrokerConnection> _connection;
+  uint16_t _timeoutMs = 1000;
+};
+
+// Host-only DNS: a query sent to port 53 is answered from the FakeBroker host names
+// (NXDOMAIN for anything else) after the configured delay. Nothing else is delivered.
+class EthernetUDP : public UDP
+{
+public:
+  static constexpr uint32_t NeverAnswers = 0xFFFFFFFF;
+
+  uint8_t begin(uint16_t port) override;
+  void stop() override;
+  int beginPacket(IPAddress ip, uint16_t port) override;
+  int beginPacket(const char *host, uint16_t port) override;
+  int endPacket() override;
+  size_t write(uint8_t value) override { return write(&value, 1); }
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  int parsePacket() override;
+  int available() override;
+  int read() override;
+  int read(unsigned char *buffer, size_t length) override;
+  int read(char *buffer, size_t length) override { return read(reinterpret_cast<unsigned char *>(buffer), length); }
+  int peek() override;
+  void flush() override {}
+  IPAddress remoteIP() override { return _remoteIp; }
+  uint16_t remotePort() override { return _remotePort; }
+
+  // Host-only: how long the DNS server takes to answer, and the queries it got so far
+  static void setDnsDelayMs(uint32_t delayMs) { s_dnsDelayMs = delayMs; }
+  static size_t dnsQueries() { return s_dnsQueries; }
+
+private:
+  struct Datagram
+  {
+    unsigned long readyAt;
+    IPAddress from;
+    uint16_t port;
+    std::vector<uint8_t> bytes;
+  };
+
+  void answerDns(const std::vector<uint8_t> &query);
+
+  bool _open = false;
+  IPAddress _sendIp;
+  uint16_t _sendPort = 0;
+  std::vector<uint8_t> _sending;
+  std::deque<Datagram> _inbox;
+  std::vector<uint8_t> _packet; // The datagram parsePacket() picked
+  size_t _packetPosition = 0;
+  IPAddress _remoteIp;
+  uint16_t _remotePort = 0;
+
+  static uint32_t s_dnsDelayMs;
+  static size_t s_dnsQueries;
+};
+
+#endif // SENTIENT_HOST_NATIVE_ETHERNET_H
@@ -0,0 +1,63 @@
+#ifndef SENTIENT_HOST_PRINT_H
+#define SENTIENT_HOST_PRINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class __FlashStringHelper;
+class String;
+class Printable;
+
+class Print
+{
+public:
+  virtual ~Print() = default;
+
+  virtual size_t write(uint8_t value) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  size_t write(const char *text) { return text ? write(reinterpret_cast<const uint8_t *>(text), strlen(text)) : 0; }
+  size_t write(const char *buffer, size_t size) { return write(reinterpret_cast<const uint8_t *>(buffer), size); }
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+
+  size_t print(const __FlashStringHelper *text);
+  size_t print(const String &text);
+  size_t print(const char *text);
+  size_t print(char value);
+  size_t print(unsigned char value, int base = DEC);
+  size_t print(int value, int base = DEC);
+  size_t print(unsigned int value, int base = DEC);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(long long value, int base = DEC);
+  size_t print(unsigned long long value, int base = DEC);
+  size_t print(double value, int digits = 2);
+  size_t print(const Printable &value);
+
+  size_t println();
+  template <typename T>
+  size_t println(const T &value)
+  {
+    const size_t count = print(value);
+    return count + println();
+  }
+  template <typename T>
+  size_t println(const T &value, int format)
+  {
+    const size_t count = print(value, format);
+    return count + println();
+  }
+
+  size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+private:
+  size_t printNumber(unsigned long long value, int base, bool negative);
+};
+
+#endif // SENTIENT_HOST_PRINT_H
@@ -0,0 +1,15 @@
+#ifndef SENTIENT_HOST_PRINTABLE_H
+#define SENTIENT_HOST_PRINTABLE_H
+
+#include <stddef.h>
+
+class Print;
+
+class Printable
+{
+public:
+  virtual ~Printable() = default;
+  virtual size_t printTo(Print &out) const = 0;
+};
+
+#endif // SENTIENT_HOST_PRINTABLE_H
@@ -0,0 +1,457 @@
+#include "PubSubClient.h"
+
+PubSubClient::PubSubClient()
+{
+  setBufferSize(MQTT_MAX_PACKET_SIZE);
+}
+
+PubSubClient::PubSubClient(Client &client) : PubSubClient()
+{
+  setClient(client);
+}
+
+PubSubClient::~PubSubClient()
+{
+  free(_buffer);
+}
+
+PubSubClient &PubSubClient::setServer(IPAddress ip, uint16_t port)
+{
+  _ip = ip;
+  _port = port;
+  _domain = nullptr;
+  return *this;
+}
+
+PubSubClient &PubSubClient::setServer(const char *domain, uint16_t port)
+{
+  _domain = domain;
+  _port = port;
+  return *this;
+}
+
+PubSubClient &PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE)
+{
+  this->callback = callback;
+  return *this;
+}
+
+PubSubClient &PubSubClient::setClient(Client &client)
+{
+  _client = &client;
+  return *this;
+}
+
+PubSubClient &PubSubClient::setKeepAlive(uint16_t keepAlive)
+{
+  _keepAlive = keepAlive;
+  return *this;
+}
+
+PubSubClient &PubSubClient::setSocketTimeout(uint16_t timeout)
+{
+  _socketTimeout = timeout;
+  return *this;
+}
+
+boolean PubSubClient::setBufferSize(uint16_t size)
+{
+  if (size == 0)
+  {
+    return false;
+  }
+  uint8_t *resized = static_cast<uint8_t *>(realloc(_buffer, size));
+  if (!resized)
+  {
+    return false;
+  }
+  _buffer = resized;
+  _bufferSize = size;
+  return true;
+}
+
+boolean PubSubClient::connect(const char *id)
+{
+  return connect(id, nullptr, nullptr, nullptr, 0, false, nullptr, true);
+}
+
+boolean PubSubClient::connect(const char *id, const char *user, const char *pass)
+{
+  return connect(id, user, pass, nullptr, 0, false, nullptr, true);
+}
+
+boolean PubSubClient::connect(const char *id, const char *user, const char *pass, const char *willTopic,
+                              uint8_t willQos, boolean willRetain, const char *willMessage, boolean cleanSession)
+{
+  if (connected())
+  {
+    return true;
+  }
+
+  int result = 1;
+  if (!_client->connected())
+  {
+    result = _domain ? _client->connect(_domain, _port) : _client->connect(_ip, _port);
+  }
+  if (result != 1)
+  {
+    _state = MQTT_CONNECT_FAILED;
+    return false;
+  }
+
+  _nextMsgId = 1;
+  uint16_t length = MQTT_MAX_HEADER_SIZE;
+  const uint8_t protocol[] = {0x00, 0x04, 'M', 'Q', 'T', 'T', MQTT_VERSION};
+  memcpy(_buffer + length, protocol, sizeof(protocol));
+  length += sizeof(protocol);
+
+  uint8_t flags = 0;
+  if (willTopic)
+  {
+    flags = static_cast<uint8_t>(0x04 | (willQos << 3) | (willRetain ? 0x20 : 0));
+  }
+  if (cleanSession)
+  {
+    flags |= 0x02;
+  }
+  if (user)
+  {
+    flags |= 0x80;
+    if (pass)
+    {
+      flags |= 0x40;
+    }
+  }
+  _buffer[length++] = flags;
+  _buffer[length++] = static_cast<uint8_t>(_keepAlive >> 8);
+  _buffer[length++] = static_cast<uint8_t>(_keepAlive & 0xFF);
+
+  length = writeString(id, _buffer, length);
+  if (willTopic)
+  {
+    length = writeString(willTopic, _buffer, length);
+    length = writeString(willMessage, _buffer, length);
+  }
+  if (user)
+  {
+    length = writeString(user, _buffer, length);
+    if (pass)
+    {
+      length = writeString(pass, _buffer, length);
+    }
+  }
+  writePacket(MQTTCONNECT, _buffer, length - MQTT_MAX_HEADER_SIZE);
+
+  _lastInActivity = _lastOutActivity = millis();
+  while (!_client->available())
+  {
+    if (millis() - _lastInActivity >= _socketTimeout * 1000UL)
+    {
+      _state = MQTT_CONNECTION_TIMEOUT;
+      _client->stop();
+      return false;
+    }
+    delay(1);
+  }
+
+  uint8_t lengthBytes = 0;
+  if (readPacket(&lengthBytes) == 4)
+  {
+    if (_buffer[3] == 0)
+    {
+      _lastInActivity = millis();
+      _pingOutstanding = false;
+      _state = MQTT_CONNECTED;
+      return true;
+    }
+    _state = _buffer[3];
+  }
+  _client->stop();
+  return false;
+}
+
+void PubSubClient::disconnect()
+{
+  _buffer[0] = MQTTDISCONNECT;
+  _buffer[1] = 0;
+  _client->write(_buffer, 2);
+  _state = MQTT_DISCONNECTED;
+  _client->flush();
+  _client->stop();
+  _lastInActivity = _lastOutActivity = millis();
+}
+
+boolean PubSubClient::publish(const char *topic, const char *payload)
+{
+  return publish(topic, reinterpret_cast<const uint8_t *>(payload), payload ? strlen(payload) : 0, false);
+}
+
+boolean PubSubClient::publish(const char *topic, const char *payload, boolean retained)
+{
+  return publish(topic, reinterpret_cast<const uint8_t *>(payload), payload ? strlen(payload) : 0, retained);
+}
+
+boolean PubSubClient::publish(const char *topic, const uint8_t *payload, unsigned int length)
+{
+  return publish(topic, payload, length, false);
+}
+
+boolean PubSubClient::publish(const char *topic, const uint8_t *payload, unsigned int length, boolean retained)
+{
+  if (!connected())
+  {
+    return false;
+  }
+  if (_bufferSize < MQTT_MAX_HEADER_SIZE + 2 + strnlen(topic, _bufferSize) + length)
+  {
+    return false;
+  }
+  uint16_t position = writeString(topic, _buffer, MQTT_MAX_HEADER_SIZE);
+  memcpy(_buffer + position, payload, length);
+  position = static_cast<uint16_t>(position + length);
+  return writePacket(static_cast<uint8_t>(MQTTPUBLISH | (retained ? 1 : 0)), _buffer,
+                     static_cast<uint16_t>(position - MQTT_MAX_HEADER_SIZE));
+}
+
+boolean PubSubClient::beginPublish(const char *topic, unsigned int length, boolean retained)
+{
+  if (!connected())
+  {
+    return false;
+  }
+  const uint16_t position = writeString(topic, _buffer, MQTT_MAX_HEADER_SIZE);
+  const size_t headerLength = buildHeader(static_cast<uint8_t>(MQTTPUBLISH | (retained ? 1 : 0)), _buffer,
+                                          static_cast<uint16_t>(length + position - MQTT_MAX_HEADER_SIZE));
+  const size_t count = position - (MQTT_MAX_HEADER_SIZE - headerLength);
+  const size_t written = _client->write(_buffer + (MQTT_MAX_HEADER_SIZE - headerLength), count);
+  _lastOutActivity = millis();
+  return written == count;
+}
+
+int PubSubClient::endPublish()
+{
+  return 1;
+}
+
+size_t PubSubClient::write(uint8_t value)
+{
+  _lastOutActivity = millis();
+  return _client->write(value);
+}
+
+size_t PubSubClient::write(const uint8_t *buffer, size_t size)
+{
+  _lastOutActivity = millis();
+  return _client->write(buffer, size);
+}
+
+boolean PubSubClient::subscribe(const char *topic)
+{
+  return subscribe(topic, 0);
+}
+
+boolean PubSubClient::subscribe(const char *topic, uint8_t qos)
+{
+  const size_t topicLength = strnlen(topic, _bufferSize);
+  if (qos > 1 || _bufferSize < 9 + topicLength || !connected())
+  {
+    return false;
+  }
+  uint16_t position = MQTT_MAX_HEADER_SIZE;
+  if (++_nextMsgId == 0)
+  {
+    _nextMsgId = 1;
+  }
+  _buffer[position++] = static_cast<uint8_t>(_nextMsgId >> 8);
+  _buffer[position++] = static_cast<uint8_t>(_nextMsgId & 0xFF);
+  position = writeString(topic, _buffer, position);
+  _buffer[position++] = qos;
+  return writePacket(MQTTSUBSCRIBE | MQTTQOS1, _buffer, static_cast<uint16_t>(position - MQTT_MAX_HEADER_SIZE));
+}
+
+boolean PubSubClient::loop()
+{
+  if (!connected())
+  {
+    return false;
+  }
+
+  const unsigned long now = millis();
+  const unsigned long keepAliveMs = _keepAlive * 1000UL;
+  if (keepAliveMs > 0 && (now - _lastInActivity > keepAliveMs || now - _lastOutActivity > keepAliveMs))
+  {
+    if (_pingOutstanding)
+    {
+      _state = MQTT_CONNECTION_TIMEOUT;
+      _client->stop();
+      return false;
+    }
+    _buffer[0] = MQTTPINGREQ;
+    _buffer[1] = 0;
+    _client->write(_buffer, 2);
+    _lastOutActivity = _lastInActivity = now;
+    _pingOutstanding = true;
+  }
+
+  if (_client->available())
+  {
+    uint8_t lengthBytes = 0;
+    const uint32_t length = readPacket(&lengthBytes);
+    if (length > 0)
+    {
+      _lastInActivity = millis();
+      const uint8_t type = _buffer[0] & 0xF0;
+      if (type == MQTTPUBLISH && callback)
+      {
+        // Shift the topic down one byte so it can be NUL-terminated in place
+        const uint16_t topicLength = static_cast<uint16_t>((_buffer[lengthBytes + 1] << 8) + _buffer[lengthBytes + 2]);
+        memmove(_buffer + lengthBytes + 2, _buffer + lengthBytes + 3, topicLength);
+        _buffer[lengthBytes + 2 + topicLength] = 0;
+        char *topic = reinterpret_cast<char *>(_buffer + lengthBytes + 2);
+        const uint32_t skip = lengthBytes + 3 + topicLength + ((_buffer[0] & 0x06) ? 2 : 0);
+        callback(topic, _buffer + skip, length - skip);
+      }
+      else if (type == MQTTPINGREQ)
+      {
+        _buffer[0] = MQTTPINGRESP;
+        _buffer[1] = 0;
+        _client->write(_buffer, 2);
+      }
+      else if (type == MQTTPINGRESP)
+      {
+        _pingOutstanding = false;
+      }
+    }
+    else if (!connected())
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+boolean PubSubClient::connected()
+{
+  if (!_client)
+  {
+    return false;
+  }
+  if (_client->connected())
+  {
+    return _state == MQTT_CONNECTED;
+  }
+  if (_state == MQTT_CONNECTED)
+  {
+    _state = MQTT_CONNECTION_LOST;
+    _client->flush();
+    _client->stop();
+  }
+  return false;
+}
+
+bool PubSubClient::readByte(uint8_t *result)
+{
+  const unsigned long start = millis();
+  while (!_client->available())
+  {
+    if (millis() - start >= _socketTimeout * 1000UL)
+    {
+      return false;
+    }
+    delay(1);
+  }
+  *result = static_cast<uint8_t>(_client->read());
+  return true;
+}
+
+// Returns the whole packet length (0 on timeout or overflow); the packet is left in _buffer
+uint32_t PubSubClient::readPacket(uint8_t *lengthBytes)
+{
+  uint32_t length = 0;
+  if (!readByte(&_buffer[length]))
+  {
+    return 0;
+  }
+  ++length;
+
+  uint32_t remaining = 0;
+  uint32_t multiplier = 1;
+  uint8_t digit = 0;
+  uint8_t count = 0;
+  do
+  {
+    if (count == 4 || !readByte(&digit))
+    {
+      return 0;
+    }
+    _buffer[length++] = digit;
+    remaining += (digit & 127) * multiplier;
+    multiplier <<= 7;
+    ++count;
+  } while ((digit & 128) != 0);
+  *lengthBytes = count;
+
+  for (uint32_t i = 0; i < remaining; ++i)
+  {
+    uint8_t value = 0;
+    if (!readByte(&value))
+    {
+      return 0;
+    }
+    if (length < _bufferSize)
+    {
+      _buffer[length] = value;
+    }
+    ++length;
+  }
+  // Oversized packets are consumed and dropped, as the Arduino library does
+  return length <= _bufferSize ? length : 0;
+}
+
+boolean PubSubClient::writePacket(uint8_t header, uint8_t *buffer, uint16_t length)
+{
+  const size_t headerLength = buildHeader(header, buffer, length);
+  const size_t count = headerLength + length;
+  const size_t written = _client->write(buffer + (MQTT_MAX_HEADER_SIZE - headerLength), count);
+  _lastOutActivity = millis();
+  return written == count;
+}
+
+// Writes the fixed header right-aligned in buffer[0..MQTT_MAX_HEADER_SIZE); returns its size
+size_t PubSubClient::buildHeader(uint8_t header, uint8_t *buffer, uint16_t length)
+{
+  uint8_t encoded[4];
+  uint8_t count = 0;
+  uint16_t remaining = length;
+  do
+  {
+    uint8_t digit = remaining % 128;
+    remaining /= 128;
+    if (remaining > 0)
+    {
+      digit |= 0x80;
+    }
+    encoded[count++] = digit;
+  } while (remaining > 0);
+
+  buffer[MQTT_MAX_HEADER_SIZE - 1 - count] = header;
+  for (uint8_t i = 0; i < count; ++i)
+  {
+    buffer[MQTT_MAX_HEADER_SIZE - count + i] = encoded[i];
+  }
+  return count + 1;
+}
+
+uint16_t PubSubClient::writeString(const char *text, uint8_t *buffer, uint16_t position)
+{
+  const uint16_t start = position;
+  position = static_cast<uint16_t>(position + 2);
+  uint16_t length = 0;
+  while (text && text[length] && position < _bufferSize)
+  {
+    buffer[position++] = static_cast<uint8_t>(text[length++]);
+  }
+  buffer[start] = static_cast<uint8_t>(length >> 8);
+  buffer[start + 1] = static_cast<uint8_t>(length & 0xFF);
+  return position;
+}
@@ -0,0 +1,119 @@
+/*
+ * Host stand-in for knolleary's PubSubClient 2.8 (QoS 0 subset).
+ *
+ * Same public API, state codes, buffer layout and blocking behaviour as the
+ * Arduino library, so SentientMQTT's handshake adoption, streamed publishes
+ * and buffer-size checks run exactly as on the controller. Only the parts the
+ * Sentient libraries and sketches call are implemented.
+ */
+
+#ifndef SENTIENT_HOST_PUBSUBCLIENT_H
+#define SENTIENT_HOST_PUBSUBCLIENT_H
+
+#include <Arduino.h>
+
+#define MQTT_VERSION_3_1_1 4
+#define MQTT_VERSION MQTT_VERSION_3_1_1
+
+#ifndef MQTT_MAX_PACKET_SIZE
+#define MQTT_MAX_PACKET_SIZE 256
+#endif
+#ifndef MQTT_KEEPALIVE
+#define MQTT_KEEPALIVE 15
+#endif
+#ifndef MQTT_SOCKET_TIMEOUT
+#define MQTT_SOCKET_TIMEOUT 15
+#endif
+
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTION_LOST -3
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+#define MQTT_CONNECTED 0
+#define MQTT_CONNECT_BAD_PROTOCOL 1
+#define MQTT_CONNECT_BAD_CLIENT_ID 2
+#define MQTT_CONNECT_UNAVAILABLE 3
+#define MQTT_CONNECT_BAD_CREDENTIALS 4
+#define MQTT_CONNECT_UNAUTHORIZED 5
+
+#define MQTTCONNECT 1 << 4
+#define MQTTPUBLISH 3 << 4
+#define MQTTSUBSCRIBE 8 << 4
+#define MQTTPINGREQ 12 << 4
+#define MQTTPINGRESP 13 << 4
+#define MQTTDISCONNECT 14 << 4
+#define MQTTQOS1 (1 << 1)
+
+// Fixed header plus up to four remaining-length bytes
+#define MQTT_MAX_HEADER_SIZE 5
+
+#define MQTT_CALLBACK_SIGNATURE void (*callback)(char *, uint8_t *, unsigned int)
+
+class PubSubClient : public Print
+{
+public:
+  PubSubClient();
+  explicit PubSubClient(Client &client);
+  ~PubSubClient() override;
+  PubSubClient(const PubSubClient &) = delete;
+  PubSubClient &operator=(const PubSubClient &) = delete;
+
+  PubSubClient &setServer(IPAddress ip, uint16_t port);
+  PubSubClient &setServer(const char *domain, uint16_t port);
+  PubSubClient &setCallback(MQTT_CALLBACK_SIGNATURE);
+  PubSubClient &setClient(Client &client);
+  PubSubClient &setKeepAlive(uint16_t keepAlive);
+  PubSubClient &setSocketTimeout(uint16_t timeout);
+
+  boolean setBufferSize(uint16_t size);
+  uint16_t getBufferSize() const { return _bufferSize; }
+
+  boolean connect(const char *id);
+  boolean connect(const char *id, const char *user, const char *pass);
+  boolean connect(const char *id, const char *user, const char *pass, const char *willTopic, uint8_t willQos,
+                  boolean willRetain, const char *willMessage, boolean cleanSession = true);
+  void disconnect();
+
+  boolean publish(const char *topic, const char *payload);
+  boolean publish(const char *topic, const char *payload, boolean retained);
+  boolean publish(const char *topic, const uint8_t *payload, unsigned int length);
+  boolean publish(const char *topic, const uint8_t *payload, unsigned int length, boolean retained);
+
+  // Streamed publish: header and topic now, payload through write(), then endPublish()
+  boolean beginPublish(const char *topic, unsigned int length, boolean retained);
+  int endPublish();
+  size_t write(uint8_t value) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+
+  boolean subscribe(const char *topic);
+  boolean subscribe(const char *topic, uint8_t qos);
+
+  boolean loop();
+  boolean connected();
+  int state() const { return _state; }
+
+private:
+  bool readByte(uint8_t *result);
+  uint32_t readPacket(uint8_t *lengthBytes);
+  boolean writePacket(uint8_t header, uint8_t *buffer, uint16_t length);
+  size_t buildHeader(uint8_t header, uint8_t *buffer, uint16_t length);
+  uint16_t writeString(const char *text, uint8_t *buffer, uint16_t position);
+
+  Client *_client = nullptr;
+  uint8_t *_buffer = nullptr;
+  uint16_t _bufferSize = 0;
+  uint16_t _keepAlive = MQTT_KEEPALIVE;
+  uint16_t _socketTimeout = MQTT_SOCKET_TIMEOUT;
+  uint16_t _nextMsgId = 0;
+  unsigned long _lastOutActivity = 0;
+  unsigned long _lastInActivity = 0;
+  bool _pingOutstanding = false;
+  MQTT_CALLBACK_SIGNATURE = nullptr;
+  IPAddress _ip;
+  const char *_domain = nullptr;
+  uint16_t _port = 0;
+  int _state = MQTT_DISCONNECTED;
+};
+
+#endif // SENTIENT_HOST_PUBSUBCLIENT_H
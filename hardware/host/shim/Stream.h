@@ -0,0 +1,23 @@
+#ifndef SENTIENT_HOST_STREAM_H
+#define SENTIENT_HOST_STREAM_H
+
+#include "Print.h"
+
+class Stream : public Print
+{
+public:
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+
+  void setTimeout(unsigned long timeoutMs) { _timeoutMs = timeoutMs; }
+
+  // Returns what is already buffered; the host shim never waits for more
+  size_t readBytes(char *buffer, size_t length);
+  size_t readBytes(uint8_t *buffer, size_t length) { return readBytes(reinterpret_cast<char *>(buffer), length); }
+
+protected:
+  unsigned long _timeoutMs = 1000;
+};
+
+#endif // SENTIENT_HOST_STREAM_H
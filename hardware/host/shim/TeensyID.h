@@ -0,0 +1,9 @@
+#ifndef SENTIENT_HOST_TEENSYID_H
+#define SENTIENT_HOST_TEENSYID_H
+
+#include <stdint.h>
+
+// Fixed locally administered address, so client ids are stable between runs
+void teensyMAC(uint8_t *mac);
+
+#endif // SENTIENT_HOST_TEENSYID_H
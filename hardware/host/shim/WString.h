@@ -0,0 +1,102 @@
+#ifndef SENTIENT_HOST_WSTRING_H
+#define SENTIENT_HOST_WSTRING_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+class __FlashStringHelper;
+class StringSumHelper;
+
+// Heap-backed like the Arduino core's String; only the members the libraries,
+// sketches and ArduinoJson's String adapter use are provided.
+class String
+{
+public:
+  String() = default;
+  String(const char *text) { *this = text; }
+  String(const __FlashStringHelper *text) : String(reinterpret_cast<const char *>(text)) {}
+  explicit String(char value) : _text(1, value) {}
+  explicit String(int value, unsigned char base = 10);
+  explicit String(unsigned int value, unsigned char base = 10);
+  explicit String(long value, unsigned char base = 10);
+  explicit String(unsigned long value, unsigned char base = 10);
+  explicit String(double value, unsigned char decimals = 2);
+
+  String &operator=(const char *text)
+  {
+    // ArduinoJson assigns a null pointer to empty a String before writing into it
+    if (text)
+    {
+      _text.assign(text);
+    }
+    else
+    {
+      _text.clear();
+    }
+    return *this;
+  }
+
+  unsigned char concat(const String &text) { return concat(text.c_str(), text.length()); }
+  unsigned char concat(const char *text) { return text ? concat(text, strlen(text)) : 0; }
+  unsigned char concat(const char *text, size_t length)
+  {
+    _text.append(text, length);
+    return 1;
+  }
+  unsigned char concat(char value)
+  {
+    _text.push_back(value);
+    return 1;
+  }
+  unsigned char concat(int value) { return concat(String(value)); }
+  unsigned char concat(unsigned int value) { return concat(String(value)); }
+  unsigned char concat(long value) { return concat(String(value)); }
+  unsigned char concat(unsigned long value) { return concat(String(value)); }
+
+  template <typename T>
+  String &operator+=(const T &value)
+  {
+    concat(value);
+    return *this;
+  }
+
+  const char *c_str() const { return _text.c_str(); }
+  unsigned int length() const { return static_cast<unsigned int>(_text.size()); }
+  bool reserve(unsigned int size)
+  {
+    _text.reserve(size);
+    return true;
+  }
+  char operator[](unsigned int index) const { return index < _text.size() ? _text[index] : '\0'; }
+  char charAt(unsigned int index) const { return (*this)[index]; }
+
+  bool equals(const char *text) const { return text && _text == text; }
+  bool operator==(const String &other) const { return _text == other._text; }
+  bool operator==(const char *text) const { return equals(text); }
+  bool operator!=(const String &other) const { return !(*this == other); }
+  bool operator!=(const char *text) const { return !equals(text); }
+  bool startsWith(const char *prefix) const { return prefix && _text.compare(0, strlen(prefix), prefix) == 0; }
+  int indexOf(char value, unsigned int from = 0) const;
+  String substring(unsigned int from, unsigned int to = ~0u) const;
+  long toInt() const { return strtol(_text.c_str(), nullptr, 10); }
+
+private:
+  std::string _text;
+};
+
+class StringSumHelper : public String
+{
+public:
+  StringSumHelper(const String &text) : String(text) {}
+  StringSumHelper(const char *text) : String(text) {}
+};
+
+StringSumHelper &operator+(const StringSumHelper &lhs, const String &rhs);
+StringSumHelper &operator+(const StringSumHelper &lhs, const char *rhs);
+StringSumHelper &operator+(const StringSumHelper &lhs, char rhs);
+StringSumHelper &operator+(const StringSumHelper &lhs, int rhs);
+StringSumHelper &operator+(const StringSumHelper &lhs, unsigned long rhs);
+
+#endif // SENTIENT_HOST_WSTRING_H
@@ -0,0 +1,33 @@
+#ifndef SENTIENT_HOST_FNET_H
+#define SENTIENT_HOST_FNET_H
+
+// Name services are not simulated: init succeeds and polling does nothing
+
+#ifndef AF_INET
+#define AF_INET 2
+#endif
+
+using fnet_netif_desc_t = void *;
+using fnet_mdns_desc_t = void *;
+using fnet_llmnr_desc_t = void *;
+
+struct fnet_mdns_params_t
+{
+  fnet_netif_desc_t netif_desc = nullptr;
+  int addr_family = 0;
+  const char *name = nullptr;
+};
+
+struct fnet_llmnr_params_t
+{
+  fnet_netif_desc_t netif_desc = nullptr;
+  int addr_family = 0;
+  const char *host_name = nullptr;
+};
+
+fnet_netif_desc_t fnet_netif_get_default();
+fnet_mdns_desc_t fnet_mdns_init(const fnet_mdns_params_t *params);
+fnet_llmnr_desc_t fnet_llmnr_init(const fnet_llmnr_params_t *params);
+void fnet_service_poll();
+
+#endif // SENTIENT_HOST_FNET_H
@@ -0,0 +1,82 @@
+/*
+ * ControllerFixture - a SentientMQTT controller connected to a FakeBroker,
+ * driven under virtual time. Shared by the host tests and benchmarks.
+ *
+ * Publish lanes keep the library default (unlimited); tests that exercise
+ * rate limiting set config.laneBudgets before start().
+ */
+
+#ifndef SENTIENT_HOST_CONTROLLER_FIXTURE_H
+#define SENTIENT_HOST_CONTROLLER_FIXTURE_H
+
+#include <FakeBroker.h>
+#include <SentientMQTT.h>
+
+#include <memory>
+
+class ControllerFixture
+{
+public:
+  static constexpr const char *kTopicRoot = "paragon/room1";
+
+  ControllerFixture() : broker(IPAddress(10, 0, 0, 1))
+  {
+    HostClock::useVirtualTime(true);
+    Ethernet.setLinkStatus(LinkON);
+    EthernetUDP::setDnsDelayMs(0);
+    config.brokerIp = IPAddress(10, 0, 0, 1);
+    config.roomId = "room1";
+    config.puzzleId = "ctrl";
+    config.deviceId = "dev";
+    config.displayName = "Host Controller";
+  }
+
+  bool start()
+  {
+    mqtt.reset(new SentientMQTT(config));
+    return mqtt->begin() && pumpUntilConnected();
+  }
+
+  // Runs loop() until the session is up and subscribed; false after `maxLoops`
+  bool pumpUntilConnected(int maxLoops = 50)
+  {
+    for (int i = 0; i < maxLoops; ++i)
+    {
+      pump();
+      if (mqtt->isConnected() && broker.sessions() == 1 && mqtt->outboundQueue().empty())
+      {
+        pump(); // Completes the subscribe stage
+        return mqtt->isConnected();
+      }
+    }
+    return false;
+  }
+
+  void pump(int loops = 1, uint32_t stepUs = 1000)
+  {
+    for (int i = 0; i < loops; ++i)
+    {
+      HostClock::advance(stepUs);
+      mqtt->loop();
+    }
+  }
+
+  // <namespace>/<room>/commands/<controller>/<device>/<command>
+  void sendCommand(const char *command, const char *payload)
+  {
+    char topic[160];
+    snprintf(topic, sizeof(topic), "%s/commands/ctrl/dev/%s", kTopicRoot, command);
+    broker.inject(topic, payload);
+  }
+
+  static std::string topic(const char *category, const char *item)
+  {
+    return std::string(kTopicRoot) + "/" + category + "/ctrl/dev/" + item;
+  }
+
+  FakeBroker broker;
+  SentientMQTTConfig config;
+  std::unique_ptr<SentientMQTT> mqtt;
+};
+
+#endif // SENTIENT_HOST_CONTROLLER_FIXTURE_H
@@ -0,0 +1,119 @@
+/*
+ * HostTest - minimal test registry for the host build.
+ *
+ *   HOST_TEST(publishes_state) { CHECK(mqtt.publishState("idle")); }
+ *
+ * Every test runs in registration order; a failed CHECK reports file:line and
+ * ends that test. main() (HOST_TEST_MAIN) returns non-zero if any test failed,
+ * which is what ctest looks at.
+ */
+
+#ifndef SENTIENT_HOST_TEST_H
+#define SENTIENT_HOST_TEST_H
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+namespace host_test
+{
+  struct Failure
+  {
+  };
+
+  struct Case
+  {
+    const char *name;
+    void (*run)();
+  };
+
+  inline std::vector<Case> &cases()
+  {
+    static std::vector<Case> registered;
+    return registered;
+  }
+
+  struct Registrar
+  {
+    Registrar(const char *name, void (*run)()) { cases().push_back({name, run}); }
+  };
+
+  inline void fail(const char *file, int line, const std::string &message)
+  {
+    fprintf(stderr, "  %s:%d: %s\n", file, line, message.c_str());
+    throw Failure();
+  }
+
+  inline int runAll(int argc, char **argv)
+  {
+    const char *filter = argc > 1 ? argv[1] : nullptr;
+    int failed = 0;
+    int ran = 0;
+    for (const Case &test : cases())
+    {
+      if (filter && !strstr(test.name, filter))
+      {
+        continue;
+      }
+      ++ran;
+      try
+      {
+        test.run();
+        printf("[ OK ] %s\n", test.name);
+      }
+      catch (const Failure &)
+      {
+        ++failed;
+        printf("[FAIL] %s\n", test.name);
+      }
+    }
+    printf("%d/%d passed\n", ran - failed, ran);
+    return failed == 0 && ran > 0 ? 0 : 1;
+  }
+} // namespace host_test
+
+#define HOST_TEST(name) \
+  static void host_test_##name(); \
+  static host_test::Registrar host_test_registrar_##name(#name, host_test_##name); \
+  static void host_test_##name()
+
+#define CHECK(condition) \
+  do \
+  { \
+    if (!(condition)) \
+    { \
+      host_test::fail(__FILE__, __LINE__, "CHECK(" #condition ")"); \
+    } \
+  } while (0)
+
+#define CHECK_EQ(expected, actual) \
+  do \
+  { \
+    const auto &host_test_expected = (expected); \
+    const auto &host_test_actual = (actual); \
+    if (!(host_test_expected == host_test_actual)) \
+    { \
+      host_test::fail(__FILE__, __LINE__, "CHECK_EQ(" #expected ", " #actual ")"); \
+    } \
+  } while (0)
+
+#define CHECK_STR(expected, actual) \
+  do \
+  { \
+    const std::string host_test_expected = (expected); \
+    const std::string host_test_actual = (actual); \
+    if (host_test_expected != host_test_actual) \
+    { \
+      host_test::fail(__FILE__, __LINE__, "expected \"" + host_test_expected + "\", got \"" + host_test_actual + "\""); \
+    } \
+  } while (0)
+
+#define HOST_TEST_MAIN() \
+  int main(int argc, char **argv) \
+  { \
+    return host_test::runAll(argc, argv); \
+  }
+
+#endif // SENTIENT_HOST_TEST_H
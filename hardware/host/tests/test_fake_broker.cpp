@@ -0,0 +1,99 @@
+// The broker and PubSubClient shims themselves: topic filters, retained delivery, packet framing
+
+#include <FakeBroker.h>
+#include <NativeEthernet.h>
+#include <PubSubClient.h>
+
+#include "HostTest.h"
+
+namespace
+{
+  std::string lastTopic;
+  std::string lastPayload;
+
+  void capture(char *topic, uint8_t *payload, unsigned int length)
+  {
+    lastTopic = topic;
+    lastPayload.assign(reinterpret_cast<const char *>(payload), length);
+  }
+} // namespace
+
+HOST_TEST(topic_filters_match_like_mosquitto)
+{
+  CHECK(FakeBroker::topicMatches("a/b", "a/b"));
+  CHECK(!FakeBroker::topicMatches("a/b", "a/b/c"));
+  CHECK(!FakeBroker::topicMatches("a/b/c", "a/b"));
+  CHECK(FakeBroker::topicMatches("a/+/c", "a/x/c"));
+  CHECK(!FakeBroker::topicMatches("a/+", "a/x/c"));
+  CHECK(FakeBroker::topicMatches("a/#", "a"));
+  CHECK(FakeBroker::topicMatches("a/#", "a/x/y"));
+  CHECK(FakeBroker::topicMatches("#", "anything/at/all"));
+  CHECK(FakeBroker::topicMatches("a/+", "a/"));
+}
+
+HOST_TEST(pubsubclient_round_trip_with_retained_message)
+{
+  HostClock::useVirtualTime(true);
+  FakeBroker broker(IPAddress(10, 0, 0, 2));
+  broker.setHost("broker.local");
+  broker.inject("room/status", "ready", true);
+
+  EthernetClient socket;
+  PubSubClient client(socket);
+  client.setServer("broker.local", 1883);
+  client.setCallback(capture);
+  CHECK(client.connect("host-test", "user", "secret"));
+  CHECK_EQ(MQTT_CONNECTED, client.state());
+
+  CHECK(client.subscribe("room/#"));
+  client.loop(); // SUBACK
+  client.loop(); // Retained publish
+  CHECK_STR("room/status", lastTopic);
+  CHECK_STR("ready", lastPayload);
+
+  CHECK(client.publish("room/echo", "ping"));
+  client.loop();
+  CHECK_STR("room/echo", lastTopic);
+  CHECK_STR("ping", lastPayload);
+  CHECK_STR("host-test", broker.lastOn("room/echo")->clientId);
+
+  // Streamed publish with a multi-byte remaining length
+  const std::string body(400, 'z');
+  CHECK(client.beginPublish("room/big", body.size(), false));
+  CHECK_EQ(body.size(), client.write(reinterpret_cast<const uint8_t *>(body.data()), body.size()));
+  CHECK(client.endPublish());
+  CHECK_STR(body, broker.lastOn("room/big")->payload);
+}
+
+HOST_TEST(dropped_session_reports_connection_lost)
+{
+  HostClock::useVirtualTime(true);
+  FakeBroker broker(IPAddress(10, 0, 0, 3));
+  EthernetClient socket;
+  PubSubClient client(socket);
+  client.setServer(IPAddress(10, 0, 0, 3), 1883);
+  CHECK(client.connect("host-test"));
+  broker.dropConnections();
+  CHECK(!client.connected());
+  CHECK_EQ(MQTT_CONNECTION_LOST, client.state());
+  CHECK(!client.publish("room/x", "y"));
+}
+
+HOST_TEST(keepalive_ping_is_answered)
+{
+  HostClock::useVirtualTime(true);
+  FakeBroker broker(IPAddress(10, 0, 0, 4));
+  EthernetClient socket;
+  PubSubClient client(socket);
+  client.setServer(IPAddress(10, 0, 0, 4), 1883);
+  client.setKeepAlive(1);
+  CHECK(client.connect("host-test"));
+  for (int i = 0; i < 10; ++i)
+  {
+    HostClock::advance(700'000);
+    CHECK(client.loop());
+  }
+  CHECK(client.connected());
+}
+
+HOST_TEST_MAIN()
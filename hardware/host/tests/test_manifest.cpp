@@ -0,0 +1,562 @@
+// SentientDeviceRegistry -> SentientCapabilityManifest -> registration messages on the broker,
+// and the compile-time SentientManifestImage that has to send the same bytes
+
+#include <SentientDeviceRegistry.h>
+#include <SentientDeviceTable.h>
+#include <SentientManifestImage.h>
+
+#include "ControllerFixture.h"
+#include "HostTest.h"
+
+#include <set>
+
+namespace
+{
+  const char *kLightCommands[] = {"light_on", "light_off"};
+  const char *kDoorSensors[] = {"door_state"};
+
+  constexpr const char *kImageCommands[] = {"fire_on", "fire_off"};
+  constexpr const char *kImageSensors[] = {"lux", "color \"temp\""};
+  constexpr SentientDeviceDef kImageFire("fire", "Fire\tLEDs", "led_strip", kImageCommands, 2);
+  constexpr SentientDeviceDef kImageSensor("sensor", "Color Sensor", "sensor", kImageSensors, 2, true);
+  constexpr SentientDeviceDef kImageBoth("both", nullptr, "controller", kImageCommands, 2, kImageSensors, 1);
+  constexpr const SentientDeviceDef *kImageDevices[] = {&kImageFire, &kImageSensor, &kImageBoth};
+  constexpr SentientManifestController kImageController = {"ctrl", "Host Controller", "1.0.0", "room1", "ctrl",
+                                                           "room-uuid"};
+  SENTIENT_MANIFEST_IMAGE(kImage, kImageController, kImageDevices);
+  static_assert(decltype(kImage)::deviceCount() == 3, "one record per device");
+
+  // The same devices as a flash table, and the image rendered from it
+  SENTIENT_DEVICE_TABLE(kTable, kImageFire, kImageSensor, kImageBoth);
+  static_assert(decltype(kTable)::deviceCount() == 3, "sized by the compiler");
+  static_assert(decltype(kTable)::commandCount() == 4, "fire_on, fire_off for fire and for both");
+  static_assert(kTable.deviceHandle("both") == 2, "device handles are table positions");
+  static_assert(kTable.commandHandle("fire_off") == 1, "a shared command resolves to its first device");
+  static_assert(kTable.commandHandle(2, "fire_on") == 2, "command handles number (device, command) pairs");
+  static_assert(kTable.commandHandle(1, "fire_on") == -1, "sensor has no commands");
+  SENTIENT_MANIFEST_IMAGE(kTableImage, kImageController, kTable);
+  static_assert(sizeof(kTableImage.bytes) == sizeof(kImage.bytes), "same registration from either form");
+
+  const char *kRegisterPrefix = "sentient/system/register/";
+
+  // Two devices through the runtime manifest: three registration records
+  struct RuntimeManifest
+  {
+    SentientDeviceDef light{"light", "Ceiling Light", "relay", kLightCommands, 2};
+    SentientDeviceDef door{"door", "Door Sensor", "sensor", kDoorSensors, 1, true};
+    SentientDeviceRegistry registry;
+    SentientCapabilityManifest manifest;
+
+    RuntimeManifest()
+    {
+      registry.addDevice(&light);
+      registry.addDevice(&door);
+      manifest.set_controller_info("ctrl", "Host Controller", "1.0.0", "room1", "ctrl");
+      registry.buildManifest(manifest);
+    }
+  };
+
+  JsonDocument parse(const std::string &payload)
+  {
+    JsonDocument doc;
+    deserializeJson(doc, payload);
+    return doc;
+  }
+
+  // Collects a record written through SentientRegistrationSource::writeRecord()
+  struct StringPrint : Print
+  {
+    size_t write(uint8_t byte) override
+    {
+      text += static_cast<char>(byte);
+      return 1;
+    }
+    const std::string &str() const { return text; }
+    std::string text;
+  };
+
+  // Stand-in for the backend: asks for the records of an unknown fingerprint,
+  // and knows the manifest once its controller record has arrived
+  struct FingerprintResponder
+  {
+    explicit FingerprintResponder(ControllerFixture &fixture) : fixture(fixture) {}
+
+    void pump(int loops = 1, uint32_t stepUs = 1000)
+    {
+      for (int i = 0; i < loops; ++i)
+      {
+        fixture.pump(1, stepUs);
+        answer();
+      }
+    }
+
+    void answer()
+    {
+      const auto &published = fixture.broker.published();
+      for (; seen < published.size(); ++seen)
+      {
+        const FakeBroker::Message &message = published[seen];
+        if (message.topic == ControllerFixture::topic("register", "fingerprint"))
+        {
+          const std::string hash = parse(message.payload)["manifest_hash"] | "";
+          if (known.count(hash))
+          {
+            fixture.sendCommand("manifest_known", ("{\"manifest_hash\":\"" + hash + "\"}").c_str());
+          }
+          else
+          {
+            requested = hash;
+            fixture.sendCommand("send_manifest", "{}");
+          }
+        }
+        else if (message.topic == "sentient/system/register/controller")
+        {
+          known.insert(requested);
+        }
+      }
+    }
+
+    ControllerFixture &fixture;
+    std::set<std::string> known;
+    std::string requested;
+    size_t seen = 0;
+  };
+} // namespace
+
+HOST_TEST(registry_builds_manifest)
+{
+  SentientDeviceDef light("light", "Ceiling Light", "relay", kLightCommands, 2);
+  SentientDeviceDef door("door", "Door Sensor", "sensor", kDoorSensors, 1, true);
+  SentientDeviceRegistry registry;
+  CHECK(registry.addDevice(&light));
+  CHECK(registry.addDevice(&door));
+
+  SentientCapabilityManifest manifest;
+  registry.buildManifest(manifest);
+  JsonObject root = manifest.getManifest();
+  CHECK_EQ(size_t(2), root["devices"].size());
+  CHECK_STR("light_on", root["devices"][0]["device_command_name"] | "");
+  CHECK_STR("input", root["devices"][1]["device_category"] | "");
+  CHECK_EQ(size_t(3), root["mqtt_topics_publish"].size());
+  CHECK_STR("commands/light_off", root["mqtt_topics_publish"][1]["topic"] | "");
+  CHECK_STR("sensors/door_state", root["mqtt_topics_publish"][2]["topic"] | "");
+}
+
+HOST_TEST(registry_lookups)
+{
+  SentientDeviceDef light("light", "Ceiling Light", "relay", kLightCommands, 2);
+  SentientDeviceRegistry registry(1);
+  CHECK(registry.addDevice(&light));
+  CHECK(!registry.addDevice(&light));
+  CHECK(registry.findDevice("light") == &light);
+  CHECK(registry.findDevice("door") == nullptr);
+  CHECK(registry.isValidCommand("light_off"));
+  CHECK(!registry.isValidCommand("door_state"));
+}
+
+HOST_TEST(registry_handles)
+{
+  // More devices and commands than the initial index holds, so the command index rehashes
+  std::vector<std::string> names;
+  for (int i = 0; i < 40; ++i)
+  {
+    names.push_back("device_" + std::to_string(i));
+    names.push_back("device_" + std::to_string(i) + "_on");
+  }
+  std::vector<const char *> commands;
+  for (int i = 0; i < 40; ++i)
+  {
+    commands.push_back(names[i * 2 + 1].c_str());
+  }
+  std::vector<SentientDeviceDef> devices;
+  for (int i = 0; i < 40; ++i)
+  {
+    devices.emplace_back(names[i * 2].c_str(), "Device", "relay", &commands[i], 1);
+  }
+  SentientDeviceDef shared("shared", "Shared", "relay", kLightCommands, 2);
+  SentientDeviceDef again("again", "Again", "relay", kLightCommands, 2);
+
+  SentientDeviceRegistry registry(42);
+  for (const SentientDeviceDef &device : devices)
+  {
+    CHECK(registry.addDevice(&device));
+  }
+  CHECK(registry.addDevice(&shared));
+  CHECK(registry.addDevice(&again));
+  CHECK_EQ(44, registry.getCommandCount());
+
+  for (int i = 0; i < 40; ++i)
+  {
+    CHECK_EQ(i, registry.deviceHandle(names[i * 2].c_str()));
+    CHECK_EQ(i, registry.commandHandle(commands[i]));
+    CHECK_EQ(i, registry.commandDevice(i));
+  }
+  CHECK_EQ(-1, registry.deviceHandle("device_40"));
+  CHECK_EQ(-1, registry.commandHandle(0, "device_1_on"));
+
+  // Duplicate command names stay apart per device; an unqualified lookup finds the first
+  CHECK_EQ(41, registry.commandHandle("light_off"));
+  CHECK_EQ(43, registry.commandHandle(41, "light_off"));
+  CHECK_EQ(41, registry.commandDevice(43));
+  CHECK_STR("light_off", registry.commandName(43));
+}
+
+HOST_TEST(registration_publishes_controller_then_devices)
+{
+  ControllerFixture fixture;
+  CHECK(fixture.start());
+
+  SentientDeviceDef light("light", "Ceiling Light", "relay", kLightCommands, 2);
+  SentientDeviceDef door("door", "Door Sensor", "sensor", kDoorSensors, 1, true);
+  SentientDeviceRegistry registry;
+  registry.addDevice(&light);
+  registry.addDevice(&door);
+  SentientCapabilityManifest manifest;
+  manifest.set_controller_info("ctrl", "Host Controller", "1.0.0", "room1", "ctrl");
+  registry.buildManifest(manifest);
+
+  fixture.broker.clearPublished();
+  CHECK(manifest.publish_registration(fixture.mqtt->get_client(), "room-uuid"));
+
+  const auto &published = fixture.broker.published();
+  CHECK_EQ(size_t(3), published.size());
+  CHECK_STR("sentient/system/register/controller", published[0].topic);
+  JsonDocument controller = parse(published[0].payload);
+  CHECK_STR("room-uuid", controller["room_id"] | "");
+  CHECK_EQ(2, controller["device_count"] | 0);
+
+  CHECK_STR("sentient/system/register/device", published[1].topic);
+  JsonDocument device = parse(published[1].payload);
+  CHECK_STR("light", device["device_id"] | "");
+  CHECK_EQ(size_t(2), device["mqtt_topics"].size());
+  CHECK_EQ(1, parse(published[2].payload)["device_index"] | -1);
+}
+
+HOST_TEST(device_table_lookups)
+{
+  CHECK(kTable.findDevice("sensor") == &kTable[1]);
+  CHECK(kTable.findDevice("light") == nullptr);
+  CHECK(kTable.getDevice(2) == &kTable[2]);
+  CHECK(kTable.getDevice(3) == nullptr);
+  CHECK(kTable.isValidCommand("fire_off"));
+  CHECK(!kTable.isValidCommand("lux"));
+  CHECK_EQ(1, kTable.deviceHandle("sensor"));
+  CHECK_EQ(3, kTable.commandHandle(2, "fire_off"));
+  CHECK_EQ(2, kTable.commandDevice(3));
+  CHECK_STR("fire_off", kTable.commandName(3));
+  CHECK_EQ(0, memcmp(kTable.begin()->commands, kImageCommands, sizeof(kImageCommands)));
+  CHECK_EQ(0, memcmp(kTableImage.bytes, kImage.bytes, sizeof(kImage.bytes)));
+  CHECK_EQ(kImage.hash, kTableImage.hash);
+
+  // A runtime manifest built from the table matches one built by the registry
+  SentientDeviceRegistry registry;
+  for (const SentientDeviceDef *device : kImageDevices)
+  {
+    registry.addDevice(device);
+  }
+  SentientCapabilityManifest fromRegistry;
+  SentientCapabilityManifest fromTable;
+  registry.buildManifest(fromRegistry);
+  kTable.buildManifest(fromTable);
+  CHECK_STR(fromRegistry.toJson().c_str(), fromTable.toJson().c_str());
+}
+
+HOST_TEST(device_topics_join_by_device_id)
+{
+  SentientCapabilityManifest manifest;
+  manifest.set_controller_info("ctrl", "Host Controller", "1.0.0", "room1", "ctrl");
+  manifest.add_device("light", "Ceiling Light", "relay", "actuator");
+  manifest.add_device("door", "Door Sensor", "sensor", "sensor");
+  manifest.add_device_topic("door", "sensors/door_state", "sensor");
+  manifest.add_device_topic("light", "commands/light_on", "command");
+  manifest.add_device_topic("light", "commands/light_off", "command");
+
+  // Each device gets its own topics, in the order they were added
+  StringPrint light;
+  manifest.writeRecord(1, light);
+  JsonDocument record = parse(light.str());
+  CHECK_EQ(size_t(2), record["mqtt_topics"].size());
+  CHECK_STR("commands/light_off", record["mqtt_topics"][1]["topic"] | "");
+  CHECK_EQ(light.str().size(), manifest.recordLength(1));
+
+  // A topic added before its device still reaches it
+  manifest.add_device_topic("fog", "commands/fog_on", "command");
+  manifest.add_device("fog", "Fog Machine", "relay", "actuator");
+  StringPrint door;
+  manifest.writeRecord(2, door);
+  CHECK_EQ(size_t(1), parse(door.str())["mqtt_topics"].size());
+  StringPrint fog;
+  manifest.writeRecord(3, fog);
+  CHECK_STR("commands/fog_on", parse(fog.str())["mqtt_topics"][0]["topic"] | "");
+}
+
+HOST_TEST(indexed_registration_matches_record_scan)
+{
+  // publish_registration() joins topics through the pass's index; writeRecord() outside a pass scans. Same bytes either way,
+  // including a topic added before its device and two devices sharing an id (index skipped).
+  ControllerFixture fixture;
+  CHECK(fixture.start());
+  for (bool shared_id : {false, true})
+  {
+    SentientCapabilityManifest manifest;
+    manifest.set_controller_info("ctrl", "Host Controller", "1.0.0", "room1", "ctrl");
+    manifest.add_device_topic("fog", "commands/fog_on", "command");
+    manifest.add_device("light", "Ceiling Light", "relay", "actuator");
+    manifest.add_device("fog", "Fog Machine", "relay", "actuator");
+    manifest.add_device_topic("light", "commands/light_on", "command");
+    manifest.addPublishTopic("sensors/ambient", "sensor");
+    manifest.add_device_topic("fog", "commands/fog_off", "command");
+    if (shared_id)
+    {
+      manifest.add_device("light", "Spare Light", "relay", "actuator");
+    }
+
+    fixture.broker.clearPublished();
+    CHECK(manifest.publish_registration(fixture.mqtt->get_client(), "room-uuid"));
+    const auto &published = fixture.broker.published();
+    CHECK_EQ(manifest.recordCount(), published.size());
+    for (size_t i = 0; i < published.size(); ++i)
+    {
+      StringPrint scanned;
+      manifest.writeRecord(i, scanned);
+      CHECK_STR(scanned.str(), published[i].payload);
+    }
+    CHECK_EQ(size_t(2), parse(published[2].payload)["mqtt_topics"].size());
+
+    // The pass setRegistration() runs: recordLength() then writeRecord(), both from the pass's index
+    manifest.beginRecords();
+    for (size_t i = 0; i < published.size(); ++i)
+    {
+      StringPrint passed;
+      CHECK_EQ(published[i].payload.size(), manifest.recordLength(i));
+      manifest.writeRecord(i, passed);
+      CHECK_STR(published[i].payload, passed.str());
+    }
+    // A device added mid-pass shows in the records that follow
+    manifest.add_device("late", "Late Relay", "relay", "actuator");
+    manifest.add_device_topic("late", "commands/late_on", "command");
+    StringPrint late;
+    manifest.writeRecord(manifest.recordCount() - 1, late);
+    manifest.endRecords();
+    CHECK_EQ(size_t(1), parse(late.str())["mqtt_topics"].size());
+  }
+}
+
+HOST_TEST(manifest_image_matches_runtime_registration)
+{
+  ControllerFixture fixture;
+  CHECK(fixture.start());
+
+  SentientDeviceRegistry registry;
+  for (const SentientDeviceDef *device : kImageDevices)
+  {
+    registry.addDevice(device);
+  }
+  SentientCapabilityManifest manifest;
+  manifest.set_controller_info(kImageController.unique_id, kImageController.friendly_name,
+                               kImageController.firmware_version, kImageController.room_id,
+                               kImageController.controller_id);
+  registry.buildManifest(manifest);
+
+  fixture.broker.clearPublished();
+  CHECK(manifest.publish_registration(fixture.mqtt->get_client(), "room-uuid"));
+  const auto expected = fixture.broker.published();
+  fixture.broker.clearPublished();
+  CHECK(kImage.publish_registration(fixture.mqtt->get_client()));
+  const auto &actual = fixture.broker.published();
+
+  CHECK_EQ(size_t(4), expected.size());
+  CHECK_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size() && i < actual.size(); ++i)
+  {
+    CHECK_STR(expected[i].topic, actual[i].topic);
+    CHECK_STR(expected[i].payload, actual[i].payload);
+  }
+  size_t length = 0;
+  kImage.record(0, length);
+  CHECK_EQ(expected[0].payload.size(), length);
+
+  // Both sources fingerprint the same bytes: compile-time FNV-1a matches the runtime one
+  uint32_t hash = sentient_fnv::Offset;
+  for (const FakeBroker::Message &message : expected)
+  {
+    for (char c : message.payload)
+    {
+      hash = sentient_fnv::step(hash, static_cast<uint8_t>(c));
+    }
+  }
+  manifest.set_registration_room("room-uuid");
+  CHECK_EQ(hash, kImage.hash);
+  CHECK_EQ(hash, manifest.manifestHash());
+  SentientManifestImageSource source(kImage);
+  CHECK_EQ(hash, source.manifestHash());
+  CHECK_STR("ctrl", source.controllerId());
+  CHECK_STR("1.0.0", source.firmwareVersion());
+}
+
+HOST_TEST(manifest_hash_is_cached_until_the_manifest_changes)
+{
+  // Counts the records manifestHash() serializes
+  struct CountingManifest : SentientCapabilityManifest
+  {
+    size_t writes = 0;
+    void writeRecord(size_t index, Print &out) override
+    {
+      ++writes;
+      SentientCapabilityManifest::writeRecord(index, out);
+    }
+  };
+
+  CountingManifest manifest;
+  manifest.set_controller_info("ctrl", "Host Controller", "1.0.0", "room1", "ctrl");
+  manifest.add_device("light", "Ceiling Light", "relay", "actuator");
+  const uint32_t first = manifest.manifestHash();
+  const size_t writes = manifest.writes;
+  CHECK_EQ(size_t(2), writes);
+  CHECK_EQ(first, manifest.manifestHash());
+  CHECK_EQ(writes, manifest.writes);
+
+  manifest.add_device_topic("light", "commands/light_on", "command");
+  const uint32_t changed = manifest.manifestHash();
+  CHECK(changed != first);
+  CHECK_EQ(writes + 2, manifest.writes);
+  CHECK_EQ(changed, manifest.manifestHash());
+  CHECK_EQ(writes + 2, manifest.writes);
+}
+
+HOST_TEST(registration_sends_one_record_per_loop)
+{
+  ControllerFixture fixture;
+  fixture.config.registrationFingerprintTimeoutMs = 0;
+  CHECK(fixture.start());
+  RuntimeManifest runtime;
+  fixture.broker.clearPublished();
+  fixture.mqtt->setRegistration(&runtime.manifest);
+
+  size_t previous = 0;
+  for (int i = 0; i < 10; ++i)
+  {
+    fixture.pump();
+    const size_t sent = fixture.broker.countOn(kRegisterPrefix);
+    CHECK(sent - previous <= 1);
+    previous = sent;
+  }
+  CHECK_EQ(size_t(3), previous);
+  CHECK_STR("sentient/system/register/controller", fixture.broker.published()[0].topic);
+  CHECK_STR("room1", parse(fixture.broker.published()[0].payload)["room_id"] | "");
+  CHECK_EQ(1, parse(fixture.broker.lastOn("sentient/system/register/device")->payload)["device_index"] | -1);
+
+  // No fixed sleeps: three records over three 1 ms loops, not 100 + 2 * 50 ms of delay()
+  CHECK(fixture.mqtt->registration().complete());
+  CHECK_EQ(1.0f, SentientMetrics::value(SentientMetrics::gauge("registration_progress")));
+  CHECK(SentientMetrics::value(SentientMetrics::gauge("registration_ms")) < 10.0f);
+}
+
+HOST_TEST(registration_waits_for_socket_space)
+{
+  ControllerFixture fixture;
+  fixture.config.registrationFingerprintTimeoutMs = 0;
+  CHECK(fixture.start());
+  RuntimeManifest runtime;
+  fixture.broker.setClientWriteSpace(64);
+  fixture.mqtt->setRegistration(&runtime.manifest);
+  fixture.pump(5);
+  CHECK_EQ(size_t(0), fixture.broker.countOn(kRegisterPrefix));
+  CHECK(fixture.mqtt->isConnected());
+
+  fixture.broker.setClientWriteSpace(2048);
+  fixture.pump(5);
+  CHECK_EQ(size_t(3), fixture.broker.countOn(kRegisterPrefix));
+}
+
+HOST_TEST(registration_resumes_after_a_dropped_session)
+{
+  ControllerFixture fixture;
+  fixture.config.registrationFingerprintTimeoutMs = 0;
+  CHECK(fixture.start());
+  RuntimeManifest runtime;
+  fixture.broker.clearPublished();
+  fixture.mqtt->setRegistration(&runtime.manifest);
+  fixture.pump(2);
+  CHECK_EQ(size_t(2), fixture.broker.countOn(kRegisterPrefix));
+
+  fixture.broker.dropConnections();
+  fixture.pump(200, 10'000);
+  CHECK(fixture.mqtt->isConnected());
+  // Only the device that had not gone out yet; the controller record is not repeated
+  CHECK_EQ(size_t(3), fixture.broker.countOn(kRegisterPrefix));
+  CHECK_EQ(1, parse(fixture.broker.lastOn("sentient/system/register/device")->payload)["device_index"] | -1);
+  CHECK_EQ(uint32_t(1), fixture.mqtt->registration().resumes());
+  CHECK(fixture.mqtt->registration().complete());
+
+  // A finished registration is sent again in full to the next session
+  fixture.broker.dropConnections();
+  fixture.pump(200, 10'000);
+  CHECK(fixture.mqtt->isConnected());
+  CHECK_EQ(size_t(6), fixture.broker.countOn(kRegisterPrefix));
+  CHECK_EQ(uint32_t(2), fixture.mqtt->registration().completions());
+}
+
+HOST_TEST(registration_fingerprint_goes_first)
+{
+  ControllerFixture fixture;
+  CHECK(fixture.start());
+  RuntimeManifest runtime;
+  fixture.mqtt->setRegistration(&runtime.manifest);
+  fixture.pump(10);
+
+  // Nobody answers yet: only the fingerprint is out
+  CHECK_EQ(size_t(0), fixture.broker.countOn(kRegisterPrefix));
+  const FakeBroker::Message *fingerprint = fixture.broker.lastOn(ControllerFixture::topic("register", "fingerprint").c_str());
+  CHECK(fingerprint != nullptr);
+  JsonDocument doc = parse(fingerprint ? fingerprint->payload : "");
+  CHECK_STR("ctrl", doc["controller_id"] | "");
+  CHECK_STR("1.0.0", doc["firmware_version"] | "");
+  char hash[9];
+  snprintf(hash, sizeof(hash), "%08lx", static_cast<unsigned long>(runtime.manifest.manifestHash()));
+  CHECK_STR(hash, doc["manifest_hash"] | "");
+
+  // A verdict for some other manifest is ignored; no verdict at all falls back to the records
+  fixture.sendCommand("manifest_known", "{\"manifest_hash\":\"00000000\"}");
+  fixture.pump(10);
+  CHECK_EQ(size_t(0), fixture.broker.countOn(kRegisterPrefix));
+  fixture.pump(2100);
+  CHECK_EQ(size_t(3), fixture.broker.countOn(kRegisterPrefix));
+  CHECK(fixture.mqtt->registration().complete());
+  CHECK_EQ(uint32_t(0), fixture.mqtt->registration().skips());
+}
+
+HOST_TEST(registration_skipped_when_backend_knows_the_manifest)
+{
+  ControllerFixture fixture;
+  CHECK(fixture.start());
+  FingerprintResponder backend(fixture);
+  RuntimeManifest runtime;
+  fixture.mqtt->setRegistration(&runtime.manifest);
+
+  // Unknown hash: the backend asks and gets every record, well before the timeout
+  backend.pump(10);
+  CHECK_EQ(size_t(3), fixture.broker.countOn(kRegisterPrefix));
+  CHECK_EQ(uint32_t(1), fixture.mqtt->registration().completions());
+
+  // Broker restart: the same manifest is only fingerprinted
+  fixture.broker.dropConnections();
+  for (int i = 0; i < 200 && fixture.mqtt->registration().skips() == 0; ++i)
+  {
+    backend.pump(1, 10'000);
+  }
+  backend.pump(10);
+  CHECK(fixture.mqtt->isConnected());
+  CHECK_EQ(size_t(3), fixture.broker.countOn(kRegisterPrefix));
+  CHECK_EQ(size_t(2), fixture.broker.countOn(ControllerFixture::topic("register", "fingerprint").c_str()));
+  CHECK_EQ(uint32_t(1), fixture.mqtt->registration().skips());
+  CHECK(fixture.mqtt->registration().complete());
+
+  // The backend can still ask for the whole manifest at any time
+  fixture.sendCommand("send_manifest", "{}");
+  backend.pump(10);
+  CHECK_EQ(size_t(6), fixture.broker.countOn(kRegisterPrefix));
+  CHECK_EQ(uint32_t(2), fixture.mqtt->registration().completions());
+}
+
+HOST_TEST_MAIN()
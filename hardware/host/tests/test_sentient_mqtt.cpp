@@ -0,0 +1,535 @@
+// SentientMQTT against the in-process broker: connect, publish, dispatch, reconnect
+
+#include "ControllerFixture.h"
+#include "HostTest.h"
+
+#include <SentientCommandRouter.h>
+
+namespace
+{
+  struct Received
+  {
+    int calls = 0;
+    std::string command;
+    std::string value;
+    int level = -1;
+    const SentientMQTT *mqtt = nullptr; // Set to record commandDevice()
+    std::string device;
+  };
+
+  void recordCommand(const char *command, const JsonDocument &payload, void *context)
+  {
+    Received &received = *static_cast<Received *>(context);
+    ++received.calls;
+    received.command = command;
+    received.level = payload["level"] | -1;
+    received.value = payload["value"] | "";
+    if (received.mqtt)
+    {
+      received.device = received.mqtt->commandDevice();
+    }
+  }
+
+  JsonDocument parse(const std::string &payload)
+  {
+    JsonDocument doc;
+    deserializeJson(doc, payload);
+    return doc;
+  }
+
+  void countRoute(const JsonDocument &, void *context)
+  {
+    ++*static_cast<int *>(context);
+  }
+
+  // A 32-relay power panel's worth of commands: more than a single-seed table could place
+  constexpr SentientCommandRoute kPanelRoutes[] = {
+      {"relay_00_power_on", countRoute}, {"relay_00_power_off", countRoute},
+      {"relay_01_power_on", countRoute}, {"relay_01_power_off", countRoute},
+      {"relay_02_power_on", countRoute}, {"relay_02_power_off", countRoute},
+      {"relay_03_power_on", countRoute}, {"relay_03_power_off", countRoute},
+      {"relay_04_power_on", countRoute}, {"relay_04_power_off", countRoute},
+      {"relay_05_power_on", countRoute}, {"relay_05_power_off", countRoute},
+      {"relay_06_power_on", countRoute}, {"relay_06_power_off", countRoute},
+      {"relay_07_power_on", countRoute}, {"relay_07_power_off", countRoute},
+      {"relay_08_power_on", countRoute}, {"relay_08_power_off", countRoute},
+      {"relay_09_power_on", countRoute}, {"relay_09_power_off", countRoute},
+      {"relay_10_power_on", countRoute}, {"relay_10_power_off", countRoute},
+      {"relay_11_power_on", countRoute}, {"relay_11_power_off", countRoute},
+      {"relay_12_power_on", countRoute}, {"relay_12_power_off", countRoute},
+      {"relay_13_power_on", countRoute}, {"relay_13_power_off", countRoute},
+      {"relay_14_power_on", countRoute}, {"relay_14_power_off", countRoute},
+      {"relay_15_power_on", countRoute}, {"relay_15_power_off", countRoute},
+      {"relay_16_power_on", countRoute}, {"relay_16_power_off", countRoute},
+      {"relay_17_power_on", countRoute}, {"relay_17_power_off", countRoute},
+      {"relay_18_power_on", countRoute}, {"relay_18_power_off", countRoute},
+      {"relay_19_power_on", countRoute}, {"relay_19_power_off", countRoute},
+      {"relay_20_power_on", countRoute}, {"relay_20_power_off", countRoute},
+      {"relay_21_power_on", countRoute}, {"relay_21_power_off", countRoute},
+      {"relay_22_power_on", countRoute}, {"relay_22_power_off", countRoute},
+      {"relay_23_power_on", countRoute}, {"relay_23_power_off", countRoute},
+      {"relay_24_power_on", countRoute}, {"relay_24_power_off", countRoute},
+      {"relay_25_power_on", countRoute}, {"relay_25_power_off", countRoute},
+      {"relay_26_power_on", countRoute}, {"relay_26_power_off", countRoute},
+      {"relay_27_power_on", countRoute}, {"relay_27_power_off", countRoute},
+      {"relay_28_power_on", countRoute}, {"relay_28_power_off", countRoute},
+      {"relay_29_power_on", countRoute}, {"relay_29_power_off", countRoute},
+      {"relay_30_power_on", countRoute}, {"relay_30_power_off", countRoute},
+      {"relay_31_power_on", countRoute}, {"relay_31_power_off", countRoute},
+  };
+} // namespace
+
+HOST_TEST(connects_and_announces_online)
+{
+  ControllerFixture fixture;
+  CHECK(fixture.start());
+  CHECK_EQ(size_t(1), fixture.broker.sessions());
+
+  const FakeBroker::Message *online = fixture.broker.lastOn(ControllerFixture::topic("status", "connection").c_str());
+  CHECK(online != nullptr);
+  CHECK(online->retain);
+  CHECK_STR("online", parse(online->payload)["state"] | "");
+  CHECK_EQ(MQTT_CONNECTED, fixture.mqtt->get_client().state());
+}
+
+HOST_TEST(refused_connack_backs_off_and_retries)
+{
+  ControllerFixture fixture;
+  fixture.broker.setConnackCode(MQTT_CONNECT_BAD_CREDENTIALS);
+  fixture.mqtt.reset(new SentientMQTT(fixture.config));
+  CHECK(fixture.mqtt->begin());
+  fixture.pump(20);
+  CHECK(!fixture.mqtt->isConnected());
+  CHECK_EQ(size_t(0), fixture.broker.connectsAccepted());
+
+  fixture.broker.setConnackCode(0);
+  fixture.pump(100, 10'000);
+  CHECK(fixture.mqtt->isConnected());
+}
+
+HOST_TEST(broker_host_is_looked_up_once_per_ttl)
+{
+  ControllerFixture fixture;
+  fixture.broker.setHost("broker.test");
+  fixture.broker.setConnackCode(MQTT_CONNECT_BAD_CREDENTIALS);
+  fixture.config.brokerIp = IPAddress();
+  fixture.config.brokerHost = "broker.test";
+  fixture.config.brokerHostTtlMs = 60'000;
+  fixture.mqtt.reset(new SentientMQTT(fixture.config));
+  CHECK(fixture.mqtt->begin());
+
+  // Refusals say nothing about the address: every retry reuses the first answer
+  const size_t lookupsBefore = EthernetUDP::dnsQueries();
+  fixture.pump(1'000, 10'000);
+  CHECK(!fixture.mqtt->isConnected());
+  CHECK(fixture.broker.connectAttempts() > 3);
+  CHECK_EQ(lookupsBefore + 1, EthernetUDP::dnsQueries());
+
+  fixture.broker.setConnackCode(0);
+  fixture.pump(100, 100'000);
+  CHECK(fixture.mqtt->isConnected());
+  CHECK_EQ(lookupsBefore + 1, EthernetUDP::dnsQueries());
+
+  // Past the TTL the next connect looks the host up again
+  fixture.pump(600, 100'000);
+  fixture.broker.dropConnections();
+  fixture.pump(100, 10'000);
+  CHECK(fixture.mqtt->isConnected());
+  CHECK_EQ(lookupsBefore + 2, EthernetUDP::dnsQueries());
+}
+
+HOST_TEST(broker_lookup_runs_beside_the_connect)
+{
+  ControllerFixture fixture;
+  fixture.broker.setHost("broker.test");
+  fixture.config.brokerIp = IPAddress();
+  fixture.config.brokerHost = "broker.test";
+  fixture.config.brokerHostTtlMs = 60'000;
+  EthernetUDP::setDnsDelayMs(EthernetUDP::NeverAnswers);
+  fixture.mqtt.reset(new SentientMQTT(fixture.config));
+  CHECK(fixture.mqtt->begin());
+
+  // A DNS server that never answers: loop() keeps its pace and the query is re-sent, but nothing connects
+  const size_t queriesBefore = EthernetUDP::dnsQueries();
+  const unsigned long startMs = millis();
+  fixture.pump(5'000);
+  CHECK_EQ(5'000ul, millis() - startMs);
+  CHECK(!fixture.mqtt->isConnected());
+  CHECK_EQ(size_t(0), fixture.broker.connectAttempts());
+  CHECK(EthernetUDP::dnsQueries() - queriesBefore >= SentientDnsLookup::kAttempts);
+
+  // Answers a few milliseconds late: the first connect waits for one
+  EthernetUDP::setDnsDelayMs(5);
+  fixture.pump(10'000);
+  CHECK(fixture.mqtt->isConnected());
+
+  // Past the TTL with DNS silent again, the reconnect uses the cached address while the refresh is out
+  EthernetUDP::setDnsDelayMs(EthernetUDP::NeverAnswers);
+  fixture.pump(61, 1'000'000);
+  const size_t queriesBeforeRefresh = EthernetUDP::dnsQueries();
+  fixture.broker.dropConnections();
+  fixture.pump(1'000);
+  CHECK(fixture.mqtt->isConnected());
+  CHECK(EthernetUDP::dnsQueries() > queriesBeforeRefresh);
+}
+
+HOST_TEST(silent_broker_does_not_stall_loop)
+{
+  ControllerFixture fixture;
+  fixture.broker.setHandshakeMs(FakeBroker::NeverAnswers);
+  fixture.mqtt.reset(new SentientMQTT(fixture.config));
+  CHECK(fixture.mqtt->begin());
+
+  // Ten seconds of a broker host that is down: the TCP connect is retried in slices that
+  // start at the step budget, and no single one outlasts the attempt
+  uint64_t worstLoopUs = 0;
+  size_t budgetLoops = 0;
+  for (int i = 0; i < 10'000; ++i)
+  {
+    HostClock::advance(1000);
+    const uint64_t startUs = HostClock::nowMicros();
+    fixture.mqtt->loop();
+    const uint64_t loopUs = HostClock::nowMicros() - startUs;
+    worstLoopUs = loopUs > worstLoopUs ? loopUs : worstLoopUs;
+    budgetLoops += loopUs <= fixture.config.connectStepBudgetUs ? 1 : 0;
+  }
+  CHECK(!fixture.mqtt->isConnected());
+  CHECK(worstLoopUs <= fixture.config.connectTimeoutMs * 1000u);
+  CHECK(budgetLoops > 9'900);
+  CHECK(fixture.broker.connectAttempts() > 10);
+
+  // A broker whose handshake takes many slices still connects
+  fixture.broker.setHandshakeMs(50);
+  fixture.pump(1'000, 10'000);
+  CHECK(fixture.mqtt->isConnected());
+}
+
+HOST_TEST(publish_sensor_reaches_broker)
+{
+  ControllerFixture fixture;
+  CHECK(fixture.start());
+  CHECK(fixture.mqtt->publishSensor("temperature", 21.5f, "C"));
+
+  const FakeBroker::Message *message =
+      fixture.broker.lastOn(ControllerFixture::topic("sensors", "temperature").c_str());
+  CHECK(message != nullptr);
+  JsonDocument doc = parse(message->payload);
+  CHECK_EQ(21.5f, doc["value"].as<float>());
+  CHECK_STR("C", doc["unit"] | "");
+}
+
+HOST_TEST(lane_overflow_is_counted_not_silent)
+{
+  ControllerFixture fixture;
+  fixture.config.laneBudgets[SentientPublishLanes::Sensors] = {1, 1};
+  CHECK(fixture.start());
+  const SentientMetrics::Id dropped = SentientMetrics::counter("publishes_dropped");
+  const uint32_t droppedBefore = SentientMetrics::count(dropped);
+  fixture.broker.clearPublished();
+
+  // One token, then distinct topics pile up in the queue until it has to evict
+  char name[16];
+  for (int i = 0; i < SENTIENT_MQTT_QUEUE_SLOTS + 4; ++i)
+  {
+    snprintf(name, sizeof(name), "probe_%d", i);
+    CHECK(fixture.mqtt->publishSensor(name, static_cast<float>(i)));
+  }
+  CHECK_EQ(size_t(1), fixture.broker.countOn(ControllerFixture::topic("sensors", "").c_str()));
+  CHECK_EQ(droppedBefore + 3, SentientMetrics::count(dropped));
+  CHECK_EQ(uint32_t(3), fixture.mqtt->outboundQueue().stats().evicted);
+
+  // The queued values still go out, one per second as the lane refills
+  fixture.pump(200, 100'000);
+  CHECK_EQ(size_t(1 + SENTIENT_MQTT_QUEUE_SLOTS), fixture.broker.countOn(ControllerFixture::topic("sensors", "").c_str()));
+}
+
+HOST_TEST(payload_larger_than_client_buffer_is_streamed)
+{
+  ControllerFixture fixture;
+  CHECK(fixture.start());
+
+  JsonDocument doc;
+  std::string filler(3000, 'x');
+  doc["blob"] = filler.c_str();
+  CHECK(measureJson(doc) > fixture.mqtt->get_client().getBufferSize());
+  CHECK(fixture.mqtt->publishJson("diagnostics", "blob", doc));
+
+  const FakeBroker::Message *message = fixture.broker.lastOn(ControllerFixture::topic("diagnostics", "blob").c_str());
+  CHECK(message != nullptr);
+  std::string expected;
+  serializeJson(doc, expected);
+  CHECK_STR(expected, message->payload);
+}
+
+namespace
+{
+  std::string largePayload(JsonDocument &doc, char fill)
+  {
+    const std::string filler(3000, fill);
+    doc["blob"] = filler.c_str();
+    std::string serialized;
+    serializeJson(doc, serialized);
+    return serialized;
+  }
+} // namespace
+
+HOST_TEST(streamed_publish_waits_for_its_lane)
+{
+  ControllerFixture fixture;
+  fixture.config.laneBudgets[SentientPublishLanes::State] = {1, 1};
+  CHECK(fixture.start());
+  fixture.pump(20, 100'000); // Refill after the connect-time state publishes
+  fixture.broker.clearPublished();
+  const std::string topic = ControllerFixture::topic("diagnostics", "blob");
+
+  JsonDocument doc;
+  largePayload(doc, 'a');
+  CHECK(fixture.mqtt->publishJson("diagnostics", "blob", doc));
+  CHECK_EQ(size_t(1), fixture.broker.countOn(topic.c_str()));
+
+  // Out of tokens: held back, and a newer value for the same topic replaces the waiting one
+  largePayload(doc, 'b');
+  CHECK(fixture.mqtt->publishJson("diagnostics", "blob", doc));
+  const std::string latest = largePayload(doc, 'c');
+  CHECK(fixture.mqtt->publishJson("diagnostics", "blob", doc));
+  CHECK_EQ(size_t(1), fixture.broker.countOn(topic.c_str()));
+  CHECK_EQ(uint32_t(1), fixture.mqtt->publishLanes().stats(SentientPublishLanes::State).deferred);
+
+  // A second large topic cannot take the slot while it is busy
+  CHECK(!fixture.mqtt->publishJson("diagnostics", "other", doc));
+
+  fixture.pump(20, 100'000);
+  CHECK_EQ(size_t(2), fixture.broker.countOn(topic.c_str()));
+  CHECK_STR(latest, fixture.broker.lastOn(topic.c_str())->payload);
+}
+
+HOST_TEST(streamed_publish_waits_for_socket_room)
+{
+  ControllerFixture fixture;
+  CHECK(fixture.start());
+  const std::string topic = ControllerFixture::topic("diagnostics", "blob");
+
+  // A nearly full TX buffer defers the stream instead of stalling loop() on it
+  fixture.broker.setClientWriteSpace(64);
+  JsonDocument doc;
+  const std::string expected = largePayload(doc, 'a');
+  CHECK(fixture.mqtt->publishJson("diagnostics", "blob", doc));
+  fixture.pump(5);
+  CHECK_EQ(size_t(0), fixture.broker.countOn(topic.c_str()));
+  CHECK(fixture.mqtt->isConnected());
+
+  fixture.broker.setClientWriteSpace(2048);
+  fixture.pump();
+  CHECK_EQ(size_t(1), fixture.broker.countOn(topic.c_str()));
+  CHECK_STR(expected, fixture.broker.lastOn(topic.c_str())->payload);
+}
+
+HOST_TEST(streamed_publish_survives_a_dropped_session)
+{
+  ControllerFixture fixture;
+  CHECK(fixture.start());
+  const std::string topic = ControllerFixture::topic("diagnostics", "blob");
+
+  fixture.broker.dropConnections();
+  fixture.pump();
+  CHECK(!fixture.mqtt->isConnected());
+  JsonDocument doc;
+  const std::string expected = largePayload(doc, 'a');
+  CHECK(fixture.mqtt->publishJson("diagnostics", "blob", doc));
+
+  fixture.pump(50, 100'000);
+  CHECK(fixture.mqtt->isConnected());
+  CHECK_EQ(size_t(1), fixture.broker.countOn(topic.c_str()));
+  CHECK_STR(expected, fixture.broker.lastOn(topic.c_str())->payload);
+}
+
+HOST_TEST(commands_dispatch_to_callback)
+{
+  ControllerFixture fixture;
+  Received received;
+  CHECK(fixture.start());
+  fixture.mqtt->setCommandCallback(recordCommand, &received);
+
+  fixture.sendCommand("set_level", "{\"level\":7}");
+  fixture.pump();
+  CHECK_EQ(1, received.calls);
+  CHECK_STR("set_level", received.command);
+  CHECK_EQ(7, received.level);
+
+  // Plain text is handed over as {"value": text}
+  fixture.sendCommand("say", "hello");
+  fixture.pump();
+  CHECK_EQ(2, received.calls);
+  CHECK_STR("hello", received.value);
+}
+
+HOST_TEST(commands_report_their_device)
+{
+  ControllerFixture fixture;
+  Received received;
+  CHECK(fixture.start());
+  received.mqtt = fixture.mqtt.get();
+  fixture.mqtt->setCommandCallback(recordCommand, &received);
+
+  fixture.sendCommand("set_level", "{\"level\":7}");
+  fixture.pump();
+  CHECK_EQ(1, received.calls);
+  CHECK_STR("set_level", received.command);
+  CHECK_STR("dev", received.device);
+  CHECK_STR("", fixture.mqtt->commandDevice());
+
+  // commands/<controller>/<command> carries no device
+  fixture.broker.inject((std::string(ControllerFixture::kTopicRoot) + "/commands/ctrl/reset").c_str(), "{}");
+  fixture.pump();
+  CHECK_EQ(2, received.calls);
+  CHECK_STR("reset", received.command);
+  CHECK_STR("", received.device);
+}
+
+HOST_TEST(command_arena_is_sized_from_config)
+{
+  // A command larger than the configured arena still parses; the excess spills to the heap
+  ControllerFixture fixture;
+  fixture.config.commandJsonCapacity = 256;
+  fixture.config.clientBufferSize = 2048;
+  Received received;
+  CHECK(fixture.start());
+  fixture.mqtt->setCommandCallback(recordCommand, &received);
+
+  std::string payload = "{\"level\":3,\"steps\":[";
+  for (int i = 0; i < 100; ++i)
+  {
+    payload += (i ? ",\"" : "\"") + std::string("step_") + std::to_string(i) + "\"";
+  }
+  payload += "]}";
+  fixture.sendCommand("run_sequence", payload.c_str());
+  fixture.pump();
+  CHECK_EQ(1, received.calls);
+  CHECK_EQ(3, received.level);
+}
+
+HOST_TEST(oversized_command_is_reported)
+{
+  ControllerFixture fixture;
+  Received received;
+  fixture.config.clientBufferSize = 512;
+  CHECK(fixture.start());
+  fixture.mqtt->setCommandCallback(recordCommand, &received);
+  const SentientMetrics::Id oversized = SentientMetrics::counter("inbound_oversized");
+  const uint32_t oversizedBefore = SentientMetrics::count(oversized);
+
+  // PubSubClient drops a packet larger than its buffer; the library counts it
+  const std::string big = "{\"level\":3,\"pad\":\"" + std::string(600, 'x') + "\"}";
+  fixture.sendCommand("set_level", big.c_str());
+  fixture.pump();
+  CHECK_EQ(0, received.calls);
+  CHECK_EQ(oversizedBefore + 1, SentientMetrics::count(oversized));
+
+  // The next packet is framed correctly and still arrives
+  fixture.sendCommand("set_level", "{\"level\":7}");
+  fixture.pump();
+  CHECK_EQ(1, received.calls);
+  CHECK_EQ(7, received.level);
+  CHECK_EQ(oversizedBefore + 1, SentientMetrics::count(oversized));
+}
+
+HOST_TEST(raised_buffer_takes_a_large_command)
+{
+  // The default holds ordinary commands; a sketch with bigger ones raises clientBufferSize
+  ControllerFixture fixture;
+  Received received;
+  fixture.config.clientBufferSize = 2048;
+  CHECK(fixture.start());
+  fixture.mqtt->setCommandCallback(recordCommand, &received);
+
+  const std::string big = "{\"level\":3,\"pad\":\"" + std::string(1500, 'x') + "\"}";
+  fixture.sendCommand("set_level", big.c_str());
+  fixture.pump();
+  CHECK_EQ(1, received.calls);
+  CHECK_EQ(3, received.level);
+}
+
+HOST_TEST(traced_command_is_acknowledged)
+{
+  ControllerFixture fixture;
+  Received received;
+  CHECK(fixture.start());
+  fixture.mqtt->setCommandCallback(recordCommand, &received);
+
+  fixture.sendCommand("open", "{\"traceId\":\"t-42\"}");
+  fixture.pump();
+  const FakeBroker::Message *ack = fixture.broker.lastOn(ControllerFixture::topic("events", "command_ack").c_str());
+  CHECK(ack != nullptr);
+  JsonDocument doc = parse(ack->payload);
+  CHECK_STR("t-42", doc["traceId"] | "");
+  CHECK_STR("open", doc["command"] | "");
+}
+
+HOST_TEST(offline_state_is_queued_and_flushed_after_reconnect)
+{
+  ControllerFixture fixture;
+  CHECK(fixture.start());
+  fixture.broker.dropConnections();
+  fixture.pump();
+  CHECK(!fixture.mqtt->isConnected());
+
+  CHECK(fixture.mqtt->publishState("solved"));
+  CHECK(!fixture.mqtt->outboundQueue().empty());
+
+  fixture.pump(200, 10'000);
+  CHECK(fixture.mqtt->isConnected());
+  CHECK(fixture.mqtt->outboundQueue().empty());
+  const FakeBroker::Message *state = fixture.broker.lastOn(ControllerFixture::topic("status", "state").c_str());
+  CHECK(state != nullptr);
+  CHECK_STR("solved", parse(state->payload)["state"] | "");
+}
+
+HOST_TEST(time_sync_reply_syncs_the_clock)
+{
+  ControllerFixture fixture;
+  CHECK(fixture.start());
+  fixture.pump(5);
+  const FakeBroker::Message *request = fixture.broker.lastOn(ControllerFixture::topic("timesync", "request").c_str());
+  CHECK(request != nullptr);
+
+  const uint64_t t1 = parse(request->payload)["t1"].as<uint64_t>();
+  JsonDocument reply;
+  reply["t1"] = t1;
+  reply["t2"] = 1'700'000'000'000'000ULL;
+  reply["t3"] = 1'700'000'000'000'100ULL;
+  std::string text;
+  serializeJson(reply, text);
+  fixture.sendCommand("timesync", text.c_str());
+  fixture.pump();
+  CHECK(fixture.mqtt->clockSynced());
+}
+
+HOST_TEST(dump_trace_streams_chunks)
+{
+  ControllerFixture fixture;
+  CHECK(fixture.start());
+  fixture.sendCommand("dump_trace", "{}");
+  fixture.pump(100);
+  CHECK(fixture.broker.countOn(ControllerFixture::topic("trace", "dump").c_str()) > 0);
+  const FakeBroker::Message *chunk = fixture.broker.lastOn(ControllerFixture::topic("trace", "dump").c_str());
+  CHECK(chunk != nullptr);
+  CHECK_STR("STRC", chunk->payload.substr(0, 4));
+}
+
+HOST_TEST(command_router_places_every_route)
+{
+  static constexpr auto router = makeSentientCommandRouter(kPanelRoutes);
+  JsonDocument payload;
+  int calls = 0;
+  for (size_t i = 0; i < router.size(); ++i)
+  {
+    CHECK_EQ(static_cast<int>(i), router.find(kPanelRoutes[i].command));
+    CHECK(router.dispatch(kPanelRoutes[i].command, payload, &calls));
+  }
+  CHECK_EQ(64, calls);
+  CHECK_EQ(-1, router.find("relay_32_power_on"));
+  CHECK_EQ(-1, router.find(""));
+  CHECK(!router.dispatch(nullptr, payload, &calls));
+}
+
+HOST_TEST_MAIN()
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Decode a SentientTrace dump into a readable timeline.
+
+Send the controller its dump_trace command and capture the chunks as hex,
+one message per line:
+
+    mosquitto_sub -h <broker> -t 'paragon/<room>/trace/<controller>/<device>/dump' -F '%x' > dump.hex
+    mosquitto_pub -h <broker> -t 'paragon/<room>/commands/<controller>/<device>/dump_trace' -m '{}'
+    decode_trace.py dump.hex --names clock_v2/controller_naming.h
+
+Commands and topics are recorded as FNV-1a hashes. --names resolves them from
+any text files containing the names (quoted strings are picked up, so a
+controller_naming.h works as is); --topic-prefix adds full topic names built
+from a prefix and the quoted item names.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+CHUNK_HEADER = struct.Struct("<4sBBHHHI")
+ENTRY = struct.Struct("<IBBHI")
+
+EVENTS = {
+    1: "boot",
+    2: "command_received",
+    3: "command_dispatched",
+    4: "sensor_edge",
+    5: "publish",
+    6: "publish_failed",
+    7: "connect",
+    8: "disconnect",
+    9: "motion_start",
+    10: "motion_stop",
+    11: "mark",
+    12: "dumped",
+}
+
+# Events whose "b" argument is a name hash
+HASHED = {2, 3, 5, 6}
+
+
+def fnv1a(text):
+    value = 2166136261
+    for byte in text.encode():
+        value ^= byte
+        value = (value * 16777619) & 0xFFFFFFFF
+    return value
+
+
+def load_names(paths, topic_prefixes):
+    names = {}
+    for path in paths:
+        with open(path, encoding="utf-8", errors="replace") as handle:
+            for word in re.findall(r'"([^"\\]{1,120})"', handle.read()):
+                names.setdefault(fnv1a(word), word)
+                for prefix in topic_prefixes:
+                    topic = f"{prefix.rstrip('/')}/{word}"
+                    names.setdefault(fnv1a(topic), topic)
+    return names
+
+
+def read_chunks(path):
+    with open(path, "rb") as handle:
+        data = handle.read()
+    text = data.decode("ascii", errors="ignore")
+    if re.fullmatch(r"[0-9a-fA-F\s]+", text or "x"):
+        return [bytes.fromhex(line) for line in text.split() if line]
+    # Raw binary: chunks concatenated back to back
+    chunks = []
+    offset = 0
+    while offset + CHUNK_HEADER.size <= len(data):
+        _, _, _, _, _, count, _ = CHUNK_HEADER.unpack_from(data, offset)
+        size = CHUNK_HEADER.size + count * ENTRY.size
+        chunks.append(data[offset:offset + size])
+        offset += size
+    return chunks
+
+
+def decode(chunks):
+    ordered = {}
+    survived = False
+    boots = 0
+    expected = None
+    for chunk in chunks:
+        magic, version, flags, index, count, entries, boots = CHUNK_HEADER.unpack_from(chunk)
+        if magic != b"STRC" or version != 1:
+            print(f"skipping chunk with magic {magic!r} version {version}", file=sys.stderr)
+            continue
+        survived = bool(flags & 1)
+        expected = count
+        ordered[index] = [ENTRY.unpack_from(chunk, CHUNK_HEADER.size + i * ENTRY.size) for i in range(entries)]
+    if expected is not None and len(ordered) != expected:
+        missing = sorted(set(range(expected)) - set(ordered))
+        print(f"warning: missing chunks {missing}", file=sys.stderr)
+    entries = [entry for index in sorted(ordered) for entry in ordered[index]]
+    return entries, survived, boots
+
+
+def describe(event, a, b, names):
+    name = names.get(b, f"#{b:08x}")
+    if event == 1:
+        return f"{'warm' if a else 'cold'} start, reset reason 0x{b:x}"
+    if event == 2:
+        return f"{name} ({a} bytes)"
+    if event == 3:
+        return f"{name} handled {a}{'+' if a == 0xFFFF else ''} us after receipt"
+    if event in (5, 6):
+        return f"{name} ({a}{'+' if a == 0xFFFF else ''} bytes)"
+    if event == 7:
+        return f"after {a} failed attempts"
+    if event == 8:
+        return f"client state {struct.unpack('<i', struct.pack('<I', b))[0]}"
+    if event == 4:
+        return f"id {a} -> {b}"
+    if event in (9, 10):
+        return f"axis {a} {'target' if event == 9 else 'position'} {struct.unpack('<i', struct.pack('<I', b))[0]}"
+    return f"a={a} b={b}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("dump", help="hex lines from mosquitto_sub -F '%%x', or raw concatenated chunks")
+    parser.add_argument("--names", nargs="*", default=[], help="files whose quoted strings name commands and topics")
+    parser.add_argument("--topic-prefix", nargs="*", default=[], help="topic prefixes to combine with the names")
+    args = parser.parse_args()
+
+    names = load_names(args.names, args.topic_prefix)
+    entries, survived, boots = decode(read_chunks(args.dump))
+    print(f"{len(entries)} entries, boot #{boots}, ring {'survived a reset' if survived else 'from this run only'}")
+
+    previous = None
+    for time_us, event, _, a, b in entries:
+        if event == 1:
+            previous = None
+            print("-" * 72)
+        # micros() wraps every 71.6 minutes; deltas stay right across one wrap
+        delta = "" if previous is None else f"+{((time_us - previous) & 0xFFFFFFFF) / 1000:.3f} ms"
+        previous = time_us
+        label = EVENTS.get(event, f"event_{event}")
+        print(f"{time_us / 1e6:14.6f}s {delta:>14}  {label:<19} {describe(event, a, b, names)}")
+
+
+if __name__ == "__main__":
+    main()
@@ -8,6 +8,8 @@ import { DeviceRegistry } from './devices/DeviceRegistry';
 import { MQTTManager } from './mqtt/MQTTManager';
 import { buildRoutes } from './routes';
 import { TopicBuilder } from './mqtt/topics';
+import { TimeSyncResponder } from './mqtt/TimeSyncResponder';
+import { ManifestFingerprintResponder } from './mqtt/ManifestFingerprintResponder';
 import { AlertManager } from './alerts/AlertManager';
 import { PuzzleEngineBridge } from './integrations/PuzzleEngineBridge';
 import { WebSocketServer } from './websocket/WebSocketServer';
@@ -31,6 +33,10 @@ const mqtt = new MQTTManager({
   topicFilter: config.MQTT_TOPIC_FILTER,
 });
 const topicBuilder = new TopicBuilder();
+const timeSync = new TimeSyncResponder(mqtt);
+const manifestFingerprints = new ManifestFingerprintResponder(mqtt, {
+  databaseUrl: process.env.DATABASE_URL || '',
+});
 const alerts = new AlertManager();
 
 // Initialize controller registration handler (legacy single-message format)
@@ -136,14 +142,23 @@ splitRegistration = new SplitRegistrationHandler({
   databaseUrl: config.DATABASE_URL,
   registrationTimeoutMs: 10000,
   wsServer,
+  onRegistered: (controller_id, controller_db_id) => manifestFingerprints.registered(controller_id, controller_db_id),
 });
 
 const HEALTH_SWEEP_INTERVAL = config.HEALTH_SWEEP_INTERVAL_MS;
 const healthInterval = setInterval(() => registry.performHealthSweep(), HEALTH_SWEEP_INTERVAL);
 
 mqtt.on('message', (message) => {
+  // Answer controller clock sync first; its reply timing is what the exchange measures
+  if (TimeSyncResponder.isRequest(message.topic)) {
+    timeSync.handleMessage(message);
+  }
+  // Controllers fingerprint their manifest first; only unknown ones are asked for the full registration
+  else if (ManifestFingerprintResponder.isFingerprint(message.topic)) {
+    manifestFingerprints.handleMessage(message);
+  }
   // Check if this is a split controller registration message (v2.0.7+)
-  if (
+  else if (
     message.topic === 'sentient/system/register/controller' ||
     message.topic.endsWith('/system/register/controller')
   ) {
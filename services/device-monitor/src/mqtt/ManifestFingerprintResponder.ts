@@ -0,0 +1,113 @@
+import { Pool } from 'pg';
+import { logger } from '../logger';
+import type { IncomingMessage } from '../devices/types';
+import type { MQTTManager } from './MQTTManager';
+
+// <namespace>/<room>/register/<controller>/<device>/fingerprint
+const FINGERPRINT_TOPIC = /^([^/]+)\/([^/]+)\/register\/([^/]+)\/([^/]+)\/fingerprint$/;
+
+export interface ManifestFingerprintOptions {
+  databaseUrl: string;
+}
+
+/**
+ * Answers SentientMQTT manifest fingerprints so reconnecting controllers only
+ * re-send their registration when it changed: a hash already stored for the
+ * controller gets "manifest_known", anything else "send_manifest". A hash is
+ * stored (controllers.manifest_hash) once the registration it asked for has
+ * been stored, so known controllers stay known across restarts of this service.
+ */
+export class ManifestFingerprintResponder {
+  private readonly dbPool: Pool;
+  private readonly known = new Map<string, string>(); // Cache of controllers.manifest_hash
+  private readonly requested = new Map<string, string>();
+
+  constructor(private readonly mqtt: MQTTManager, options: ManifestFingerprintOptions) {
+    this.dbPool = new Pool({ connectionString: options.databaseUrl, max: 2 });
+  }
+
+  public static isFingerprint(topic: string): boolean {
+    return FINGERPRINT_TOPIC.test(topic);
+  }
+
+  public handleMessage(message: IncomingMessage): void {
+    const match = FINGERPRINT_TOPIC.exec(message.topic);
+    if (!match) {
+      return;
+    }
+
+    let fingerprint: { controller_id?: unknown; firmware_version?: unknown; manifest_hash?: unknown };
+    try {
+      fingerprint = JSON.parse(message.payload.toString());
+    } catch {
+      return;
+    }
+    const { controller_id, firmware_version, manifest_hash } = fingerprint;
+    if (typeof controller_id !== 'string' || typeof manifest_hash !== 'string') {
+      return;
+    }
+
+    const [, namespace, room, controller, device] = match;
+    const commandTopic = `${namespace}/${room}/commands/${controller}/${device}`;
+    this.storedHash(controller_id, room).then((stored) => {
+      if (stored === manifest_hash) {
+        logger.debug({ controller_id, firmware_version, manifest_hash }, 'Manifest unchanged, registration skipped');
+        this.reply(`${commandTopic}/manifest_known`, { manifest_hash });
+        return;
+      }
+
+      logger.info({ controller_id, firmware_version, manifest_hash }, 'Unknown manifest, requesting registration');
+      this.requested.set(controller_id, manifest_hash);
+      this.reply(`${commandTopic}/send_manifest`, {});
+    });
+  }
+
+  /** The registration requested for this controller is stored; its hash is now known. */
+  public registered(controller_id: string, controller_db_id: string): void {
+    const manifest_hash = this.requested.get(controller_id);
+    if (manifest_hash === undefined) {
+      return;
+    }
+    this.requested.delete(controller_id);
+    this.known.set(controller_id, manifest_hash);
+
+    this.dbPool
+      .query('UPDATE controllers SET manifest_hash = $1 WHERE id = $2', [manifest_hash, controller_db_id])
+      .catch((error) => {
+        logger.warn({ error: error.message, controller_id }, 'Failed to store manifest hash');
+      });
+  }
+
+  // The hash of the controller's last stored registration; undefined when there is none
+  private async storedHash(controller_id: string, room: string): Promise<string | undefined> {
+    const cached = this.known.get(controller_id);
+    if (cached !== undefined) {
+      return cached;
+    }
+
+    try {
+      const result = await this.dbPool.query(
+        `SELECT manifest_hash
+         FROM controllers
+         WHERE controller_id = $1 AND mqtt_room_id = $2 AND manifest_hash IS NOT NULL
+         LIMIT 1`,
+        [controller_id, room]
+      );
+      const stored: string | undefined = result.rows[0]?.manifest_hash;
+      if (stored !== undefined) {
+        this.known.set(controller_id, stored);
+      }
+      return stored;
+    } catch (error: any) {
+      // Asking for the full registration is always safe
+      logger.warn({ error: error.message, controller_id }, 'Failed to read stored manifest hash');
+      return undefined;
+    }
+  }
+
+  private reply(topic: string, payload: object): void {
+    this.mqtt.publish(topic, JSON.stringify(payload), 1).catch((error) => {
+      logger.warn({ err: error, topic }, 'Failed to publish manifest fingerprint reply');
+    });
+  }
+}
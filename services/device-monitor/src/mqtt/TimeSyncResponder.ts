@@ -0,0 +1,47 @@
+import { performance } from 'perf_hooks';
+import { logger } from '../logger';
+import type { IncomingMessage } from '../devices/types';
+import type { MQTTManager } from './MQTTManager';
+
+// <namespace>/<room>/timesync/<controller>/<device>/request
+const REQUEST_TOPIC = /^([^/]+)\/([^/]+)\/timesync\/([^/]+)\/([^/]+)\/request$/;
+
+const epochMicros = (): number => Math.round((performance.timeOrigin + performance.now()) * 1000);
+
+/**
+ * Answers SentientMQTT time-sync requests so controllers can lock their clocks
+ * to this host: echoes the controller's t1 with our receive (t2) and send (t3)
+ * times in epoch microseconds on the controller's timesync command topic.
+ */
+export class TimeSyncResponder {
+  constructor(private readonly mqtt: MQTTManager) {}
+
+  public static isRequest(topic: string): boolean {
+    return REQUEST_TOPIC.test(topic);
+  }
+
+  public handleMessage(message: IncomingMessage): void {
+    const t2 = epochMicros();
+    const match = REQUEST_TOPIC.exec(message.topic);
+    if (!match) {
+      return;
+    }
+
+    let t1: unknown;
+    try {
+      t1 = JSON.parse(message.payload.toString()).t1;
+    } catch {
+      return;
+    }
+    if (typeof t1 !== 'number') {
+      return;
+    }
+
+    const [, namespace, room, controller, device] = match;
+    const replyTopic = `${namespace}/${room}/commands/${controller}/${device}/timesync`;
+    // QoS 0: a retransmitted reply would only carry a stale t3
+    this.mqtt.publish(replyTopic, JSON.stringify({ t1, t2, t3: epochMicros() }), 0).catch((error) => {
+      logger.warn({ err: error, topic: replyTopic }, 'Failed to publish time-sync reply');
+    });
+  }
+}
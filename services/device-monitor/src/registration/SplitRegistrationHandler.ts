@@ -58,6 +58,7 @@ export interface SplitRegistrationOptions {
   registrationTimeoutMs?: number;  // How long to wait for all devices (default 10s)
   databaseUrl: string;  // Direct database connection (required)
   wsServer?: any;  // WebSocket server for real-time updates (optional)
+  onRegistered?: (controller_id: string, controller_db_id: string) => void;  // Called once a registration is stored (optional)
 }
 
 /**
@@ -73,11 +74,13 @@ export class SplitRegistrationHandler {
   private readonly registrationTimeoutMs: number;
   private readonly dbPool: Pool;
   private readonly wsServer?: any;
+  private readonly onRegistered?: (controller_id: string, controller_db_id: string) => void;
   private pendingRegistrations = new Map<string, PendingRegistration>();
 
   constructor(options: SplitRegistrationOptions) {
     this.registrationTimeoutMs = options.registrationTimeoutMs || 10000;
     this.wsServer = options.wsServer;
+    this.onRegistered = options.onRegistered;
 
     // Initialize database pool (required)
     this.dbPool = new Pool({
@@ -279,6 +282,7 @@ export class SplitRegistrationHandler {
         },
         'Registration complete'
       );
+      this.onRegistered?.(controller_id, controller.id);
     } catch (error: any) {
       logger.error(
         { error: error.message, controller_id },